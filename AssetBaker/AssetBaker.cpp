@@ -0,0 +1,344 @@
+//***************************************************************************************
+// AssetBaker : packs every .dds under Textures/ and every .txt / .m3d under
+// Models/ into one AssetArchive that Init_Direct3D maps at startup.
+//
+// usage: AssetBaker [assetRoot] [output]
+//        assetRoot defaults to "..", output to <assetRoot>/Assets.pak
+//
+// Only portable code is used (no Windows or D3D headers), so the tool also
+// builds on Linux, e.g. from this directory:
+//   g++ -std=c++17 -O2 -pthread -I<DirectXMath> AssetBaker.cpp ../Common/MathHelper.cpp
+//       ../Init_Direct3D/{AssetArchive,BakedClip,ClipCompressor,CompiledClip,LoadM3d,M3dCache,
+//       MappedFile,MeshOptimizer,SkinnedData,TextScanner,ThreadPool,VertexWelder}.cpp -o AssetBaker
+// DirectXMath is header only; outside Windows it also needs the sal.h from DirectX-Headers.
+//***************************************************************************************
+
+#include "../Init_Direct3D/AssetArchive.h"
+#include "../Init_Direct3D/LoadM3d.h"
+#include "../Init_Direct3D/M3dCache.h"
+#include "../Init_Direct3D/MeshOptimizer.h"
+#include "../Init_Direct3D/TextScanner.h"
+#include "../Init_Direct3D/ThreadPool.h"
+#include "../Init_Direct3D/VertexWelder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+	// Same defaults as the runtime WeldEpsilon.
+	const float WeldPositionEpsilon = 1e-5f;
+	const float WeldNormalEpsilon = 1e-3f;
+	const float WeldUVEpsilon = 1e-5f;
+	const float WeldTangentEpsilon = 1e-3f;
+	const float WeldBoneWeightEpsilon = 1e-3f;
+
+	// Collects a whole skinned model from M3DLoader::StreamM3d.
+	class SkinnedModelSink : public M3DLoader::M3dSink
+	{
+	public:
+		virtual bool Begin(UINT numVertices, UINT numTriangles,
+			const std::vector<M3DLoader::Subset>& subsets,
+			const std::vector<M3DLoader::M3dMaterial>& mats)override
+		{
+			VertexData.resize(numVertices);
+			IndexData.resize((size_t)numTriangles * 3);
+			Subsets = subsets;
+			Mats = mats;
+			return true;
+		}
+
+		virtual void Vertices(UINT firstVertex, const M3DLoader::SkinnedVertex* vertices, UINT count)override
+		{
+			std::copy(vertices, vertices + count, VertexData.begin() + firstVertex);
+		}
+
+		virtual void Indices(UINT firstIndex, const UINT* indices, UINT count)override
+		{
+			std::copy(indices, indices + count, IndexData.begin() + firstIndex);
+		}
+
+		virtual void Skeleton(const std::vector<int>& boneIndexToParentIndex,
+			const std::vector<DirectX::XMFLOAT4X4>& boneOffsets,
+			const std::unordered_map<std::string, AnimationClip>& animations)override
+		{
+			BoneHierarchy = boneIndexToParentIndex;
+			BoneOffsets = boneOffsets;
+			Animations = animations;
+		}
+
+		virtual bool End()override
+		{
+			return true;
+		}
+
+	public:
+		std::vector<M3DLoader::SkinnedVertex> VertexData;
+		std::vector<UINT> IndexData;
+		std::vector<M3DLoader::Subset> Subsets;
+		std::vector<M3DLoader::M3dMaterial> Mats;
+		std::vector<int> BoneHierarchy;
+		std::vector<DirectX::XMFLOAT4X4> BoneOffsets;
+		std::unordered_map<std::string, AnimationClip> Animations;
+	};
+
+	bool ReadWholeFile(const fs::path& path, std::vector<std::uint8_t>& data)
+	{
+		std::ifstream fin(path, std::ios::binary | std::ios::ate);
+		if(!fin)
+			return false;
+
+		data.resize((size_t)fin.tellg());
+		fin.seekg(0);
+		fin.read(reinterpret_cast<char*>(data.data()), (std::streamsize)data.size());
+		return (bool)fin;
+	}
+
+	// Triangles of each range reordered for the vertex cache (kept only when
+	// the ACMR improves), then vertices in first-use order.
+	void OptimizeMesh(void* vertices, size_t vertexCount, size_t vertexStride,
+		std::uint32_t* indices, size_t indexCount, const std::vector<std::pair<size_t, size_t>>& ranges)
+	{
+		std::vector<std::uint32_t> reordered;
+		for(const auto& range : ranges)
+		{
+			std::uint32_t* first = indices + range.first;
+
+			reordered.assign(first, first + range.second);
+			MeshOptimizer::OptimizeVertexCache(reordered.data(), reordered.size(), vertexCount);
+
+			if(MeshOptimizer::ComputeACMR(reordered.data(), reordered.size(), vertexCount) <
+			   MeshOptimizer::ComputeACMR(first, range.second, vertexCount))
+			{
+				std::copy(reordered.begin(), reordered.end(), first);
+			}
+		}
+
+		MeshOptimizer::OptimizeVertexFetch(vertices, vertexCount, vertexStride, indices, indexCount);
+	}
+
+	bool BakeTexture(AssetArchive::Writer& writer, const fs::path& file, const std::string& name)
+	{
+		std::vector<std::uint8_t> data;
+		if(!ReadWholeFile(file, data) || data.size() < 128 || memcmp(data.data(), "DDS ", 4) != 0)
+			return false;
+
+		writer.Add(name, AssetArchive::AssetType::Texture, std::move(data));
+		return true;
+	}
+
+	// Text mesh as written for skull.txt / car.txt: positions and normals only.
+	bool BakeMesh(AssetArchive::Writer& writer, ThreadPool& pool, const fs::path& file, const std::string& name)
+	{
+		TextScanner fin;
+		if(!fin.Open(file.string()))
+			return false;
+
+		UINT vertexCount = 0;
+		UINT triangleCount = 0;
+		fin.Skip() >> vertexCount;
+		fin.Skip() >> triangleCount;
+		fin.Skip(4);
+
+		std::vector<AssetArchive::MeshVertex> vertices(vertexCount);
+		for(auto& v : vertices)
+		{
+			fin >> v.Position[0] >> v.Position[1] >> v.Position[2];
+			fin >> v.Normal[0] >> v.Normal[1] >> v.Normal[2];
+		}
+
+		fin.Skip(3);
+		std::vector<std::uint32_t> indices((size_t)triangleCount * 3);
+		for(auto& i : indices)
+			fin >> i;
+
+		if(fin.Fail())
+			return false;
+
+		for(std::uint32_t i : indices)
+		{
+			if(i >= vertexCount)
+				return false;
+		}
+
+		const std::vector<VertexWelder::Attribute> attributes =
+		{
+			{ offsetof(AssetArchive::MeshVertex, Position), 3, VertexWelder::AttributeType::Float, WeldPositionEpsilon },
+			{ offsetof(AssetArchive::MeshVertex, Normal), 3, VertexWelder::AttributeType::Float, WeldNormalEpsilon },
+			{ offsetof(AssetArchive::MeshVertex, TexC), 2, VertexWelder::AttributeType::Float, WeldUVEpsilon },
+			{ offsetof(AssetArchive::MeshVertex, TangentU), 3, VertexWelder::AttributeType::Float, WeldTangentEpsilon }
+		};
+		vertices.resize(VertexWelder::Weld(vertices.data(), vertices.size(), sizeof(AssetArchive::MeshVertex), attributes,
+			indices.data(), indices.size(), &pool));
+
+		OptimizeMesh(vertices.data(), vertices.size(), sizeof(AssetArchive::MeshVertex),
+			indices.data(), indices.size(), { { 0, indices.size() } });
+
+		writer.AddMesh(name, vertices.data(), (std::uint32_t)vertices.size(), indices.data(), (std::uint32_t)indices.size());
+
+		printf("  %-28s mesh    %u -> %zu vertices, %u triangles\n", name.c_str(), vertexCount, vertices.size(), triangleCount);
+		return true;
+	}
+
+	bool BakeSkinnedModel(AssetArchive::Writer& writer, ThreadPool& pool, const fs::path& file, const std::string& name,
+		const fs::path& scratchFile)
+	{
+		M3DLoader loader;
+		loader.SetThreadPool(&pool);
+
+		SkinnedModelSink model;
+		if(!loader.StreamM3d(file.string(), model))
+			return false;
+
+		const UINT sourceVertexCount = (UINT)model.VertexData.size();
+
+		const std::vector<VertexWelder::Attribute> attributes =
+		{
+			{ offsetof(M3DLoader::SkinnedVertex, Pos), 3, VertexWelder::AttributeType::Float, WeldPositionEpsilon },
+			{ offsetof(M3DLoader::SkinnedVertex, Normal), 3, VertexWelder::AttributeType::Float, WeldNormalEpsilon },
+			{ offsetof(M3DLoader::SkinnedVertex, TexC), 2, VertexWelder::AttributeType::Float, WeldUVEpsilon },
+			{ offsetof(M3DLoader::SkinnedVertex, TangentU), 3, VertexWelder::AttributeType::Float, WeldTangentEpsilon },
+			{ offsetof(M3DLoader::SkinnedVertex, BoneWeights), 3, VertexWelder::AttributeType::Float, WeldBoneWeightEpsilon },
+			{ offsetof(M3DLoader::SkinnedVertex, BoneIndices), 4, VertexWelder::AttributeType::Bytes, 0.0f }
+		};
+		model.VertexData.resize(VertexWelder::Weld(model.VertexData.data(), model.VertexData.size(), sizeof(M3DLoader::SkinnedVertex),
+			attributes, model.IndexData.data(), model.IndexData.size(), &pool));
+
+		std::vector<std::pair<size_t, size_t>> ranges;
+		for(const auto& subset : model.Subsets)
+			ranges.push_back({ (size_t)subset.FaceStart * 3, (size_t)subset.FaceCount * 3 });
+
+		OptimizeMesh(model.VertexData.data(), model.VertexData.size(), sizeof(M3DLoader::SkinnedVertex),
+			model.IndexData.data(), model.IndexData.size(), ranges);
+
+		// Vertex numbers changed, so the vertex range of every subset too.
+		for(auto& subset : model.Subsets)
+		{
+			if(subset.FaceCount == 0)
+				continue;
+
+			UINT lo = UINT32_MAX;
+			UINT hi = 0;
+			for(UINT i = subset.FaceStart * 3; i < (subset.FaceStart + subset.FaceCount) * 3; ++i)
+			{
+				lo = MathHelper::Min(lo, model.IndexData[i]);
+				hi = MathHelper::Max(hi, model.IndexData[i]);
+			}
+
+			subset.VertexStart = lo;
+			subset.VertexCount = hi - lo + 1;
+		}
+
+		AssetArchive::Entry info = {};
+		info.VertexCount = (std::uint32_t)model.VertexData.size();
+		info.IndexCount = (std::uint32_t)model.IndexData.size();
+
+		// The cache writer streams to a file; the image is read back as the blob.
+		std::vector<std::uint8_t> image;
+		const bool written = M3dCache::Write(scratchFile.string(), file.string(), model.VertexData, model.IndexData,
+			model.Subsets, model.Mats, model.BoneHierarchy, model.BoneOffsets, model.Animations) &&
+			ReadWholeFile(scratchFile, image);
+
+		std::error_code ec;
+		fs::remove(scratchFile, ec);
+		if(!written)
+			return false;
+
+		writer.Add(name, AssetArchive::AssetType::SkinnedModel, std::move(image), info);
+
+		printf("  %-28s skinned %u -> %u vertices, %zu subsets, %zu bones, %zu clips\n", name.c_str(),
+			sourceVertexCount, info.VertexCount, model.Subsets.size(), model.BoneHierarchy.size(), model.Animations.size());
+		return true;
+	}
+
+	std::vector<fs::path> ListFiles(const fs::path& directory)
+	{
+		std::vector<fs::path> files;
+		std::error_code ec;
+		for(const auto& entry : fs::directory_iterator(directory, ec))
+		{
+			if(entry.is_regular_file())
+				files.push_back(entry.path());
+		}
+
+		std::sort(files.begin(), files.end());
+		return files;
+	}
+
+	std::string Extension(const fs::path& file)
+	{
+		std::string ext = file.extension().string();
+		std::transform(ext.begin(), ext.end(), ext.begin(), [](char c) { return (char)tolower((unsigned char)c); });
+		return ext;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const fs::path root = argc > 1 ? fs::path(argv[1]) : fs::path("..");
+	const fs::path output = argc > 2 ? fs::path(argv[2]) : root / "Assets.pak";
+
+	const auto start = std::chrono::steady_clock::now();
+
+	ThreadPool pool;
+	AssetArchive::Writer writer;
+	int failed = 0;
+
+	for(const fs::path& file : ListFiles(root / "Textures"))
+	{
+		const std::string name = "Textures/" + file.filename().string();
+		if(Extension(file) != ".dds")
+		{
+			printf("  %-28s skipped (no runtime loader)\n", name.c_str());
+			continue;
+		}
+
+		if(!BakeTexture(writer, file, name))
+		{
+			printf("  %-28s FAILED\n", name.c_str());
+			++failed;
+		}
+	}
+
+	for(const fs::path& file : ListFiles(root / "Models"))
+	{
+		const std::string name = "Models/" + file.filename().string();
+		const std::string ext = Extension(file);
+
+		bool ok = true;
+		if(ext == ".txt")
+			ok = BakeMesh(writer, pool, file, name);
+		else if(ext == ".m3d")
+			ok = BakeSkinnedModel(writer, pool, file, name, output.string() + ".tmp");
+		else
+			continue;
+
+		if(!ok)
+		{
+			printf("  %-28s FAILED\n", name.c_str());
+			++failed;
+		}
+	}
+
+	if(!writer.Write(output.string()))
+	{
+		printf("Failed to write %s\n", output.string().c_str());
+		return 1;
+	}
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::error_code ec;
+	printf("%s : %zu entries, %llu bytes, %.2f s%s\n", output.string().c_str(), writer.EntryCount(),
+		(unsigned long long)fs::file_size(output, ec), seconds, failed > 0 ? " (with errors)" : "");
+
+	return failed > 0 ? 1 : 0;
+}
@@ -6,9 +6,19 @@
 
 #pragma once
 
+#include <cstdint>
+#include <cstdlib>
+
+#ifdef _WIN32
 #include <Windows.h>
+#else
+// Windows integer types used by the portable loaders (SkinnedData, LoadM3d, M3dCache).
+typedef std::uint8_t  BYTE;
+typedef std::uint32_t UINT;
+typedef std::uint64_t UINT64;
+#endif
+
 #include <DirectXMath.h>
-#include <cstdint>
 
 class MathHelper
 {
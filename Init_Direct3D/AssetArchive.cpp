@@ -0,0 +1,252 @@
+#include "AssetArchive.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+	const std::uint64_t IndexAlignment = 16;
+
+	std::uint64_t AlignUp(std::uint64_t value, std::uint64_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+}
+
+std::string AssetArchive::NormalizeName(const std::string& path)
+{
+	std::string name = path;
+	std::replace(name.begin(), name.end(), '\\', '/');
+
+	// Entries are relative to the asset root, so leading "./" and "../" go.
+	for(;;)
+	{
+		if(name.compare(0, 2, "./") == 0)
+			name.erase(0, 2);
+		else if(name.compare(0, 3, "../") == 0)
+			name.erase(0, 3);
+		else
+			break;
+	}
+
+	return name;
+}
+
+void AssetArchive::Writer::Add(const std::string& name, AssetType type, std::vector<std::uint8_t> blob, const Entry& info)
+{
+	PendingEntry entry;
+	entry.Name = NormalizeName(name);
+	entry.Info = info;
+	entry.Info.Type = (std::uint32_t)type;
+	entry.Info.Size = blob.size();
+	entry.Blob = std::move(blob);
+
+	mEntries.push_back(std::move(entry));
+}
+
+void AssetArchive::Writer::AddMesh(const std::string& name, const MeshVertex* vertices, std::uint32_t vertexCount,
+	const std::uint32_t* indices, std::uint32_t indexCount)
+{
+	Entry info = {};
+	info.VertexCount = vertexCount;
+	info.IndexCount = indexCount;
+	info.IndexOffset = (std::uint32_t)AlignUp((std::uint64_t)vertexCount * sizeof(MeshVertex), IndexAlignment);
+
+	std::vector<std::uint8_t> blob(info.IndexOffset + (std::size_t)indexCount * sizeof(std::uint32_t), 0);
+	memcpy(blob.data(), vertices, (std::size_t)vertexCount * sizeof(MeshVertex));
+	memcpy(blob.data() + info.IndexOffset, indices, (std::size_t)indexCount * sizeof(std::uint32_t));
+
+	Add(name, AssetType::Mesh, std::move(blob), info);
+}
+
+std::size_t AssetArchive::Writer::EntryCount()const
+{
+	return mEntries.size();
+}
+
+bool AssetArchive::Writer::Write(const std::string& filename)
+{
+	// Sorted by name so that Find can binary search the table.
+	std::sort(mEntries.begin(), mEntries.end(),
+		[](const PendingEntry& a, const PendingEntry& b) { return a.Name < b.Name; });
+
+	for(std::size_t i = 1; i < mEntries.size(); ++i)
+	{
+		if(mEntries[i].Name == mEntries[i - 1].Name)
+			return false;
+	}
+
+	std::vector<char> strings;
+	std::vector<Entry> entries(mEntries.size());
+	for(std::size_t i = 0; i < mEntries.size(); ++i)
+	{
+		entries[i] = mEntries[i].Info;
+		entries[i].NameOffset = (std::uint32_t)strings.size();
+		strings.insert(strings.end(), mEntries[i].Name.begin(), mEntries[i].Name.end());
+		strings.push_back('\0');
+	}
+
+	Header header = {};
+	header.Magic = Magic;
+	header.Version = Version;
+	header.EntryCount = (std::uint32_t)entries.size();
+	header.StringsSize = (std::uint32_t)strings.size();
+	header.StringsOffset = sizeof(Header) + sizeof(Entry) * entries.size();
+
+	std::uint64_t offset = header.StringsOffset + strings.size();
+	for(Entry& entry : entries)
+	{
+		entry.Offset = AlignUp(offset, BlobAlignment);
+		offset = entry.Offset + entry.Size;
+	}
+
+	std::ofstream fout(filename, std::ios::binary | std::ios::trunc);
+	if(!fout)
+		return false;
+
+	fout.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+	fout.write(reinterpret_cast<const char*>(entries.data()), sizeof(Entry) * entries.size());
+	fout.write(strings.data(), (std::streamsize)strings.size());
+
+	static const char zeros[BlobAlignment] = {};
+	std::uint64_t written = header.StringsOffset + strings.size();
+	for(std::size_t i = 0; i < entries.size(); ++i)
+	{
+		fout.write(zeros, (std::streamsize)(entries[i].Offset - written));
+		fout.write(reinterpret_cast<const char*>(mEntries[i].Blob.data()), (std::streamsize)entries[i].Size);
+		written = entries[i].Offset + entries[i].Size;
+	}
+
+	fout.close();
+	return !fout.fail();
+}
+
+bool AssetArchive::IsValidMesh(const Entry& entry, const std::uint8_t* blob)
+{
+	// Vertices, then the indices at IndexOffset, both inside the blob.
+	if((std::uint64_t)entry.VertexCount * sizeof(MeshVertex) > entry.IndexOffset ||
+	   entry.IndexOffset % sizeof(std::uint32_t) != 0 ||
+	   entry.IndexOffset + (std::uint64_t)entry.IndexCount * sizeof(std::uint32_t) > entry.Size)
+	{
+		return false;
+	}
+
+	// MeshVertices / MeshIndices go straight into a vertex and index
+	// buffer, so every index has to name a vertex of the blob.
+	const std::uint32_t* indices = reinterpret_cast<const std::uint32_t*>(blob + entry.IndexOffset);
+	for(std::uint32_t i = 0; i < entry.IndexCount; ++i)
+	{
+		if(indices[i] >= entry.VertexCount)
+			return false;
+	}
+	return true;
+}
+
+bool AssetArchive::Open(const std::string& filename)
+{
+	Close();
+
+	if(!mFile.Open(filename))
+		return false;
+
+	const std::uint8_t* data = mFile.Data();
+	const std::uint64_t size = mFile.Size();
+
+	const Header* header = reinterpret_cast<const Header*>(data);
+	if(size < sizeof(Header) ||
+	   header->Magic != Magic ||
+	   header->Version != Version ||
+	   header->StringsOffset != sizeof(Header) + sizeof(Entry) * (std::uint64_t)header->EntryCount ||
+	   header->StringsOffset + header->StringsSize > size ||
+	   (header->StringsSize > 0 && data[header->StringsOffset + header->StringsSize - 1] != '\0'))
+	{
+		Close();
+		return false;
+	}
+
+	const Entry* entries = reinterpret_cast<const Entry*>(data + sizeof(Header));
+	for(std::uint32_t i = 0; i < header->EntryCount; ++i)
+	{
+		const Entry& e = entries[i];
+		if(e.NameOffset >= header->StringsSize ||
+		   e.Offset % BlobAlignment != 0 ||
+		   e.Offset + e.Size > size ||
+		   (e.Type == (std::uint32_t)AssetType::Mesh && !IsValidMesh(e, data + e.Offset)))
+		{
+			Close();
+			return false;
+		}
+	}
+
+	mHeader = header;
+	mEntries = entries;
+	mStrings = reinterpret_cast<const char*>(data + header->StringsOffset);
+	return true;
+}
+
+void AssetArchive::Close()
+{
+	mFile.Close();
+	mHeader = nullptr;
+	mEntries = nullptr;
+	mStrings = nullptr;
+}
+
+bool AssetArchive::IsOpen()const
+{
+	return mHeader != nullptr;
+}
+
+std::uint32_t AssetArchive::EntryCount()const
+{
+	return mHeader != nullptr ? mHeader->EntryCount : 0;
+}
+
+const AssetArchive::Entry& AssetArchive::GetEntry(std::uint32_t i)const
+{
+	return mEntries[i];
+}
+
+const char* AssetArchive::EntryName(const Entry& entry)const
+{
+	return mStrings + entry.NameOffset;
+}
+
+const AssetArchive::Entry* AssetArchive::Find(const std::string& path)const
+{
+	if(!IsOpen())
+		return nullptr;
+
+	const std::string name = NormalizeName(path);
+	const Entry* first = mEntries;
+	const Entry* last = mEntries + mHeader->EntryCount;
+
+	const Entry* found = std::lower_bound(first, last, name,
+		[this](const Entry& e, const std::string& n) { return strcmp(EntryName(e), n.c_str()) < 0; });
+
+	if(found == last || name != EntryName(*found))
+		return nullptr;
+
+	return found;
+}
+
+const AssetArchive::Entry* AssetArchive::Find(const std::string& path, AssetType type)const
+{
+	const Entry* entry = Find(path);
+	return entry != nullptr && entry->Type == (std::uint32_t)type ? entry : nullptr;
+}
+
+const std::uint8_t* AssetArchive::Data(const Entry& entry)const
+{
+	return mFile.Data() + entry.Offset;
+}
+
+const AssetArchive::MeshVertex* AssetArchive::MeshVertices(const Entry& entry)const
+{
+	return reinterpret_cast<const MeshVertex*>(Data(entry));
+}
+
+const std::uint32_t* AssetArchive::MeshIndices(const Entry& entry)const
+{
+	return reinterpret_cast<const std::uint32_t*>(Data(entry) + entry.IndexOffset);
+}
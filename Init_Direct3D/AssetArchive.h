@@ -0,0 +1,137 @@
+#ifndef ASSETARCHIVE_H
+#define ASSETARCHIVE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+
+///<summary>
+/// One packed file with every asset the app loads at startup, written
+/// offline by the AssetBaker tool and mapped once at runtime.
+///
+/// The layout is a header, a table of contents sorted by name, a string
+/// table and then one blob per entry.  Every blob starts on a BlobAlignment
+/// boundary, so it can be used in place from the mapped file and copied
+/// straight into an upload buffer.
+///
+/// Entry names are paths relative to the asset root with '/' separators,
+/// e.g. "Textures/bricks.dds" or "Models/skull.txt".  Blob contents:
+///     Texture      : the .dds file, unchanged.
+///     Mesh         : MeshVertex[VertexCount], then std::uint32_t[IndexCount]
+///                    at IndexOffset.  Welded and reordered for the vertex
+///                    cache and vertex fetch.
+///     SkinnedModel : an M3dCache image, opened with M3dCache::Open(data, size).
+///                    Welded and reordered like Mesh, per subset.
+///</summary>
+class AssetArchive
+{
+public:
+	static const std::uint32_t Magic = 0x4B415041; // 'APAK'
+	static const std::uint32_t Version = 2;	// 2: no per-entry bounds (the loader computes them per submesh)
+
+	// D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, which also covers buffer uploads.
+	static const std::uint64_t BlobAlignment = 512;
+
+	enum class AssetType : std::uint32_t
+	{
+		Texture = 0,
+		Mesh,
+		SkinnedModel
+	};
+
+	// Same layout as the app's static Vertex.
+	struct MeshVertex
+	{
+		float Position[3];
+		float Normal[3];
+		float TexC[2];
+		float TangentU[3];
+	};
+
+	struct Header
+	{
+		std::uint32_t Magic;
+		std::uint32_t Version;
+		std::uint32_t EntryCount;
+		std::uint32_t StringsSize;
+		std::uint64_t StringsOffset;
+	};
+
+	struct Entry
+	{
+		std::uint32_t NameOffset;
+		std::uint32_t Type;
+		std::uint64_t Offset;
+		std::uint64_t Size;
+
+		// Mesh and SkinnedModel only.
+		std::uint32_t VertexCount;
+		std::uint32_t IndexCount;
+		std::uint32_t IndexOffset;		// bytes from the start of the blob (Mesh)
+		std::uint32_t Reserved;
+	};
+
+	///<summary>
+	/// Collects blobs in memory and writes the archive in one go.
+	///</summary>
+	class Writer
+	{
+	public:
+		// info supplies the type specific fields; name, type, offset and size are filled in here.
+		void Add(const std::string& name, AssetType type, std::vector<std::uint8_t> blob, const Entry& info = Entry());
+
+		// Mesh blob from vertices and indices; also fills in the counts.
+		void AddMesh(const std::string& name, const MeshVertex* vertices, std::uint32_t vertexCount,
+			const std::uint32_t* indices, std::uint32_t indexCount);
+
+		bool Write(const std::string& filename);
+
+		std::size_t EntryCount()const;
+
+	private:
+		struct PendingEntry
+		{
+			std::string Name;
+			Entry Info;
+			std::vector<std::uint8_t> Blob;
+		};
+
+		std::vector<PendingEntry> mEntries;
+	};
+
+public:
+	// "..\\Models\\skull.txt" -> "Models/skull.txt"
+	static std::string NormalizeName(const std::string& path);
+
+	// Fails on anything out of range, including Mesh entries whose vertex
+	// array overlaps the indices or whose indices are >= VertexCount, so
+	// the Mesh* accessors can be used without further checks.
+	bool Open(const std::string& filename);
+	void Close();
+	bool IsOpen()const;
+
+	std::uint32_t EntryCount()const;
+	const Entry& GetEntry(std::uint32_t i)const;
+	const char* EntryName(const Entry& entry)const;
+
+	// Looks up a path (normalized first); nullptr when it isn't in the archive.
+	const Entry* Find(const std::string& path)const;
+	const Entry* Find(const std::string& path, AssetType type)const;
+
+	const std::uint8_t* Data(const Entry& entry)const;
+	const MeshVertex* MeshVertices(const Entry& entry)const;
+	const std::uint32_t* MeshIndices(const Entry& entry)const;
+
+private:
+	static bool IsValidMesh(const Entry& entry, const std::uint8_t* blob);
+
+private:
+	MappedFile mFile;
+	const Header* mHeader = nullptr;
+	const Entry* mEntries = nullptr;
+	const char* mStrings = nullptr;
+};
+
+#endif // ASSETARCHIVE_H
@@ -0,0 +1,156 @@
+#include "AssetManager.h"
+
+AssetManager::AssetManager(ThreadPool& threadPool)
+	: mThreadPool(threadPool)
+{
+}
+
+AssetManager::~AssetManager()
+{
+	// Loads that have not started yet bail out; running ones are waited
+	// for because they still reference this object.
+	std::unique_lock<std::mutex> lock(mMutex);
+	mStop = true;
+	mLoadsDone.wait(lock, [this] { return mQueuedLoads == 0; });
+}
+
+AssetManager::Handle AssetManager::Load(const std::string& name, std::function<bool()> load, std::function<void()> finish)
+{
+	Handle handle = InvalidHandle;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+
+		Asset asset;
+		asset.Name = name;
+		asset.Finish = std::move(finish);
+		mAssets.push_back(std::move(asset));
+
+		handle = (Handle)mAssets.size();
+		++mQueuedLoads;
+	}
+
+	mThreadPool.Enqueue([this, handle, load]() { RunLoad(handle, load); });
+	return handle;
+}
+
+void AssetManager::RunLoad(Handle handle, const std::function<bool()>& load)
+{
+	bool stop = false;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		stop = mStop;
+		mAssets[handle - 1].Status = stop ? State::Failed : State::Loading;
+	}
+
+	// An exception thrown by load counts as a failed load.
+	bool loaded = false;
+	if(!stop)
+	{
+		try
+		{
+			loaded = load();
+		}
+		catch(...)
+		{
+			loaded = false;
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	if(loaded)
+	{
+		mAssets[handle - 1].Status = State::Loaded;
+		mLoaded.push_back(handle);
+	}
+	else
+	{
+		mAssets[handle - 1].Status = State::Failed;
+		mAssets[handle - 1].Finish = nullptr;
+	}
+
+	if(--mQueuedLoads == 0)
+		mLoadsDone.notify_all();
+}
+
+std::size_t AssetManager::Update()
+{
+	std::vector<Handle> loaded;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		loaded.swap(mLoaded);
+	}
+
+	// finish runs unlocked: it may call Load or query other handles.
+	for(Handle handle : loaded)
+	{
+		std::function<void()> finish;
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			finish = std::move(mAssets[handle - 1].Finish);
+			mAssets[handle - 1].Finish = nullptr;
+		}
+
+		if(finish)
+			finish();
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		mAssets[handle - 1].Status = State::Ready;
+	}
+
+	return loaded.size();
+}
+
+AssetManager::State AssetManager::GetState(Handle handle)const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	if(handle == InvalidHandle || handle > mAssets.size())
+		return State::Failed;
+
+	return mAssets[handle - 1].Status;
+}
+
+bool AssetManager::IsReady(Handle handle)const
+{
+	return GetState(handle) == State::Ready;
+}
+
+std::string AssetManager::GetName(Handle handle)const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	if(handle == InvalidHandle || handle > mAssets.size())
+		return std::string();
+
+	return mAssets[handle - 1].Name;
+}
+
+AssetManager::Stats AssetManager::GetStats()const
+{
+	Stats stats;
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	for(const Asset& asset : mAssets)
+	{
+		switch(asset.Status)
+		{
+		case State::Pending: ++stats.Pending; break;
+		case State::Loading:
+		case State::Loaded: ++stats.InFlight; break;
+		case State::Ready: ++stats.Completed; break;
+		case State::Failed: ++stats.Failed; break;
+		}
+	}
+
+	return stats;
+}
+
+bool AssetManager::IsIdle()const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mQueuedLoads == 0 && mLoaded.empty();
+}
+
+void AssetManager::Wait()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	mLoadsDone.wait(lock, [this] { return mQueuedLoads == 0; });
+}
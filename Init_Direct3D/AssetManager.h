@@ -0,0 +1,98 @@
+#ifndef ASSETMANAGER_H
+#define ASSETMANAGER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "ThreadPool.h"
+
+///<summary>
+/// Queue of asset loads that run on the shared ThreadPool.  Load returns a
+/// handle right away; the asset becomes ready some frames later, so the
+/// caller never blocks on file IO or mesh processing.
+///
+/// A load has two parts:
+///     load   : runs on a pool thread.  Parsing, welding, building buffers
+///              and anything else that does not touch state shared with
+///              the frame.  Returning false marks the asset Failed.
+///     finish : runs on the thread that calls Update, once load succeeded.
+///              Publishes the result (maps, render items, GPU uploads that
+///              need the command list).  It may queue further loads.
+///
+/// Handles are never reused, so a stale handle still reports its last state.
+///</summary>
+class AssetManager
+{
+public:
+	typedef std::uint32_t Handle;
+	static const Handle InvalidHandle = 0;
+
+	enum class State
+	{
+		Pending,	// queued, no thread has picked it up yet
+		Loading,	// load is running
+		Loaded,		// load is done, finish waits for the next Update
+		Ready,
+		Failed
+	};
+
+	struct Stats
+	{
+		std::size_t Pending = 0;
+		std::size_t InFlight = 0;	// Loading + Loaded
+		std::size_t Completed = 0;
+		std::size_t Failed = 0;
+	};
+
+	explicit AssetManager(ThreadPool& threadPool);
+	~AssetManager();
+
+	AssetManager(const AssetManager& rhs) = delete;
+	AssetManager& operator=(const AssetManager& rhs) = delete;
+
+	Handle Load(const std::string& name, std::function<bool()> load, std::function<void()> finish = nullptr);
+
+	// Runs finish for every load that completed since the last call.
+	// Returns the number of assets that became Ready.
+	std::size_t Update();
+
+	State GetState(Handle handle)const;
+	bool IsReady(Handle handle)const;
+	std::string GetName(Handle handle)const;
+	Stats GetStats()const;
+
+	// True once nothing is pending, loading or waiting for Update.
+	bool IsIdle()const;
+
+	// Blocks until no load is pending or running.  finish still needs Update.
+	void Wait();
+
+private:
+	struct Asset
+	{
+		std::string Name;
+		State Status = State::Pending;
+		std::function<void()> Finish;
+	};
+
+	void RunLoad(Handle handle, const std::function<bool()>& load);
+
+private:
+	ThreadPool& mThreadPool;
+
+	mutable std::mutex mMutex;
+	std::condition_variable mLoadsDone;
+
+	// mAssets[handle - 1]
+	std::vector<Asset> mAssets;
+	std::vector<Handle> mLoaded;
+
+	std::size_t mQueuedLoads = 0;	// Pending + Loading
+	bool mStop = false;
+};
+
+#endif // ASSETMANAGER_H
@@ -0,0 +1,106 @@
+#include "BakedClip.h"
+#include <algorithm>
+#include <cassert>
+
+using namespace DirectX;
+
+void BakedClip::Allocate(std::size_t boneCount, std::size_t frameCount, float startTime, float endTime)
+{
+	assert(frameCount >= 2 && endTime > startTime);
+
+	mBoneCount = boneCount;
+	mFrameCount = frameCount;
+	mStartTime = startTime;
+	mEndTime = endTime;
+	mFramesPerSecond = (frameCount - 1) / (endTime - startTime);
+
+	mRows.assign(frameCount * boneCount * RowCount, XMFLOAT4A(0.0f, 0.0f, 0.0f, 0.0f));
+}
+
+void BakedClip::Clear()
+{
+	mBoneCount = 0;
+	mFrameCount = 0;
+	mStartTime = mEndTime = mFramesPerSecond = 0.0f;
+
+	// Release the memory, not just the size.
+	std::vector<XMFLOAT4A>().swap(mRows);
+}
+
+bool BakedClip::IsEmpty()const
+{
+	return mFrameCount == 0;
+}
+
+std::size_t BakedClip::BoneCount()const
+{
+	return mBoneCount;
+}
+
+std::size_t BakedClip::FrameCount()const
+{
+	return mFrameCount;
+}
+
+std::size_t BakedClip::GetByteSize()const
+{
+	return mRows.size() * sizeof(XMFLOAT4A);
+}
+
+float BakedClip::GetStartTime()const
+{
+	return mStartTime;
+}
+
+float BakedClip::GetEndTime()const
+{
+	return mEndTime;
+}
+
+float BakedClip::GetFrameTime(std::size_t frame)const
+{
+	// The last frame is exactly the clip end.
+	return frame + 1 < mFrameCount ? mStartTime + frame / mFramesPerSecond : mEndTime;
+}
+
+void BakedClip::SetFrame(std::size_t frame, const XMFLOAT4X4* palette)
+{
+	assert(frame < mFrameCount);
+
+	XMFLOAT4A* rows = &mRows[frame * mBoneCount * RowCount];
+	for(std::size_t bone = 0; bone < mBoneCount; ++bone)
+	{
+		const XMMATRIX M = XMLoadFloat4x4(&palette[bone]);
+		for(std::size_t row = 0; row < RowCount; ++row)
+			XMStoreFloat4A(&rows[bone * RowCount + row], M.r[row]);
+	}
+}
+
+void BakedClip::Sample(float t, XMFLOAT4X4* palette)const
+{
+	assert(!IsEmpty());
+
+	// Frames are evenly spaced: the frame index is just the scaled time.
+	const float position = std::min(std::max((t - mStartTime) * mFramesPerSecond, 0.0f), (float)(mFrameCount - 1));
+	const std::size_t frame0 = std::min((std::size_t)position, mFrameCount - 1);
+	const XMVECTOR s = XMVectorReplicate(position - frame0);
+
+	// On a frame s is 0 and the lerp returns it unchanged; that holds for
+	// the last frame too, which is lerped with itself.
+	const XMFLOAT4A* rows0 = &mRows[frame0 * mBoneCount * RowCount];
+	const XMFLOAT4A* rows1 = frame0 + 1 < mFrameCount ? rows0 + mBoneCount * RowCount : rows0;
+	const XMVECTOR lastRow = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
+
+	for(std::size_t bone = 0; bone < mBoneCount; ++bone)
+	{
+		XMMATRIX M;
+		for(std::size_t row = 0; row < RowCount; ++row)
+		{
+			const std::size_t i = bone * RowCount + row;
+			M.r[row] = XMVectorLerpV(XMLoadFloat4A(&rows0[i]), XMLoadFloat4A(&rows1[i]), s);
+		}
+		M.r[3] = lastRow;
+
+		XMStoreFloat4x4(&palette[bone], M);
+	}
+}
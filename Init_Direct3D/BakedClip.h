@@ -0,0 +1,64 @@
+#ifndef BAKEDCLIP_H
+#define BAKEDCLIP_H
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <vector>
+
+///<summary>
+/// Final palettes of one clip, sampled at a fixed rate.
+///
+/// Each frame holds the BoneCount final transforms of the clip at that
+/// time, in the transposed constant buffer layout SkinnedData::GetFinalTransforms
+/// writes.  Only the first three rows are kept; the last row of an affine
+/// transform is always (0, 0, 0, 1).  Frames are spaced evenly from the
+/// clip start to the clip end, so sampling finds the two frames around t
+/// directly and lerps them: no keyframe search and no hierarchy pass.
+///
+/// The lerp is per matrix element, which slightly shrinks rotations
+/// halfway between frames; a higher rate trades memory for less error.
+/// SkinnedData::BakeClips fills these and reports both.
+///</summary>
+class BakedClip
+{
+public:
+	struct Report
+	{
+		float SampleRate = 0.0f;			// frames per second actually used (>= the requested rate)
+		std::size_t FrameCount = 0;
+		std::size_t ByteSize = 0;
+		float MaxBonePositionError = 0.0f;	// against the keyframes, between frames
+	};
+
+	// frameCount frames (at least 2) evenly spaced from startTime to endTime.
+	void Allocate(std::size_t boneCount, std::size_t frameCount, float startTime, float endTime);
+	void Clear();
+
+	bool IsEmpty()const;
+	std::size_t BoneCount()const;
+	std::size_t FrameCount()const;
+	std::size_t GetByteSize()const;
+	float GetStartTime()const;
+	float GetEndTime()const;
+	float GetFrameTime(std::size_t frame)const;
+
+	// Stores BoneCount palette matrices as frame.
+	void SetFrame(std::size_t frame, const DirectX::XMFLOAT4X4* palette);
+
+	// Writes BoneCount palette matrices at t, clamped to the clip.
+	void Sample(float t, DirectX::XMFLOAT4X4* palette)const;
+
+private:
+	static constexpr std::size_t RowCount = 3;
+
+	std::size_t mBoneCount = 0;
+	std::size_t mFrameCount = 0;
+	float mStartTime = 0.0f;
+	float mEndTime = 0.0f;
+	float mFramesPerSecond = 0.0f;
+
+	// mRows[(frame * mBoneCount + bone) * RowCount + row]
+	std::vector<DirectX::XMFLOAT4A> mRows;
+};
+
+#endif // BAKEDCLIP_H
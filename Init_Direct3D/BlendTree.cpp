@@ -0,0 +1,240 @@
+#include "BlendTree.h"
+#include <cassert>
+#include <cmath>
+
+using namespace DirectX;
+
+BlendTree::SourceId BlendTree::AddSource(SkinnedData::ClipHandle clip, float startTime, float speed, bool loop)
+{
+	Source source;
+	source.Clip = clip;
+	source.Time = startTime;
+	source.Speed = speed;
+	source.Loop = loop;
+
+	mSources.push_back(std::move(source));
+	return (SourceId)mSources.size() - 1;
+}
+
+BlendTree::NodeId BlendTree::AddClip(SourceId source)
+{
+	assert(source < mSources.size());
+
+	Node node;
+	node.Type = NodeType::Clip;
+	node.Source = source;
+
+	mNodes.push_back(std::move(node));
+	mRoot = (NodeId)mNodes.size() - 1;
+	return mRoot;
+}
+
+BlendTree::NodeId BlendTree::AddBlend(NodeId a, NodeId b, float weight)
+{
+	assert(a < mNodes.size() && b < mNodes.size());
+
+	Node node;
+	node.Type = NodeType::Blend;
+	node.Inputs[0] = a;
+	node.Inputs[1] = b;
+	node.Weight = node.FadeTarget = weight;
+
+	mNodes.push_back(std::move(node));
+	mRoot = (NodeId)mNodes.size() - 1;
+	return mRoot;
+}
+
+BlendTree::NodeId BlendTree::AddLayer(NodeId base, NodeId layer, const std::vector<float>& boneMask, float weight)
+{
+	assert(base < mNodes.size() && layer < mNodes.size());
+
+	Node node;
+	node.Type = NodeType::Layer;
+	node.Inputs[0] = base;
+	node.Inputs[1] = layer;
+	node.Weight = node.FadeTarget = weight;
+
+	// Same lanes as the pose: bone i is lane i % 4 of vector i / 4.
+	node.BoneWeights.assign((boneMask.size() + 3) / 4, XMFLOAT4A(0.0f, 0.0f, 0.0f, 0.0f));
+	for(std::size_t bone = 0; bone < boneMask.size(); ++bone)
+		(&node.BoneWeights[bone / 4].x)[bone % 4] = boneMask[bone];
+
+	mNodes.push_back(std::move(node));
+	mRoot = (NodeId)mNodes.size() - 1;
+	return mRoot;
+}
+
+void BlendTree::SetRoot(NodeId node)
+{
+	assert(node < mNodes.size());
+	mRoot = node;
+}
+
+void BlendTree::SetSourceTime(SourceId source, float time)
+{
+	mSources[source].Time = time;
+}
+
+float BlendTree::GetSourceTime(SourceId source)const
+{
+	return mSources[source].Time;
+}
+
+void BlendTree::SetWeight(NodeId node, float weight)
+{
+	mNodes[node].Weight = mNodes[node].FadeTarget = weight;
+	mNodes[node].FadeRate = 0.0f;
+}
+
+void BlendTree::FadeWeight(NodeId node, float target, float duration)
+{
+	Node& n = mNodes[node];
+	if(duration <= 0.0f)
+	{
+		SetWeight(node, target);
+		return;
+	}
+
+	n.FadeTarget = target;
+	n.FadeRate = fabsf(target - n.Weight) / duration;
+}
+
+float BlendTree::GetWeight(NodeId node)const
+{
+	return mNodes[node].Weight;
+}
+
+void BlendTree::Advance(const SkinnedData& skinnedData, float dt)
+{
+	for(Source& source : mSources)
+	{
+		const float startTime = skinnedData.GetClipStartTime(source.Clip);
+		const float endTime = skinnedData.GetClipEndTime(source.Clip);
+
+		// A negative speed plays backwards and leaves through the start instead.
+		source.Time += dt * source.Speed;
+		if(source.Time > endTime || source.Time < startTime)
+		{
+			const float length = endTime - startTime;
+			if(source.Loop && length > 0.0f)
+			{
+				float offset = fmodf(source.Time - startTime, length);
+				if(offset < 0.0f)
+					offset += length;
+				source.Time = startTime + offset;
+			}
+			else
+			{
+				source.Time = source.Time > endTime ? endTime : startTime;
+			}
+		}
+	}
+
+	for(Node& node : mNodes)
+	{
+		if(node.FadeRate == 0.0f)
+			continue;
+
+		const float step = node.FadeRate * dt;
+		if(fabsf(node.FadeTarget - node.Weight) <= step)
+		{
+			node.Weight = node.FadeTarget;
+			node.FadeRate = 0.0f;
+		}
+		else
+		{
+			node.Weight += node.FadeTarget > node.Weight ? step : -step;
+		}
+	}
+}
+
+void BlendTree::Evaluate(const SkinnedData& skinnedData, XMFLOAT4X4* palette, SkinnedData::EvalScratch& scratch)
+{
+	assert(mRoot < mNodes.size());
+
+	// A new frame stamp invalidates every source's pose at once.
+	++mFrame;
+	mSampledSources = 0;
+	mTempPosesUsed = 0;
+
+	const XMFLOAT4A* pose = EvaluateNode(skinnedData, mRoot);
+
+	const UINT numBones = skinnedData.BoneCount();
+	if(scratch.ToParentTransforms.size() < numBones)
+		scratch.ToParentTransforms.resize(numBones);
+
+	CompiledClip::PoseToMatrices(pose, numBones, scratch.ToParentTransforms.data());
+	skinnedData.GetFinalTransforms(scratch.ToParentTransforms.data(), palette, scratch);
+}
+
+std::size_t BlendTree::GetSampledSourceCount()const
+{
+	return mSampledSources;
+}
+
+std::vector<float> BlendTree::MakeSubtreeMask(const SkinnedData& skinnedData, UINT bone)
+{
+	// Parents come before their children, so one pass marks the subtree.
+	std::vector<float> mask(skinnedData.BoneCount(), 0.0f);
+	mask[bone] = 1.0f;
+	for(UINT i = bone + 1; i < mask.size(); ++i)
+	{
+		const int parent = skinnedData.GetBoneParent(i);
+		if(parent >= 0 && mask[parent] > 0.0f)
+			mask[i] = 1.0f;
+	}
+
+	return mask;
+}
+
+const XMFLOAT4A* BlendTree::EvaluateNode(const SkinnedData& skinnedData, NodeId id)
+{
+	const Node& node = mNodes[id];
+	const std::size_t poseSize = CompiledClip::PoseSize(skinnedData.BoneCount());
+
+	if(node.Type == NodeType::Clip)
+	{
+		Source& source = mSources[node.Source];
+		if(source.SampledFrame != mFrame)
+		{
+			if(source.Pose.size() != poseSize)
+				source.Pose.resize(poseSize);
+
+			const CompiledClip* compiled = skinnedData.FindCompiledClip(source.Clip);
+			assert(compiled != nullptr);
+			compiled->SamplePose(source.Time, source.Pose.data(), source.Cursor);
+			source.SampledFrame = mFrame;
+			++mSampledSources;
+		}
+		return source.Pose.data();
+	}
+
+	// Only the side that contributes is evaluated.
+	if(node.Weight <= 0.0f)
+		return EvaluateNode(skinnedData, node.Inputs[0]);
+	if(node.Type == NodeType::Blend && node.Weight >= 1.0f)
+		return EvaluateNode(skinnedData, node.Inputs[1]);
+
+	const XMFLOAT4A* a = EvaluateNode(skinnedData, node.Inputs[0]);
+	const XMFLOAT4A* b = EvaluateNode(skinnedData, node.Inputs[1]);
+
+	assert(node.Type != NodeType::Layer || node.BoneWeights.size() * 4 >= skinnedData.BoneCount());
+
+	XMFLOAT4A* out = AllocateTempPose(poseSize);
+	const XMFLOAT4A* boneWeights = node.Type == NodeType::Layer ? node.BoneWeights.data() : nullptr;
+	CompiledClip::BlendPoses(a, b, boneWeights, MathHelper::Min(node.Weight, 1.0f), skinnedData.BoneCount(), out);
+	return out;
+}
+
+XMFLOAT4A* BlendTree::AllocateTempPose(std::size_t size)
+{
+	// The outer vector may grow, but the poses handed out keep their buffers.
+	if(mTempPosesUsed == mTempPoses.size())
+		mTempPoses.emplace_back();
+
+	std::vector<XMFLOAT4A>& pose = mTempPoses[mTempPosesUsed++];
+	if(pose.size() != size)
+		pose.resize(size);
+
+	return pose.data();
+}
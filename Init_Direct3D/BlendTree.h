@@ -0,0 +1,118 @@
+#ifndef BLENDTREE_H
+#define BLENDTREE_H
+
+#include "SkinnedData.h"
+#include <cstdint>
+#include <vector>
+
+///<summary>
+/// Blends several clips of one SkinnedData into a single pose.
+///
+/// Sources are playing clips (clip, time, speed).  Nodes form the tree: a
+/// Clip node plays a source, a Blend node cross-fades between two nodes
+/// and a Layer node blends a node over a base with a per-bone mask (e.g.
+/// upper body only).  Blending happens on local translation / scale /
+/// rotation, four bones per vector in the CompiledClip pose layout, and
+/// the hierarchy pass runs once on the result.
+///
+/// Evaluate only visits nodes that contribute: a blend at weight 0 or 1
+/// and a layer at weight 0 skip the unused side.  Each source reached is
+/// sampled once, however many nodes use it, so the cost follows the clips
+/// that are active rather than the size of the tree.
+///
+/// Sampling uses the compiled clips (nlerp between keys), so the
+/// SkinnedData needs UseCompiledClips(true).  One BlendTree per playing
+/// instance; it keeps the cursors and pose buffers of that instance.
+///</summary>
+class BlendTree
+{
+public:
+	typedef std::uint32_t SourceId;
+	typedef std::uint32_t NodeId;
+
+	SourceId AddSource(SkinnedData::ClipHandle clip, float startTime = 0.0f, float speed = 1.0f, bool loop = true);
+
+	NodeId AddClip(SourceId source);
+	// weight 0 is a, 1 is b.
+	NodeId AddBlend(NodeId a, NodeId b, float weight = 0.0f);
+	// boneMask holds one weight per bone (0 keeps base, 1 takes layer), scaled by weight.
+	NodeId AddLayer(NodeId base, NodeId layer, const std::vector<float>& boneMask, float weight = 1.0f);
+
+	// The last node added is the root unless set here.
+	void SetRoot(NodeId node);
+
+	void SetSourceTime(SourceId source, float time);
+	float GetSourceTime(SourceId source)const;
+
+	// Weight of a Blend or Layer node.  FadeWeight moves it linearly to
+	// target over duration seconds (in Advance).
+	void SetWeight(NodeId node, float weight);
+	void FadeWeight(NodeId node, float target, float duration);
+	float GetWeight(NodeId node)const;
+
+	// Advances every source and running fade.  A looping source wraps
+	// around the clip; the others stop at the clip end (or at the start
+	// when played backwards with a negative speed).
+	void Advance(const SkinnedData& skinnedData, float dt);
+
+	// Writes BoneCount final transforms, as SkinnedData::GetFinalTransforms does.
+	void Evaluate(const SkinnedData& skinnedData, DirectX::XMFLOAT4X4* palette, SkinnedData::EvalScratch& scratch);
+
+	// Sources sampled by the last Evaluate.
+	std::size_t GetSampledSourceCount()const;
+
+	// Mask for AddLayer: 1 for bone and every bone below it, 0 elsewhere.
+	static std::vector<float> MakeSubtreeMask(const SkinnedData& skinnedData, UINT bone);
+
+private:
+	enum class NodeType
+	{
+		Clip,
+		Blend,
+		Layer
+	};
+
+	struct Source
+	{
+		SkinnedData::ClipHandle Clip;
+		float Time = 0.0f;
+		float Speed = 1.0f;
+		bool Loop = true;
+
+		std::uint32_t Cursor = 0;
+		std::uint32_t SampledFrame = 0;			// mFrame of the last sample in Pose
+		std::vector<DirectX::XMFLOAT4A> Pose;
+	};
+
+	struct Node
+	{
+		NodeType Type = NodeType::Clip;
+		SourceId Source = 0;
+		NodeId Inputs[2] = {};
+
+		float Weight = 0.0f;
+		float FadeTarget = 0.0f;
+		float FadeRate = 0.0f;					// weight per second, 0 when not fading
+
+		// Layer: the mask in pose layout, one vector per group of four bones
+		std::vector<DirectX::XMFLOAT4A> BoneWeights;
+	};
+
+	// Pose of node; either a source's pose or one of mTempPoses.
+	const DirectX::XMFLOAT4A* EvaluateNode(const SkinnedData& skinnedData, NodeId node);
+	DirectX::XMFLOAT4A* AllocateTempPose(std::size_t size);
+
+private:
+	std::vector<Source> mSources;
+	std::vector<Node> mNodes;
+	NodeId mRoot = 0;
+
+	std::uint32_t mFrame = 0;
+	std::size_t mSampledSources = 0;
+
+	// Blend results, reused every Evaluate
+	std::vector<std::vector<DirectX::XMFLOAT4A>> mTempPoses;
+	std::size_t mTempPosesUsed = 0;
+};
+
+#endif // BLENDTREE_H
@@ -0,0 +1,457 @@
+#include "ClipCompressor.h"
+#include "SkinnedData.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+	const float QuantizeScale = 65535.0f;
+
+	// Smallest-three keeps 15 bits per component, in [-1/sqrt2, 1/sqrt2].
+	const float SmallestThreeScale = 32767.0f;
+	const float SmallestThreeRange = 0.70710678f;
+
+	std::uint16_t QuantizeUnit(float v)
+	{
+		v = MathHelper::Clamp(v, 0.0f, 1.0f);
+		return (std::uint16_t)(v * QuantizeScale + 0.5f);
+	}
+
+	float DequantizeUnit(std::uint16_t q)
+	{
+		return q / QuantizeScale;
+	}
+
+	// Angle of the rotation between a and b.  acos of the dot product loses
+	// too much precision near 1 for errors this small.
+	float RotationAngle(FXMVECTOR a, FXMVECTOR b)
+	{
+		XMVECTOR delta = XMQuaternionMultiply(XMQuaternionConjugate(a), b);
+		float sinHalf = XMVectorGetX(XMVector3Length(delta));
+		float cosHalf = fabsf(XMVectorGetW(delta));
+		return 2.0f * atan2f(sinHalf, cosHalf);
+	}
+
+	// One track component set (translation or scale) with its quantization range.
+	struct Range
+	{
+		float Min[3];
+		float Extent[3];
+		bool Constant;
+	};
+
+	Range ComputeRange(const std::vector<Keyframe>& keys, XMFLOAT3 Keyframe::* member, float error)
+	{
+		Range range;
+		float maxExtent = 0.0f;
+		for(int c = 0; c < 3; ++c)
+		{
+			float lo = MathHelper::Infinity;
+			float hi = -MathHelper::Infinity;
+			for(const Keyframe& key : keys)
+			{
+				const float v = (&(key.*member).x)[c];
+				lo = MathHelper::Min(lo, v);
+				hi = MathHelper::Max(hi, v);
+			}
+			range.Min[c] = lo;
+			range.Extent[c] = hi - lo;
+			maxExtent = MathHelper::Max(maxExtent, hi - lo);
+		}
+
+		// Within the error of its midpoint: store the midpoint once.
+		range.Constant = maxExtent <= error;
+		if(range.Constant)
+		{
+			for(int c = 0; c < 3; ++c)
+			{
+				range.Min[c] += range.Extent[c] * 0.5f;
+				range.Extent[c] = 0.0f;
+			}
+		}
+
+		return range;
+	}
+
+	void Quantize(const XMFLOAT3& v, const Range& range, std::uint16_t* q)
+	{
+		for(int c = 0; c < 3; ++c)
+		{
+			const float x = (&v.x)[c];
+			q[c] = range.Extent[c] > 0.0f ? QuantizeUnit((x - range.Min[c]) / range.Extent[c]) : 0;
+		}
+	}
+
+	XMFLOAT3 Dequantize(const std::uint16_t* q, const float* min, const float* extent)
+	{
+		return XMFLOAT3(
+			min[0] + DequantizeUnit(q[0]) * extent[0],
+			min[1] + DequantizeUnit(q[1]) * extent[1],
+			min[2] + DequantizeUnit(q[2]) * extent[2]);
+	}
+}
+
+void ClipCompressor::Compress(const AnimationClip& clip, const Settings& settings, CompressedClip& compressed, Report* report)
+{
+	compressed = CompressedClip();
+
+	compressed.mStartTime = clip.GetClipStartTime();
+	compressed.mDuration = MathHelper::Max(0.0f, clip.GetClipEndTime() - compressed.mStartTime);
+
+	Report result;
+
+	compressed.mBones.resize(clip.BoneAnimations.size());
+	for(std::size_t b = 0; b < clip.BoneAnimations.size(); ++b)
+	{
+		const std::vector<Keyframe>& keys = clip.BoneAnimations[b].Keyframes;
+		const std::size_t keyCount = keys.size();
+		CompressedClip::Bone& bone = compressed.mBones[b];
+
+		result.OriginalKeys += keyCount;
+		result.OriginalBytes += keyCount * sizeof(Keyframe);
+
+		if(keyCount == 0)
+			continue;
+
+		const Range translationRange = ComputeRange(keys, &Keyframe::Translation, settings.TranslationError);
+		const Range scaleRange = ComputeRange(keys, &Keyframe::Scale, settings.ScaleError);
+
+		// Quantize every key first, so key reduction measures the error of
+		// what is actually stored.
+		std::vector<std::uint16_t> times(keyCount);
+		std::vector<std::uint16_t> rotations(keyCount * 3);
+		std::vector<std::uint16_t> translations(keyCount * 3);
+		std::vector<std::uint16_t> scales(keyCount * 3);
+		std::vector<Keyframe> decoded(keyCount);
+
+		for(std::size_t k = 0; k < keyCount; ++k)
+		{
+			const float time = compressed.mDuration > 0.0f ? (keys[k].TimePos - compressed.mStartTime) / compressed.mDuration : 0.0f;
+			times[k] = QuantizeUnit(time);
+			CompressedClip::EncodeRotation(keys[k].RotationQuat, &rotations[k * 3]);
+			Quantize(keys[k].Translation, translationRange, &translations[k * 3]);
+			Quantize(keys[k].Scale, scaleRange, &scales[k * 3]);
+
+			decoded[k].TimePos = compressed.mStartTime + DequantizeUnit(times[k]) * compressed.mDuration;
+			decoded[k].RotationQuat = CompressedClip::DecodeRotation(&rotations[k * 3]);
+			decoded[k].Translation = Dequantize(&translations[k * 3], translationRange.Min, translationRange.Extent);
+			decoded[k].Scale = Dequantize(&scales[k * 3], scaleRange.Min, scaleRange.Extent);
+		}
+
+		// Error of the stored keys a..e, interpolated at the time of original key k.
+		auto measure = [&](std::size_t a, std::size_t e, std::size_t k, float& translationError, float& rotationError, float& scaleError)
+		{
+			const float span = decoded[e].TimePos - decoded[a].TimePos;
+			const float s = span > 0.0f ? MathHelper::Clamp((keys[k].TimePos - decoded[a].TimePos) / span, 0.0f, 1.0f) : 0.0f;
+
+			XMVECTOR T = XMVectorLerp(XMLoadFloat3(&decoded[a].Translation), XMLoadFloat3(&decoded[e].Translation), s);
+			XMVECTOR S = XMVectorLerp(XMLoadFloat3(&decoded[a].Scale), XMLoadFloat3(&decoded[e].Scale), s);
+			XMVECTOR Q = XMQuaternionSlerp(XMLoadFloat4(&decoded[a].RotationQuat), XMLoadFloat4(&decoded[e].RotationQuat), s);
+
+			translationError = XMVectorGetX(XMVector3Length(XMVectorSubtract(T, XMLoadFloat3(&keys[k].Translation))));
+			scaleError = XMVectorGetX(XMVector3Length(XMVectorSubtract(S, XMLoadFloat3(&keys[k].Scale))));
+			rotationError = RotationAngle(Q, XMLoadFloat4(&keys[k].RotationQuat));
+		};
+
+		auto fits = [&](std::size_t a, std::size_t e)
+		{
+			for(std::size_t k = a + 1; k < e; ++k)
+			{
+				float translationError, rotationError, scaleError;
+				measure(a, e, k, translationError, rotationError, scaleError);
+
+				if(translationError > settings.TranslationError || rotationError > settings.RotationError || scaleError > settings.ScaleError)
+					return false;
+			}
+			return true;
+		};
+
+		// Greedy: grow each segment until a key in between no longer fits.
+		std::vector<std::size_t> kept;
+		kept.push_back(0);
+
+		std::size_t anchor = 0;
+		for(std::size_t end = 2; end < keyCount; ++end)
+		{
+			if(!fits(anchor, end))
+			{
+				kept.push_back(end - 1);
+				anchor = end - 1;
+			}
+		}
+		if(keyCount > 1)
+			kept.push_back(keyCount - 1);
+
+		// A bone that never moves keeps a single key.
+		if(kept.size() == 2)
+		{
+			bool still = true;
+			for(std::size_t k = 1; k < keyCount && still; ++k)
+			{
+				float translationError, rotationError, scaleError;
+				measure(0, 0, k, translationError, rotationError, scaleError);
+				still = translationError <= settings.TranslationError && rotationError <= settings.RotationError && scaleError <= settings.ScaleError;
+			}
+			if(still)
+				kept.resize(1);
+		}
+
+		// Report the error of every original key against the kept ones.
+		for(std::size_t i = 0; i < kept.size(); ++i)
+		{
+			const std::size_t a = kept[i];
+			const std::size_t e = i + 1 < kept.size() ? kept[i + 1] : a;
+			const std::size_t last = i + 1 < kept.size() ? e : keyCount - 1;
+			for(std::size_t k = a; k <= last; ++k)
+			{
+				float translationError, rotationError, scaleError;
+				measure(a, e, k, translationError, rotationError, scaleError);
+
+				result.MaxTranslationError = MathHelper::Max(result.MaxTranslationError, translationError);
+				result.MaxRotationError = MathHelper::Max(result.MaxRotationError, rotationError);
+				result.MaxScaleError = MathHelper::Max(result.MaxScaleError, scaleError);
+			}
+		}
+
+		// Store the kept keys.
+		bone.FirstKey = (std::uint32_t)compressed.mTimes.size();
+		bone.KeyCount = (std::uint32_t)kept.size();
+		bone.FirstTranslation = (std::uint32_t)compressed.mTranslations.size();
+		bone.FirstScale = (std::uint32_t)compressed.mScales.size();
+		bone.Flags = (translationRange.Constant ? CompressedClip::ConstantTranslation : 0) | (scaleRange.Constant ? CompressedClip::ConstantScale : 0);
+
+		for(int c = 0; c < 3; ++c)
+		{
+			bone.TranslationMin[c] = translationRange.Min[c];
+			bone.TranslationExtent[c] = translationRange.Extent[c];
+			bone.ScaleMin[c] = scaleRange.Min[c];
+			bone.ScaleExtent[c] = scaleRange.Extent[c];
+		}
+
+		for(std::size_t k : kept)
+		{
+			compressed.mTimes.push_back(times[k]);
+			compressed.mRotations.insert(compressed.mRotations.end(), &rotations[k * 3], &rotations[k * 3] + 3);
+
+			if(!translationRange.Constant)
+				compressed.mTranslations.insert(compressed.mTranslations.end(), &translations[k * 3], &translations[k * 3] + 3);
+			if(!scaleRange.Constant)
+				compressed.mScales.insert(compressed.mScales.end(), &scales[k * 3], &scales[k * 3] + 3);
+		}
+
+		result.CompressedKeys += kept.size();
+	}
+
+	compressed.mTimes.shrink_to_fit();
+	compressed.mRotations.shrink_to_fit();
+	compressed.mTranslations.shrink_to_fit();
+	compressed.mScales.shrink_to_fit();
+
+	result.CompressedBytes = compressed.SizeInBytes();
+	if(report != nullptr)
+		*report = result;
+}
+
+void CompressedClip::Decompress(AnimationClip& clip)const
+{
+	clip.BoneAnimations.assign(mBones.size(), BoneAnimation());
+	for(std::size_t b = 0; b < mBones.size(); ++b)
+	{
+		const Bone& bone = mBones[b];
+		std::vector<Keyframe>& keys = clip.BoneAnimations[b].Keyframes;
+		keys.resize(bone.KeyCount);
+
+		for(std::uint32_t k = 0; k < bone.KeyCount; ++k)
+			DecodeKey(bone, k, keys[k]);
+	}
+}
+
+float CompressedClip::KeyTime(std::size_t key)const
+{
+	return mStartTime + DequantizeUnit(mTimes[key]) * mDuration;
+}
+
+void CompressedClip::DecodeKey(const Bone& bone, std::uint32_t k, Keyframe& key)const
+{
+	const std::size_t index = bone.FirstKey + k;
+
+	key.TimePos = KeyTime(index);
+	key.RotationQuat = DecodeRotation(&mRotations[index * 3]);
+
+	if(bone.Flags & ConstantTranslation)
+		key.Translation = XMFLOAT3(bone.TranslationMin[0], bone.TranslationMin[1], bone.TranslationMin[2]);
+	else
+		key.Translation = Dequantize(&mTranslations[bone.FirstTranslation + k * 3], bone.TranslationMin, bone.TranslationExtent);
+
+	if(bone.Flags & ConstantScale)
+		key.Scale = XMFLOAT3(bone.ScaleMin[0], bone.ScaleMin[1], bone.ScaleMin[2]);
+	else
+		key.Scale = Dequantize(&mScales[bone.FirstScale + k * 3], bone.ScaleMin, bone.ScaleExtent);
+}
+
+std::uint32_t CompressedClip::FindKey(const Bone& bone, float t, std::uint32_t& cursor)const
+{
+	const std::uint32_t last = bone.KeyCount - 1;
+
+	// Forward playback: a few steps ahead from the last segment, as BoneAnimation::FindKeyframe.
+	const std::uint32_t maxSteps = 4;
+	if(cursor < last && KeyTime(bone.FirstKey + cursor) <= t)
+	{
+		for(std::uint32_t step = 0; step < maxSteps && cursor < last; ++step, ++cursor)
+		{
+			if(t < KeyTime(bone.FirstKey + cursor + 1))
+				return cursor;
+		}
+	}
+
+	// Key times only grow with their quantized value, so search those.
+	const std::uint16_t* first = &mTimes[bone.FirstKey];
+	const std::uint16_t* next = std::upper_bound(first, first + bone.KeyCount, t,
+		[this](float time, std::uint16_t q) { return time < mStartTime + DequantizeUnit(q) * mDuration; });
+
+	cursor = (std::uint32_t)(next - first) - 1;
+	return cursor;
+}
+
+void CompressedClip::Interpolate(std::size_t b, float t, Keyframe& key, std::uint32_t& cursor)const
+{
+	const Bone& bone = mBones[b];
+	assert(bone.KeyCount > 0);
+
+	// Same cases and math as BoneAnimation::Interpolate on the decoded keys.
+	const std::uint32_t last = bone.KeyCount - 1;
+	if(t <= KeyTime(bone.FirstKey))
+	{
+		DecodeKey(bone, 0, key);
+		cursor = 0;
+	}
+	else if(t >= KeyTime(bone.FirstKey + last))
+	{
+		DecodeKey(bone, last, key);
+	}
+	else
+	{
+		const std::uint32_t i = FindKey(bone, t, cursor);
+
+		Keyframe key0;
+		Keyframe key1;
+		DecodeKey(bone, i, key0);
+		DecodeKey(bone, i + 1, key1);
+
+		float lerpPercent = (t - key0.TimePos) / (key1.TimePos - key0.TimePos);
+
+		XMStoreFloat3(&key.Scale, XMVectorLerp(XMLoadFloat3(&key0.Scale), XMLoadFloat3(&key1.Scale), lerpPercent));
+		XMStoreFloat3(&key.Translation, XMVectorLerp(XMLoadFloat3(&key0.Translation), XMLoadFloat3(&key1.Translation), lerpPercent));
+		XMStoreFloat4(&key.RotationQuat, XMQuaternionSlerp(XMLoadFloat4(&key0.RotationQuat), XMLoadFloat4(&key1.RotationQuat), lerpPercent));
+	}
+
+	key.TimePos = t;
+}
+
+void CompressedClip::Interpolate(std::size_t bone, float t, XMFLOAT4X4& M, std::uint32_t& cursor)const
+{
+	Keyframe key;
+	Interpolate(bone, t, key, cursor);
+
+	XMVECTOR S = XMLoadFloat3(&key.Scale);
+	XMVECTOR P = XMLoadFloat3(&key.Translation);
+	XMVECTOR Q = XMLoadFloat4(&key.RotationQuat);
+
+	XMVECTOR zero = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
+	XMStoreFloat4x4(&M, XMMatrixAffineTransformation(S, zero, Q, P));
+}
+
+float CompressedClip::GetStartTime()const
+{
+	float t = MathHelper::Infinity;
+	for(const Bone& bone : mBones)
+	{
+		if(bone.KeyCount > 0)
+			t = MathHelper::Min(t, KeyTime(bone.FirstKey));
+	}
+
+	return t;
+}
+
+float CompressedClip::GetEndTime()const
+{
+	float t = 0.0f;
+	for(const Bone& bone : mBones)
+	{
+		if(bone.KeyCount > 0)
+			t = MathHelper::Max(t, KeyTime(bone.FirstKey + bone.KeyCount - 1));
+	}
+
+	return t;
+}
+
+std::size_t CompressedClip::BoneCount()const
+{
+	return mBones.size();
+}
+
+std::size_t CompressedClip::KeyCount()const
+{
+	return mTimes.size();
+}
+
+std::size_t CompressedClip::SizeInBytes()const
+{
+	return sizeof(mStartTime) + sizeof(mDuration) +
+		mBones.size() * sizeof(Bone) +
+		(mTimes.size() + mRotations.size() + mTranslations.size() + mScales.size()) * sizeof(std::uint16_t);
+}
+
+void CompressedClip::EncodeRotation(const XMFLOAT4& rotation, std::uint16_t* encoded)
+{
+	float q[4] = { rotation.x, rotation.y, rotation.z, rotation.w };
+
+	int largest = 0;
+	for(int i = 1; i < 4; ++i)
+	{
+		if(fabsf(q[i]) > fabsf(q[largest]))
+			largest = i;
+	}
+
+	// q and -q are the same rotation; make the dropped component positive.
+	const float sign = q[largest] < 0.0f ? -1.0f : 1.0f;
+
+	int slot = 0;
+	for(int i = 0; i < 4; ++i)
+	{
+		if(i == largest)
+			continue;
+
+		float v = (sign * q[i] / SmallestThreeRange + 1.0f) * 0.5f;
+		v = MathHelper::Clamp(v, 0.0f, 1.0f);
+		encoded[slot++] = (std::uint16_t)(v * SmallestThreeScale + 0.5f);
+	}
+
+	// Index of the dropped component in the two spare top bits.
+	encoded[0] |= (std::uint16_t)((largest & 1) << 15);
+	encoded[1] |= (std::uint16_t)((largest >> 1) << 15);
+}
+
+XMFLOAT4 CompressedClip::DecodeRotation(const std::uint16_t* encoded)
+{
+	const int largest = (encoded[0] >> 15) | ((encoded[1] >> 15) << 1);
+
+	float q[4];
+	float sumSq = 0.0f;
+	int slot = 0;
+	for(int i = 0; i < 4; ++i)
+	{
+		if(i == largest)
+			continue;
+
+		float v = (encoded[slot++] & 0x7fff) / SmallestThreeScale;
+		q[i] = (v * 2.0f - 1.0f) * SmallestThreeRange;
+		sumSq += q[i] * q[i];
+	}
+	q[largest] = sqrtf(MathHelper::Max(0.0f, 1.0f - sumSq));
+
+	return XMFLOAT4(q[0], q[1], q[2], q[3]);
+}
@@ -0,0 +1,127 @@
+#ifndef CLIPCOMPRESSOR_H
+#define CLIPCOMPRESSOR_H
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct AnimationClip;
+struct Keyframe;
+
+///<summary>
+/// AnimationClip in compressed form.  Per key it stores a 16 bit time, the
+/// rotation as smallest-three (48 bits) and translation / scale as 16 bit
+/// values inside a per-bone range.  A translation or scale track that does
+/// not change is stored once per bone instead of per key.
+///
+/// Interpolate samples the stored keys directly, dequantizing only the two
+/// keys around t, and gives the same result as BoneAnimation::Interpolate
+/// on the decompressed clip; SkinnedData::CompressClips keeps clips in this
+/// form.  Decompress rebuilds an AnimationClip with the kept keys, e.g. to
+/// compile it.
+///</summary>
+class CompressedClip
+{
+public:
+	void Decompress(AnimationClip& clip)const;
+
+	std::size_t BoneCount()const;
+	std::size_t KeyCount()const;
+	std::size_t SizeInBytes()const;
+
+	// Same as AnimationClip::GetClipStartTime / GetClipEndTime of the decompressed clip.
+	float GetStartTime()const;
+	float GetEndTime()const;
+
+	// cursor is the kept-key segment the previous call for this bone ended
+	// in, as in BoneAnimation::Interpolate.
+	void Interpolate(std::size_t bone, float t, Keyframe& key, std::uint32_t& cursor)const;
+	void Interpolate(std::size_t bone, float t, DirectX::XMFLOAT4X4& M, std::uint32_t& cursor)const;
+
+	// Smallest-three: the largest component is dropped (made positive, as q
+	// and -q are the same rotation), the other three keep 15 bits each and
+	// the two spare top bits hold the index of the dropped one.
+	static void EncodeRotation(const DirectX::XMFLOAT4& rotation, std::uint16_t* encoded);
+	static DirectX::XMFLOAT4 DecodeRotation(const std::uint16_t* encoded);
+
+private:
+	friend class ClipCompressor;
+
+	enum BoneFlags : std::uint8_t
+	{
+		ConstantTranslation = 1,
+		ConstantScale = 2
+	};
+
+	struct Bone
+	{
+		std::uint32_t FirstKey = 0;
+		std::uint32_t KeyCount = 0;
+		std::uint32_t FirstTranslation = 0;		// into mTranslations, 3 values per key (or one key if constant)
+		std::uint32_t FirstScale = 0;			// into mScales, same as above
+		std::uint8_t Flags = 0;
+
+		// Dequantized value = Min + q / 65535 * Extent
+		float TranslationMin[3] = {};
+		float TranslationExtent[3] = {};
+		float ScaleMin[3] = {};
+		float ScaleExtent[3] = {};
+	};
+
+	float KeyTime(std::size_t key)const;
+	void DecodeKey(const Bone& bone, std::uint32_t k, Keyframe& key)const;
+
+	// Index i of the kept key with time <= t < the next one, t strictly inside the bone's keys.
+	std::uint32_t FindKey(const Bone& bone, float t, std::uint32_t& cursor)const;
+
+private:
+	float mStartTime = 0.0f;
+	float mDuration = 0.0f;
+
+	std::vector<Bone> mBones;
+	std::vector<std::uint16_t> mTimes;			// one per key
+	std::vector<std::uint16_t> mRotations;		// three per key
+	std::vector<std::uint16_t> mTranslations;
+	std::vector<std::uint16_t> mScales;
+};
+
+///<summary>
+/// Builds a CompressedClip.  Every bone keeps its first and last key; a key
+/// in between is dropped when interpolating the kept neighbours (using the
+/// quantized values) reproduces it within the error limits, so the limits
+/// cover both key reduction and quantization.
+///</summary>
+class ClipCompressor
+{
+public:
+	struct Settings
+	{
+		float TranslationError = 1e-3f;		// position units
+		float RotationError = 1e-3f;		// radians
+		float ScaleError = 1e-3f;
+	};
+
+	struct Report
+	{
+		std::size_t OriginalKeys = 0;
+		std::size_t CompressedKeys = 0;
+		std::size_t OriginalBytes = 0;		// Keyframe data
+		std::size_t CompressedBytes = 0;
+
+		// Largest local (to-parent) error at the original key times
+		float MaxTranslationError = 0.0f;
+		float MaxRotationError = 0.0f;		// radians
+		float MaxScaleError = 0.0f;
+
+		// Largest bone position error in model space, sampled at 60 Hz.
+		// Needs the bone hierarchy, so only SkinnedData::CompressClips fills it in.
+		float MaxBonePositionError = 0.0f;
+
+		float Ratio()const { return CompressedBytes > 0 ? (float)OriginalBytes / CompressedBytes : 0.0f; }
+	};
+
+	static void Compress(const AnimationClip& clip, const Settings& settings, CompressedClip& compressed, Report* report = nullptr);
+};
+
+#endif // CLIPCOMPRESSOR_H
@@ -16,6 +16,35 @@ struct VertexIn
 #endif
 };
 
+#ifdef PACKED
+//   Է (BuildPackedInputLayout)
+struct PackedVertexIn
+{
+    float4 PosL         : POSITION; // snorm16
+    float2 NormalL      : NORMAL;   // 8ü ڵ
+    float2 Uv           : TEXCOORD; // half
+    float2 Tangent      : TANGENT;  // 8ü ڵ
+#ifdef SKINNED
+    float3 BoneWeights  : WEIGHTS;  // unorm8
+    uint4 BoneIndices   : BONEINDICES;
+#endif
+};
+
+VertexIn UnpackVertex(PackedVertexIn pin)
+{
+    VertexIn vin;
+    vin.PosL = UnpackPosition(pin.PosL.xyz);
+    vin.NormalL = UnpackUnitVector(pin.NormalL);
+    vin.Uv = float3(pin.Uv, 0.0f);
+    vin.Tangent = UnpackUnitVector(pin.Tangent);
+#ifdef SKINNED
+    vin.BoneWeights = pin.BoneWeights;
+    vin.BoneIndices = pin.BoneIndices;
+#endif
+    return vin;
+}
+#endif // PACKED
+
 struct VertexOut
 {
     float4 PosH         : SV_POSITION;
@@ -27,8 +56,14 @@ struct VertexOut
 };
 
 // Vertex Shader
+#ifdef PACKED
+VertexOut VS(PackedVertexIn pin)
+{
+    VertexIn vin = UnpackVertex(pin);
+#else
 VertexOut VS(VertexIn vin)
 {
+#endif
     VertexOut vout;
     
 #ifdef SKINNED
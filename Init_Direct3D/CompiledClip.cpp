@@ -0,0 +1,339 @@
+#include "CompiledClip.h"
+#include "SkinnedData.h"
+#include <algorithm>
+
+using namespace DirectX;
+
+void CompiledClip::Compile(const AnimationClip& clip)
+{
+	mBoneCount = clip.BoneAnimations.size();
+	mGroupCount = (mBoneCount + GroupSize - 1) / GroupSize;
+
+	// One time array for every bone: the union of all key times.  Each
+	// bone's own keys are in it, so its curve is reproduced exactly.
+	mTimes.clear();
+	for(const BoneAnimation& bone : clip.BoneAnimations)
+	{
+		for(const Keyframe& key : bone.Keyframes)
+			mTimes.push_back(key.TimePos);
+	}
+	std::sort(mTimes.begin(), mTimes.end());
+	mTimes.erase(std::unique(mTimes.begin(), mTimes.end()), mTimes.end());
+
+	// Lanes past the last bone keep an identity transform.
+	mKeys.assign(mTimes.size() * mGroupCount * ChannelCount, XMFLOAT4A(0.0f, 0.0f, 0.0f, 0.0f));
+	for(std::size_t frame = 0; frame < mTimes.size(); ++frame)
+	{
+		XMFLOAT4A* keys = &mKeys[frame * mGroupCount * ChannelCount];
+		for(std::size_t group = 0; group < mGroupCount; ++group)
+		{
+			XMFLOAT4A* channels = keys + group * ChannelCount;
+			channels[ScaleX] = channels[ScaleY] = channels[ScaleZ] = XMFLOAT4A(1.0f, 1.0f, 1.0f, 1.0f);
+			channels[RotationW] = XMFLOAT4A(1.0f, 1.0f, 1.0f, 1.0f);
+		}
+	}
+
+	for(std::size_t bone = 0; bone < mBoneCount; ++bone)
+	{
+		const BoneAnimation& animation = clip.BoneAnimations[bone];
+		if(animation.Keyframes.empty())
+			continue;
+
+		const std::size_t group = bone / GroupSize;
+		const std::size_t lane = bone % GroupSize;
+
+		UINT cursor = 0;
+		XMVECTOR previousQ = XMVectorZero();
+		for(std::size_t frame = 0; frame < mTimes.size(); ++frame)
+		{
+			Keyframe key;
+			animation.Interpolate(mTimes[frame], key, cursor);
+
+			// nlerp needs neighbouring keys in the same hemisphere.
+			XMVECTOR Q = XMLoadFloat4(&key.RotationQuat);
+			if(frame > 0 && XMVectorGetX(XMQuaternionDot(Q, previousQ)) < 0.0f)
+				Q = XMVectorNegate(Q);
+			previousQ = Q;
+			XMStoreFloat4(&key.RotationQuat, Q);
+
+			const float values[ChannelCount] =
+			{
+				key.Translation.x, key.Translation.y, key.Translation.z,
+				key.Scale.x, key.Scale.y, key.Scale.z,
+				key.RotationQuat.x, key.RotationQuat.y, key.RotationQuat.z, key.RotationQuat.w
+			};
+
+			XMFLOAT4A* channels = &mKeys[(frame * mGroupCount + group) * ChannelCount];
+			for(std::size_t channel = 0; channel < ChannelCount; ++channel)
+				(&channels[channel].x)[lane] = values[channel];
+		}
+	}
+}
+
+void CompiledClip::Clear()
+{
+	mBoneCount = 0;
+	mGroupCount = 0;
+
+	// Release the memory, not just the size.
+	std::vector<float>().swap(mTimes);
+	std::vector<XMFLOAT4A>().swap(mKeys);
+}
+
+bool CompiledClip::IsEmpty()const
+{
+	return mTimes.empty();
+}
+
+std::size_t CompiledClip::BoneCount()const
+{
+	return mBoneCount;
+}
+
+std::size_t CompiledClip::FrameCount()const
+{
+	return mTimes.size();
+}
+
+float CompiledClip::GetStartTime()const
+{
+	return mTimes.empty() ? 0.0f : mTimes.front();
+}
+
+float CompiledClip::GetEndTime()const
+{
+	return mTimes.empty() ? 0.0f : mTimes.back();
+}
+
+std::size_t CompiledClip::GetByteSize()const
+{
+	return mTimes.size() * sizeof(float) + mKeys.size() * sizeof(XMFLOAT4A);
+}
+
+std::uint32_t CompiledClip::FindFrame(float t, std::uint32_t& cursor)const
+{
+	const std::uint32_t last = (std::uint32_t)mTimes.size() - 1;
+
+	// Forward playback: walk ahead a few frames from the last one.
+	const std::uint32_t maxSteps = 4;
+	if(cursor < last && mTimes[cursor] <= t)
+	{
+		for(std::uint32_t step = 0; step < maxSteps && cursor < last; ++step, ++cursor)
+		{
+			if(t < mTimes[cursor + 1])
+				return cursor;
+		}
+	}
+
+	// Seek, loop or a large time step.
+	auto next = std::upper_bound(mTimes.begin(), mTimes.end(), t);
+	cursor = (std::uint32_t)(next - mTimes.begin()) - 1;
+	return cursor;
+}
+
+void CompiledClip::Locate(float t, std::uint32_t& cursor, std::size_t& frame0, std::size_t& frame1, float& lerpPercent)const
+{
+	frame0 = 0;
+	frame1 = 0;
+	lerpPercent = 0.0f;
+	if(t <= mTimes.front())
+	{
+		cursor = 0;
+	}
+	else if(t >= mTimes.back())
+	{
+		frame0 = frame1 = mTimes.size() - 1;
+	}
+	else
+	{
+		frame0 = FindFrame(t, cursor);
+		frame1 = frame0 + 1;
+		lerpPercent = (t - mTimes[frame0]) / (mTimes[frame1] - mTimes[frame0]);
+	}
+}
+
+void CompiledClip::LerpGroup(const XMFLOAT4A* channels0, const XMFLOAT4A* channels1, FXMVECTOR s, XMVECTOR* v)
+{
+	for(std::size_t channel = 0; channel < ChannelCount; ++channel)
+		v[channel] = XMVectorLerpV(XMLoadFloat4A(&channels0[channel]), XMLoadFloat4A(&channels1[channel]), s);
+}
+
+void CompiledClip::NormalizeRotations(XMVECTOR* v)
+{
+	// nlerp: normalize the lerped quaternions.
+	XMVECTOR lengthSq = XMVectorMultiply(v[RotationX], v[RotationX]);
+	lengthSq = XMVectorMultiplyAdd(v[RotationY], v[RotationY], lengthSq);
+	lengthSq = XMVectorMultiplyAdd(v[RotationZ], v[RotationZ], lengthSq);
+	lengthSq = XMVectorMultiplyAdd(v[RotationW], v[RotationW], lengthSq);
+	XMVECTOR invLength = XMVectorReciprocalSqrt(lengthSq);
+
+	v[RotationX] = XMVectorMultiply(v[RotationX], invLength);
+	v[RotationY] = XMVectorMultiply(v[RotationY], invLength);
+	v[RotationZ] = XMVectorMultiply(v[RotationZ], invLength);
+	v[RotationW] = XMVectorMultiply(v[RotationW], invLength);
+}
+
+void CompiledClip::StoreMatrices(const XMVECTOR* v, std::size_t count, XMFLOAT4X4* toParentTransforms)
+{
+	const XMVECTOR zero = XMVectorZero();
+	const XMVECTOR one = XMVectorSplatOne();
+
+	const XMVECTOR qx = v[RotationX];
+	const XMVECTOR qy = v[RotationY];
+	const XMVECTOR qz = v[RotationZ];
+	const XMVECTOR qw = v[RotationW];
+
+	// Scale * Rotation * Translation, as XMMatrixAffineTransformation
+	// builds it, one matrix element per vector.
+	XMVECTOR x2 = XMVectorAdd(qx, qx);
+	XMVECTOR y2 = XMVectorAdd(qy, qy);
+	XMVECTOR z2 = XMVectorAdd(qz, qz);
+
+	XMVECTOR xx = XMVectorMultiply(qx, x2);
+	XMVECTOR yy = XMVectorMultiply(qy, y2);
+	XMVECTOR zz = XMVectorMultiply(qz, z2);
+	XMVECTOR xy = XMVectorMultiply(qx, y2);
+	XMVECTOR xz = XMVectorMultiply(qx, z2);
+	XMVECTOR yz = XMVectorMultiply(qy, z2);
+	XMVECTOR wx = XMVectorMultiply(qw, x2);
+	XMVECTOR wy = XMVectorMultiply(qw, y2);
+	XMVECTOR wz = XMVectorMultiply(qw, z2);
+
+	XMVECTOR m00 = XMVectorMultiply(XMVectorSubtract(one, XMVectorAdd(yy, zz)), v[ScaleX]);
+	XMVECTOR m01 = XMVectorMultiply(XMVectorAdd(xy, wz), v[ScaleX]);
+	XMVECTOR m02 = XMVectorMultiply(XMVectorSubtract(xz, wy), v[ScaleX]);
+
+	XMVECTOR m10 = XMVectorMultiply(XMVectorSubtract(xy, wz), v[ScaleY]);
+	XMVECTOR m11 = XMVectorMultiply(XMVectorSubtract(one, XMVectorAdd(xx, zz)), v[ScaleY]);
+	XMVECTOR m12 = XMVectorMultiply(XMVectorAdd(yz, wx), v[ScaleY]);
+
+	XMVECTOR m20 = XMVectorMultiply(XMVectorAdd(xz, wy), v[ScaleZ]);
+	XMVECTOR m21 = XMVectorMultiply(XMVectorSubtract(yz, wx), v[ScaleZ]);
+	XMVECTOR m22 = XMVectorMultiply(XMVectorSubtract(one, XMVectorAdd(xx, yy)), v[ScaleZ]);
+
+	// Lanes back to bones: after the transposes, r[j] is a row of bone j.
+	XMMATRIX row0 = XMMatrixTranspose(XMMATRIX(m00, m01, m02, zero));
+	XMMATRIX row1 = XMMatrixTranspose(XMMATRIX(m10, m11, m12, zero));
+	XMMATRIX row2 = XMMatrixTranspose(XMMATRIX(m20, m21, m22, zero));
+	XMMATRIX row3 = XMMatrixTranspose(XMMATRIX(v[TranslationX], v[TranslationY], v[TranslationZ], one));
+
+	for(std::size_t lane = 0; lane < count; ++lane)
+		XMStoreFloat4x4(&toParentTransforms[lane], XMMATRIX(row0.r[lane], row1.r[lane], row2.r[lane], row3.r[lane]));
+}
+
+void CompiledClip::Sample(float t, XMFLOAT4X4* toParentTransforms, std::uint32_t& cursor)const
+{
+	if(mTimes.empty())
+		return;
+
+	// One keyframe search for the whole pose.
+	std::size_t frame0, frame1;
+	float lerpPercent;
+	Locate(t, cursor, frame0, frame1, lerpPercent);
+
+	const XMVECTOR s = XMVectorReplicate(lerpPercent);
+
+	const XMFLOAT4A* keys0 = &mKeys[frame0 * mGroupCount * ChannelCount];
+	const XMFLOAT4A* keys1 = &mKeys[frame1 * mGroupCount * ChannelCount];
+
+	for(std::size_t group = 0; group < mGroupCount; ++group)
+	{
+		// Four bones per operation from here on.
+		XMVECTOR v[ChannelCount];
+		LerpGroup(keys0 + group * ChannelCount, keys1 + group * ChannelCount, s, v);
+		NormalizeRotations(v);
+
+		const std::size_t first = group * GroupSize;
+		StoreMatrices(v, MathHelper::Min(GroupSize, mBoneCount - first), toParentTransforms + first);
+	}
+}
+
+std::size_t CompiledClip::PoseSize(std::size_t boneCount)
+{
+	return (boneCount + GroupSize - 1) / GroupSize * ChannelCount;
+}
+
+void CompiledClip::SamplePose(float t, XMFLOAT4A* pose, std::uint32_t& cursor)const
+{
+	if(mTimes.empty())
+		return;
+
+	std::size_t frame0, frame1;
+	float lerpPercent;
+	Locate(t, cursor, frame0, frame1, lerpPercent);
+
+	const XMVECTOR s = XMVectorReplicate(lerpPercent);
+
+	const XMFLOAT4A* keys0 = &mKeys[frame0 * mGroupCount * ChannelCount];
+	const XMFLOAT4A* keys1 = &mKeys[frame1 * mGroupCount * ChannelCount];
+
+	for(std::size_t group = 0; group < mGroupCount; ++group)
+	{
+		XMVECTOR v[ChannelCount];
+		LerpGroup(keys0 + group * ChannelCount, keys1 + group * ChannelCount, s, v);
+		NormalizeRotations(v);
+
+		XMFLOAT4A* channels = pose + group * ChannelCount;
+		for(std::size_t channel = 0; channel < ChannelCount; ++channel)
+			XMStoreFloat4A(&channels[channel], v[channel]);
+	}
+}
+
+void CompiledClip::BlendPoses(const XMFLOAT4A* a, const XMFLOAT4A* b, const XMFLOAT4A* boneWeights, float weight,
+	std::size_t boneCount, XMFLOAT4A* out)
+{
+	const std::size_t groupCount = (boneCount + GroupSize - 1) / GroupSize;
+	const XMVECTOR uniform = XMVectorReplicate(weight);
+
+	for(std::size_t group = 0; group < groupCount; ++group)
+	{
+		const XMFLOAT4A* channelsA = a + group * ChannelCount;
+		const XMFLOAT4A* channelsB = b + group * ChannelCount;
+
+		XMVECTOR s = uniform;
+		if(boneWeights != nullptr)
+			s = XMVectorMultiply(s, XMLoadFloat4A(&boneWeights[group]));
+
+		XMVECTOR va[ChannelCount];
+		XMVECTOR vb[ChannelCount];
+		for(std::size_t channel = 0; channel < ChannelCount; ++channel)
+		{
+			va[channel] = XMLoadFloat4A(&channelsA[channel]);
+			vb[channel] = XMLoadFloat4A(&channelsB[channel]);
+		}
+
+		// Blend the rotations the short way: flip b where the dot product is negative.
+		XMVECTOR dot = XMVectorMultiply(va[RotationX], vb[RotationX]);
+		dot = XMVectorMultiplyAdd(va[RotationY], vb[RotationY], dot);
+		dot = XMVectorMultiplyAdd(va[RotationZ], vb[RotationZ], dot);
+		dot = XMVectorMultiplyAdd(va[RotationW], vb[RotationW], dot);
+		XMVECTOR flip = XMVectorLess(dot, XMVectorZero());
+		for(std::size_t channel = RotationX; channel <= RotationW; ++channel)
+			vb[channel] = XMVectorSelect(vb[channel], XMVectorNegate(vb[channel]), flip);
+
+		XMVECTOR v[ChannelCount];
+		for(std::size_t channel = 0; channel < ChannelCount; ++channel)
+			v[channel] = XMVectorLerpV(va[channel], vb[channel], s);
+		NormalizeRotations(v);
+
+		XMFLOAT4A* channels = out + group * ChannelCount;
+		for(std::size_t channel = 0; channel < ChannelCount; ++channel)
+			XMStoreFloat4A(&channels[channel], v[channel]);
+	}
+}
+
+void CompiledClip::PoseToMatrices(const XMFLOAT4A* pose, std::size_t boneCount, XMFLOAT4X4* toParentTransforms)
+{
+	const std::size_t groupCount = (boneCount + GroupSize - 1) / GroupSize;
+	for(std::size_t group = 0; group < groupCount; ++group)
+	{
+		const XMFLOAT4A* channels = pose + group * ChannelCount;
+
+		XMVECTOR v[ChannelCount];
+		for(std::size_t channel = 0; channel < ChannelCount; ++channel)
+			v[channel] = XMLoadFloat4A(&channels[channel]);
+
+		const std::size_t first = group * GroupSize;
+		StoreMatrices(v, MathHelper::Min(GroupSize, boneCount - first), toParentTransforms + first);
+	}
+}
@@ -0,0 +1,93 @@
+#ifndef COMPILEDCLIP_H
+#define COMPILEDCLIP_H
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct AnimationClip;
+
+///<summary>
+/// AnimationClip resampled into a layout made for sampling whole poses.
+///
+/// Every bone is evaluated at the union of all key times of the clip, so
+/// all bones share one time array and one keyframe search per pose.  The
+/// keys of a frame are stored as structure of arrays: bones are packed
+/// four to a group and each group holds one vector per channel
+/// (translation xyz, scale xyz, rotation xyzw) with one bone per lane.
+/// Sampling lerps translation / scale and nlerps rotation for four bones
+/// per vector operation.
+///
+/// The union keeps translation and scale exact.  Rotation uses nlerp
+/// instead of slerp between keys, which is close for the small angles
+/// between neighbouring keys.  Quaternions are flipped at compile time so
+/// neighbouring keys are in the same hemisphere.
+///</summary>
+class CompiledClip
+{
+public:
+	void Compile(const AnimationClip& clip);
+	void Clear();
+
+	bool IsEmpty()const;
+	std::size_t BoneCount()const;
+	std::size_t FrameCount()const;
+	float GetStartTime()const;
+	float GetEndTime()const;
+	std::size_t GetByteSize()const;
+
+	// Writes BoneCount to-parent transforms (same layout as
+	// BoneAnimation::Interpolate).  cursor is the frame the previous call
+	// ended in; forward playback resumes from it, seeks binary search.
+	void Sample(float t, DirectX::XMFLOAT4X4* toParentTransforms, std::uint32_t& cursor)const;
+
+	// Local poses, for blending before the matrices are built.  A pose has
+	// PoseSize(BoneCount) vectors in the frame layout below; rotations are
+	// normalized.
+	static std::size_t PoseSize(std::size_t boneCount);
+	void SamplePose(float t, DirectX::XMFLOAT4A* pose, std::uint32_t& cursor)const;
+
+	// out = a blended toward b: lerp for translation / scale, nlerp (in the
+	// shorter direction) for rotation.  The weight of bone i is weight times
+	// lane i % 4 of boneWeights[i / 4], or just weight without boneWeights.
+	// out may be a or b.
+	static void BlendPoses(const DirectX::XMFLOAT4A* a, const DirectX::XMFLOAT4A* b,
+		const DirectX::XMFLOAT4A* boneWeights, float weight, std::size_t boneCount, DirectX::XMFLOAT4A* out);
+
+	// Same matrices Sample writes, built from a pose.
+	static void PoseToMatrices(const DirectX::XMFLOAT4A* pose, std::size_t boneCount, DirectX::XMFLOAT4X4* toParentTransforms);
+
+private:
+	// Index i with mTimes[i] <= t < mTimes[i+1], t strictly inside the clip.
+	std::uint32_t FindFrame(float t, std::uint32_t& cursor)const;
+
+	// Frames around t (clamped to the clip) and the lerp percent between them.
+	void Locate(float t, std::uint32_t& cursor, std::size_t& frame0, std::size_t& frame1, float& lerpPercent)const;
+
+	// One group, four bones per vector: v holds ChannelCount vectors.
+	static void LerpGroup(const DirectX::XMFLOAT4A* channels0, const DirectX::XMFLOAT4A* channels1, DirectX::FXMVECTOR s, DirectX::XMVECTOR* v);
+	static void NormalizeRotations(DirectX::XMVECTOR* v);
+	static void StoreMatrices(const DirectX::XMVECTOR* v, std::size_t count, DirectX::XMFLOAT4X4* toParentTransforms);
+
+	enum Channel
+	{
+		TranslationX, TranslationY, TranslationZ,
+		ScaleX, ScaleY, ScaleZ,
+		RotationX, RotationY, RotationZ, RotationW,
+		ChannelCount
+	};
+
+	static constexpr std::size_t GroupSize = 4;
+
+private:
+	std::size_t mBoneCount = 0;
+	std::size_t mGroupCount = 0;
+
+	std::vector<float> mTimes;
+
+	// mKeys[(frame * mGroupCount + group) * ChannelCount + channel], lane = bone % 4
+	std::vector<DirectX::XMFLOAT4A> mKeys;
+};
+
+#endif // COMPILEDCLIP_H
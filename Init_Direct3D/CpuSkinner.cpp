@@ -0,0 +1,85 @@
+#include "CpuSkinner.h"
+#include "ThreadPool.h"
+#include <cassert>
+#include <cstdint>
+
+using namespace DirectX;
+
+namespace
+{
+	const std::size_t ChunkSize = 1024;
+
+	void SkinRange(const std::uint8_t* vertices, std::size_t first, std::size_t last, const CpuSkinner::InputLayout& in,
+		const XMFLOAT4X4* palette, std::size_t boneCount, std::uint8_t* posed, const CpuSkinner::OutputLayout& out)
+	{
+		for(std::size_t i = first; i < last; ++i)
+		{
+			const std::uint8_t* v = vertices + i * in.Stride;
+			std::uint8_t* p = posed + i * out.Stride;
+
+			const XMFLOAT3& weights = *reinterpret_cast<const XMFLOAT3*>(v + in.BoneWeights);
+			const std::uint8_t* indices = v + in.BoneIndices;
+			const float w[4] = { weights.x, weights.y, weights.z, 1.0f - weights.x - weights.y - weights.z };
+
+			// Weighted sum of the (transposed) bone matrices: one blended
+			// transform instead of transforming every attribute four times.
+			XMMATRIX M;
+			M.r[0] = M.r[1] = M.r[2] = M.r[3] = XMVectorZero();
+			for(int j = 0; j < 4; ++j)
+			{
+				// The shader adds zero-weight bones too; skipping them gives the same sum.
+				if(w[j] == 0.0f)
+					continue;
+
+				assert(indices[j] < boneCount);
+				const XMMATRIX bone = XMLoadFloat4x4(&palette[indices[j]]);
+				const XMVECTOR weight = XMVectorReplicate(w[j]);
+				M.r[0] = XMVectorMultiplyAdd(bone.r[0], weight, M.r[0]);
+				M.r[1] = XMVectorMultiplyAdd(bone.r[1], weight, M.r[1]);
+				M.r[2] = XMVectorMultiplyAdd(bone.r[2], weight, M.r[2]);
+				M.r[3] = XMVectorMultiplyAdd(bone.r[3], weight, M.r[3]);
+			}
+			M = XMMatrixTranspose(M);
+
+			const XMVECTOR position = XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(v + in.Position));
+			XMStoreFloat3(reinterpret_cast<XMFLOAT3*>(p + out.Position), XMVector3Transform(position, M));
+
+			if(out.Normal != CpuSkinner::NoAttribute && in.Normal != CpuSkinner::NoAttribute)
+			{
+				const XMVECTOR normal = XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(v + in.Normal));
+				XMStoreFloat3(reinterpret_cast<XMFLOAT3*>(p + out.Normal), XMVector3TransformNormal(normal, M));
+			}
+
+			if(out.Tangent != CpuSkinner::NoAttribute && in.Tangent != CpuSkinner::NoAttribute)
+			{
+				const XMVECTOR tangent = XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(v + in.Tangent));
+				XMStoreFloat3(reinterpret_cast<XMFLOAT3*>(p + out.Tangent), XMVector3TransformNormal(tangent, M));
+			}
+		}
+	}
+}
+
+void CpuSkinner::Skin(const void* vertices, std::size_t vertexCount, const InputLayout& in,
+	const XMFLOAT4X4* palette, std::size_t boneCount,
+	void* posed, const OutputLayout& out, ThreadPool* pool)
+{
+	const std::uint8_t* src = static_cast<const std::uint8_t*>(vertices);
+	std::uint8_t* dst = static_cast<std::uint8_t*>(posed);
+
+	// Chunks write disjoint vertices, so they need no synchronization.
+	const std::size_t chunkCount = (vertexCount + ChunkSize - 1) / ChunkSize;
+	auto runChunk = [&](std::size_t chunk)
+	{
+		const std::size_t first = chunk * ChunkSize;
+		const std::size_t last = first + ChunkSize < vertexCount ? first + ChunkSize : vertexCount;
+		SkinRange(src, first, last, in, palette, boneCount, dst, out);
+	};
+
+	if(pool != nullptr && chunkCount > 1)
+		pool->ParallelFor(chunkCount, runChunk);
+	else
+	{
+		for(std::size_t chunk = 0; chunk < chunkCount; ++chunk)
+			runChunk(chunk);
+	}
+}
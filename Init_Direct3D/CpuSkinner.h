@@ -0,0 +1,57 @@
+#ifndef CPUSKINNER_H
+#define CPUSKINNER_H
+
+#include <DirectXMath.h>
+#include <cstddef>
+
+class ThreadPool;
+
+///<summary>
+/// Linear blend skinning on the CPU, the same math as the SKINNED vertex
+/// shaders: up to four bones per vertex, three stored weights and the
+/// fourth one 1 - (sum of the others), and normals / tangents transformed
+/// by the upper 3x3 without renormalizing.
+///
+/// The palette is the one SkinnedData::GetFinalTransforms writes for the
+/// constant buffer (transposed), so a pose can be checked or used without
+/// a GPU.  Per vertex the four bone matrices are blended first and the
+/// result is applied once to position, normal and tangent, with
+/// DirectXMath vector operations throughout.
+///
+/// Vertices are read and written through byte offsets, so any vertex
+/// struct works, e.g. SkinnedVertex in and the static Vertex out.  Output
+/// bytes not covered by the layout (uv, ...) are left untouched.  With a
+/// pool, vertices are split into fixed chunks that run in parallel.
+///</summary>
+class CpuSkinner
+{
+public:
+	static constexpr std::size_t NoAttribute = ~(std::size_t)0;
+
+	struct InputLayout
+	{
+		std::size_t Stride = 0;
+		std::size_t Position = 0;				// 3 floats
+		std::size_t Normal = NoAttribute;		// 3 floats
+		std::size_t Tangent = NoAttribute;		// 3 floats
+		std::size_t BoneWeights = 0;			// 3 floats
+		std::size_t BoneIndices = 0;			// 4 bytes
+	};
+
+	// NoAttribute skips the attribute (e.g. positions only for shadows).
+	struct OutputLayout
+	{
+		std::size_t Stride = 0;
+		std::size_t Position = 0;
+		std::size_t Normal = NoAttribute;
+		std::size_t Tangent = NoAttribute;
+	};
+
+	// Skins vertexCount vertices by palette (boneCount matrices).  Bone
+	// indices must be below boneCount.  posed must not overlap vertices.
+	static void Skin(const void* vertices, std::size_t vertexCount, const InputLayout& in,
+		const DirectX::XMFLOAT4X4* palette, std::size_t boneCount,
+		void* posed, const OutputLayout& out, ThreadPool* pool = nullptr);
+};
+
+#endif // CPUSKINNER_H
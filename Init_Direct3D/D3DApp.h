@@ -52,6 +52,9 @@ protected:
 	virtual void OnMouseUp(WPARAM btnState, int x, int y) { }
 	virtual void OnMouseMove(WPARAM btnState, int x, int y) { }
 
+	// Extra text appended to the window caption by CalculateFrameStats.
+	virtual std::wstring GetFrameStatsText() { return L""; }
+
 protected:
 	bool InitMainWindow();
 
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "SkinnedData.h"
+#include "BlendTree.h"
+#include "MeshletBuilder.h"
+#include "AssetManager.h"
 #include "../Common/d3dUtil.h"
 using namespace DirectX;
 using namespace Microsoft::WRL;
@@ -40,11 +43,42 @@ struct SkinnedVertex
 	BYTE boneIndices[4];
 };
 
+//    (44 -> 20 Ʈ)
+// ġ ޽ ߽ / ũ  snorm16 (  GeometryInfo::posDequant)
+// 븻 / źƮ 8ü ڵ, uv  half
+struct PackedVertex
+{
+	PackedVector::XMSHORTN4 pos;
+	PackedVector::XMSHORTN2 normal;
+	PackedVector::XMSHORTN2 tangent;
+	PackedVector::XMHALF2 uv;
+};
+
+// ִϸ̼ ִ    (60 -> 28 Ʈ)
+//  ġ unorm8 (w   ġ)
+struct PackedSkinnedVertex
+{
+	PackedVector::XMSHORTN4 pos;
+	PackedVector::XMSHORTN2 normal;
+	PackedVector::XMSHORTN2 tangent;
+	PackedVector::XMHALF2 uv;
+	PackedVector::XMUBYTEN4 boneWeights;
+	BYTE boneIndices[4];
+};
+
+// BuildGeometry  ѱ  
+enum class VertexType
+{
+	Standard,	// Vertex
+	Skinned		// SkinnedVertex
+};
+
 //  Ʈ  (World)
 struct ObjectConstants
 {
 	XMFLOAT4X4 world = MathHelper::Identity4x4(); //  
 	XMFLOAT4X4 texTransform = MathHelper::Identity4x4(); //  
+	XMFLOAT4 posDequant = { 0.0f, 0.0f, 0.0f, 1.0f }; //   ġ  (xyz ߽, w ũ)
 };
 
 //  Ʈ  
@@ -60,6 +94,20 @@ struct MatConstants
 	XMFLOAT2 padding = { 0.f, 0.f };
 };
 
+//  ϳ  ܰ
+struct GeometryLod
+{
+	UINT startIndexLocation = 0;
+	UINT indexCount = 0;
+	int baseVertexLocation = 0;
+
+	//  ǥ Ÿ ( , ٻ簪)
+	float error = 0.0f;
+
+	// ø ﰢ  (IndexOffset  startIndexLocation , ġ  )
+	vector<Meshlet> meshlets;
+};
+
 struct GeometryInfo
 {
 	string name;
@@ -82,6 +130,69 @@ struct GeometryInfo
 	UINT startIndexLocation = 0;
 	// ؽ 
 	int baseVertexLocation = 0;
+
+	//   ġ   (xyz ߽, w ũ),  ʾ ״
+	XMFLOAT4 posDequant = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+	//    (Ű ޽ô ִϸ̼  ü Ѵ)
+	BoundingBox boundingBox;
+	BoundingSphere boundingSphere;
+
+	// 0  , ڷ  ﰢ  (  VB/IB  )
+	vector<GeometryLod> lods;
+};
+
+// ޽÷ ø  þ ( )
+//  ̸ ü +  ġ,  ̸  + ü  ˻
+struct ClusterCullView
+{
+	bool orthographic = false;
+	BoundingFrustum frustum;
+	BoundingOrientedBox box;
+	XMFLOAT3 eyePosW = { 0.0f, 0.0f, 0.0f };
+	XMFLOAT3 viewDirW = { 0.0f, 0.0f, 1.0f };
+
+	template<class T>
+	bool Intersects(const T& bounds) const
+	{
+		return orthographic ? box.Intersects(bounds) : frustum.Intersects(bounds);
+	}
+};
+
+// Ӵ ﰢ  (׸ н )
+struct ClusterStats
+{
+	UINT64 totalTriangles = 0;		// LOD, ø  ׷ 
+	UINT64 lodTriangles = 0;		// õ LOD, ø 
+	UINT64 drawnTriangles = 0;		//   
+	UINT drawCalls = 0;
+};
+
+// Ӵ Ű   
+struct AnimationLodStats
+{
+	UINT evaluated = 0;			//    νϽ
+	UINT skippedReduced = 0;	// ־ ̹  ǳʶ ( ȷƮ )
+	UINT skippedOffscreen = 0;	// ȭ / ׸ ̶ ð 
+};
+
+// ϳ VB/IB ȿ  ׷ 
+struct SubmeshInfo
+{
+	string name;
+	UINT startIndexLocation = 0;
+	UINT indexCount = 0;
+};
+
+//  (ߺ  ġ)  , и   ̳   
+// 0 ̸    ģ
+struct WeldEpsilon
+{
+	float position = 1e-5f;
+	float normal = 1e-3f;
+	float uv = 1e-5f;
+	float tangent = 1e-3f;
+	float boneWeight = 1e-3f;
 };
 
 // Material ü
@@ -103,22 +214,76 @@ struct MaterialInfo
 struct SkinnedModelInstance
 {
 	SkinnedData* skinnedInfo = nullptr;	// ϳ Ŭ   
-	vector<XMFLOAT4X4> finalTransforms;
-	string clipName;
+	SkinnedData::ClipHandle clip = SkinnedData::InvalidClip;	//   Ŭ (̸   ãƵд)
 	float timePos = 0.0f;
-
-	void UpdateSkinnedAnimation(float dt)
+	vector<UINT> keyCursors;	//    Ű  (  ˻ )
+	SkinnedData::EvalScratch scratch;	//   ӽ  (ù   Ҵ )
+	const BakedClip* bakedClip = nullptr;	//  ̸  ȷƮ  Ѵ (nullptr ̸ ǽð )
+
+	//  ̵ ݺ (blendTree   )
+	//  Ŭ ҽ   ΰ,     crossFadeTime  ٸ  ó Ʋ鼭 Ѿ
+	unique_ptr<BlendTree> blendTree;
+	BlendTree::SourceId loopSources[2] = {};
+	BlendTree::NodeId loopBlend = 0;	// ġ 0 : loopSources[0], 1 : loopSources[1]
+	int loopActive = 0;
+	float crossFadeTime = 0.0f;
+
+	// ִϸ̼ LOD (UpdateAnimationLods    )
+	bool visible = true;			// ī޶ ü ׸  ,   ̸ ð 
+	float screenSize = 0.0f;		//    ȭ鿡 ϴ ȼ 
+	UINT updateInterval = 1;		//       ,    ȷƮ ״ 
+	UINT updatePhase = 0;			// νϽ ޸ ؼ ϴ   ´
+	bool paletteStale = true;		// ȷƮ  ð  ߳ (ó / ȭ ۿ ־), ̸ ٷ 
+
+	// ð  (  )
+	void AdvanceAnimation(float dt)
 	{
+		if (blendTree != nullptr)
+		{
+			blendTree->Advance(*skinnedInfo, dt);
+
+			if (blendTree->GetSourceTime(loopSources[loopActive]) >= skinnedInfo->GetClipEndTime(clip) - crossFadeTime)
+			{
+				loopActive = 1 - loopActive;
+				blendTree->SetSourceTime(loopSources[loopActive], skinnedInfo->GetClipStartTime(clip));
+				blendTree->FadeWeight(loopBlend, (float)loopActive, crossFadeTime);
+			}
+			return;
+		}
+
 		timePos += dt;
 
-		// Ŭ ̸ - ð?
 		// ݺ 
-		if (timePos > skinnedInfo->GetClipEndTime(clipName))
+		//  ð ε     (ڿ ˻ /  ȸ )
+		// ģ ð  ʰ ó ̾  (0   ݺ ݾ Ƥ)
+		const float startTime = skinnedInfo->GetClipStartTime(clip);
+		const float endTime = skinnedInfo->GetClipEndTime(clip);
+		if (timePos > endTime)
 		{
-			timePos = 0;
+			timePos = endTime > startTime ? startTime + fmodf(timePos - startTime, endTime - startTime) : startTime;
 		}
+	}
+
+	//  ð  
+	// palette :  ŭ   (ġ   )  ٷ  
+	void EvaluateAnimation(XMFLOAT4X4* palette)
+	{
+		//  ȷƮ յ  
+		//  Ʈ ̵  ƴϸ ҽ ϳ ø
+		if (bakedClip != nullptr)
+			bakedClip->Sample(timePos, palette);
+		else if (blendTree != nullptr)
+			blendTree->Evaluate(*skinnedInfo, palette, scratch);
+		else
+			skinnedInfo->GetFinalTransforms(clip, timePos, palette, keyCursors, scratch);
+
+		paletteStale = false;
+	}
 
-		skinnedInfo->GetFinalTransforms(clipName, timePos, finalTransforms);
+	void UpdateSkinnedAnimation(float dt, XMFLOAT4X4* palette)
+	{
+		AdvanceAnimation(dt);
+		EvaluateAnimation(palette);
 	}
 };
 
@@ -134,11 +299,20 @@ struct RenderItem
 	D3D12_PRIMITIVE_TOPOLOGY primitiveTopology = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 
 	//  
+	// 񵿱 εǴ ϴ غ  nullptr (׸ ), غǸ geometryName  
 	GeometryInfo* geometry = nullptr;
+	string geometryName;
 	MaterialInfo* material = nullptr;
 
 	UINT skinnedCBIndex = 0;
 	SkinnedModelInstance* skinnedModelInst = nullptr;
+
+	// ̹ ӿ ׸ geometry->lods ȣ
+	UINT lodIndex = 0;
+
+	//    (geometry 踦 world  ȯ,   )
+	BoundingBox worldBounds;
+	BoundingSphere worldSphere;
 };
 
 //   ü
@@ -194,4 +368,9 @@ struct TextureInfo
 
 	ComPtr<ID3D12Resource> resource = nullptr;
 	ComPtr<ID3D12Resource> uploadHeap = nullptr;
+
+	// 񵿱 ε (غǱ  SRV ڸ null SRV,  ؽ  ׸)
+	AssetManager::Handle asset = AssetManager::InvalidHandle;
+	int srvHeapIndex = -1;
+	bool cubeMap = false;
 };
@@ -43,49 +43,83 @@ bool InitDirect3DApp::Initialize()
 	// ʱȭ ɵ غϱ    缳
 	mCommandList->Reset(mDirectCmdListAlloc.Get(), nullptr);
 
-	// 豸 
-	mSceneBounds.Center = XMFLOAT3(0.f, 0.f, 0.f);
-	mSceneBounds.Radius = sqrtf(10.0f * 10.0f + 15.0f * 15.0f);
-
 	// ׸  
 	mShadowMap = make_unique<ShadowMap>(md3dDevice.Get(), 2048, 2048);
 
 	// ī޶ ʱ ġ 
 	mCamera.SetPosition(0.0f, 2.0f, -15.0f);
 
+	// 񵿱 ε ؽ ε   ( · )
+	md3dDevice->CreateCommandAllocator(
+		D3D12_COMMAND_LIST_TYPE_DIRECT,
+		IID_PPV_ARGS(&mUploadCmdListAlloc)
+	);
+
+	md3dDevice->CreateCommandList(
+		0,
+		D3D12_COMMAND_LIST_TYPE_DIRECT,
+		mUploadCmdListAlloc.Get(),
+		nullptr,
+		IID_PPV_ARGS(&mUploadCmdList)
+	);
+	mUploadCmdList->Close();
+
 	// -----------------------------------------------------
 	// ʱȭ 
 	// -----------------------------------------------------
 
-	// Skinned Model ε
-	LoadSkinnedModel();
+	//   ī̺긦    (   Ͽ ε)
+	if (mAssetArchive.Open(mAssetArchiveFileName))
+	{
+		string msg = "[AssetArchive] " + mAssetArchiveFileName + " : " + to_string(mAssetArchive.EntryCount()) + " entries\n";
+		OutputDebugStringA(msg.c_str());
+	}
 
-	// ؽ ε
-	LoadTextures();
+	// ſ  Ŀ 忡 ñ ٷ ù  Ѿ
+	// غ ͺ UpdateAssets  Ѱܹް,   ׸ ʰų () ؽ  ׸ ()
+	mAssetLoadStart = chrono::steady_clock::now();
 
-	// SRV  
-	BuildDescriptorHeaps();
+	// ʱȭ ܰ踦   ׷  (ϴ ܰ谡    Ǯ )
+	//    ʴ´ (۴ ε , ؽĴ UpdateAssets  ε)
+	TaskGraph startup;
+
+	// Skinned Model /  / ؽ ε (۾ ɰ ٷ )
+	startup.Add("LoadSkinnedModel", [this] { LoadSkinnedModel(); });
+	TaskGraph::TaskId textures = startup.Add("LoadTextures", [this] { LoadTextures(); });
+	startup.Add("BuildSkullGeometry", [this] { BuildSkullGeometry(); });
+
+	// SRV   : ؽ / ׸  ڸ LoadTextures  
+	startup.Add("BuildDescriptorHeaps", [this] { BuildDescriptorHeaps(); }, { textures });
 
 	//   
-	BuildBoxGeometry();
-	BuildGridGeometry();
-	BuildSphereGeometry();
-	BuildCylinderGeometry();
-	BuildQuadGeometry();
-	BuildSkullGeometry();
+	vector<TaskGraph::TaskId> itemDeps;
+	itemDeps.push_back(startup.Add("BuildBoxGeometry", [this] { BuildBoxGeometry(); }));
+	itemDeps.push_back(startup.Add("BuildGridGeometry", [this] { BuildGridGeometry(); }));
+	itemDeps.push_back(startup.Add("BuildSphereGeometry", [this] { BuildSphereGeometry(); }));
+	itemDeps.push_back(startup.Add("BuildCylinderGeometry", [this] { BuildCylinderGeometry(); }));
+	itemDeps.push_back(startup.Add("BuildQuadGeometry", [this] { BuildQuadGeometry(); }));
 
-	//  
-	BuildMaterials();
+	//   (ī̹ڽ  mSkyboxTexHeapIndex  )
+	itemDeps.push_back(startup.Add("BuildMaterials", [this] { BuildMaterials(); }, { textures }));
 
 	//  Ʈ 
-	BuildRenderItems();
+	startup.Add("BuildRenderItems", [this] { BuildRenderItems(); }, itemDeps);
 
 	//   
-	BuildInputLayout();
-	BuildShader();
-	BuildConstantBuffers();
-	BuildRootSignature();
-	BuildPSO();
+	TaskGraph::TaskId inputLayout = startup.Add("BuildInputLayout", [this]
+		{
+			if (mPackedVertices)
+				BuildPackedInputLayout();
+			else
+				BuildInputLayout();
+		});
+	TaskGraph::TaskId shader = startup.Add("BuildShader", [this] { BuildShader(); });
+	startup.Add("BuildConstantBuffers", [this] { BuildConstantBuffers(); });
+	TaskGraph::TaskId rootSignature = startup.Add("BuildRootSignature", [this] { BuildRootSignature(); });
+	startup.Add("BuildPSO", [this] { BuildPSO(); }, { inputLayout, shader, rootSignature });
+
+	startup.Run(mThreadPool);
+	LogStartupGraph(startup);
 
 	// ʱȭ  
 	mCommandList->Close();
@@ -99,6 +133,34 @@ bool InitDirect3DApp::Initialize()
 	return true;
 }
 
+void InitDirect3DApp::LogStartupGraph(const TaskGraph& graph)
+{
+	char msg[256];
+
+	// ܰ躰  /  (Run  )
+	for (TaskGraph::TaskId id = 0; id < graph.GetTaskCount(); id++)
+	{
+		const TaskGraph::Task& task = graph.GetTask(id);
+		sprintf_s(msg, "[Startup] %-22s %8.2f - %8.2f ms (%.2f ms)\n", task.Name.c_str(), task.StartMs, task.EndMs, task.EndMs - task.StartMs);
+		OutputDebugStringA(msg);
+	}
+
+	// Ӱ  :  ܰ  ʱȭ 
+	string path;
+	double pathMs = 0.0;
+	for (TaskGraph::TaskId id : graph.GetCriticalPath())
+	{
+		const TaskGraph::Task& task = graph.GetTask(id);
+		if (!path.empty())
+			path += " -> ";
+		path += task.Name;
+		pathMs += task.EndMs - task.StartMs;
+	}
+
+	sprintf_s(msg, "[Startup] %.2f ms (serial %.2f ms), critical path %.2f ms : ", graph.GetTotalMs(), graph.GetSerialMs(), pathMs);
+	OutputDebugStringA((msg + path + "\n").c_str());
+}
+
 void InitDirect3DApp::OnResize()
 {
 	D3DApp::OnResize();
@@ -109,15 +171,46 @@ void InitDirect3DApp::OnResize()
 
 void InitDirect3DApp::Update(const GameTimer& gt)
 {
+	UpdateAssets(gt);
 	UpdateCamera(gt);
+	UpdateBounds(gt);
+	UpdateLods(gt);
 	UpdateObjectCBs(gt);
 	UpdateMaterialCB(gt);
 	UpdateShadowTransform(gt);
+	UpdateCullViews(gt);
+	UpdateAnimationLods(gt);
 	UpdatePassCB(gt);
 	UpdateShadowPassCB(gt);
 	UpdateSkinnedPassCBs(gt);
 }
 
+void InitDirect3DApp::UpdateAssets(const GameTimer& gt)
+{
+	// ε   Ϸ ݹ  ( , ؽ ε  ...)
+	mAssetManager.Update();
+
+	// ̹   Ϻ  ǹǷ  ӿ ׸  ִ
+	if (mUploadCmdListOpen)
+	{
+		mUploadCmdList->Close();
+		ID3D12CommandList* cmdLists[] = { mUploadCmdList.Get() };
+		mCommandQueue->ExecuteCommandLists(_countof(cmdLists), cmdLists);
+		mUploadCmdListOpen = false;
+	}
+
+	if (!mAssetsIdleReported && mAssetManager.IsIdle())
+	{
+		const AssetManager::Stats stats = mAssetManager.GetStats();
+		const double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - mAssetLoadStart).count();
+
+		char msg[256];
+		sprintf_s(msg, "[AssetManager] %zu ready, %zu failed, %.1f ms after Initialize\n", stats.Completed, stats.Failed, ms);
+		OutputDebugStringA(msg);
+		mAssetsIdleReported = true;
+	}
+}
+
 void InitDirect3DApp::UpdateCamera(const GameTimer& gt)
 {
 	const float dt = gt.DeltaTime();
@@ -137,16 +230,90 @@ void InitDirect3DApp::UpdateCamera(const GameTimer& gt)
 	mCamera.UpdateViewMatrix();
 }
 
+void InitDirect3DApp::UpdateBounds(const GameTimer& gt)
+{
+	//   
+	for (auto& e : mRenderItems)
+	{
+		if (e->geometry == nullptr)
+			continue;
+
+		XMMATRIX world = XMLoadFloat4x4(&e->world);
+		e->geometry->boundingBox.Transform(e->worldBounds, world);
+		e->geometry->boundingSphere.Transform(e->worldSphere, world);
+	}
+
+	//   : ī̹ڽ()  (ȭ ) 
+	const RenderLayer sceneLayers[] = { RenderLayer::Opaque, RenderLayer::SkinnedOpaque, RenderLayer::AlphaTested, RenderLayer::Transparent };
+
+	BoundingBox sceneBox;
+	bool empty = true;
+	for (RenderLayer layer : sceneLayers)
+	{
+		for (auto item : mItemLayer[(int)layer])
+		{
+			if (item->geometry == nullptr)
+				continue;
+
+			if (empty)
+				sceneBox = item->worldBounds;
+			else
+				BoundingBox::CreateMerged(sceneBox, sceneBox, item->worldBounds);
+			empty = false;
+		}
+	}
+
+	if (!empty)
+		BoundingSphere::CreateFromBoundingBox(mSceneBounds, sceneBox);
+}
+
+void InitDirect3DApp::UpdateLods(const GameTimer& gt)
+{
+	// Ÿ 1    1  ȭ鿡 ϴ ȼ 
+	const float pixelsPerUnit = mClientHeight * 0.5f / tanf(mCamera.GetFovY() * 0.5f);
+	XMVECTOR eyePos = mCamera.GetPosition();
+
+	for (auto& e : mRenderItems)
+	{
+		e->lodIndex = 0;
+		if (!mLodEnabled || e->geometry == nullptr || e->geometry->lods.size() < 2)
+			continue;
+
+		XMMATRIX world = XMLoadFloat4x4(&e->world);
+		const float scale = MathHelper::Max(XMVectorGetX(XMVector3Length(world.r[0])),
+			MathHelper::Max(XMVectorGetX(XMVector3Length(world.r[1])), XMVectorGetX(XMVector3Length(world.r[2]))));
+
+		//      Ÿ ( ̸ near )
+		const float distance = MathHelper::Max(XMVectorGetX(XMVector3Length(XMLoadFloat3(&e->worldSphere.Center) - eyePos)) -
+			e->worldSphere.Radius, mCamera.GetNearZ());
+
+		//   ܰ,   ġ ̸ 
+		const vector<GeometryLod>& lods = e->geometry->lods;
+		for (UINT i = (UINT)lods.size() - 1; i > 0; i--)
+		{
+			if (lods[i].error * scale * pixelsPerUnit / distance <= mLodPixelError)
+			{
+				e->lodIndex = i;
+				break;
+			}
+		}
+	}
+}
+
 void InitDirect3DApp::UpdateObjectCBs(const GameTimer& gt)
 {
 	for (auto& e : mRenderItems)
 	{
+		if (e->geometry == nullptr)
+			continue;
+
 		XMMATRIX world = XMLoadFloat4x4(&e->world);
 		XMMATRIX texTransform = XMLoadFloat4x4(&e->texTransform);
 
 		ObjectConstants objectConstants;
 		XMStoreFloat4x4(&objectConstants.world, XMMatrixTranspose(world));
 		XMStoreFloat4x4(&objectConstants.texTransform, XMMatrixTranspose(texTransform));
+		objectConstants.posDequant = e->geometry->posDequant;
 
 		UINT elementIdx = e->objCbIndex;
 		UINT elementByteSize = (sizeof(ObjectConstants) + 255) & ~255;
@@ -165,8 +332,8 @@ void InitDirect3DApp::UpdateMaterialCB(const GameTimer& gt)
 		matConstants.diffuseAlbedo = mat->diffuseAlbedo;
 		matConstants.fresnelR0 = mat->fresnelR0;
 		matConstants.roughness = mat->roughness;
-		matConstants.texture_on = (mat->diffuseSrvHeapIndex == -1 ? 0 : 1);
-		matConstants.normal_on = (mat->normalSrvHeapIndex == -1 ? 0 : 1);
+		matConstants.texture_on = (IsSrvReady(mat->diffuseSrvHeapIndex) ? 1 : 0);
+		matConstants.normal_on = (IsSrvReady(mat->normalSrvHeapIndex) ? 1 : 0);
 
 		UINT elementIdx = mat->matCBIdx;
 		UINT elementByteSize = (sizeof(MatConstants) + 255) & ~255;
@@ -224,6 +391,77 @@ void InitDirect3DApp::UpdateShadowTransform(const GameTimer& gt)
 	XMStoreFloat4x4(&mShadowTransform, S);
 }
 
+void InitDirect3DApp::UpdateCullViews(const GameTimer& gt)
+{
+	// ī޶ :   ü  
+	XMMATRIX view = mCamera.GetView();
+	XMMATRIX invView = XMMatrixInverse(&XMMatrixDeterminant(view), view);
+
+	mCameraCullView.orthographic = false;
+	BoundingFrustum::CreateFromMatrix(mCameraCullView.frustum, mCamera.GetProj());
+	mCameraCullView.frustum.Transform(mCameraCullView.frustum, invView);
+	mCameraCullView.eyePosW = mCamera.GetPosition3f();
+
+	// ׸ :   (NDC [-1,1]^2 x [0,1])   ->  
+	XMMATRIX lightView = XMLoadFloat4x4(&mLightView);
+	XMMATRIX lightProj = XMLoadFloat4x4(&mLightProj);
+	XMMATRIX invLightView = XMMatrixInverse(&XMMatrixDeterminant(lightView), lightView);
+	XMMATRIX invLightProj = XMMatrixInverse(&XMMatrixDeterminant(lightProj), lightProj);
+
+	BoundingBox lightBox;
+	BoundingBox::CreateFromPoints(lightBox,
+		XMVector3TransformCoord(XMVectorSet(-1.0f, -1.0f, 0.0f, 1.0f), invLightProj),
+		XMVector3TransformCoord(XMVectorSet(1.0f, 1.0f, 1.0f, 1.0f), invLightProj));
+
+	mShadowCullView.orthographic = true;
+	BoundingOrientedBox::CreateFromBoundingBox(mShadowCullView.box, lightBox);
+	mShadowCullView.box.Transform(mShadowCullView.box, invLightView);
+	XMStoreFloat3(&mShadowCullView.viewDirW, XMVector3Normalize(invLightView.r[2]));
+}
+
+void InitDirect3DApp::UpdateAnimationLods(const GameTimer& gt)
+{
+	// νϽ     ũ ̴  Ѵ
+	for (auto& inst : mSkinnedModelInsts)
+	{
+		inst->visible = false;
+		inst->screenSize = 0.0f;
+	}
+
+	const float pixelsPerUnit = mClientHeight * 0.5f / tanf(mCamera.GetFovY() * 0.5f);
+	XMVECTOR eyePos = mCamera.GetPosition();
+
+	for (RenderItem* e : mItemLayer[(int)RenderLayer::SkinnedOpaque])
+	{
+		SkinnedModelInstance* inst = e->skinnedModelInst;
+		if (inst == nullptr || e->geometry == nullptr)
+			continue;
+
+		if (!mCameraCullView.Intersects(e->worldBounds))
+		{
+			// ȭ ̾ ׸ڴ   ִ
+			inst->visible |= mShadowCullView.Intersects(e->worldBounds);
+			continue;
+		}
+
+		const float distance = MathHelper::Max(XMVectorGetX(XMVector3Length(XMLoadFloat3(&e->worldSphere.Center) - eyePos)),
+			mCamera.GetNearZ());
+
+		inst->visible = true;
+		inst->screenSize = MathHelper::Max(inst->screenSize, 2.0f * e->worldSphere.Radius * pixelsPerUnit / distance);
+	}
+
+	for (auto& inst : mSkinnedModelInsts)
+	{
+		// ׸ڿ ɸ screenSize  0 ̶ ִ 
+		UINT interval = 1;
+		while (mAnimationLod && inst->screenSize * interval < mAnimationLodFullPixels && interval < mAnimationLodMaxInterval)
+			interval *= 2;
+
+		inst->updateInterval = interval;
+	}
+}
+
 void InitDirect3DApp::UpdatePassCB(const GameTimer& gt)
 {
 	PassConstants passConstants;
@@ -301,20 +539,52 @@ void InitDirect3DApp::UpdateShadowPassCB(const GameTimer& gt)
 
 void InitDirect3DApp::UpdateSkinnedPassCBs(const GameTimer& gt)
 {
+	//   ε 
+	if (mSkinnedModelInsts.empty())
+		return;
+
+	const auto start = chrono::steady_clock::now();
+
 	// Update Animation
-	//   
-	mSkinnedModelInst->UpdateSkinnedAnimation(gt.DeltaTime());
+	//    : ε   νϽ ڸ   ٷ  (߰  / Ҵ )
+	// SkinnedData  б⸸ ϰ Ŀ / ӽ  νϽ ζ νϽ    ó
+	// ð  ϰ,  UpdateAnimationLods    ƿ νϽ 
+	// ǳʶ νϽ   ڸ  ȷƮ ״  ִ
+	const UINT skinnedCBByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(SkinnedConstants));
+	const float dt = gt.DeltaTime();
 
-	SkinnedConstants skinnedCB = {};
+	mAnimationLodStats = AnimationLodStats();
+	mAnimationEvalList.clear();
+	for (UINT i = 0; i < (UINT)mSkinnedModelInsts.size(); i++)
+	{
+		SkinnedModelInstance* inst = mSkinnedModelInsts[i].get();
+		inst->AdvanceAnimation(dt);
 
-	copy
-	(
-		begin(mSkinnedModelInst->finalTransforms),
-		end(mSkinnedModelInst->finalTransforms),
-		&skinnedCB.boneTransform[0]
-	);
+		if (mAnimationLod && !inst->visible)
+		{
+			inst->paletteStale = true;
+			mAnimationLodStats.skippedOffscreen++;
+		}
+		else if (!mAnimationLod || inst->paletteStale || (mAnimationFrame + inst->updatePhase) % inst->updateInterval == 0)
+		{
+			mAnimationEvalList.push_back(i);
+		}
+		else
+		{
+			mAnimationLodStats.skippedReduced++;
+		}
+	}
+	mAnimationLodStats.evaluated = (UINT)mAnimationEvalList.size();
+	mAnimationFrame++;
+
+	mThreadPool.ParallelFor(mAnimationEvalList.size(), [&](size_t n)
+	{
+		const UINT i = mAnimationEvalList[n];
+		SkinnedConstants* skinnedCB = reinterpret_cast<SkinnedConstants*>(mSkinnedMappedData + i * skinnedCBByteSize);
+		mSkinnedModelInsts[i]->EvaluateAnimation(skinnedCB->boneTransform);
+	});
 
-	memcpy(&mSkinnedMappedData[0], &skinnedCB, sizeof(SkinnedConstants));
+	mCrowdUpdateMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
 }
 
 void InitDirect3DApp::DrawBegin(const GameTimer& gt)
@@ -338,6 +608,8 @@ void InitDirect3DApp::Draw(const GameTimer& gt)
 	// Ʈ ñ״ó,  ۺ 
 	mCommandList->SetGraphicsRootSignature(mRootSignature.Get());
 
+	mClusterStats = {};
+
 	DrawSceneToShadowMap();
 
 	// Ʈ 
@@ -368,17 +640,20 @@ void InitDirect3DApp::Draw(const GameTimer& gt)
 
 	mCommandList->SetGraphicsRootDescriptorTable(6, mShadowMapSrv);
 
+	//  ׸  ׽Ʈ / ī̹ڽ ޽÷ ø 
+	const ClusterCullView* cullView = mMeshletCulling ? &mCameraCullView : nullptr;
+
 	mCommandList->SetPipelineState(mPSOs["opaque"].Get());
-	DrawRenderItems(mItemLayer[(int)RenderLayer::Opaque]);
+	DrawRenderItems(mItemLayer[(int)RenderLayer::Opaque], cullView);
 
 	mCommandList->SetPipelineState(mPSOs["skinnedOpaque"].Get());
-	DrawRenderItems(mItemLayer[(int)RenderLayer::SkinnedOpaque]);
+	DrawRenderItems(mItemLayer[(int)RenderLayer::SkinnedOpaque], cullView);
 
 	mCommandList->SetPipelineState(mPSOs["alphaTest"].Get());
 	DrawRenderItems(mItemLayer[(int)RenderLayer::AlphaTested]);
 
 	mCommandList->SetPipelineState(mPSOs["transparent"].Get());
-	DrawRenderItems(mItemLayer[(int)RenderLayer::Transparent]);
+	DrawRenderItems(mItemLayer[(int)RenderLayer::Transparent], cullView);
 
 	mCommandList->SetPipelineState(mPSOs["debug"].Get());
 	DrawRenderItems(mItemLayer[(int)RenderLayer::Debug]);
@@ -387,7 +662,7 @@ void InitDirect3DApp::Draw(const GameTimer& gt)
 	DrawRenderItems(mItemLayer[(int)RenderLayer::SkyBox]);
 }
 
-void InitDirect3DApp::DrawRenderItems(vector<RenderItem*>& renderItems)
+void InitDirect3DApp::DrawRenderItems(vector<RenderItem*>& renderItems, const ClusterCullView* cullView)
 {
 	UINT objCBByteSize = (sizeof(ObjectConstants) + 255) & ~255;
 	UINT matCBByteSize = (sizeof(MatConstants) + 255) & ~255;
@@ -400,6 +675,15 @@ void InitDirect3DApp::DrawRenderItems(vector<RenderItem*>& renderItems)
 		if (item->geometry == nullptr)
 			continue;
 
+		const GeometryLod& lod = item->geometry->lods[item->lodIndex];
+
+		mClusterStats.totalTriangles += item->geometry->indexCount / 3;
+		mClusterStats.lodTriangles += lod.indexCount / 3;
+
+		//  ü þ  (Ű ޽õ ִϸ̼    ˻  ִ)
+		if (cullView != nullptr && !cullView->Intersects(item->worldBounds))
+			continue;
+
 		//cbv
 		D3D12_GPU_VIRTUAL_ADDRESS objCBAdress = mObjectCB->GetGPUVirtualAddress();
 		objCBAdress += item->objCbIndex * objCBByteSize;	// ϳ ƴϹǷ
@@ -445,15 +729,95 @@ void InitDirect3DApp::DrawRenderItems(vector<RenderItem*>& renderItems)
 		//topology
 		mCommandList->IASetPrimitiveTopology(item->primitiveTopology);
 
+		// Ű ޽÷ ε    ø 
+		if (cullView != nullptr && item->skinnedModelInst == nullptr && !lod.meshlets.empty())
+		{
+			CullMeshlets(*item, lod, *cullView, mVisibleRanges);
+
+			for (const auto& range : mVisibleRanges)
+			{
+				mCommandList->DrawIndexedInstanced
+				(
+					range.second,
+					1,
+					lod.startIndexLocation + range.first,
+					lod.baseVertexLocation,
+					0
+				);
+
+				mClusterStats.drawnTriangles += range.second / 3;
+				mClusterStats.drawCalls++;
+			}
+			continue;
+		}
+
 		// Render
 		mCommandList->DrawIndexedInstanced
 		(
-			item->geometry->indexCount,
+			lod.indexCount,
 			1,
-			item->geometry->startIndexLocation,
-			item->geometry->baseVertexLocation,
+			lod.startIndexLocation,
+			lod.baseVertexLocation,
 			0
 		);
+
+		mClusterStats.drawnTriangles += lod.indexCount / 3;
+		mClusterStats.drawCalls++;
+	}
+}
+
+void InitDirect3DApp::CullMeshlets(const RenderItem& item, const GeometryLod& lod, const ClusterCullView& cullView,
+	vector<pair<UINT, UINT>>& visibleRanges)
+{
+	visibleRanges.clear();
+
+	XMMATRIX world = XMLoadFloat4x4(&item.world);
+	XMVECTOR worldDet = XMMatrixDeterminant(world);
+	XMMATRIX invWorld = XMMatrixInverse(&worldDet, world);
+
+	//    ū  Ϸ Ű
+	const float scaleX = XMVectorGetX(XMVector3Length(world.r[0]));
+	const float scaleY = XMVectorGetX(XMVector3Length(world.r[1]));
+	const float scaleZ = XMVectorGetX(XMVector3Length(world.r[2]));
+	const float maxScale = MathHelper::Max(scaleX, MathHelper::Max(scaleY, scaleZ));
+
+	//   ˻    Űܼ Ѵ
+	// յ ̰  (  ) ȯ  ȴ
+	const float tolerance = 1e-3f * maxScale;
+	const bool coneValid = XMVectorGetX(worldDet) > 0.0f &&
+		fabsf(scaleX - scaleY) <= tolerance && fabsf(scaleX - scaleZ) <= tolerance;
+
+	XMFLOAT3 eyeL;
+	XMFLOAT3 viewDirL;
+	XMStoreFloat3(&eyeL, XMVector3TransformCoord(XMLoadFloat3(&cullView.eyePosW), invWorld));
+	XMStoreFloat3(&viewDirL, XMVector3TransformNormal(XMLoadFloat3(&cullView.viewDirW), invWorld));
+
+	for (const Meshlet& meshlet : lod.meshlets)
+	{
+		BoundingSphere sphere;
+		XMStoreFloat3(&sphere.Center, XMVector3TransformCoord(XMLoadFloat3((const XMFLOAT3*)meshlet.Center), world));
+		sphere.Radius = meshlet.Radius * maxScale;
+
+		if (!cullView.Intersects(sphere))
+			continue;
+
+		if (coneValid)
+		{
+			const bool backfacing = cullView.orthographic ?
+				MeshletBuilder::IsBackfacingOrtho(meshlet, &viewDirL.x) :
+				MeshletBuilder::IsBackfacing(meshlet, &eyeL.x);
+			if (backfacing)
+				continue;
+		}
+
+		//   ƴ  ƴ   ο ģ
+		// (ø ﰢ   ο ȣ  δ)
+		const UINT rangeEnd = meshlet.IndexOffset + meshlet.TriangleCount * 3;
+		if (!visibleRanges.empty() &&
+			meshlet.IndexOffset <= visibleRanges.back().first + visibleRanges.back().second + mMeshletMergeGap * 3)
+			visibleRanges.back().second = rangeEnd - visibleRanges.back().first;
+		else
+			visibleRanges.push_back({ meshlet.IndexOffset, rangeEnd - meshlet.IndexOffset });
 	}
 }
 
@@ -475,11 +839,13 @@ void InitDirect3DApp::DrawSceneToShadowMap()
 	D3D12_GPU_VIRTUAL_ADDRESS passCBAddress = mPassCB->GetGPUVirtualAddress() + passCBByteSize;
 	mCommandList->SetGraphicsRootConstantBufferView(2, passCBAddress);
 
+	const ClusterCullView* cullView = mMeshletCulling ? &mShadowCullView : nullptr;
+
 	mCommandList->SetPipelineState(mPSOs["shadow"].Get());
-	DrawRenderItems(mItemLayer[(int)RenderLayer::Opaque]);
+	DrawRenderItems(mItemLayer[(int)RenderLayer::Opaque], cullView);
 
 	mCommandList->SetPipelineState(mPSOs["skinnedShadow"].Get());
-	DrawRenderItems(mItemLayer[(int)RenderLayer::SkinnedOpaque]);
+	DrawRenderItems(mItemLayer[(int)RenderLayer::SkinnedOpaque], cullView);
 
 
 	mCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(mShadowMap->Resource(),
@@ -536,89 +902,377 @@ void InitDirect3DApp::OnMouseMove(WPARAM btnState, int x, int y)
 }
 #pragma endregion
 
+wstring InitDirect3DApp::GetFrameStatsText()
+{
+	//   (׸ н )
+	//  / LOD   / 
+	//  :  / ε  / Ϸ
+	const AssetManager::Stats assets = mAssetManager.GetStats();
+
+	return L"   tris: " + to_wstring(mClusterStats.drawnTriangles) + L" / " + to_wstring(mClusterStats.lodTriangles) +
+		L" / " + to_wstring(mClusterStats.totalTriangles) +
+		L"   draws: " + to_wstring(mClusterStats.drawCalls) +
+		L"   crowd: " + to_wstring(mSkinnedModelInsts.size()) + L" in " + to_wstring(mCrowdUpdateMs) + L" ms" +
+		L"   anim: " + to_wstring(mAnimationLodStats.evaluated) + L" full, " +
+		to_wstring(mAnimationLodStats.skippedReduced + mAnimationLodStats.skippedOffscreen) + L" skipped (" +
+		to_wstring(mAnimationLodStats.skippedOffscreen) + L" off-screen)" +
+		L"   assets: " + to_wstring(assets.Pending) + L" / " + to_wstring(assets.InFlight) + L" / " + to_wstring(assets.Completed);
+}
+
 
 void InitDirect3DApp::LoadSkinnedModel()
 {
-	vector<M3DLoader::SkinnedVertex> vertices;
-	vector<uint16_t> indices;
+	// Ŀ б /  /   ,  忡  Ѱܹ޴´
+	struct SkinnedModelLoad
+	{
+		SkinnedData skinnedInfo;
+		vector<M3DLoader::Subset> subsets;
+		vector<M3DLoader::M3dMaterial> mats;
+		vector<unique_ptr<GeometryInfo>> geometries;
+	};
+	auto model = make_shared<SkinnedModelLoad>();
+
+	auto load = [this, model]()
+	{
+		// ؽƮ Ľ  ̳ʸ ĳø ؼ ٷ 
+		// (ĳð ų  ٲ δ  )
+		// ī̺꿡     ĳ ̹ ״  (̹  / ȭ)
+		M3dCache cache;
+		const AssetArchive::Entry* baked = mAssetArchive.Find(mSkinnedModelFileName, AssetArchive::AssetType::SkinnedModel);
+		const bool fromArchive = baked != nullptr && cache.Open(mAssetArchive.Data(*baked), (size_t)baked->Size);
+
+		M3DLoader m3dLoader;
+		m3dLoader.SetThreadPool(&mThreadPool);
+		if (!fromArchive && !m3dLoader.LoadM3dCached(mSkinnedModelFileName, cache))
+		{
+			OutputDebugStringA(("[SkinnedModel] " + mSkinnedModelFileName + " : load failed\n").c_str());
+			return false;
+		}
+
+		cache.GetSubsets(model->subsets);
+		cache.GetMaterials(model->mats);
+		cache.GetSkinnedData(model->skinnedInfo);
+
+		//   / Ʈ   ڸ  Ƿ ġ  ε з ó
+		// ( 忡 Ȯ, BuildSkinnedModelItems  UpdateSkinnedPassCBs    ϰ )
+		const UINT maxBoneCount = sizeof(SkinnedConstants::boneTransform) / sizeof(XMFLOAT4X4);
+		string error;
+		if (model->skinnedInfo.BoneCount() > maxBoneCount)
+			error = to_string(model->skinnedInfo.BoneCount()) + " bones (max " + to_string(maxBoneCount) + ")";
+		else if (model->mats.size() > mMaxSkinnedSubsets)
+			error = to_string(model->mats.size()) + " materials (max " + to_string(mMaxSkinnedSubsets) + ")";
+		else if (model->skinnedInfo.FindClip("Take1") == SkinnedData::InvalidClip)
+			error = "no Take1 clip";
+
+		if (!error.empty())
+		{
+			OutputDebugStringA(("[SkinnedModel] " + mSkinnedModelFileName + " : " + error + ", load failed\n").c_str());
+			return false;
+		}
+
+		//   ȿ Ű ̰ ȭ  Ŭ ü ( Ű )
+		if (mCompressClips)
+		{
+			unordered_map<string, ClipCompressor::Report> reports;
+			model->skinnedInfo.CompressClips(mClipCompression, &reports);
+
+			for (const auto& clip : reports)
+			{
+				const ClipCompressor::Report& report = clip.second;
+				char msg[256];
+				sprintf_s(msg, "[ClipCompressor] %s : keys %zu -> %zu, %zu -> %zu bytes (x%.1f), max error T %.2e R %.2e rad S %.2e, bone %.3f\n",
+					clip.first.c_str(), report.OriginalKeys, report.CompressedKeys, report.OriginalBytes, report.CompressedBytes, report.Ratio(),
+					report.MaxTranslationError, report.MaxRotationError, report.MaxScaleError, report.MaxBonePositionError);
+				OutputDebugStringA(msg);
+			}
+		}
+
+		//  Ű ´ ( Ŀ ؾ ϴ Ŭ )
+		//  ȷƮ  νϽ   ʴ´
+		if (mAnimationBakeRate > 0.0f && mBakedCrowdRatio > 0.0f)
+		{
+			unordered_map<string, BakedClip::Report> reports;
+			model->skinnedInfo.BakeClips(mAnimationBakeRate, &reports);
+
+			for (const auto& clip : reports)
+			{
+				const BakedClip::Report& report = clip.second;
+				char msg[256];
+				sprintf_s(msg, "[BakedClip] %s : %.1f Hz, %zu frames, %.1f KB, max bone error %.3f\n",
+					clip.first.c_str(), report.SampleRate, report.FrameCount, report.ByteSize / 1024.0, report.MaxBonePositionError);
+				OutputDebugStringA(msg);
+			}
+		}
+
+		// CompiledClip     (ε 忡,  / Ⱑ  Ŭ)
+		model->skinnedInfo.UseCompiledClips(mCompiledClips);
+		if (mCompiledClips)
+		{
+			for (const string& name : model->skinnedInfo.GetClipNames())
+			{
+				char msg[256];
+				sprintf_s(msg, "[CompiledClip] %s : %.1f KB\n", name.c_str(),
+					model->skinnedInfo.FindCompiledClip(model->skinnedInfo.FindClip(name))->GetByteSize() / 1024.0);
+				OutputDebugStringA(msg);
+			}
+		}
+
+		// ĳô б  εǾ Ƿ ؼ  
+		static_assert(sizeof(SkinnedVertex) == sizeof(M3DLoader::SkinnedVertex), "SkinnedVertex layout mismatch");
+		vector<SkinnedVertex> vertices(cache.VertexCount());
+		memcpy(vertices.data(), cache.Vertices(), vertices.size() * sizeof(SkinnedVertex));
+		vector<uint32_t> indices(cache.Indices(), cache.Indices() + cache.IndexCount());
+
+		if (fromArchive)
+		{
+			BuildSkinnedGeometry("sm_", model->skinnedInfo, vertices, indices, model->subsets, model->geometries, true);
+			return true;
+		}
+
+		const UINT weldedCount = WeldVertices(mSkinnedModelFileName, vertices.data(), (UINT)vertices.size(), sizeof(SkinnedVertex),
+			GetSkinnedWeldAttributes(), indices.data(), (UINT)indices.size());
+		vertices.resize(weldedCount);
 
-	M3DLoader m3dLoader;
-	m3dLoader.LoadM3d(mSkinnedModelFileName, vertices, indices, mSkinnedSubsets, mSkinnedMats, mSkinnedInfo);
+		//   ȣ ٲǷ    ٽ 
+		for (auto& subset : model->subsets)
+		{
+			if (subset.FaceCount == 0)
+				continue;
+
+			uint32_t lo = UINT32_MAX;
+			uint32_t hi = 0;
+			for (UINT i = subset.FaceStart * 3; i < (subset.FaceStart + subset.FaceCount) * 3; i++)
+			{
+				lo = MathHelper::Min(lo, indices[i]);
+				hi = MathHelper::Max(hi, indices[i]);
+			}
+
+			subset.VertexStart = lo;
+			subset.VertexCount = hi - lo + 1;
+		}
 
-	mSkinnedModelInst = make_unique<SkinnedModelInstance>();
-	mSkinnedModelInst->skinnedInfo = &mSkinnedInfo;
-	mSkinnedModelInst->finalTransforms.resize(mSkinnedInfo.BoneCount());
-	mSkinnedModelInst->clipName = "Take1";
-	mSkinnedModelInst->timePos = 0.0f;
+		//    ("sm_0" ~ "sm_N")
+		BuildSkinnedGeometry("sm_", model->skinnedInfo, vertices, indices, model->subsets, model->geometries);
+		return true;
+	};
 
-	//  ŭ?
-	// ϳ ü  Ӹ,   ޽÷ иŲ
-	for (UINT i = 0; i < (UINT)mSkinnedSubsets.size(); i++)
+	auto finish = [this, model]()
 	{
-		//   Է
-		auto geo = std::make_unique<GeometryInfo>();
-		geo->name = "sm_" + to_string(i);
+		mSkinnedInfo = move(model->skinnedInfo);
+		mSkinnedSubsets = move(model->subsets);
+		mSkinnedMats = move(model->mats);
+		AddGeometries(model->geometries);
 
-		//   
-		geo->vertexCount = (UINT)vertices.size();
-		const UINT vbByteSize = geo->vertexCount * sizeof(SkinnedVertex);
+		BuildSkinnedModelItems();
 
-		D3D12_HEAP_PROPERTIES heapProperty = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-		D3D12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Buffer(vbByteSize);
+		if (mCrowdBenchmark)
+			BenchmarkCrowd();
+	};
 
-		md3dDevice->CreateCommittedResource(
-			&heapProperty,
-			D3D12_HEAP_FLAG_NONE,
-			&desc,
-			D3D12_RESOURCE_STATE_GENERIC_READ,
-			nullptr,
-			IID_PPV_ARGS(&geo->vertexBuffer));
+	mSkinnedModelAsset = mAssetManager.Load(mSkinnedModelFileName, load, finish);
+}
 
-		void* vertexDataBuff = nullptr;
-		CD3DX12_RANGE vertexRange(0, 0);
-		geo->vertexBuffer->Map(0, &vertexRange, &vertexDataBuff);
-		memcpy(vertexDataBuff, vertices.data(), vbByteSize);
-		geo->vertexBuffer->Unmap(0, nullptr);
+void InitDirect3DApp::BuildSkinnedGeometry(const string& geoPrefix, const SkinnedData& skinnedInfo, const vector<SkinnedVertex>& vertices,
+	const vector<uint32_t>& indices, const vector<M3DLoader::Subset>& subsets, vector<unique_ptr<GeometryInfo>>& geometries,
+	bool optimized)
+{
+	//  / ε ۴ 𵨴 ϳ 
+	// (Ӹ,  ...)  ۸ startIndexLocation / baseVertexLocation   
+	vector<SubmeshInfo> submeshes(subsets.size());
+	for (UINT i = 0; i < (UINT)subsets.size(); i++)
+	{
+		submeshes[i].name = geoPrefix + to_string(i);
+		submeshes[i].startIndexLocation = subsets[i].FaceStart * 3;	// ̶ x3
+		submeshes[i].indexCount = subsets[i].FaceCount * 3;
+	}
 
-		geo->vertexBufferView.BufferLocation = geo->vertexBuffer->GetGPUVirtualAddress();
-		geo->vertexBufferView.StrideInBytes = sizeof(SkinnedVertex);
-		geo->vertexBufferView.SizeInBytes = vbByteSize;
+	const size_t firstGeometry = geometries.size();
+	const UINT64 sharedBytes = CreateGeometry(geoPrefix, VertexType::Skinned, vertices.data(), (UINT)vertices.size(),
+		indices.data(), (UINT)indices.size(), geometries, submeshes, optimized);
 
-		//ε   
-		geo->indexCount = (UINT)indices.size();
-		const UINT ibByteSize = geo->indexCount * sizeof(uint16_t);
+	// ε  踦 ִϸ̼    ü
+	for (size_t i = 0; i < submeshes.size(); i++)
+	{
+		if (submeshes[i].indexCount == 0)
+			continue;
 
-		heapProperty = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-		desc = CD3DX12_RESOURCE_DESC::Buffer(ibByteSize);
+		GeometryInfo* geo = geometries[firstGeometry + i].get();
+		geo->boundingBox = ComputeSkinnedBounds(skinnedInfo, vertices, indices.data() + submeshes[i].startIndexLocation,
+			submeshes[i].indexCount);
+		BoundingSphere::CreateFromBoundingBox(geo->boundingSphere, geo->boundingBox);
+	}
 
-		md3dDevice->CreateCommittedResource(
-			&heapProperty,
-			D3D12_HEAP_FLAG_NONE,
-			&desc,
-			D3D12_RESOURCE_STATE_GENERIC_READ,
-			nullptr,
-			IID_PPV_ARGS(&geo->indexBuffer));
+	if (mCheckSkinnedBounds)
+	{
+		vector<const GeometryInfo*> submeshGeometries;
+		for (size_t i = 0; i < submeshes.size(); i++)
+			submeshGeometries.push_back(geometries[firstGeometry + i].get());
+		CheckSkinnedBounds(geoPrefix, skinnedInfo, vertices, indices, submeshes, submeshGeometries.data());
+	}
 
-		void* indexDataBuff = nullptr;
-		CD3DX12_RANGE indexRange(0, 0);
-		geo->indexBuffer->Map(0, &indexRange, &indexDataBuff);
-		memcpy(indexDataBuff, indices.data(), ibByteSize);
-		geo->indexBuffer->Unmap(0, nullptr);
+	// ¸ ü ޽ø  ø Ͱ  ෮
+	const UINT64 perSubsetBytes = sharedBytes * subsets.size();
 
-		geo->indexBufferView.BufferLocation = geo->indexBuffer->GetGPUVirtualAddress();
-		geo->indexBufferView.Format = DXGI_FORMAT_R16_UINT;
-		geo->indexBufferView.SizeInBytes = ibByteSize;
+	string msg = "[SkinnedModel] " + geoPrefix + " : " + to_string(subsets.size()) + " subsets, " +
+		to_string(sharedBytes) + " bytes (per-subset buffers: " + to_string(perSubsetBytes) +
+		" bytes, saved " + to_string(perSubsetBytes - sharedBytes) + " bytes)\n";
+	OutputDebugStringA(msg.c_str());
+}
+
+void InitDirect3DApp::BuildSkinnedModelItems()
+{
+	//     ڸ   ȴ (UpdateSkinnedPassCBs  ٷ , ε忡 Ȯ)
+	assert(mSkinnedInfo.BoneCount() <= sizeof(SkinnedConstants::boneTransform) / sizeof(XMFLOAT4X4));
+	const SkinnedData::ClipHandle clip = mSkinnedInfo.FindClip("Take1");
+	assert(clip != SkinnedData::InvalidClip);
+
+	// νϽ i     i ° ڸ 
+	//     ʵ  ð Ŭ  ȿ   ´
+	const float clipLength = mSkinnedInfo.GetClipEndTime(clip);
+	mSkinnedModelInsts.clear();
+
+	//  (ε ū, ī޶󿡼 ) νϽ bakedCount   ȷƮ 
+	const BakedClip* bakedClip = mSkinnedInfo.FindBakedClip(clip);
+	const UINT bakedCount = bakedClip != nullptr ? (UINT)(mCrowdSize * MathHelper::Clamp(mBakedCrowdRatio, 0.0f, 1.0f) + 0.5f) : 0;
+	for (UINT i = 0; i < mCrowdSize; i++)
+	{
+		auto inst = make_unique<SkinnedModelInstance>();
+		inst->skinnedInfo = &mSkinnedInfo;
+		inst->clip = clip;
+		inst->timePos = clipLength * fmodf(i * 0.618034f, 1.0f);
+		inst->updatePhase = i;	//   νϽ  ӿ  ʵ
+		inst->bakedClip = i >= mCrowdSize - bakedCount ? bakedClip : nullptr;
+
+		// ݺ   Ʈ  ̵ (ҽ  Ŭ,  ִٰ ʷ ó )
+		//  ȷƮ ϴ νϽ    Ƿ ó ̾ (AdvanceAnimation)
+		//  Ʈ CompiledClip  øϹǷ mCompiledClips   ־ ó ̾
+		if (mLoopCrossFade > 0.0f && inst->bakedClip == nullptr && mSkinnedInfo.IsUsingCompiledClips())
+		{
+			inst->blendTree = make_unique<BlendTree>();
+			inst->loopSources[0] = inst->blendTree->AddSource(clip, inst->timePos, 1.0f, false);
+			inst->loopSources[1] = inst->blendTree->AddSource(clip, clipLength, 1.0f, false);
+			inst->loopBlend = inst->blendTree->AddBlend(inst->blendTree->AddClip(inst->loopSources[0]), inst->blendTree->AddClip(inst->loopSources[1]), 0.0f);
+			inst->crossFadeTime = MathHelper::Min(mLoopCrossFade, clipLength * 0.5f);
+		}
+
+		mSkinnedModelInsts.push_back(move(inst));
+	}
+
+	// ؽ ε ( ̸  , SRV ڸ mSkinnedSrvHeapStart  ̸ )
+	auto textureSlot = [this](const string& fileName)
+	{
+		const string name = fileName.substr(0, fileName.find_last_of("."));
 
-		geo->indexCount = mSkinnedSubsets[i].FaceCount * 3;
-		geo->startIndexLocation = mSkinnedSubsets[i].FaceStart * 3;	// ̶ x3
-		//geo->baseVertexLocation = 0;
+		auto found = find(mSkinnedTextureName.begin(), mSkinnedTextureName.end(), name);
+		if (found != mSkinnedTextureName.end())
+			return (int)(mSkinnedSrvHeapStart + (found - mSkinnedTextureName.begin()));
 
-		mGeometries[geo->name] = std::move(geo);
+		const int srvHeapIndex = (int)(mSkinnedSrvHeapStart + mSkinnedTextureName.size());
+		if (srvHeapIndex >= (int)mSrvHeapCapacity)
+		{
+			OutputDebugStringA(("[SkinnedModel] " + fileName + " : no free SRV slot\n").c_str());
+			return -1;
+		}
+
+		mSkinnedTextureName.push_back(name);
+		LoadTexture(name, "../Textures/" + fileName, srvHeapIndex);
+		return srvHeapIndex;
+	};
+
+	//   (  ڸ   ڿ)
+	for (UINT i = 0; i < (UINT)mSkinnedMats.size(); i++)
+	{
+		if (mMateirals.size() >= mMaxMaterialCount)
+			break;
+
+		auto mat = make_unique<MaterialInfo>();
+		mat->name = mSkinnedMats[i].Name;
+		mat->matCBIdx = (int)mMateirals.size();
+		mat->diffuseSrvHeapIndex = textureSlot(mSkinnedMats[i].DiffuseMapName);
+		mat->normalSrvHeapIndex = textureSlot(mSkinnedMats[i].NormalMapName);
+
+		mat->diffuseAlbedo = mSkinnedMats[i].DiffuseAlbedo;
+		mat->fresnelR0 = mSkinnedMats[i].FresnelR0;
+		mat->roughness = mSkinnedMats[i].Roughness;
+
+		mMateirals[mat->name] = move(mat);
+	}
+
+	// νϽ / ¸   (  ڸ   ڿ)
+	// ù νϽ  ڸ (0, 0, -5),   ڷ  ġ
+	assert(mSkinnedMats.size() <= mMaxSkinnedSubsets);	// ε忡 Ȯ
+	const UINT columns = (UINT)ceilf(sqrtf((float)mCrowdSize));
+	for (UINT inst = 0; inst < (UINT)mSkinnedModelInsts.size(); inst++)
+	{
+		const float x = ((inst % columns) - (columns - 1) * 0.5f) * mCrowdSpacing;
+		const float z = -5.0f + (inst / columns) * mCrowdSpacing;
+
+		for (UINT i = 0; i < (UINT)mSkinnedMats.size(); i++)
+		{
+			if (mRenderItems.size() >= mMaxObjectCount || mMateirals.count(mSkinnedMats[i].Name) == 0)
+				break;
+
+			auto rItem = make_unique<RenderItem>();
+			XMMATRIX scale = XMMatrixScaling(0.05f, 0.05f, -0.05f);
+			XMMATRIX rotation = XMMatrixRotationY(MathHelper::Pi);
+			XMMATRIX pos = XMMatrixTranslation(x, 0.0f, z);
+			XMStoreFloat4x4(&rItem->world, scale * rotation* pos);
+
+			rItem->texTransform = MathHelper::Identity4x4();
+			rItem->objCbIndex = (UINT)mRenderItems.size();
+			rItem->material = mMateirals[mSkinnedMats[i].Name].get();
+
+			string meshName = "sm_" + to_string(i);
+			rItem->geometry = mGeometries[meshName].get();
+			rItem->primitiveTopology = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+
+			rItem->skinnedCBIndex = inst;
+			rItem->skinnedModelInst = mSkinnedModelInsts[inst].get();
+
+			mItemLayer[(int)RenderLayer::SkinnedOpaque].push_back(rItem.get());
+			mRenderItems.push_back(move(rItem));
+		}
+	}
+}
+
+void InitDirect3DApp::BenchmarkCrowd()
+{
+	// UpdateSkinnedPassCBs   ۾ Ǯ ũ⸸ ٲ  ݺ
+	// dt = 0 ̶ νϽ  ð ״,   ӿ 
+	const UINT skinnedCBByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(SkinnedConstants));
+	const int frameCount = 100;
+	const size_t maxThreads = MathHelper::Max(1u, thread::hardware_concurrency());
+
+	for (size_t threads = 1; threads <= maxThreads; threads *= 2)
+	{
+		// Ǯ 尡 ϳ ParallelFor  ȣ 忡 
+		ThreadPool pool(threads);
+		auto evaluate = [&]()
+		{
+			pool.ParallelFor(mSkinnedModelInsts.size(), [&](size_t i)
+			{
+				SkinnedConstants* skinnedCB = reinterpret_cast<SkinnedConstants*>(mSkinnedMappedData + i * skinnedCBByteSize);
+				mSkinnedModelInsts[i]->UpdateSkinnedAnimation(0.0f, skinnedCB->boneTransform);
+			});
+		};
+
+		evaluate();
+
+		const auto start = chrono::steady_clock::now();
+		for (int frame = 0; frame < frameCount; frame++)
+			evaluate();
+		const double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / frameCount;
+
+		char msg[256];
+		sprintf_s(msg, "[Crowd] %zu instances, pool %zu threads : %.3f ms, %.0f instances/ms\n",
+			mSkinnedModelInsts.size(), threads, ms, mSkinnedModelInsts.size() / ms);
+		OutputDebugStringA(msg);
 	}
 }
 
 void InitDirect3DApp::LoadTextures()
 {
+	// 2D ؽĴ 0 ,  ڷ ī̹ڽ / ׸  / Ű  ؽ ڸ
 	vector<string> texNames =
 	{
 		"bricks",		// 0
@@ -627,67 +1281,740 @@ void InitDirect3DApp::LoadTextures()
 		"tile",			// 3
 		"tileNormal",	// 4
 		"fence",		// 5
-		"default",		// 6
-		"skyCubeMap"	// 7
+		"default"		// 6
 	};
 
-	vector<wstring> texPaths =
+	vector<string> texPaths =
 	{
-		L"../Textures/bricks.dds",
-		L"../Textures/bricks_nmap.dds",
-		L"../Textures/stone.dds",
-		L"../Textures/tile.dds",
-		L"../Textures/tile_nmap.dds",
-		L"../Textures/WireFence.dds",
-		L"../Textures/white1x1.dds",
-		L"../Textures/snowcube1024.dds"
+		"../Textures/bricks.dds",
+		"../Textures/bricks_nmap.dds",
+		"../Textures/stone.dds",
+		"../Textures/tile.dds",
+		"../Textures/tile_nmap.dds",
+		"../Textures/WireFence.dds",
+		"../Textures/white1x1.dds"
 	};
 
-	// Skinned Model Texture Add
-	for (UINT i = 0; i < (UINT)mSkinnedMats.size(); i++)
+	mSkyboxTexHeapIndex = (UINT)texPaths.size();
+	mShadowMapHeapIndex = mSkyboxTexHeapIndex + 1;
+	mSkinnedSrvHeapStart = mShadowMapHeapIndex + 1;
+	mSrvAssets.assign(mSrvHeapCapacity, AssetManager::InvalidHandle);
+
+	for (int i = 0; i < (int)texPaths.size(); i++)
+		LoadTexture(texNames[i], texPaths[i], i);
+
+	LoadTexture("skyCubeMap", "../Textures/snowcube1024.dds", (int)mSkyboxTexHeapIndex, true);
+}
+
+AssetManager::Handle InitDirect3DApp::LoadTexture(const string& name, const string& fileName, int srvHeapIndex, bool cubeMap)
+{
+	auto texture = make_unique<TextureInfo>();
+	texture->name = name;
+	texture->fileName = AnsiToWString(fileName);
+	texture->srvHeapIndex = srvHeapIndex;
+	texture->cubeMap = cubeMap;
+
+	TextureInfo* tex = texture.get();
+	mTextures[name] = move(texture);
+
+	// ī̺꿡  ε DDS  ״ ,  Ŀ  о д
+	struct TextureLoad
+	{
+		const uint8_t* data = nullptr;
+		size_t size = 0;
+		vector<uint8_t> fileData;
+	};
+	auto file = make_shared<TextureLoad>();
+
+	auto load = [this, fileName, file]()
+	{
+		const AssetArchive::Entry* baked = mAssetArchive.Find(fileName, AssetArchive::AssetType::Texture);
+		if (baked != nullptr)
+		{
+			file->data = mAssetArchive.Data(*baked);
+			file->size = (size_t)baked->Size;
+
+			// ε  ⼭ ̸ о  尡 ũ ٸ ʰ Ѵ
+			volatile uint8_t touch = 0;
+			for (size_t i = 0; i < file->size; i += 4096)
+				touch += file->data[i];
+			return true;
+		}
+
+		MappedFile mapped;
+		if (!mapped.Open(fileName))
+		{
+			OutputDebugStringA(("[Texture] " + fileName + " : not found\n").c_str());
+			return false;
+		}
+
+		file->fileData.assign(mapped.Data(), mapped.Data() + mapped.Size());
+		file->data = file->fileData.data();
+		file->size = file->fileData.size();
+		return true;
+	};
+
+	auto finish = [this, tex, file]()
+	{
+		ThrowIfFailed(DirectX::CreateDDSTextureFromMemory12
+		(
+			md3dDevice.Get(),
+			GetUploadCommandList(),
+			file->data,
+			file->size,
+			tex->resource,
+			tex->uploadHeap
+		));
+
+		file->fileData = vector<uint8_t>();
+		CreateTextureSrv(*tex);
+	};
+
+	tex->asset = mAssetManager.Load(fileName, load, finish);
+	if (srvHeapIndex >= 0 && srvHeapIndex < (int)mSrvAssets.size())
+		mSrvAssets[srvHeapIndex] = tex->asset;
+
+	return tex->asset;
+}
+
+void InitDirect3DApp::CreateTextureSrv(const TextureInfo& texture)
+{
+	D3D12_RESOURCE_DESC desc = texture.resource->GetDesc();
+
+	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	srvDesc.Format = desc.Format;
+
+	if (texture.cubeMap)
+	{
+		srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBE;
+		srvDesc.TextureCube.MostDetailedMip = 0;
+		srvDesc.TextureCube.MipLevels = desc.MipLevels;
+		srvDesc.TextureCube.ResourceMinLODClamp = 0.0f;
+	}
+	else
+	{
+		srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+		srvDesc.Texture2D.MostDetailedMip = 0;
+		srvDesc.Texture2D.MipLevels = desc.MipLevels;
+		srvDesc.Texture2D.ResourceMinLODClamp = 0.0f;
+	}
+
+	CD3DX12_CPU_DESCRIPTOR_HANDLE hDescriptor(mSrvDescriptorHeap->GetCPUDescriptorHandleForHeapStart(),
+		texture.srvHeapIndex, mCbvSrvDescriptorSize);
+	md3dDevice->CreateShaderResourceView(texture.resource.Get(), &srvDesc, hDescriptor);
+}
+
+bool InitDirect3DApp::IsSrvReady(int srvHeapIndex)const
+{
+	if (srvHeapIndex < 0 || srvHeapIndex >= (int)mSrvAssets.size())
+		return false;
+
+	return mAssetManager.IsReady(mSrvAssets[srvHeapIndex]);
+}
+
+ID3D12GraphicsCommandList* InitDirect3DApp::GetUploadCommandList()
+{
+	//     ť Ƿ ٷ 
+	if (!mUploadCmdListOpen)
+	{
+		ThrowIfFailed(mUploadCmdListAlloc->Reset());
+		ThrowIfFailed(mUploadCmdList->Reset(mUploadCmdListAlloc.Get(), nullptr));
+		mUploadCmdListOpen = true;
+	}
+
+	return mUploadCmdList.Get();
+}
+
+UINT64 InitDirect3DApp::BuildGeometry(const string& name, VertexType vertexType, const void* vertices, UINT vertexCount,
+	const uint32_t* indices, UINT indexCount, const vector<SubmeshInfo>& submeshes, bool optimized)
+{
+	vector<unique_ptr<GeometryInfo>> geometries;
+	const UINT64 bytes = CreateGeometry(name, vertexType, vertices, vertexCount, indices, indexCount, geometries, submeshes, optimized);
+	AddGeometries(geometries);
+
+	return bytes;
+}
+
+UINT64 InitDirect3DApp::CreateGeometry(const string& name, VertexType vertexType, const void* vertices, UINT vertexCount,
+	const uint32_t* indices, UINT indexCount, vector<unique_ptr<GeometryInfo>>& geometries,
+	const vector<SubmeshInfo>& submeshes, bool optimized)
+{
+	UINT vertexStride = vertexType == VertexType::Skinned ? sizeof(SkinnedVertex) : sizeof(Vertex);
+
+	// ޽ð  ޽ ü ϳ 
+	vector<SubmeshInfo> ranges = submeshes;
+	if (ranges.empty())
+		ranges.push_back({ name, 0, indexCount });
+
+	// ۸    ĳ /  fetch  ȭ
+	vector<uint8_t> optVertices((const uint8_t*)vertices, (const uint8_t*)vertices + (size_t)vertexCount * vertexStride);
+	vector<uint32_t> optIndices(indices, indices + indexCount);
+	if (!optimized)
+		OptimizeMesh(name, optVertices.data(), vertexCount, vertexStride, optIndices.data(), indexCount, ranges);
+
+	//  LOD ü (   ε ڿ ٴ´)
+	vector<vector<GeometryLod>> lods(ranges.size());
+	for (size_t r = 0; r < ranges.size(); r++)
+		lods[r].push_back({ ranges[r].startIndexLocation, ranges[r].indexCount });
+
+	if (mLodEnabled)
+		BuildLods(name, vertexType, optVertices.data(), vertexCount, vertexStride, optIndices, lods);
+	indexCount = (UINT)optIndices.size();
+
+	// ø ޽÷ (ġ о ϹǷ  )
+	if (mMeshletCulling)
+		BuildMeshlets(name, vertexType, optVertices.data(), vertexCount, vertexStride, optIndices.data(), indexCount, lods);
+
+	//    (  )
+	const size_t positionOffset = vertexType == VertexType::Skinned ? offsetof(SkinnedVertex, pos) : offsetof(Vertex, pos);
+	vector<BoundingBox> boxes(ranges.size());
+	vector<BoundingSphere> spheres(ranges.size());
+	for (size_t r = 0; r < ranges.size(); r++)
+	{
+		ComputeBounds(optVertices.data(), vertexStride, positionOffset,
+			optIndices.data() + ranges[r].startIndexLocation, ranges[r].indexCount, boxes[r], spheres[r]);
+	}
+
+	vertices = optVertices.data();
+	indices = optIndices.data();
+
+	//    ȯ (ġ   Ʈ  ̴ ѱ)
+	XMFLOAT4 posDequant = { 0.0f, 0.0f, 0.0f, 1.0f };
+	vector<uint8_t> packedVertices;
+	if (mPackedVertices)
 	{
-		string diffuseName = mSkinnedMats[i].DiffuseMapName;
-		string normalName = mSkinnedMats[i].NormalMapName;
+		const UINT64 unpackedBytes = (UINT64)vertexCount * vertexStride;
+
+		vertexStride = vertexType == VertexType::Skinned ? sizeof(PackedSkinnedVertex) : sizeof(PackedVertex);
+		packedVertices.resize((size_t)vertexCount * vertexStride);
+		posDequant = PackVertices(vertexType, vertices, vertexCount, packedVertices.data());
+
+		string msg = "[VertexPacking] " + name + " : " + to_string(unpackedBytes) + " -> " +
+			to_string((UINT64)vertexCount * vertexStride) + " bytes\n";
+		OutputDebugStringA(msg.c_str());
+
+		vertices = packedVertices.data();
+	}
 
-		wstring diffuseFile = L"../Textures/" + AnsiToWString(diffuseName);
-		wstring normalFile = L"../Textures/" + AnsiToWString(normalName);
+	// ε  
+	// 1.  ū ε 16Ʈ  R16
+	// 2. ƴϸ LOD    ε baseVertexLocation   16Ʈ  Ȯ
+	// 3. ׷  Ǹ R32
+	uint32_t maxIndex = 0;
+	for (UINT i = 0; i < indexCount; i++)
+		maxIndex = MathHelper::Max(maxIndex, indices[i]);
 
-		diffuseName = diffuseName.substr(0, diffuseName.find_last_of("."));
-		normalName = normalName.substr(0, normalName.find_last_of("."));
+	bool use16Bit = maxIndex <= 0xFFFF;
+	if (!use16Bit && !submeshes.empty())
+	{
+		use16Bit = true;
+		for (auto& rangeLods : lods)
+		{
+			for (GeometryLod& lod : rangeLods)
+			{
+				uint32_t lo = UINT32_MAX;
+				uint32_t hi = 0;
+				for (UINT i = lod.startIndexLocation; i < lod.startIndexLocation + lod.indexCount; i++)
+				{
+					lo = MathHelper::Min(lo, indices[i]);
+					hi = MathHelper::Max(hi, indices[i]);
+				}
+
+				if (lod.indexCount > 0)
+				{
+					lod.baseVertexLocation = (int)lo;
+					use16Bit = use16Bit && hi - lo <= 0xFFFF;
+				}
+			}
+		}
 
-		// ߺ ̸ ٸ ߰
-		if (find(mSkinnedTextureName.begin(), mSkinnedTextureName.end(), diffuseName) == mSkinnedTextureName.end())
+		if (!use16Bit)
 		{
-			mSkinnedTextureName.push_back(diffuseName);
-			texNames.push_back(diffuseName);
-			texPaths.push_back(diffuseFile);
+			for (auto& rangeLods : lods)
+				for (GeometryLod& lod : rangeLods)
+					lod.baseVertexLocation = 0;
 		}
+	}
+
+	// 
+	const UINT vbByteSize = vertexCount * vertexStride;
+	ComPtr<ID3D12Resource> vertexBuffer = CreateUploadBuffer(vertices, vbByteSize);
+
+	//ε 
+	UINT ibByteSize = 0;
+	ComPtr<ID3D12Resource> indexBuffer;
 
-		if (find(mSkinnedTextureName.begin(), mSkinnedTextureName.end(), normalName) == mSkinnedTextureName.end())
+	if (use16Bit)
+	{
+		vector<uint16_t> indices16(indexCount);
+		for (UINT i = 0; i < indexCount; i++)
+			indices16[i] = (uint16_t)indices[i];
+
+		for (const auto& rangeLods : lods)
 		{
-			mSkinnedTextureName.push_back(normalName);
-			texNames.push_back(normalName);
-			texPaths.push_back(normalFile);
+			for (const GeometryLod& lod : rangeLods)
+			{
+				if (lod.baseVertexLocation == 0)
+					continue;
+
+				for (UINT i = lod.startIndexLocation; i < lod.startIndexLocation + lod.indexCount; i++)
+					indices16[i] = (uint16_t)(indices[i] - lod.baseVertexLocation);
+			}
 		}
+
+		ibByteSize = indexCount * sizeof(uint16_t);
+		indexBuffer = CreateUploadBuffer(indices16.data(), ibByteSize);
+	}
+	else
+	{
+		ibByteSize = indexCount * sizeof(uint32_t);
+		indexBuffer = CreateUploadBuffer(indices, ibByteSize);
 	}
 
-	for (int i = 0; i < (int)texPaths.size(); i++)
+	//    Է (۴ ComPtr  )
+	for (size_t r = 0; r < ranges.size(); r++)
+	{
+		auto geo = std::make_unique<GeometryInfo>();
+		geo->name = ranges[r].name;
+
+		geo->vertexBuffer = vertexBuffer;
+		geo->vertexBufferView.BufferLocation = vertexBuffer->GetGPUVirtualAddress();
+		geo->vertexBufferView.StrideInBytes = vertexStride;
+		geo->vertexBufferView.SizeInBytes = vbByteSize;
+
+		geo->indexBuffer = indexBuffer;
+		geo->indexBufferView.BufferLocation = indexBuffer->GetGPUVirtualAddress();
+		geo->indexBufferView.Format = use16Bit ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+		geo->indexBufferView.SizeInBytes = ibByteSize;
+
+		geo->vertexCount = vertexCount;
+		geo->indexCount = ranges[r].indexCount;
+		geo->startIndexLocation = ranges[r].startIndexLocation;
+		geo->baseVertexLocation = lods[r][0].baseVertexLocation;
+		geo->posDequant = posDequant;
+		geo->boundingBox = boxes[r];
+		geo->boundingSphere = spheres[r];
+		geo->lods = move(lods[r]);
+
+		geometries.push_back(std::move(geo));
+	}
+
+	return (UINT64)vbByteSize + ibByteSize;
+}
+
+void InitDirect3DApp::AddGeometries(vector<unique_ptr<GeometryInfo>>& geometries)
+{
+	// ʱȭ ׷   ܰ谡 ÿ ִ´
+	lock_guard<mutex> lock(mGeometryMutex);
+
+	for (auto& geo : geometries)
+	{
+		GeometryInfo* geometry = geo.get();
+		mGeometries[geometry->name] = move(geo);
+
+		for (auto& item : mRenderItems)
+		{
+			if (item->geometry == nullptr && item->geometryName == geometry->name)
+				item->geometry = geometry;
+		}
+	}
+	geometries.clear();
+}
+
+void InitDirect3DApp::ComputeBounds(const void* vertices, UINT vertexStride, size_t positionOffset,
+	const uint32_t* indices, UINT indexCount, BoundingBox& box, BoundingSphere& sphere)
+{
+	const uint8_t* positions = (const uint8_t*)vertices + positionOffset;
+
+	if (indexCount == 0)
+	{
+		box = BoundingBox(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 0.0f));
+		sphere = BoundingSphere(XMFLOAT3(0.0f, 0.0f, 0.0f), 0.0f);
+		return;
+	}
+
+	// 1. AABB : к min / max
+	XMVECTOR vMin = XMVectorReplicate(+MathHelper::Infinity);
+	XMVECTOR vMax = XMVectorReplicate(-MathHelper::Infinity);
+	for (UINT i = 0; i < indexCount; i++)
+	{
+		XMVECTOR p = XMLoadFloat3((const XMFLOAT3*)(positions + (size_t)indices[i] * vertexStride));
+		vMin = XMVectorMin(vMin, p);
+		vMax = XMVectorMax(vMax, p);
+	}
+	BoundingBox::CreateFromPoints(box, vMin, vMax);
+
+	// 2.   : ߽ AABB ߽,    
+	//    (AABB  δ  ۴)
+	XMVECTOR center = XMLoadFloat3(&box.Center);
+	XMVECTOR maxDistSq = XMVectorZero();
+	for (UINT i = 0; i < indexCount; i++)
+	{
+		XMVECTOR p = XMLoadFloat3((const XMFLOAT3*)(positions + (size_t)indices[i] * vertexStride));
+		maxDistSq = XMVectorMax(maxDistSq, XMVector3LengthSq(p - center));
+	}
+
+	sphere.Center = box.Center;
+	sphere.Radius = XMVectorGetX(XMVectorSqrt(maxDistSq));
+}
+
+BoundingBox InitDirect3DApp::ComputeSkinnedBounds(const SkinnedData& skinnedInfo, const vector<SkinnedVertex>& vertices,
+	const uint32_t* indices, UINT indexCount)const
+{
+	// ,    ޴  ε  AABB
+	// Ű׵ ġ  ȯ ġ  ̹Ƿ
+	//  ڸ   ȯ ű ڵ  ׻  Ѵ
+	const UINT boneCount = skinnedInfo.BoneCount();
+	vector<XMVECTOR> boneMin(boneCount, XMVectorReplicate(+MathHelper::Infinity));
+	vector<XMVECTOR> boneMax(boneCount, XMVectorReplicate(-MathHelper::Infinity));
+	vector<bool> boneUsed(boneCount, false);
+
+	XMVECTOR bindMin = XMVectorReplicate(+MathHelper::Infinity);
+	XMVECTOR bindMax = XMVectorReplicate(-MathHelper::Infinity);
+
+	for (UINT i = 0; i < indexCount; i++)
+	{
+		const SkinnedVertex& v = vertices[indices[i]];
+		XMVECTOR p = XMLoadFloat3(&v.pos);
+		bindMin = XMVectorMin(bindMin, p);
+		bindMax = XMVectorMax(bindMax, p);
+
+		//  ° ġ ̴  1 - ( )
+		const float weights[4] = { v.boneWeights.x, v.boneWeights.y, v.boneWeights.z,
+			1.0f - v.boneWeights.x - v.boneWeights.y - v.boneWeights.z };
+		for (int j = 0; j < 4; j++)
+		{
+			const UINT bone = v.boneIndices[j];
+			if (weights[j] <= 0.0f || bone >= boneCount)
+				continue;
+
+			boneMin[bone] = XMVectorMin(boneMin[bone], p);
+			boneMax[bone] = XMVectorMax(boneMax[bone], p);
+			boneUsed[bone] = true;
+		}
+	}
+
+	BoundingBox bounds;
+	BoundingBox::CreateFromPoints(bounds, bindMin, bindMax);
+
+	//  Ŭ   ø (Ŭ  ε   ״)
+	vector<XMFLOAT4X4> transforms(boneCount);
+	bool first = true;
+	SkinnedData::EvalScratch scratch;
+	for (SkinnedData::ClipHandle clip = 0; clip < skinnedInfo.ClipCount(); clip++)
+	{
+		const float startTime = skinnedInfo.GetClipStartTime(clip);
+		const float endTime = skinnedInfo.GetClipEndTime(clip);
+		const UINT steps = MathHelper::Max(1u, (UINT)ceilf((endTime - startTime) * mSkinnedBoundsSampleRate));
+
+		// ð  øϹǷ Ű ˻   ̾
+		vector<UINT> keyCursors;
+		for (UINT s = 0; s <= steps; s++)
+		{
+			const float t = startTime + (endTime - startTime) * s / steps;
+			skinnedInfo.GetFinalTransforms(clip, t, transforms.data(), keyCursors, scratch);
+
+			for (UINT b = 0; b < boneCount; b++)
+			{
+				if (!boneUsed[b])
+					continue;
+
+				//  ۿ ġǾ Ƿ ǵ 
+				BoundingBox boneBox;
+				BoundingBox::CreateFromPoints(boneBox, boneMin[b], boneMax[b]);
+				boneBox.Transform(boneBox, XMMatrixTranspose(XMLoadFloat4x4(&transforms[b])));
+
+				if (first)
+					bounds = boneBox;
+				else
+					BoundingBox::CreateMerged(bounds, bounds, boneBox);
+				first = false;
+			}
+		}
+	}
+
+	return bounds;
+}
+
+void InitDirect3DApp::CheckSkinnedBounds(const string& geoPrefix, const SkinnedData& skinnedInfo, const vector<SkinnedVertex>& vertices,
+	const vector<uint32_t>& indices, const vector<SubmeshInfo>& submeshes, const GeometryInfo* const* geometries)
+{
+	// ̴  Ű  (ġ)
+	CpuSkinner::InputLayout in;
+	in.Stride = sizeof(SkinnedVertex);
+	in.Position = offsetof(SkinnedVertex, pos);
+	in.BoneWeights = offsetof(SkinnedVertex, boneWeights);
+	in.BoneIndices = offsetof(SkinnedVertex, boneIndices);
+
+	CpuSkinner::OutputLayout out;
+	out.Stride = sizeof(XMFLOAT3);
+	out.Position = 0;
+
+	vector<XMFLOAT3> posed(vertices.size());
+	vector<XMFLOAT4X4> transforms(skinnedInfo.BoneCount());
+	SkinnedData::EvalScratch scratch;
+
+	UINT poseCount = 0;
+	UINT64 outsideCount = 0;
+	float maxOutside = 0.0f;
+	double skinMs = 0.0;
+
+	// ComputeSkinnedBounds     4  
+	for (SkinnedData::ClipHandle clip = 0; clip < skinnedInfo.ClipCount(); clip++)
+	{
+		const float startTime = skinnedInfo.GetClipStartTime(clip);
+		const float endTime = skinnedInfo.GetClipEndTime(clip);
+		const UINT steps = MathHelper::Max(1u, (UINT)ceilf((endTime - startTime) * mSkinnedBoundsSampleRate * 4.0f));
+
+		vector<UINT> keyCursors;
+		for (UINT s = 0; s <= steps; s++)
+		{
+			const float t = startTime + (endTime - startTime) * s / steps;
+			skinnedInfo.GetFinalTransforms(clip, t, transforms.data(), keyCursors, scratch);
+
+			const auto start = chrono::steady_clock::now();
+			CpuSkinner::Skin(vertices.data(), vertices.size(), in, transforms.data(), transforms.size(),
+				posed.data(), out, &mThreadPool);
+			skinMs += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+			poseCount++;
+
+			for (size_t i = 0; i < submeshes.size(); i++)
+			{
+				const BoundingBox& box = geometries[i]->boundingBox;
+				XMVECTOR center = XMLoadFloat3(&box.Center);
+				XMVECTOR extents = XMLoadFloat3(&box.Extents);
+
+				for (UINT j = 0; j < submeshes[i].indexCount; j++)
+				{
+					//    Ÿ
+					XMVECTOR p = XMLoadFloat3(&posed[indices[submeshes[i].startIndexLocation + j]]);
+					XMVECTOR d = XMVectorMax(XMVectorSubtract(XMVectorAbs(XMVectorSubtract(p, center)), extents), XMVectorZero());
+					const float outside = XMVectorGetX(XMVector3Length(d));
+					if (outside > 0.0f)
+					{
+						outsideCount++;
+						maxOutside = MathHelper::Max(maxOutside, outside);
+					}
+				}
+			}
+		}
+	}
+
+	char msg[256];
+	sprintf_s(msg, "[CpuSkinner] %s : %zu vertices, %u poses, %.3f ms/pose, outside bounds %llu (max %.4f)\n",
+		geoPrefix.c_str(), vertices.size(), poseCount, poseCount > 0 ? skinMs / poseCount : 0.0, outsideCount, maxOutside);
+	OutputDebugStringA(msg);
+}
+
+UINT InitDirect3DApp::WeldVertices(const string& name, void* vertices, UINT vertexCount, UINT vertexStride,
+	const vector<VertexWelder::Attribute>& attributes, uint32_t* indices, UINT indexCount)
+{
+	const UINT weldedCount = (UINT)VertexWelder::Weld(vertices, vertexCount, vertexStride, attributes,
+		indices, indexCount, &mThreadPool);
+
+	string msg = "[VertexWelder] " + name + " : " + to_string(vertexCount) + " -> " + to_string(weldedCount) +
+		" vertices, " + to_string((UINT64)vertexCount * vertexStride) + " -> " + to_string((UINT64)weldedCount * vertexStride) + " bytes\n";
+	OutputDebugStringA(msg.c_str());
+
+	return weldedCount;
+}
+
+vector<VertexWelder::Attribute> InitDirect3DApp::GetWeldAttributes()const
+{
+	// ù ° Ӽ(ġ)  ؽø 
+	return
+	{
+		{ offsetof(Vertex, pos), 3, VertexWelder::AttributeType::Float, mWeldEpsilon.position },
+		{ offsetof(Vertex, normal), 3, VertexWelder::AttributeType::Float, mWeldEpsilon.normal },
+		{ offsetof(Vertex, uv), 2, VertexWelder::AttributeType::Float, mWeldEpsilon.uv },
+		{ offsetof(Vertex, tangent), 3, VertexWelder::AttributeType::Float, mWeldEpsilon.tangent }
+	};
+}
+
+vector<VertexWelder::Attribute> InitDirect3DApp::GetSkinnedWeldAttributes()const
+{
+	//  ε   ƾ Ѵ
+	return
+	{
+		{ offsetof(SkinnedVertex, pos), 3, VertexWelder::AttributeType::Float, mWeldEpsilon.position },
+		{ offsetof(SkinnedVertex, normal), 3, VertexWelder::AttributeType::Float, mWeldEpsilon.normal },
+		{ offsetof(SkinnedVertex, uv), 2, VertexWelder::AttributeType::Float, mWeldEpsilon.uv },
+		{ offsetof(SkinnedVertex, tangent), 3, VertexWelder::AttributeType::Float, mWeldEpsilon.tangent },
+		{ offsetof(SkinnedVertex, boneWeights), 3, VertexWelder::AttributeType::Float, mWeldEpsilon.boneWeight },
+		{ offsetof(SkinnedVertex, boneIndices), 4, VertexWelder::AttributeType::Bytes, 0.0f }
+	};
+}
+
+void InitDirect3DApp::OptimizeMesh(const string& name, void* vertices, UINT vertexCount, UINT vertexStride,
+	uint32_t* indices, UINT indexCount, const vector<SubmeshInfo>& ranges)
+{
+	const float acmrBefore = MeshOptimizer::ComputeACMR(indices, indexCount, vertexCount);
+
+	// 1. (޽) ﰢ  
+	//    ̹ ĳ       Ƿ ACMR  پ 츸 
+	vector<uint32_t> reordered;
+	for (const SubmeshInfo& range : ranges)
+	{
+		uint32_t* first = indices + range.startIndexLocation;
+
+		reordered.assign(first, first + range.indexCount);
+		MeshOptimizer::OptimizeVertexCache(reordered.data(), reordered.size(), vertexCount);
+
+		if (MeshOptimizer::ComputeACMR(reordered.data(), reordered.size(), vertexCount) <
+			MeshOptimizer::ComputeACMR(first, range.indexCount, vertexCount))
+		{
+			copy(reordered.begin(), reordered.end(), first);
+		}
+	}
+
+	// 2.  ó ̴  ġ (ε  )
+	MeshOptimizer::OptimizeVertexFetch(vertices, vertexCount, vertexStride, indices, indexCount);
+
+	const float acmrAfter = MeshOptimizer::ComputeACMR(indices, indexCount, vertexCount);
+
+	char msg[256];
+	sprintf_s(msg, "[MeshOptimizer] %s : ACMR %.3f -> %.3f\n", name.c_str(), acmrBefore, acmrAfter);
+	OutputDebugStringA(msg);
+}
+
+void InitDirect3DApp::BuildLods(const string& name, VertexType vertexType, const void* vertices, UINT vertexCount, UINT vertexStride,
+	vector<uint32_t>& indices, vector<vector<GeometryLod>>& lods)
+{
+	const size_t positionOffset = vertexType == VertexType::Skinned ? offsetof(SkinnedVertex, pos) : offsetof(Vertex, pos);
+	const uint8_t* positions = static_cast<const uint8_t*>(vertices) + positionOffset;
+
+	string msg = "[MeshSimplifier] " + name + " :";
+	vector<uint32_t> simplified;
+	for (auto& rangeLods : lods)
+	{
+		const UINT fullIndexCount = rangeLods[0].indexCount;
+		msg += " " + to_string(fullIndexCount / 3);
+
+		//  ܰ踦 ٽ ٿ  ܰ踦 
+		for (float ratio : mLodRatios)
+		{
+			const GeometryLod& prev = rangeLods.back();
+			const size_t target = (size_t)(fullIndexCount * ratio) / 3 * 3;
+
+			float error = 0.0f;
+			simplified.resize(prev.indexCount);
+			const size_t count = MeshSimplifier::Simplify(simplified.data(), indices.data() + prev.startIndexLocation,
+				prev.indexCount, positions, vertexStride, vertexCount, target, &error);
+
+			//  /        ʴ´
+			if (count == 0 || count > prev.indexCount * 9 / 10)
+				break;
+
+			MeshOptimizer::OptimizeVertexCache(simplified.data(), count, vertexCount);
+
+			GeometryLod lod;
+			lod.startIndexLocation = (UINT)indices.size();
+			lod.indexCount = (UINT)count;
+			lod.error = MathHelper::Max(prev.error, error);
+			indices.insert(indices.end(), simplified.begin(), simplified.begin() + count);
+			rangeLods.push_back(lod);
+
+			msg += " -> " + to_string(count / 3);
+		}
+		msg += ",";
+	}
+
+	msg.back() = '\n';
+	OutputDebugStringA(msg.c_str());
+}
+
+void InitDirect3DApp::BuildMeshlets(const string& name, VertexType vertexType, void* vertices, UINT vertexCount, UINT vertexStride,
+	uint32_t* indices, UINT indexCount, vector<vector<GeometryLod>>& lods)
+{
+	const size_t positionOffset = vertexType == VertexType::Skinned ? offsetof(SkinnedVertex, pos) : offsetof(Vertex, pos);
+	const uint8_t* positions = static_cast<const uint8_t*>(vertices) + positionOffset;
+
+	size_t meshletCount = 0;
+	for (auto& rangeLods : lods)
+	{
+		for (GeometryLod& lod : rangeLods)
+		{
+			uint32_t* first = indices + lod.startIndexLocation;
+			lod.meshlets = MeshletBuilder::Build(first, lod.indexCount, positions, vertexStride, vertexCount);
+
+			// ޽÷ ȿ ٽ  ĳ  (޽÷  ״)
+			for (const Meshlet& meshlet : lod.meshlets)
+				MeshOptimizer::OptimizeVertexCache(first + meshlet.IndexOffset, meshlet.TriangleCount * 3, vertexCount);
+
+			meshletCount += lod.meshlets.size();
+		}
+	}
+
+	// ﰢ  ٲǷ   ٽ 
+	MeshOptimizer::OptimizeVertexFetch(vertices, vertexCount, vertexStride, indices, indexCount);
+
+	char msg[256];
+	sprintf_s(msg, "[Meshlet] %s : %zu meshlets, %u triangles, ACMR %.3f\n", name.c_str(), meshletCount,
+		indexCount / 3, MeshOptimizer::ComputeACMR(indices, indexCount, vertexCount));
+	OutputDebugStringA(msg);
+}
+
+XMFLOAT4 InitDirect3DApp::PackVertices(VertexType vertexType, const void* vertices, UINT vertexCount, void* packedVertices)
+{
+	if (vertexCount == 0)
+		return XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+
+	// Ӽ 迭 ü   ȯ
+	if (vertexType == VertexType::Skinned)
 	{
-		auto texture = make_unique<TextureInfo>();
-		texture->name = texNames[i];
-		texture->fileName = texPaths[i];
+		const SkinnedVertex* src = static_cast<const SkinnedVertex*>(vertices);
+		PackedSkinnedVertex* dst = static_cast<PackedSkinnedVertex*>(packedVertices);
+		const size_t srcStride = sizeof(SkinnedVertex);
+		const size_t dstStride = sizeof(PackedSkinnedVertex);
+
+		XMFLOAT4 posDequant = VertexPacking::PackPositions(&src->pos, srcStride, vertexCount, &dst->pos, dstStride);
+		VertexPacking::PackUnitVectors(&src->normal, srcStride, vertexCount, &dst->normal, dstStride);
+		VertexPacking::PackUnitVectors(&src->tangent, srcStride, vertexCount, &dst->tangent, dstStride);
+		VertexPacking::PackTexCoords(&src->uv, srcStride, vertexCount, &dst->uv, dstStride);
+		VertexPacking::PackBoneWeights(&src->boneWeights, srcStride, vertexCount, &dst->boneWeights, dstStride);
+
+		for (UINT i = 0; i < vertexCount; i++)
+			memcpy(dst[i].boneIndices, src[i].boneIndices, sizeof(src[i].boneIndices));
+
+		return posDequant;
+	}
+
+	const Vertex* src = static_cast<const Vertex*>(vertices);
+	PackedVertex* dst = static_cast<PackedVertex*>(packedVertices);
+	const size_t srcStride = sizeof(Vertex);
+	const size_t dstStride = sizeof(PackedVertex);
+
+	XMFLOAT4 posDequant = VertexPacking::PackPositions(&src->pos, srcStride, vertexCount, &dst->pos, dstStride);
+	VertexPacking::PackUnitVectors(&src->normal, srcStride, vertexCount, &dst->normal, dstStride);
+	VertexPacking::PackUnitVectors(&src->tangent, srcStride, vertexCount, &dst->tangent, dstStride);
+	VertexPacking::PackTexCoords(&src->uv, srcStride, vertexCount, &dst->uv, dstStride);
+
+	return posDequant;
+}
+
+ComPtr<ID3D12Resource> InitDirect3DApp::CreateUploadBuffer(const void* data, UINT byteSize)
+{
+	ComPtr<ID3D12Resource> buffer;
+
+	D3D12_HEAP_PROPERTIES heapProperty = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
+	D3D12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Buffer(byteSize);
+
+	md3dDevice->CreateCommittedResource(
+		&heapProperty,
+		D3D12_HEAP_FLAG_NONE,
+		&desc,
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(&buffer));
 
-		ThrowIfFailed(DirectX::CreateDDSTextureFromFile12
-		(
-			md3dDevice.Get(),
-			mCommandList.Get(),
-			texture->fileName.c_str(),
-			texture->resource,
-			texture->uploadHeap
-		));
+	void* dataBuff = nullptr;
+	CD3DX12_RANGE range(0, 0);
+	buffer->Map(0, &range, &dataBuff);
+	memcpy(dataBuff, data, byteSize);
+	buffer->Unmap(0, nullptr);
 
-		mTextures[texture->name] = move(texture);
-	}
+	return buffer;
 }
 
 void InitDirect3DApp::BuildBoxGeometry()
@@ -707,65 +2034,9 @@ void InitDirect3DApp::BuildBoxGeometry()
 		vertices[k].tangent = box.Vertices[i].TangentU;
 	}
 
-	//ε 
-	std::vector<std::uint16_t> indices;
-	indices.insert(indices.end(), std::begin(box.GetIndices16()), std::end(box.GetIndices16()));
-
-	//   Է
-	auto geo = std::make_unique<GeometryInfo>();
-	geo->name = "Box";
-
-	//   
-	geo->vertexCount = (UINT)vertices.size();
-	const UINT vbByteSize = geo->vertexCount * sizeof(Vertex);
-
-	D3D12_HEAP_PROPERTIES heapProperty = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-	D3D12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Buffer(vbByteSize);
-
-	md3dDevice->CreateCommittedResource(
-		&heapProperty,
-		D3D12_HEAP_FLAG_NONE,
-		&desc,
-		D3D12_RESOURCE_STATE_GENERIC_READ,
-		nullptr,
-		IID_PPV_ARGS(&geo->vertexBuffer));
-
-	void* vertexDataBuff = nullptr;
-	CD3DX12_RANGE vertexRange(0, 0);
-	geo->vertexBuffer->Map(0, &vertexRange, &vertexDataBuff);
-	memcpy(vertexDataBuff, vertices.data(), vbByteSize);
-	geo->vertexBuffer->Unmap(0, nullptr);
-
-	geo->vertexBufferView.BufferLocation = geo->vertexBuffer->GetGPUVirtualAddress();
-	geo->vertexBufferView.StrideInBytes = sizeof(Vertex);
-	geo->vertexBufferView.SizeInBytes = vbByteSize;
-
-	//ε   
-	geo->indexCount = (UINT)indices.size();
-	const UINT ibByteSize = geo->indexCount * sizeof(uint16_t);
-
-	heapProperty = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-	desc = CD3DX12_RESOURCE_DESC::Buffer(ibByteSize);
-
-	md3dDevice->CreateCommittedResource(
-		&heapProperty,
-		D3D12_HEAP_FLAG_NONE,
-		&desc,
-		D3D12_RESOURCE_STATE_GENERIC_READ,
-		nullptr,
-		IID_PPV_ARGS(&geo->indexBuffer));
-
-	void* indexDataBuff = nullptr;
-	CD3DX12_RANGE indexRange(0, 0);
-	geo->indexBuffer->Map(0, &indexRange, &indexDataBuff);
-	memcpy(indexDataBuff, indices.data(), ibByteSize);
-	geo->indexBuffer->Unmap(0, nullptr);
-
-	geo->indexBufferView.BufferLocation = geo->indexBuffer->GetGPUVirtualAddress();
-	geo->indexBufferView.Format = DXGI_FORMAT_R16_UINT;
-	geo->indexBufferView.SizeInBytes = ibByteSize;
-
-	mGeometries[geo->name] = std::move(geo);
+	//   Է (ε  BuildGeometry  )
+	BuildGeometry("Box", VertexType::Standard, vertices.data(), (UINT)vertices.size(),
+		box.Indices32.data(), (UINT)box.Indices32.size());
 }
 
 void InitDirect3DApp::BuildGridGeometry()
@@ -785,65 +2056,9 @@ void InitDirect3DApp::BuildGridGeometry()
 		vertices[k].tangent = grid.Vertices[i].TangentU;
 	}
 
-	//ε 
-	std::vector<std::uint16_t> indices;
-	indices.insert(indices.end(), std::begin(grid.GetIndices16()), std::end(grid.GetIndices16()));
-
-	//   Է
-	auto geo = std::make_unique<GeometryInfo>();
-	geo->name = "Grid";
-
-	//   
-	geo->vertexCount = (UINT)vertices.size();
-	const UINT vbByteSize = geo->vertexCount * sizeof(Vertex);
-
-	D3D12_HEAP_PROPERTIES heapProperty = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-	D3D12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Buffer(vbByteSize);
-
-	md3dDevice->CreateCommittedResource(
-		&heapProperty,
-		D3D12_HEAP_FLAG_NONE,
-		&desc,
-		D3D12_RESOURCE_STATE_GENERIC_READ,
-		nullptr,
-		IID_PPV_ARGS(&geo->vertexBuffer));
-
-	void* vertexDataBuff = nullptr;
-	CD3DX12_RANGE vertexRange(0, 0);
-	geo->vertexBuffer->Map(0, &vertexRange, &vertexDataBuff);
-	memcpy(vertexDataBuff, vertices.data(), vbByteSize);
-	geo->vertexBuffer->Unmap(0, nullptr);
-
-	geo->vertexBufferView.BufferLocation = geo->vertexBuffer->GetGPUVirtualAddress();
-	geo->vertexBufferView.StrideInBytes = sizeof(Vertex);
-	geo->vertexBufferView.SizeInBytes = vbByteSize;
-
-	//ε   
-	geo->indexCount = (UINT)indices.size();
-	const UINT ibByteSize = geo->indexCount * sizeof(uint16_t);
-
-	heapProperty = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-	desc = CD3DX12_RESOURCE_DESC::Buffer(ibByteSize);
-
-	md3dDevice->CreateCommittedResource(
-		&heapProperty,
-		D3D12_HEAP_FLAG_NONE,
-		&desc,
-		D3D12_RESOURCE_STATE_GENERIC_READ,
-		nullptr,
-		IID_PPV_ARGS(&geo->indexBuffer));
-
-	void* indexDataBuff = nullptr;
-	CD3DX12_RANGE indexRange(0, 0);
-	geo->indexBuffer->Map(0, &indexRange, &indexDataBuff);
-	memcpy(indexDataBuff, indices.data(), ibByteSize);
-	geo->indexBuffer->Unmap(0, nullptr);
-
-	geo->indexBufferView.BufferLocation = geo->indexBuffer->GetGPUVirtualAddress();
-	geo->indexBufferView.Format = DXGI_FORMAT_R16_UINT;
-	geo->indexBufferView.SizeInBytes = ibByteSize;
-
-	mGeometries[geo->name] = std::move(geo);
+	//   Է (ε  BuildGeometry  )
+	BuildGeometry("Grid", VertexType::Standard, vertices.data(), (UINT)vertices.size(),
+		grid.Indices32.data(), (UINT)grid.Indices32.size());
 }
 
 void InitDirect3DApp::BuildSphereGeometry()
@@ -863,65 +2078,9 @@ void InitDirect3DApp::BuildSphereGeometry()
 		vertices[k].tangent = sphere.Vertices[i].TangentU;
 	}
 
-	//ε 
-	std::vector<std::uint16_t> indices;
-	indices.insert(indices.end(), std::begin(sphere.GetIndices16()), std::end(sphere.GetIndices16()));
-
-	//   Է
-	auto geo = std::make_unique<GeometryInfo>();
-	geo->name = "Sphere";
-
-	//   
-	geo->vertexCount = (UINT)vertices.size();
-	const UINT vbByteSize = geo->vertexCount * sizeof(Vertex);
-
-	D3D12_HEAP_PROPERTIES heapProperty = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-	D3D12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Buffer(vbByteSize);
-
-	md3dDevice->CreateCommittedResource(
-		&heapProperty,
-		D3D12_HEAP_FLAG_NONE,
-		&desc,
-		D3D12_RESOURCE_STATE_GENERIC_READ,
-		nullptr,
-		IID_PPV_ARGS(&geo->vertexBuffer));
-
-	void* vertexDataBuff = nullptr;
-	CD3DX12_RANGE vertexRange(0, 0);
-	geo->vertexBuffer->Map(0, &vertexRange, &vertexDataBuff);
-	memcpy(vertexDataBuff, vertices.data(), vbByteSize);
-	geo->vertexBuffer->Unmap(0, nullptr);
-
-	geo->vertexBufferView.BufferLocation = geo->vertexBuffer->GetGPUVirtualAddress();
-	geo->vertexBufferView.StrideInBytes = sizeof(Vertex);
-	geo->vertexBufferView.SizeInBytes = vbByteSize;
-
-	//ε   
-	geo->indexCount = (UINT)indices.size();
-	const UINT ibByteSize = geo->indexCount * sizeof(uint16_t);
-
-	heapProperty = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-	desc = CD3DX12_RESOURCE_DESC::Buffer(ibByteSize);
-
-	md3dDevice->CreateCommittedResource(
-		&heapProperty,
-		D3D12_HEAP_FLAG_NONE,
-		&desc,
-		D3D12_RESOURCE_STATE_GENERIC_READ,
-		nullptr,
-		IID_PPV_ARGS(&geo->indexBuffer));
-
-	void* indexDataBuff = nullptr;
-	CD3DX12_RANGE indexRange(0, 0);
-	geo->indexBuffer->Map(0, &indexRange, &indexDataBuff);
-	memcpy(indexDataBuff, indices.data(), ibByteSize);
-	geo->indexBuffer->Unmap(0, nullptr);
-
-	geo->indexBufferView.BufferLocation = geo->indexBuffer->GetGPUVirtualAddress();
-	geo->indexBufferView.Format = DXGI_FORMAT_R16_UINT;
-	geo->indexBufferView.SizeInBytes = ibByteSize;
-
-	mGeometries[geo->name] = std::move(geo);
+	//   Է (ε  BuildGeometry  )
+	BuildGeometry("Sphere", VertexType::Standard, vertices.data(), (UINT)vertices.size(),
+		sphere.Indices32.data(), (UINT)sphere.Indices32.size());
 }
 
 void InitDirect3DApp::BuildCylinderGeometry()
@@ -942,65 +2101,9 @@ void InitDirect3DApp::BuildCylinderGeometry()
 		vertices[k].tangent = cylinder.Vertices[i].TangentU;
 	}
 
-	//ε 
-	std::vector<std::uint16_t> indices;
-	indices.insert(indices.end(), std::begin(cylinder.GetIndices16()), std::end(cylinder.GetIndices16()));
-
-	//   Է
-	auto geo = std::make_unique<GeometryInfo>();
-	geo->name = "Cylinder";
-
-	//   
-	geo->vertexCount = (UINT)vertices.size();
-	const UINT vbByteSize = geo->vertexCount * sizeof(Vertex);
-
-	D3D12_HEAP_PROPERTIES heapProperty = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-	D3D12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Buffer(vbByteSize);
-
-	md3dDevice->CreateCommittedResource(
-		&heapProperty,
-		D3D12_HEAP_FLAG_NONE,
-		&desc,
-		D3D12_RESOURCE_STATE_GENERIC_READ,
-		nullptr,
-		IID_PPV_ARGS(&geo->vertexBuffer));
-
-	void* vertexDataBuff = nullptr;
-	CD3DX12_RANGE vertexRange(0, 0);
-	geo->vertexBuffer->Map(0, &vertexRange, &vertexDataBuff);
-	memcpy(vertexDataBuff, vertices.data(), vbByteSize);
-	geo->vertexBuffer->Unmap(0, nullptr);
-
-	geo->vertexBufferView.BufferLocation = geo->vertexBuffer->GetGPUVirtualAddress();
-	geo->vertexBufferView.StrideInBytes = sizeof(Vertex);
-	geo->vertexBufferView.SizeInBytes = vbByteSize;
-
-	//ε   
-	geo->indexCount = (UINT)indices.size();
-	const UINT ibByteSize = geo->indexCount * sizeof(uint16_t);
-
-	heapProperty = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-	desc = CD3DX12_RESOURCE_DESC::Buffer(ibByteSize);
-
-	md3dDevice->CreateCommittedResource(
-		&heapProperty,
-		D3D12_HEAP_FLAG_NONE,
-		&desc,
-		D3D12_RESOURCE_STATE_GENERIC_READ,
-		nullptr,
-		IID_PPV_ARGS(&geo->indexBuffer));
-
-	void* indexDataBuff = nullptr;
-	CD3DX12_RANGE indexRange(0, 0);
-	geo->indexBuffer->Map(0, &indexRange, &indexDataBuff);
-	memcpy(indexDataBuff, indices.data(), ibByteSize);
-	geo->indexBuffer->Unmap(0, nullptr);
-
-	geo->indexBufferView.BufferLocation = geo->indexBuffer->GetGPUVirtualAddress();
-	geo->indexBufferView.Format = DXGI_FORMAT_R16_UINT;
-	geo->indexBufferView.SizeInBytes = ibByteSize;
-
-	mGeometries[geo->name] = std::move(geo);
+	//   Է (ε  BuildGeometry  )
+	BuildGeometry("Cylinder", VertexType::Standard, vertices.data(), (UINT)vertices.size(),
+		cylinder.Indices32.data(), (UINT)cylinder.Indices32.size());
 }
 
 void InitDirect3DApp::BuildQuadGeometry()
@@ -1020,155 +2123,79 @@ void InitDirect3DApp::BuildQuadGeometry()
 		vertices[k].tangent = quad.Vertices[i].TangentU;
 	}
 
-	//ε 
-	std::vector<std::uint16_t> indices;
-	indices.insert(indices.end(), std::begin(quad.GetIndices16()), std::end(quad.GetIndices16()));
-
-	//   Է
-	auto geo = std::make_unique<GeometryInfo>();
-	geo->name = "Quad";
-
-	//   
-	geo->vertexCount = (UINT)vertices.size();
-	const UINT vbByteSize = geo->vertexCount * sizeof(Vertex);
-
-	D3D12_HEAP_PROPERTIES heapProperty = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-	D3D12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Buffer(vbByteSize);
-
-	md3dDevice->CreateCommittedResource(
-		&heapProperty,
-		D3D12_HEAP_FLAG_NONE,
-		&desc,
-		D3D12_RESOURCE_STATE_GENERIC_READ,
-		nullptr,
-		IID_PPV_ARGS(&geo->vertexBuffer));
-
-	void* vertexDataBuff = nullptr;
-	CD3DX12_RANGE vertexRange(0, 0);
-	geo->vertexBuffer->Map(0, &vertexRange, &vertexDataBuff);
-	memcpy(vertexDataBuff, vertices.data(), vbByteSize);
-	geo->vertexBuffer->Unmap(0, nullptr);
-
-	geo->vertexBufferView.BufferLocation = geo->vertexBuffer->GetGPUVirtualAddress();
-	geo->vertexBufferView.StrideInBytes = sizeof(Vertex);
-	geo->vertexBufferView.SizeInBytes = vbByteSize;
-
-	//ε   
-	geo->indexCount = (UINT)indices.size();
-	const UINT ibByteSize = geo->indexCount * sizeof(uint16_t);
-
-	heapProperty = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-	desc = CD3DX12_RESOURCE_DESC::Buffer(ibByteSize);
-
-	md3dDevice->CreateCommittedResource(
-		&heapProperty,
-		D3D12_HEAP_FLAG_NONE,
-		&desc,
-		D3D12_RESOURCE_STATE_GENERIC_READ,
-		nullptr,
-		IID_PPV_ARGS(&geo->indexBuffer));
-
-	void* indexDataBuff = nullptr;
-	CD3DX12_RANGE indexRange(0, 0);
-	geo->indexBuffer->Map(0, &indexRange, &indexDataBuff);
-	memcpy(indexDataBuff, indices.data(), ibByteSize);
-	geo->indexBuffer->Unmap(0, nullptr);
-
-	geo->indexBufferView.BufferLocation = geo->indexBuffer->GetGPUVirtualAddress();
-	geo->indexBufferView.Format = DXGI_FORMAT_R16_UINT;
-	geo->indexBufferView.SizeInBytes = ibByteSize;
-
-	mGeometries[geo->name] = std::move(geo);
+	//   Է (ε  BuildGeometry  )
+	BuildGeometry("Quad", VertexType::Standard, vertices.data(), (UINT)vertices.size(),
+		quad.Indices32.data(), (UINT)quad.Indices32.size());
 }
 
 void InitDirect3DApp::BuildSkullGeometry()
 {
-	ifstream fin("../Models/skull.txt");
-
-	if (!fin)
-	{
-		MessageBox(0, L"../Models/skull.txt Not Found.", 0, 0);
-		return;
-	}
-
-	UINT vCnt = 0, tCnt = 0;
-	string ignore;
-
-	fin >> ignore >> vCnt;
-	fin >> ignore >> tCnt;
-	fin >> ignore >> ignore >> ignore >> ignore;
-
-	vector<Vertex> vertices(vCnt);
-	for (int i = 0; i < vCnt; i++)
-	{
-		fin >> vertices[i].pos.x >> vertices[i].pos.y >> vertices[i].pos.z;
-		fin >> vertices[i].normal.x >> vertices[i].normal.y >> vertices[i].normal.z;
-	}
-
-	fin >> ignore >> ignore >> ignore;
-	vector<uint32_t> indices(tCnt * 3);
+	// Ľ /  /   Ŀ, mGeometries   忡 ִ´
+	auto geometries = make_shared<vector<unique_ptr<GeometryInfo>>>();
 
-	for (int i = 0; i < indices.size(); i++)
+	auto load = [this, geometries]()
 	{
-		fin >> indices[i];
-	}
-	fin.close();
+		// ī̺꿡  ޽ô Ľ /  / ȭ  
+		const AssetArchive::Entry* baked = mAssetArchive.Find("../Models/skull.txt", AssetArchive::AssetType::Mesh);
+		if (baked != nullptr)
+		{
+			static_assert(sizeof(Vertex) == sizeof(AssetArchive::MeshVertex), "Vertex layout mismatch");
+			CreateGeometry("Skull", VertexType::Standard, mAssetArchive.MeshVertices(*baked), baked->VertexCount,
+				mAssetArchive.MeshIndices(*baked), baked->IndexCount, *geometries, {}, true);
+			return true;
+		}
 
-	//   Է
-	auto geo = std::make_unique<GeometryInfo>();
-	geo->name = "Skull";
+		TextScanner fin;
 
-	//   
-	geo->vertexCount = (UINT)vertices.size();
-	const UINT vbByteSize = geo->vertexCount * sizeof(Vertex);
+		if (!fin.Open("../Models/skull.txt"))
+		{
+			OutputDebugStringA("[Skull] ../Models/skull.txt Not Found.\n");
+			return false;
+		}
 
-	D3D12_HEAP_PROPERTIES heapProperty = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-	D3D12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Buffer(vbByteSize);
+		UINT vCnt = 0, tCnt = 0;
 
-	md3dDevice->CreateCommittedResource(
-		&heapProperty,
-		D3D12_HEAP_FLAG_NONE,
-		&desc,
-		D3D12_RESOURCE_STATE_GENERIC_READ,
-		nullptr,
-		IID_PPV_ARGS(&geo->vertexBuffer));
+		fin.Skip() >> vCnt;
+		fin.Skip() >> tCnt;
+		fin.Skip(4);
 
-	void* vertexDataBuff = nullptr;
-	CD3DX12_RANGE vertexRange(0, 0);
-	geo->vertexBuffer->Map(0, &vertexRange, &vertexDataBuff);
-	memcpy(vertexDataBuff, vertices.data(), vbByteSize);
-	geo->vertexBuffer->Unmap(0, nullptr);
+		vector<Vertex> vertices(vCnt);
+		for (int i = 0; i < vCnt; i++)
+		{
+			fin >> vertices[i].pos.x >> vertices[i].pos.y >> vertices[i].pos.z;
+			fin >> vertices[i].normal.x >> vertices[i].normal.y >> vertices[i].normal.z;
+		}
 
-	geo->vertexBufferView.BufferLocation = geo->vertexBuffer->GetGPUVirtualAddress();
-	geo->vertexBufferView.StrideInBytes = sizeof(Vertex);
-	geo->vertexBufferView.SizeInBytes = vbByteSize;
+		fin.Skip(3);
+		vector<uint32_t> indices(tCnt * 3);
 
-	//ε   
-	geo->indexCount = (UINT)indices.size();
-	const UINT ibByteSize = geo->indexCount * sizeof(uint32_t);
+		for (int i = 0; i < indices.size(); i++)
+		{
+			fin >> indices[i];
+		}
 
-	heapProperty = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-	desc = CD3DX12_RESOURCE_DESC::Buffer(ibByteSize);
+		if (fin.Fail())
+		{
+			OutputDebugStringA("[Skull] ../Models/skull.txt : parse error\n");
+			return false;
+		}
 
-	md3dDevice->CreateCommittedResource(
-		&heapProperty,
-		D3D12_HEAP_FLAG_NONE,
-		&desc,
-		D3D12_RESOURCE_STATE_GENERIC_READ,
-		nullptr,
-		IID_PPV_ARGS(&geo->indexBuffer));
+		// ߺ  ġ
+		vertices.resize(WeldVertices("Skull", vertices.data(), (UINT)vertices.size(), sizeof(Vertex),
+			GetWeldAttributes(), indices.data(), (UINT)indices.size()));
 
-	void* indexDataBuff = nullptr;
-	CD3DX12_RANGE indexRange(0, 0);
-	geo->indexBuffer->Map(0, &indexRange, &indexDataBuff);
-	memcpy(indexDataBuff, indices.data(), ibByteSize);
-	geo->indexBuffer->Unmap(0, nullptr);
+		//   Է ( 65536 ̸̸ 16Ʈ ε ö󰣴)
+		CreateGeometry("Skull", VertexType::Standard, vertices.data(), (UINT)vertices.size(),
+			indices.data(), (UINT)indices.size(), *geometries);
+		return true;
+	};
 
-	geo->indexBufferView.BufferLocation = geo->indexBuffer->GetGPUVirtualAddress();
-	geo->indexBufferView.Format = DXGI_FORMAT_R32_UINT;
-	geo->indexBufferView.SizeInBytes = ibByteSize;
+	auto finish = [this, geometries]()
+	{
+		AddGeometries(*geometries);
+	};
 
-	mGeometries[geo->name] = std::move(geo);
+	mSkullAsset = mAssetManager.Load("../Models/skull.txt", load, finish);
 }
 
 void InitDirect3DApp::BuildMaterials()
@@ -1243,24 +2270,6 @@ void InitDirect3DApp::BuildMaterials()
 		skybox->roughness = 1.0f;
 		mMateirals[skybox->name] = move(skybox);
 	}
-
-	UINT matCBIdx = 7;
-	UINT srvHeapIdx = mSkinnedSrvHeapStart;
-
-	for (UINT i = 0; i < (UINT)mSkinnedMats.size(); i++)
-	{
-		auto mat = make_unique<MaterialInfo>();
-		mat->name = mSkinnedMats[i].Name;
-		mat->matCBIdx = matCBIdx++;
-		mat->diffuseSrvHeapIndex = srvHeapIdx++;
-		mat->normalSrvHeapIndex = srvHeapIdx++;
-
-		mat->diffuseAlbedo = mSkinnedMats[i].DiffuseAlbedo;
-		mat->fresnelR0 = mSkinnedMats[i].FresnelR0;
-		mat->roughness = mSkinnedMats[i].Roughness;
-
-		mMateirals[mat->name] = move(mat);
-	}
 }
 
 void InitDirect3DApp::BuildRenderItems()
@@ -1307,7 +2316,7 @@ void InitDirect3DApp::BuildRenderItems()
 		XMStoreFloat4x4(&skull->world, XMMatrixScaling(0.5f, 0.5f, 0.5f) * XMMatrixTranslation(0.f, 1.0f, 0.f));
 		skull->objCbIndex = 3;
 		skull->material = mMateirals["skull"].get();
-		skull->geometry = mGeometries["Skull"].get();
+		skull->geometryName = "Skull";	// 񵿱 ε, غǸ AddGeometries  
 		skull->primitiveTopology = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 		mItemLayer[(int)RenderLayer::Opaque].push_back(skull.get());
 		mRenderItems.push_back(move(skull));
@@ -1367,31 +2376,6 @@ void InitDirect3DApp::BuildRenderItems()
 		mItemLayer[(int)RenderLayer::Opaque].push_back(rightSphere.get());
 		mRenderItems.push_back(move(rightSphere));
 	}
-
-	{
-		for (UINT i = 0; i < (UINT)mSkinnedMats.size(); i++)
-		{
-			auto rItem = make_unique<RenderItem>();
-			XMMATRIX scale = XMMatrixScaling(0.05f, 0.05f, -0.05f);
-			XMMATRIX rotation = XMMatrixRotationY(MathHelper::Pi);
-			XMMATRIX pos = XMMatrixTranslation(0.0f, 0.0f, -5.0f);
-			XMStoreFloat4x4(&rItem->world, scale * rotation* pos);
-
-			rItem->texTransform = MathHelper::Identity4x4();
-			rItem->objCbIndex = objCBIdx++;
-			rItem->material = mMateirals[mSkinnedMats[i].Name].get();
-
-			string meshName = "sm_" + to_string(i);
-			rItem->geometry = mGeometries[meshName].get();
-			rItem->primitiveTopology = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-
-			rItem->skinnedCBIndex = 0;
-			rItem->skinnedModelInst = mSkinnedModelInst.get();
-
-			mItemLayer[(int)RenderLayer::SkinnedOpaque].push_back(rItem.get());
-			mRenderItems.push_back(move(rItem));
-		}
-	}
 }
 
 void InitDirect3DApp::BuildInputLayout()
@@ -1419,6 +2403,28 @@ void InitDirect3DApp::BuildInputLayout()
 
 }
 
+void InitDirect3DApp::BuildPackedInputLayout()
+{
+	// PackedVertex / PackedSkinnedVertex   ġ
+	mInputLayout =
+	{
+		{"POSITION", 0, DXGI_FORMAT_R16G16B16A16_SNORM, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},	// 0 ~ 7 (8)
+		{"NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, 8, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},			// 8 ~ 11 (4)
+		{"TANGENT", 0, DXGI_FORMAT_R16G16_SNORM, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},		// 12 ~ 15 (4)
+		{"TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 0, 16, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0}		// 16 ~ 19 (4)
+	};
+
+	mSkinnedInputLayout =
+	{
+		{"POSITION", 0, DXGI_FORMAT_R16G16B16A16_SNORM, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},	// 0 ~ 7 (8)
+		{"NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, 8, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},			// 8 ~ 11 (4)
+		{"TANGENT", 0, DXGI_FORMAT_R16G16_SNORM, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},		// 12 ~ 15 (4)
+		{"TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 0, 16, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},		// 16 ~ 19 (4)
+		{"WEIGHTS", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 0, 20, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},		// 20 ~ 23 (4)
+		{"BONEINDICES", 0, DXGI_FORMAT_R8G8B8A8_UINT, 0, 24, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0}	// 24 ~ 27 (4)
+	};
+}
+
 void InitDirect3DApp::BuildShader()
 {
 	const D3D_SHADER_MACRO defines[] =
@@ -1440,21 +2446,77 @@ void InitDirect3DApp::BuildShader()
 		NULL, NULL
 	};
 
+	//   д  ̴
+	const D3D_SHADER_MACRO packedDefines[] =
+	{
+		"PACKED", "1",
+		NULL, NULL
+	};
+
+	const D3D_SHADER_MACRO skinnedPackedDefines[] =
+	{
+		"SKINNED", "1",
+		"PACKED", "1",
+		NULL, NULL
+	};
+
+	const D3D_SHADER_MACRO* vsDefines = mPackedVertices ? packedDefines : nullptr;
+	const D3D_SHADER_MACRO* skinnedVsDefines = mPackedVertices ? skinnedPackedDefines : skinnedDefines;
 
-	mShaders["standardVS"] = d3dUtil::CompileShader(L"Color.hlsl", nullptr, "VS", "vs_5_0");
-	mShaders["skinnedVS"] = d3dUtil::CompileShader(L"Color.hlsl", skinnedDefines, "VS", "vs_5_0");
-	mShaders["opaquePS"] = d3dUtil::CompileShader(L"Color.hlsl", defines, "PS", "ps_5_0");
-	mShaders["alphaTestedPS"] = d3dUtil::CompileShader(L"Color.hlsl", alphaTestDefines, "PS", "ps_5_0");
 
-	mShaders["skyboxVS"] = d3dUtil::CompileShader(L"SkyBox.hlsl", nullptr, "VS", "vs_5_0");
-	mShaders["skyboxPS"] = d3dUtil::CompileShader(L"SkyBox.hlsl", nullptr, "PS", "ps_5_0");
+	// ̴   (D3DCompile  忡 ϴ)
+	struct ShaderDesc
+	{
+		const char* name;
+		const wchar_t* fileName;
+		const D3D_SHADER_MACRO* defines;
+		const char* entryPoint;
+		const char* target;
+	};
+
+	const ShaderDesc shaderDescs[] =
+	{
+		{ "standardVS", L"Color.hlsl", vsDefines, "VS", "vs_5_0" },
+		{ "skinnedVS", L"Color.hlsl", skinnedVsDefines, "VS", "vs_5_0" },
+		{ "opaquePS", L"Color.hlsl", defines, "PS", "ps_5_0" },
+		{ "alphaTestedPS", L"Color.hlsl", alphaTestDefines, "PS", "ps_5_0" },
+
+		{ "skyboxVS", L"SkyBox.hlsl", vsDefines, "VS", "vs_5_0" },
+		{ "skyboxPS", L"SkyBox.hlsl", nullptr, "PS", "ps_5_0" },
+
+		{ "shadowVS", L"Shadow.hlsl", vsDefines, "VS", "vs_5_0" },
+		{ "skinnedShadowVS", L"Shadow.hlsl", skinnedVsDefines, "VS", "vs_5_0" },
+		{ "shadowPS", L"Shadow.hlsl", nullptr, "PS", "ps_5_0" },
+
+		{ "debugVS", L"ShadowDebug.hlsl", vsDefines, "VS", "vs_5_0" },
+		{ "debugPS", L"ShadowDebug.hlsl", nullptr, "PS", "ps_5_0" },
+	};
+	const size_t shaderCount = _countof(shaderDescs);
 
-	mShaders["shadowVS"] = d3dUtil::CompileShader(L"Shadow.hlsl", nullptr, "VS", "vs_5_0");
-	mShaders["skinnedShadowVS"] = d3dUtil::CompileShader(L"Shadow.hlsl", skinnedDefines, "VS", "vs_5_0");
-	mShaders["shadowPS"] = d3dUtil::CompileShader(L"Shadow.hlsl", nullptr, "PS", "ps_5_0");
+	//   (DxException)  ParallelFor     忡 ٽ 
+	vector<ComPtr<ID3DBlob>> blobs(shaderCount);
+	vector<exception_ptr> errors(shaderCount);
+	mThreadPool.ParallelFor(shaderCount, [&](size_t i)
+		{
+			const ShaderDesc& desc = shaderDescs[i];
+			try
+			{
+				blobs[i] = d3dUtil::CompileShader(desc.fileName, desc.defines, desc.entryPoint, desc.target);
+			}
+			catch (...)
+			{
+				errors[i] = current_exception();
+			}
+		});
+
+	for (size_t i = 0; i < shaderCount; i++)
+	{
+		if (errors[i])
+			rethrow_exception(errors[i]);
+	}
 
-	mShaders["debugVS"] = d3dUtil::CompileShader(L"ShadowDebug.hlsl", nullptr, "VS", "vs_5_0");
-	mShaders["debugPS"] = d3dUtil::CompileShader(L"ShadowDebug.hlsl", nullptr, "PS", "ps_5_0");
+	for (size_t i = 0; i < shaderCount; i++)
+		mShaders[shaderDescs[i].name] = blobs[i];
 
 }
 
@@ -1464,7 +2526,7 @@ void InitDirect3DApp::BuildConstantBuffers()
 	{
 		UINT size = sizeof(ObjectConstants);
 		mObjectByteSize = (size + 255) & ~255;
-		mObjectByteSize *= mRenderItems.size();
+		mObjectByteSize *= mMaxObjectCount;
 		// ø ؼ 256   ٲִ ڵ~~
 
 		D3D12_HEAP_PROPERTIES heapProperty = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
@@ -1488,7 +2550,7 @@ void InitDirect3DApp::BuildConstantBuffers()
 	{
 		UINT size = sizeof(MatConstants);
 		mMaterialByteSize = (size + 255) & ~255;
-		mMaterialByteSize *= mMateirals.size();
+		mMaterialByteSize *= mMaxMaterialCount;
 		// ø ؼ 256   ٲִ ڵ~~
 
 		D3D12_HEAP_PROPERTIES heapProperty = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
@@ -1534,7 +2596,7 @@ void InitDirect3DApp::BuildConstantBuffers()
 	// Bone Transform  
 	{
 		UINT size = sizeof(SkinnedConstants);
-		mSkinnedByteSize = ((size + 255) & ~255) * 2;
+		mSkinnedByteSize = ((size + 255) & ~255) * mCrowdSize;	// νϽ ϳ
 		// ø ؼ 256   ٲִ ڵ~~
 
 		D3D12_HEAP_PROPERTIES heapProperty = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
@@ -1605,66 +2667,38 @@ void InitDirect3DApp::BuildDescriptorHeaps()
 {
 	mCbvSrvDescriptorSize = md3dDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 
-	// srv 
+	// srv  : 񵿱 ö ؽ ڸ ̸ ´
 	D3D12_DESCRIPTOR_HEAP_DESC srvHeapDesc = {};
-	srvHeapDesc.NumDescriptors = (int)mTextures.size() + 1; //  ؽ + ׸ڸ ؽ
+	srvHeapDesc.NumDescriptors = mSrvHeapCapacity;
 	srvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
 	srvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
 	md3dDevice->CreateDescriptorHeap(&srvHeapDesc, IID_PPV_ARGS(&mSrvDescriptorHeap));
 
-	CD3DX12_CPU_DESCRIPTOR_HANDLE hDescriptor(mSrvDescriptorHeap->GetCPUDescriptorHandleForHeapStart());
-
-	vector<ComPtr<ID3D12Resource>> tex2DList =
-	{
-		mTextures["bricks"]->resource,
-		mTextures["bricksNormal"]->resource,
-		mTextures["stone"]->resource,
-		mTextures["tile"]->resource,
-		mTextures["tileNormal"]->resource,
-		mTextures["fence"]->resource,
-		mTextures["default"]->resource
-	};
-
-	mSkinnedSrvHeapStart = (UINT)tex2DList.size();
-
-	for (UINT i = 0; i < (UINT)mSkinnedTextureName.size(); i++)
-	{
-		auto texResource = mTextures[mSkinnedTextureName[i]]->resource;
-		assert(texResource != nullptr);
-
-		tex2DList.push_back(texResource);
-	}
-
-	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-	srvDesc.Texture2D.MostDetailedMip = 0;
-	srvDesc.Texture2D.ResourceMinLODClamp = 0.0f;
+	// ؽİ غ  null SRV ( ؽ  ׸, ī̹ڽ )
+	// غǸ CreateTextureSrv   ڸ 
+	D3D12_SHADER_RESOURCE_VIEW_DESC nullSrvDesc = {};
+	nullSrvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	nullSrvDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
 
-	for (int i = 0; i < (int)tex2DList.size(); i++)
+	CD3DX12_CPU_DESCRIPTOR_HANDLE hDescriptor(mSrvDescriptorHeap->GetCPUDescriptorHandleForHeapStart());
+	for (UINT i = 0; i < mSrvHeapCapacity; i++)
 	{
-		srvDesc.Format = tex2DList[i]->GetDesc().Format;
-		srvDesc.Texture2D.MipLevels = tex2DList[i]->GetDesc().MipLevels;
-		md3dDevice->CreateShaderResourceView(tex2DList[i].Get(), &srvDesc, hDescriptor);
+		if (i == mSkyboxTexHeapIndex)
+		{
+			nullSrvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBE;
+			nullSrvDesc.TextureCube.MipLevels = 1;
+		}
+		else
+		{
+			nullSrvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+			nullSrvDesc.Texture2D.MipLevels = 1;
+		}
+		md3dDevice->CreateShaderResourceView(nullptr, &nullSrvDesc, hDescriptor);
 
 		hDescriptor.Offset(1, mCbvSrvDescriptorSize);	// next Descriptor
 	}
 
-	// --------------- SKY BOX ---------------
-	auto skyCubeMap = mTextures["skyCubeMap"]->resource;
-	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBE;
-	srvDesc.TextureCube.MostDetailedMip = 0;
-	srvDesc.TextureCube.MipLevels = skyCubeMap->GetDesc().MipLevels;
-	srvDesc.TextureCube.ResourceMinLODClamp = 0.0f;
-	srvDesc.Format = skyCubeMap->GetDesc().Format;
-	md3dDevice->CreateShaderResourceView(skyCubeMap.Get(), &srvDesc, hDescriptor);
-	// ---------------------------------------
-
-	mSkyboxTexHeapIndex = (UINT)tex2DList.size();
-
 	// ----------------- SHADOW MAP --------------
-	mShadowMapHeapIndex = mSkyboxTexHeapIndex + 1;
-
 	auto srvCpuStart = mSrvDescriptorHeap->GetCPUDescriptorHandleForHeapStart();
 	auto srvGpuStart = mSrvDescriptorHeap->GetGPUDescriptorHandleForHeapStart();
 	auto dsvCpuStart = mDsvHeap->GetCPUDescriptorHandleForHeapStart();
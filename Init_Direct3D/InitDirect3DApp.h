@@ -3,12 +3,26 @@
 #include "D3dApp.h"
 #include "D3dHeader.h"
 #include <DirectXColors.h>
+#include <chrono>
+#include <mutex>
 #include "../Common/MathHelper.h"
 #include "../Common/GeometryGenerator.h"
 #include "../Common/DDSTextureLoader.h"
 #include "../Common/Camera.h"
 #include "ShadowMap.h"
 #include "LoadM3d.h"
+#include "M3dCache.h"
+#include "AssetArchive.h"
+#include "TextScanner.h"
+#include "ThreadPool.h"
+#include "AssetManager.h"
+#include "TaskGraph.h"
+#include "MeshOptimizer.h"
+#include "VertexWelder.h"
+#include "CpuSkinner.h"
+#include "VertexPacking.h"
+#include "MeshletBuilder.h"
+#include "MeshSimplifier.h"
 #include "SkinnedData.h"
 
 class InitDirect3DApp : public D3DApp
@@ -20,13 +34,21 @@ public:
 	virtual bool Initialize()override;
 
 private:
+	// ʱȭ ܰ躰 ð Ӱ  
+	void LogStartupGraph(const TaskGraph& graph);
+
 	virtual void OnResize() override;
 	virtual void Update(const GameTimer& gt) override;
 
+	void UpdateAssets(const GameTimer& gt);
 	void UpdateCamera(const GameTimer& gt);
+	void UpdateBounds(const GameTimer& gt);
+	void UpdateLods(const GameTimer& gt);
+	void UpdateAnimationLods(const GameTimer& gt);
 	void UpdateObjectCBs(const GameTimer& gt);
 	void UpdateMaterialCB(const GameTimer& gt);
 	void UpdateShadowTransform(const GameTimer& gt);
+	void UpdateCullViews(const GameTimer& gt);
 	void UpdatePassCB(const GameTimer& gt);
 	void UpdateShadowPassCB(const GameTimer& gt);
 	void UpdateSkinnedPassCBs(const GameTimer& gt);
@@ -34,8 +56,11 @@ private:
 	virtual void DrawBegin(const GameTimer& gt) override;
 	
 	virtual void Draw(const GameTimer& gt) override;
-	void DrawRenderItems(vector<RenderItem*>& renderItems);
+	// cullView   ޽÷  øؼ ̴ ε  ׸
+	void DrawRenderItems(vector<RenderItem*>& renderItems, const ClusterCullView* cullView = nullptr);
 	void DrawSceneToShadowMap();
+	void CullMeshlets(const RenderItem& item, const GeometryLod& lod, const ClusterCullView& cullView,
+		vector<pair<UINT, UINT>>& visibleRanges);
 
 	virtual void DrawEnd(const GameTimer& gt) override;
 	
@@ -43,12 +68,27 @@ private:
 	virtual void OnMouseUp(WPARAM btnState, int x, int y) override;
 	virtual void OnMouseMove(WPARAM btnState, int x, int y) override;
 
+	virtual wstring GetFrameStatsText() override;
+
 private:
-	// Skinned Model ε
+	// Skinned Model ε (񵿱, غǸ BuildSkinnedModelItems)
 	void LoadSkinnedModel();
-
-	// ؽ ε
+	void BuildSkinnedGeometry(const string& geoPrefix, const SkinnedData& skinnedInfo, const vector<SkinnedVertex>& vertices,
+		const vector<uint32_t>& indices, const vector<M3DLoader::Subset>& subsets, vector<unique_ptr<GeometryInfo>>& geometries,
+		bool optimized = false);
+	void BuildSkinnedModelItems();
+	//      ӵ (νϽ / ms)   â 
+	void BenchmarkCrowd();
+
+	// ؽ ε (񵿱)
+	// Ŀ  а,  忡 ε  Ͽ   srvHeapIndex ڸ SRV 
 	void LoadTextures();
+	AssetManager::Handle LoadTexture(const string& name, const string& fileName, int srvHeapIndex, bool cubeMap = false);
+	void CreateTextureSrv(const TextureInfo& texture);
+	bool IsSrvReady(int srvHeapIndex)const;
+
+	//  Ϸ ݹ鿡  ε   (UpdateAssets  )
+	ID3D12GraphicsCommandList* GetUploadCommandList();
 
 	//   
 	void BuildBoxGeometry();
@@ -58,6 +98,56 @@ private:
 	void BuildQuadGeometry();
 	void BuildSkullGeometry();
 
+	//     
+	// ε   R16 / R32     (޽ð  ޽ø baseVertexLocation )
+	// mPackedVertices    ٲ㼭 ø
+	// optimized  ( ī̺꿡  ޽)  ĳ / fetch ȭ 
+	// ȯ ö VB + IB ũ
+	UINT64 BuildGeometry(const string& name, VertexType vertexType, const void* vertices, UINT vertexCount,
+		const uint32_t* indices, UINT indexCount, const vector<SubmeshInfo>& submeshes = {}, bool optimized = false);
+
+	// BuildGeometry  mGeometries  ֱ  (Ŀ 忡 ȣ )
+	UINT64 CreateGeometry(const string& name, VertexType vertexType, const void* vertices, UINT vertexCount,
+		const uint32_t* indices, UINT indexCount, vector<unique_ptr<GeometryInfo>>& geometries,
+		const vector<SubmeshInfo>& submeshes = {}, bool optimized = false);
+
+	// mGeometries  ְ,  ϸ ٸ ۿ 
+	void AddGeometries(vector<unique_ptr<GeometryInfo>>& geometries);
+	ComPtr<ID3D12Resource> CreateUploadBuffer(const void* data, UINT byteSize);
+
+	// ߺ /   ġ (ε  ), ģ    ȯ
+	UINT WeldVertices(const string& name, void* vertices, UINT vertexCount, UINT vertexStride,
+		const vector<VertexWelder::Attribute>& attributes, uint32_t* indices, UINT indexCount);
+	vector<VertexWelder::Attribute> GetWeldAttributes()const;
+	vector<VertexWelder::Attribute> GetSkinnedWeldAttributes()const;
+
+	//  ĳ(ﰢ ) /  fetch( ) ȭ,  ACMR  
+	void OptimizeMesh(const string& name, void* vertices, UINT vertexCount, UINT vertexStride,
+		uint32_t* indices, UINT indexCount, const vector<SubmeshInfo>& ranges);
+
+	//  mLodRatios  LOD   indices ڿ δ (lods[r][0]   )
+	void BuildLods(const string& name, VertexType vertexType, const void* vertices, UINT vertexCount, UINT vertexStride,
+		vector<uint32_t>& indices, vector<vector<GeometryLod>>& lods);
+
+	// LOD  ޽÷  (ﰢ ޽÷  ġ)
+	void BuildMeshlets(const string& name, VertexType vertexType, void* vertices, UINT vertexCount, UINT vertexStride,
+		uint32_t* indices, UINT indexCount, vector<vector<GeometryLod>>& lods);
+
+	// ε Ű  ġ AABB    (SIMD min / max)
+	static void ComputeBounds(const void* vertices, UINT vertexStride, size_t positionOffset,
+		const uint32_t* indices, UINT indexCount, BoundingBox& box, BoundingSphere& sphere);
+
+	//  Ŭ mSkinnedBoundsSampleRate  øؼ, ִϸ̼   ϴ  AABB
+	BoundingBox ComputeSkinnedBounds(const SkinnedData& skinnedInfo, const vector<SkinnedVertex>& vertices,
+		const uint32_t* indices, UINT indexCount)const;
+
+	//    CPU  Űؼ (CpuSkinner) ޽    ȿ ִ Ȯ,  
+	void CheckSkinnedBounds(const string& geoPrefix, const SkinnedData& skinnedInfo, const vector<SkinnedVertex>& vertices,
+		const vector<uint32_t>& indices, const vector<SubmeshInfo>& submeshes, const GeometryInfo* const* geometries);
+
+	// Vertex / SkinnedVertex -> PackedVertex / PackedSkinnedVertex, ġ   ȯ
+	XMFLOAT4 PackVertices(VertexType vertexType, const void* vertices, UINT vertexCount, void* packedVertices);
+
 	//  
 	void BuildMaterials();
 
@@ -66,6 +156,7 @@ private:
 
 	// 
 	void BuildInputLayout();
+	void BuildPackedInputLayout();	//   (̴ PACKED  )
 	void BuildShader();
 	void BuildConstantBuffers();
 	void BuildRootSignature();
@@ -82,6 +173,64 @@ private:
 	// Ű ִϸ̼ǿ Է 
 	vector<D3D12_INPUT_ELEMENT_DESC> mSkinnedInputLayout;
 
+	//   (PackedVertex / PackedSkinnedVertex) ø 
+	bool mPackedVertices = true;
+
+	// ޽÷  CPU ø 
+	bool mMeshletCulling = true;
+	UINT mMeshletMergeGap = 256;	// ̺  ﰢ ƴ ø ʰ  ο쿡 ģ
+	ClusterCullView mCameraCullView;
+	ClusterCullView mShadowCullView;
+	ClusterStats mClusterStats;
+	vector<pair<UINT, UINT>> mVisibleRanges;	// DrawRenderItems  
+
+	// Ű  CompiledClip (SoA Ű,  4 SIMD ø)   
+	bool mCompiledClips = true;
+
+	//  :  SkinnedData   νϽ  (mCrowdSpacing   ġ, ⺻ ϳ)
+	//  UpdateSkinnedPassCBs   Ǯ  , νϽ    ڸ ϳ
+	// ø νϽ  Ʈ / ȷƮ   뵵 þ (mCrowdBenchmark  )
+	UINT mCrowdSize = 1;
+	float mCrowdSpacing = 5.0f;
+	UINT mMaxSkinnedSubsets = 8;	// νϽ  ()  , Ʈ   ũ 
+	double mCrowdUpdateMs = 0.0;	//     ð
+	float mLoopCrossFade = 0.25f;	// Ŭ ݺ  ó Ƣ ʰ  ð (0 ̰ų mCompiledClips     Ʈ  ٷ ó)
+	bool mCrowdBenchmark = false;	//  ε  BenchmarkCrowd  ( 带  )
+
+	// ִϸ̼ LOD : ȭ  νϽ ð , ۰ ̴ νϽ  ӿ    
+	//    mAnimationLodFullPixels ȼ ̸̻  ,     2  (ִ mAnimationLodMaxInterval)
+	// ׸ڿ ɸ νϽ ִ  
+	bool mAnimationLod = true;
+	float mAnimationLodFullPixels = 150.0f;
+	UINT mAnimationLodMaxInterval = 8;
+	UINT64 mAnimationFrame = 0;
+	AnimationLodStats mAnimationLodStats;	//  
+	vector<UINT> mAnimationEvalList;		// ̹ ӿ   νϽ (UpdateSkinnedPassCBs  )
+
+	// ε  ִϸ̼ Ŭ  (Ű  + ȭ, ս),   mClipCompression
+	//  Ű  ű⼭ ٷ ø, CompiledClip   ׸ŭ  
+	bool mCompressClips = false;
+	ClipCompressor::Settings mClipCompression;
+
+	//   mBakedCrowdRatio ŭ  ȷƮ  (ī޶󿡼   νϽ, 0 ̸  ǽð)
+	// ׷  ε  Ŭ  ȷƮ mAnimationBakeRate (Hz)  ̸  д
+	//  νϽ յ     Ѵ (Ű ˻ /   , ݺ  ̵ )
+	// ޸𸮴 Ŭ   (νϽ  ), ũ  ε  
+	//   Ʈ / CompiledClip  ǽð  (SkinnedModelInstance::bakedClip  νϽ Ѵ)
+	float mAnimationBakeRate = 60.0f;
+	float mBakedCrowdRatio = 0.0f;
+
+	// ε  LOD  (  ﰢ ), ȭ鿡  mLodPixelError ȼ    LOD 
+	bool mLodEnabled = true;
+	vector<float> mLodRatios = { 0.5f, 0.25f, 0.1f };
+	float mLodPixelError = 1.0f;
+
+	//   / SRV  ũ
+	// 񵿱 ε ߿ ߰Ǵ  /  / ؽ ڸ ̸ Ƶд
+	UINT mMaxObjectCount = 64 + mCrowdSize * mMaxSkinnedSubsets;
+	UINT mMaxMaterialCount = 32;
+	UINT mSrvHeapCapacity = 64;
+
 	//  Ʈ  
 	ComPtr<ID3D12Resource> mObjectCB = nullptr;		//  ݰ X
 	BYTE* mObjectMappedData = nullptr;				// Ǵ 
@@ -110,6 +259,14 @@ private:
 	ComPtr<ID3D12DescriptorHeap> mSrvDescriptorHeap = nullptr;
 	UINT mCbvSrvDescriptorSize = 0;
 
+	// SRV ڸ ä ؽ ε ۾
+	vector<AssetManager::Handle> mSrvAssets;
+
+	// ؽ ε   (Ӹ ť Ƿ  UpdateAssets   )
+	ComPtr<ID3D12CommandAllocator> mUploadCmdListAlloc;
+	ComPtr<ID3D12GraphicsCommandList> mUploadCmdList;
+	bool mUploadCmdListOpen = false;
+
 	// ̴ 
 	unordered_map<string, ComPtr<ID3DBlob>> mShaders;
 
@@ -124,6 +281,7 @@ private:
 
 	//   
 	unordered_map<string, unique_ptr<GeometryInfo>> mGeometries;
+	mutex mGeometryMutex;	// AddGeometries 
 
 	//   
 	unordered_map<string, unique_ptr<MaterialInfo>> mMateirals;
@@ -147,16 +305,30 @@ private:
 	// Skinned Model Data
 	UINT mSkinnedSrvHeapStart = 0;
 	string mSkinnedModelFileName = "..\\Models\\soldier.m3d";
+
+	// AssetBaker   ī̺,   Ͽ ε
+	string mAssetArchiveFileName = "..\\Assets.pak";
+	AssetArchive mAssetArchive;
 	SkinnedData mSkinnedInfo;
 	vector<M3DLoader::Subset> mSkinnedSubsets;
 	vector<M3DLoader::M3dMaterial> mSkinnedMats;
 	vector<string> mSkinnedTextureName;
 
-	unique_ptr<SkinnedModelInstance> mSkinnedModelInst;
+	vector<unique_ptr<SkinnedModelInstance>> mSkinnedModelInsts;
+
+	// ε   ۾  Ǯ
+	ThreadPool mThreadPool;
+
+	// ε     
+	WeldEpsilon mWeldEpsilon;
 
-	//   :  ̵
+	//   :  ̵ (ī̹ڽ / ׸    踦 ģ , UpdateBounds  )
 	DirectX::BoundingSphere mSceneBounds;
 
+	// Ű ޽ 踦   ʴ   
+	float mSkinnedBoundsSampleRate = 30.0f;
+	bool mCheckSkinnedBounds = false;	// ε  CheckSkinnedBounds  (Ŀ , Ŭ ̿ ؼ )
+
 	// Ʈ  
 	float mLightNearZ = 0.0f;
 	float mLightFarZ = 0.0f;
@@ -176,4 +348,12 @@ private:
 	// 콺 ǥ
 	POINT mLastMousePos = { 0,0 };
 
+	// 񵿱  ε
+	// ε ۾ ٸ  ϹǷ   Ҹǵ   (Ҹڿ   ۾ ٸ)
+	AssetManager mAssetManager{ mThreadPool };
+	AssetManager::Handle mSkullAsset = AssetManager::InvalidHandle;
+	AssetManager::Handle mSkinnedModelAsset = AssetManager::InvalidHandle;
+	chrono::steady_clock::time_point mAssetLoadStart;
+	bool mAssetsIdleReported = false;
+
 };
\ No newline at end of file
@@ -1,14 +1,239 @@
 #include "LoadM3d.h"
+#include "M3dCache.h"
+#include "TextScanner.h"
+#include "ThreadPool.h"
+#include <atomic>
+#include <cstring>
  
 using namespace DirectX;
 
+namespace
+{
+	// A "***Name***" section: Begin is the header line, Body the line after it.
+	struct TextRange
+	{
+		const char* Begin = nullptr;
+		const char* Body = nullptr;
+		const char* End = nullptr;
+	};
+
+	const char* NextLine(const char* p, const char* end)
+	{
+		p = static_cast<const char*>(memchr(p, '\n', end - p));
+		return p ? p + 1 : end;
+	}
+
+	void FindSections(const char* begin, const char* end, std::unordered_map<std::string, TextRange>& sections)
+	{
+		TextRange* current = nullptr;
+
+		// '*' only shows up in section headers, so jump from one to the next.
+		const char* p = begin;
+		while( p < end )
+		{
+			const char* star = static_cast<const char*>(memchr(p, '*', end - p));
+			if( star == nullptr )
+				break;
+
+			if( star != begin && star[-1] != '\n' )
+			{
+				p = star + 1;
+				continue;
+			}
+
+			const char* nameBegin = star;
+			while( nameBegin < end && *nameBegin == '*' )
+				++nameBegin;
+			const char* nameEnd = nameBegin;
+			while( nameEnd < end && *nameEnd != '*' && *nameEnd != '\r' && *nameEnd != '\n' )
+				++nameEnd;
+
+			if( current )
+				current->End = star;
+
+			current = &sections[std::string(nameBegin, nameEnd)];
+			current->Begin = star;
+			current->Body = NextLine(star, end);
+			current->End = end;
+
+			p = current->Body;
+		}
+	}
+
+	// A record starts on a non-blank line beginning with marker ("" accepts any non-blank line).
+	bool IsRecordStart(const char* line, const char* end, const char* marker, std::size_t markerLength)
+	{
+		while( line < end && (*line == ' ' || *line == '\t' || *line == '\r') )
+			++line;
+
+		if( line == end || *line == '\n' )
+			return false;
+
+		return (std::size_t)(end - line) >= markerLength && memcmp(line, marker, markerLength) == 0;
+	}
+
+	const char* NextRecordStart(const char* p, const char* end, const char* marker, std::size_t markerLength)
+	{
+		p = NextLine(p, end);
+		while( p < end && !IsRecordStart(p, end, marker, markerLength) )
+			p = NextLine(p, end);
+		return p;
+	}
+
+	UINT CountRecords(const char* begin, const char* end, const char* marker, std::size_t markerLength)
+	{
+		UINT count = 0;
+		for( const char* line = begin; line < end; line = NextLine(line, end) )
+		{
+			if( IsRecordStart(line, end, marker, markerLength) )
+				++count;
+		}
+		return count;
+	}
+
+	// Record boundaries of a section body: chunk i holds the records
+	// [FirstRecord[i], FirstRecord[i + 1]) and the text [Bounds[i], Bounds[i + 1]).
+	struct RecordChunks
+	{
+		std::vector<const char*> Bounds;
+		std::vector<UINT> FirstRecord;
+
+		std::size_t Count()const { return Bounds.size() - 1; }
+	};
+
+	///<summary>
+	/// Splits a section body into chunkCount pieces that start on a record
+	/// boundary and counts the records of every piece in parallel.  Returns
+	/// false if the total doesn't match the count from the file header.
+	///</summary>
+	bool SplitRecords(ThreadPool& pool, const TextRange& section, const char* marker, UINT recordCount,
+		std::size_t chunkCount, RecordChunks& chunks)
+	{
+		const std::size_t markerLength = strlen(marker);
+		chunkCount = MathHelper::Max<std::size_t>(chunkCount, 1);
+
+		chunks.Bounds.resize(chunkCount + 1);
+		chunks.Bounds[0] = section.Body;
+		chunks.Bounds[chunkCount] = section.End;
+		for( std::size_t i = 1; i < chunkCount; ++i )
+		{
+			const char* split = section.Body + (section.End - section.Body) * i / chunkCount;
+			chunks.Bounds[i] = MathHelper::Max(chunks.Bounds[i - 1], NextRecordStart(split, section.End, marker, markerLength));
+		}
+
+		chunks.FirstRecord.assign(chunkCount + 1, 0);
+		pool.ParallelFor(chunkCount, [&](std::size_t i)
+		{
+			chunks.FirstRecord[i + 1] = CountRecords(chunks.Bounds[i], chunks.Bounds[i + 1], marker, markerLength);
+		});
+
+		for( std::size_t i = 0; i < chunkCount; ++i )
+			chunks.FirstRecord[i + 1] += chunks.FirstRecord[i];
+
+		return chunks.FirstRecord[chunkCount] == recordCount;
+	}
+
+	// Parses every record of the section with readRecord(scanner, recordIndex).
+	// A parse error in any chunk sets fin's fail state.
+	template<typename ReadRecord>
+	bool ParseRecordsParallel(ThreadPool& pool, TextScanner& fin, const TextRange& section, const char* marker, UINT recordCount,
+		ReadRecord readRecord)
+	{
+		// A few chunks per thread to even out the load, but not so small that
+		// splitting costs more than it saves.
+		RecordChunks chunks;
+		if( !SplitRecords(pool, section, marker, recordCount,
+				MathHelper::Min<std::size_t>(pool.GetThreadCount() * 4, recordCount / 1024), chunks) )
+			return false;
+
+		std::atomic<bool> failed{ false };
+		pool.ParallelFor(chunks.Count(), [&](std::size_t i)
+		{
+			TextScanner scan(chunks.Bounds[i], chunks.Bounds[i + 1]);
+			for( UINT record = chunks.FirstRecord[i]; record < chunks.FirstRecord[i + 1] && !scan.Fail(); ++record )
+				readRecord(scan, record);
+
+			if( scan.Fail() )
+				failed = true;
+		});
+
+		if( failed )
+			fin.SetFail();
+		return true;
+	}
+
+	///<summary>
+	/// Streaming flavour of ParseRecordsParallel.  The chunks are about one
+	/// batch each and are parsed one wave (one chunk per thread) at a time
+	/// into per-thread buffers of valuesPerRecord T's per record, which are
+	/// then passed to emit(firstRecord, data, recordCount) in file order.
+	/// A parse error sets fin's fail state and stops before its wave is
+	/// emitted.
+	///</summary>
+	template<typename T, typename ReadRecord, typename Emit>
+	void StreamRecordsParallel(ThreadPool& pool, TextScanner& fin, const RecordChunks& chunks, UINT valuesPerRecord,
+		ReadRecord readRecord, Emit emit)
+	{
+		const std::size_t waveSize = pool.GetThreadCount();
+		std::vector<std::vector<T>> buffers(waveSize);
+
+		for( std::size_t wave = 0; wave < chunks.Count(); wave += waveSize )
+		{
+			const std::size_t chunkCount = MathHelper::Min(waveSize, chunks.Count() - wave);
+
+			std::atomic<bool> failed{ false };
+			pool.ParallelFor(chunkCount, [&](std::size_t i)
+			{
+				const std::size_t chunk = wave + i;
+				const UINT first = chunks.FirstRecord[chunk];
+				const UINT count = chunks.FirstRecord[chunk + 1] - first;
+
+				buffers[i].resize((std::size_t)count * valuesPerRecord);
+
+				TextScanner scan(chunks.Bounds[chunk], chunks.Bounds[chunk + 1]);
+				for( UINT record = 0; record < count && !scan.Fail(); ++record )
+					readRecord(scan, &buffers[i][(std::size_t)record * valuesPerRecord]);
+
+				if( scan.Fail() )
+					failed = true;
+			});
+
+			if( failed )
+			{
+				fin.SetFail();
+				return;
+			}
+
+			for( std::size_t i = 0; i < chunkCount; ++i )
+			{
+				const std::size_t chunk = wave + i;
+				const UINT first = chunks.FirstRecord[chunk];
+				const UINT count = chunks.FirstRecord[chunk + 1] - first;
+				if( count > 0 )
+					emit(first, buffers[i].data(), count);
+			}
+		}
+	}
+}
+
+struct M3DLoader::SectionTable
+{
+	std::unordered_map<std::string, TextRange> Ranges;
+
+	const TextRange* Find(const std::string& name)const
+	{
+		auto it = Ranges.find(name);
+		return it != Ranges.end() ? &it->second : nullptr;
+	}
+};
+
 bool M3DLoader::LoadM3d(const std::string& filename, 
 						std::vector<Vertex>& vertices,
-						std::vector<USHORT>& indices,
+						std::vector<UINT>& indices,
 						std::vector<Subset>& subsets,
 						std::vector<M3dMaterial>& mats)
 {
-	std::ifstream fin(filename);
+	TextScanner fin;
 
 	UINT numMaterials = 0;
 	UINT numVertices  = 0;
@@ -16,35 +241,66 @@ bool M3DLoader::LoadM3d(const std::string& filename,
 	UINT numBones     = 0;
 	UINT numAnimationClips = 0;
 
-	std::string ignore;
-
-	if( fin )
+	if( fin.Open(filename) )
 	{
-		fin >> ignore; // file header text
-		fin >> ignore >> numMaterials;
-		fin >> ignore >> numVertices;
-		fin >> ignore >> numTriangles;
-		fin >> ignore >> numBones;
-		fin >> ignore >> numAnimationClips;
+		fin.Skip(); // file header text
+		fin.Skip() >> numMaterials;
+		fin.Skip() >> numVertices;
+		fin.Skip() >> numTriangles;
+		fin.Skip() >> numBones;
+		fin.Skip() >> numAnimationClips;
  
 		ReadMaterials(fin, numMaterials, mats);
 		ReadSubsetTable(fin, numMaterials, subsets);
-	    ReadVertices(fin, numVertices, vertices);
-	    ReadTriangles(fin, numTriangles, indices);
+
+		if( !UseThreadPool() || !ReadSectionsParallel(fin, numVertices, numTriangles, vertices, indices) )
+		{
+		    ReadVertices(fin, numVertices, vertices);
+		    ReadTriangles(fin, numTriangles, indices);
+		}
  
-		return true;
+		return !fin.Fail();
 	 }
     return false;
 }
 
 bool M3DLoader::LoadM3d(const std::string& filename, 
 						std::vector<SkinnedVertex>& vertices,
-						std::vector<USHORT>& indices,
+						std::vector<UINT>& indices,
 						std::vector<Subset>& subsets,
 						std::vector<M3dMaterial>& mats,
 						SkinnedData& skinInfo)
 {
-    std::ifstream fin(filename);
+	std::vector<XMFLOAT4X4> boneOffsets;
+	std::vector<int> boneIndexToParentIndex;
+	std::unordered_map<std::string, AnimationClip> animations;
+
+	if( ReadSkinnedM3d(filename, vertices, indices, subsets, mats, boneIndexToParentIndex, boneOffsets, animations) )
+	{
+		skinInfo.Set(boneIndexToParentIndex, boneOffsets, animations);
+		return true;
+	}
+	return false;
+}
+
+bool M3DLoader::LoadM3dCached(const std::string& filename, M3dCache& cache)
+{
+	std::string cacheFilename = M3dCache::GetCachePath(filename);
+
+	if( cache.Open(cacheFilename, filename) )
+		return true;
+
+	// Parse straight into the cache file, then map it.
+	M3dCache::Writer writer(cacheFilename, filename);
+	if( !StreamM3d(filename, writer) )
+		return false;
+
+	return cache.Open(cacheFilename, filename);
+}
+
+bool M3DLoader::StreamM3d(const std::string& filename, M3dSink& sink)
+{
+	TextScanner fin;
 
 	UINT numMaterials = 0;
 	UINT numVertices  = 0;
@@ -52,139 +308,436 @@ bool M3DLoader::LoadM3d(const std::string& filename,
 	UINT numBones     = 0;
 	UINT numAnimationClips = 0;
 
-	std::string ignore;
+	if( !fin.Open(filename) )
+		return false;
+
+	fin.Skip(); // file header text
+	fin.Skip() >> numMaterials;
+	fin.Skip() >> numVertices;
+	fin.Skip() >> numTriangles;
+	fin.Skip() >> numBones;
+	fin.Skip() >> numAnimationClips;
 
-	if( fin )
+	std::vector<Subset> subsets;
+	std::vector<M3dMaterial> mats;
+	ReadMaterials(fin, numMaterials, mats);
+	ReadSubsetTable(fin, numMaterials, subsets);
+
+	// Nothing reaches the sink from a file that is already broken, and a
+	// sink that never sees End() discards what it got.
+	if( fin.Fail() || !sink.Begin(numVertices, numTriangles, subsets, mats) )
+		return false;
+
+	if( UseThreadPool() && StreamSkinnedSectionsParallel(fin, numVertices, numTriangles, numBones, numAnimationClips, sink) )
+		return !fin.Fail() && sink.End();
+
+	std::vector<SkinnedVertex> vertexBatch(MathHelper::Min(StreamBatchSize, numVertices));
+	fin.Skip(); // vertices header text
+	for( UINT first = 0; first < numVertices; first += StreamBatchSize )
 	{
-		fin >> ignore; // file header text
-		fin >> ignore >> numMaterials;
-		fin >> ignore >> numVertices;
-		fin >> ignore >> numTriangles;
-		fin >> ignore >> numBones;
-		fin >> ignore >> numAnimationClips;
- 
-		std::vector<XMFLOAT4X4> boneOffsets;
-		std::vector<int> boneIndexToParentIndex;
-		std::unordered_map<std::string, AnimationClip> animations;
+		UINT count = MathHelper::Min(StreamBatchSize, numVertices - first);
+		for( UINT i = 0; i < count; ++i )
+			ReadSkinnedVertex(fin, vertexBatch[i]);
+
+		if( fin.Fail() )
+			return false;
+		sink.Vertices(first, vertexBatch.data(), count);
+	}
+
+	std::vector<UINT> indexBatch(MathHelper::Min(StreamBatchSize, numTriangles)*3);
+	fin.Skip(); // triangles header text
+	for( UINT first = 0; first < numTriangles; first += StreamBatchSize )
+	{
+		UINT count = MathHelper::Min(StreamBatchSize, numTriangles - first);
+		for( UINT i = 0; i < count; ++i )
+			ReadTriangle(fin, &indexBatch[i*3]);
+
+		if( fin.Fail() )
+			return false;
+		sink.Indices(first*3, indexBatch.data(), count*3);
+	}
+
+	std::vector<XMFLOAT4X4> boneOffsets;
+	std::vector<int> boneIndexToParentIndex;
+	std::unordered_map<std::string, AnimationClip> animations;
+	ReadBoneOffsets(fin, numBones, boneOffsets);
+	ReadBoneHierarchy(fin, numBones, boneIndexToParentIndex);
+	ReadAnimationClips(fin, numBones, numAnimationClips, animations);
+	if( fin.Fail() )
+		return false;
+	sink.Skeleton(boneIndexToParentIndex, boneOffsets, animations);
+
+	return sink.End();
+}
+
+bool M3DLoader::ReadSkinnedM3d(const std::string& filename,
+							   std::vector<SkinnedVertex>& vertices,
+							   std::vector<UINT>& indices,
+							   std::vector<Subset>& subsets,
+							   std::vector<M3dMaterial>& mats,
+							   std::vector<int>& boneIndexToParentIndex,
+							   std::vector<XMFLOAT4X4>& boneOffsets,
+							   std::unordered_map<std::string, AnimationClip>& animations)
+{
+    TextScanner fin;
 
+	UINT numMaterials = 0;
+	UINT numVertices  = 0;
+	UINT numTriangles = 0;
+	UINT numBones     = 0;
+	UINT numAnimationClips = 0;
+
+	if( fin.Open(filename) )
+	{
+		fin.Skip(); // file header text
+		fin.Skip() >> numMaterials;
+		fin.Skip() >> numVertices;
+		fin.Skip() >> numTriangles;
+		fin.Skip() >> numBones;
+		fin.Skip() >> numAnimationClips;
+ 
 		ReadMaterials(fin, numMaterials, mats);
 		ReadSubsetTable(fin, numMaterials, subsets);
+
+		if( UseThreadPool() && ReadSkinnedSectionsParallel(fin, numVertices, numTriangles, numBones, numAnimationClips,
+			vertices, indices, boneIndexToParentIndex, boneOffsets, animations) )
+		{
+			return !fin.Fail();
+		}
+
 	    ReadSkinnedVertices(fin, numVertices, vertices);
 	    ReadTriangles(fin, numTriangles, indices);
 		ReadBoneOffsets(fin, numBones, boneOffsets);
 	    ReadBoneHierarchy(fin, numBones, boneIndexToParentIndex);
 	    ReadAnimationClips(fin, numBones, numAnimationClips, animations);
- 
-		skinInfo.Set(boneIndexToParentIndex, boneOffsets, animations);
 
-	    return true;
+	    return !fin.Fail();
 	}
     return false;
 }
 
-void M3DLoader::ReadMaterials(std::ifstream& fin, UINT numMaterials, std::vector<M3dMaterial>& mats)
+void M3DLoader::SetThreadPool(ThreadPool* pool)
+{
+	mThreadPool = pool;
+}
+
+bool M3DLoader::UseThreadPool()const
+{
+	// With a single worker the chunk counting pass is pure overhead.
+	return mThreadPool != nullptr && mThreadPool->GetThreadCount() > 1;
+}
+
+bool M3DLoader::ReadSectionsParallel(TextScanner& fin, UINT numVertices, UINT numTriangles,
+									 std::vector<Vertex>& vertices,
+									 std::vector<UINT>& indices)
+{
+	SectionTable sections;
+	FindSections(fin.Position(), fin.End(), sections.Ranges);
+
+	const TextRange* vertexSection = sections.Find("Vertices");
+	const TextRange* triangleSection = sections.Find("Triangles");
+	if( vertexSection == nullptr || triangleSection == nullptr )
+		return false;
+
+	vertices.resize(numVertices);
+	indices.resize(numTriangles*3);
+
+	if( !ParseRecordsParallel(*mThreadPool, fin, *vertexSection, "Position:", numVertices,
+			[&](TextScanner& scan, UINT i) { ReadVertex(scan, vertices[i]); }) )
+		return false;
+
+	if( !ParseRecordsParallel(*mThreadPool, fin, *triangleSection, "", numTriangles,
+			[&](TextScanner& scan, UINT i) { ReadTriangle(scan, &indices[i*3]); }) )
+		return false;
+
+	fin.Seek(MathHelper::Max(vertexSection->End, triangleSection->End));
+	return true;
+}
+
+bool M3DLoader::ReadSkinnedSectionsParallel(TextScanner& fin, UINT numVertices, UINT numTriangles, UINT numBones, UINT numAnimationClips,
+											std::vector<SkinnedVertex>& vertices,
+											std::vector<UINT>& indices,
+											std::vector<int>& boneIndexToParentIndex,
+											std::vector<XMFLOAT4X4>& boneOffsets,
+											std::unordered_map<std::string, AnimationClip>& animations)
+{
+	SectionTable sections;
+	FindSections(fin.Position(), fin.End(), sections.Ranges);
+
+	const TextRange* vertexSection = sections.Find("Vertices");
+	const TextRange* triangleSection = sections.Find("Triangles");
+	if( vertexSection == nullptr || triangleSection == nullptr )
+		return false;
+
+	if( !ReadSkeletonParallel(fin, sections, numBones, numAnimationClips, boneIndexToParentIndex, boneOffsets, animations) )
+		return false;
+
+	vertices.resize(numVertices);
+	indices.resize(numTriangles*3);
+
+	if( !ParseRecordsParallel(*mThreadPool, fin, *vertexSection, "Position:", numVertices,
+			[&](TextScanner& scan, UINT i) { ReadSkinnedVertex(scan, vertices[i]); }) )
+		return false;
+
+	if( !ParseRecordsParallel(*mThreadPool, fin, *triangleSection, "", numTriangles,
+			[&](TextScanner& scan, UINT i) { ReadTriangle(scan, &indices[i*3]); }) )
+		return false;
+
+	fin.Seek(fin.End());
+	return true;
+}
+
+bool M3DLoader::StreamSkinnedSectionsParallel(TextScanner& fin, UINT numVertices, UINT numTriangles, UINT numBones, UINT numAnimationClips,
+											  M3dSink& sink)
+{
+	SectionTable sections;
+	FindSections(fin.Position(), fin.End(), sections.Ranges);
+
+	const TextRange* vertexSection = sections.Find("Vertices");
+	const TextRange* triangleSection = sections.Find("Triangles");
+	if( vertexSection == nullptr || triangleSection == nullptr )
+		return false;
+
+	// Everything that can fail is done before the first batch goes out, so
+	// the serial fallback never hands the sink the same data twice.
+	RecordChunks vertexChunks;
+	if( !SplitRecords(*mThreadPool, *vertexSection, "Position:", numVertices,
+			(numVertices + StreamBatchSize - 1) / StreamBatchSize, vertexChunks) )
+		return false;
+
+	RecordChunks triangleChunks;
+	if( !SplitRecords(*mThreadPool, *triangleSection, "", numTriangles,
+			(numTriangles + StreamBatchSize - 1) / StreamBatchSize, triangleChunks) )
+		return false;
+
+	std::vector<XMFLOAT4X4> boneOffsets;
+	std::vector<int> boneIndexToParentIndex;
+	std::unordered_map<std::string, AnimationClip> animations;
+	if( !ReadSkeletonParallel(fin, sections, numBones, numAnimationClips, boneIndexToParentIndex, boneOffsets, animations) )
+		return false;
+
+	// From here on a parse error can't fall back any more (the sink already
+	// has batches); it is reported through fin and the sink never sees End().
+	if( !fin.Fail() )
+	{
+		StreamRecordsParallel<SkinnedVertex>(*mThreadPool, fin, vertexChunks, 1,
+			[&](TextScanner& scan, SkinnedVertex* vertex) { ReadSkinnedVertex(scan, *vertex); },
+			[&](UINT first, const SkinnedVertex* data, UINT count) { sink.Vertices(first, data, count); });
+	}
+
+	if( !fin.Fail() )
+	{
+		StreamRecordsParallel<UINT>(*mThreadPool, fin, triangleChunks, 3,
+			[&](TextScanner& scan, UINT* triangle) { ReadTriangle(scan, triangle); },
+			[&](UINT first, const UINT* data, UINT count) { sink.Indices(first*3, data, count*3); });
+	}
+
+	if( !fin.Fail() )
+		sink.Skeleton(boneIndexToParentIndex, boneOffsets, animations);
+
+	fin.Seek(fin.End());
+	return true;
+}
+
+bool M3DLoader::ReadSkeletonParallel(TextScanner& fin, const SectionTable& sections, UINT numBones, UINT numAnimationClips,
+									 std::vector<int>& boneIndexToParentIndex,
+									 std::vector<XMFLOAT4X4>& boneOffsets,
+									 std::unordered_map<std::string, AnimationClip>& animations)
+{
+	const TextRange* boneOffsetSection = sections.Find("BoneOffsets");
+	const TextRange* boneHierarchySection = sections.Find("BoneHierarchy");
+	const TextRange* clipSection = sections.Find("AnimationClips");
+	if( boneOffsetSection == nullptr || boneHierarchySection == nullptr || clipSection == nullptr )
+		return false;
+
+	// Keyframe lines never contain braces, so every bone block can be found
+	// by jumping to its closing '}' without parsing the keys.
+	struct KeyframeBlock
+	{
+		UINT Clip;
+		UINT Bone;
+		const char* Begin;
+		const char* End;
+	};
+
+	std::vector<std::pair<std::string, AnimationClip>> clips(numAnimationClips);
+	std::vector<KeyframeBlock> blocks;
+	blocks.reserve(numAnimationClips*numBones);
+
+	TextScanner clipScan(clipSection->Begin, clipSection->End);
+	clipScan.Skip(); // AnimationClips header text
+	for( UINT clipIndex = 0; clipIndex < numAnimationClips; ++clipIndex )
+	{
+		clipScan.Skip() >> clips[clipIndex].first;
+		clipScan.Skip(); // {
+
+		clips[clipIndex].second.BoneAnimations.resize(numBones);
+
+		for( UINT boneIndex = 0; boneIndex < numBones; ++boneIndex )
+		{
+			const char* begin = clipScan.Position();
+			const char* close = static_cast<const char*>(memchr(begin, '}', clipScan.End() - begin));
+			if( close == nullptr )
+				return false;
+
+			blocks.push_back({ clipIndex, boneIndex, begin, close + 1 });
+			clipScan.Seek(close + 1);
+		}
+		clipScan.Skip(); // }
+	}
+
+	if( clipScan.Fail() )
+		fin.SetFail();
+
+	// The two small bone tables ride along as the last two items.
+	std::atomic<bool> failed{ false };
+	mThreadPool->ParallelFor(blocks.size() + 2, [&](std::size_t i)
+	{
+		if( i < blocks.size() )
+		{
+			const KeyframeBlock& block = blocks[i];
+			TextScanner scan(block.Begin, block.End);
+			ReadBoneKeyframes(scan, numBones, clips[block.Clip].second.BoneAnimations[block.Bone]);
+			if( scan.Fail() )
+				failed = true;
+		}
+		else if( i == blocks.size() )
+		{
+			TextScanner scan(boneOffsetSection->Begin, boneOffsetSection->End);
+			ReadBoneOffsets(scan, numBones, boneOffsets);
+			if( scan.Fail() )
+				failed = true;
+		}
+		else
+		{
+			TextScanner scan(boneHierarchySection->Begin, boneHierarchySection->End);
+			ReadBoneHierarchy(scan, numBones, boneIndexToParentIndex);
+			if( scan.Fail() )
+				failed = true;
+		}
+	});
+
+	if( failed )
+		fin.SetFail();
+
+	for( auto& clip : clips )
+		animations[clip.first] = clip.second;
+
+	return true;
+}
+
+void M3DLoader::ReadMaterials(TextScanner& fin, UINT numMaterials, std::vector<M3dMaterial>& mats)
 {
-	 std::string ignore;
      mats.resize(numMaterials);
 
 	 std::string diffuseMapName;
 	 std::string normalMapName;
 
-     fin >> ignore; // materials header text
+     fin.Skip(); // materials header text
 	 for(UINT i = 0; i < numMaterials; ++i)
 	 {
-         fin >> ignore >> mats[i].Name;
-		 fin >> ignore >> mats[i].DiffuseAlbedo.x  >> mats[i].DiffuseAlbedo.y  >> mats[i].DiffuseAlbedo.z;
-		 fin >> ignore >> mats[i].FresnelR0.x >> mats[i].FresnelR0.y >> mats[i].FresnelR0.z;
-         fin >> ignore >> mats[i].Roughness;
-		 fin >> ignore >> mats[i].AlphaClip;
-		 fin >> ignore >> mats[i].MaterialTypeName;
-		 fin >> ignore >> mats[i].DiffuseMapName;
-		 fin >> ignore >> mats[i].NormalMapName;
+         fin.Skip() >> mats[i].Name;
+		 fin.Skip() >> mats[i].DiffuseAlbedo.x  >> mats[i].DiffuseAlbedo.y  >> mats[i].DiffuseAlbedo.z;
+		 fin.Skip() >> mats[i].FresnelR0.x >> mats[i].FresnelR0.y >> mats[i].FresnelR0.z;
+         fin.Skip() >> mats[i].Roughness;
+		 fin.Skip() >> mats[i].AlphaClip;
+		 fin.Skip() >> mats[i].MaterialTypeName;
+		 fin.Skip() >> mats[i].DiffuseMapName;
+		 fin.Skip() >> mats[i].NormalMapName;
 		}
 }
 
-void M3DLoader::ReadSubsetTable(std::ifstream& fin, UINT numSubsets, std::vector<Subset>& subsets)
+void M3DLoader::ReadSubsetTable(TextScanner& fin, UINT numSubsets, std::vector<Subset>& subsets)
 {
-    std::string ignore;
 	subsets.resize(numSubsets);
 
-	fin >> ignore; // subset header text
+	fin.Skip(); // subset header text
 	for(UINT i = 0; i < numSubsets; ++i)
 	{
-        fin >> ignore >> subsets[i].Id;
-		fin >> ignore >> subsets[i].VertexStart;
-		fin >> ignore >> subsets[i].VertexCount;
-		fin >> ignore >> subsets[i].FaceStart;
-		fin >> ignore >> subsets[i].FaceCount;
+        fin.Skip() >> subsets[i].Id;
+		fin.Skip() >> subsets[i].VertexStart;
+		fin.Skip() >> subsets[i].VertexCount;
+		fin.Skip() >> subsets[i].FaceStart;
+		fin.Skip() >> subsets[i].FaceCount;
     }
 }
 
-void M3DLoader::ReadVertices(std::ifstream& fin, UINT numVertices, std::vector<Vertex>& vertices)
+void M3DLoader::ReadVertices(TextScanner& fin, UINT numVertices, std::vector<Vertex>& vertices)
 {
-	std::string ignore;
     vertices.resize(numVertices);
 
-    fin >> ignore; // vertices header text
+    fin.Skip(); // vertices header text
     for(UINT i = 0; i < numVertices; ++i)
     {
-	    fin >> ignore >> vertices[i].Pos.x      >> vertices[i].Pos.y      >> vertices[i].Pos.z;
-		fin >> ignore >> vertices[i].TangentU.x >> vertices[i].TangentU.y >> vertices[i].TangentU.z >> vertices[i].TangentU.w;
-	    fin >> ignore >> vertices[i].Normal.x   >> vertices[i].Normal.y   >> vertices[i].Normal.z;
-	    fin >> ignore >> vertices[i].TexC.x     >> vertices[i].TexC.y;
+	    ReadVertex(fin, vertices[i]);
     }
 }
 
-void M3DLoader::ReadSkinnedVertices(std::ifstream& fin, UINT numVertices, std::vector<SkinnedVertex>& vertices)
+void M3DLoader::ReadVertex(TextScanner& fin, Vertex& vertex)
+{
+    fin.Skip() >> vertex.Pos.x      >> vertex.Pos.y      >> vertex.Pos.z;
+	fin.Skip() >> vertex.TangentU.x >> vertex.TangentU.y >> vertex.TangentU.z >> vertex.TangentU.w;
+    fin.Skip() >> vertex.Normal.x   >> vertex.Normal.y   >> vertex.Normal.z;
+    fin.Skip() >> vertex.TexC.x     >> vertex.TexC.y;
+}
+
+void M3DLoader::ReadSkinnedVertices(TextScanner& fin, UINT numVertices, std::vector<SkinnedVertex>& vertices)
 {
-	std::string ignore;
     vertices.resize(numVertices);
 
-    fin >> ignore; // vertices header text
-	int boneIndices[4];
-	float weights[4];
+    fin.Skip(); // vertices header text
     for(UINT i = 0; i < numVertices; ++i)
     {
-        float blah;
-	    fin >> ignore >> vertices[i].Pos.x        >> vertices[i].Pos.y          >> vertices[i].Pos.z;
-		fin >> ignore >> vertices[i].TangentU.x   >> vertices[i].TangentU.y     >> vertices[i].TangentU.z >> blah /*vertices[i].TangentU.w*/;
-	    fin >> ignore >> vertices[i].Normal.x     >> vertices[i].Normal.y       >> vertices[i].Normal.z;
-	    fin >> ignore >> vertices[i].TexC.x       >> vertices[i].TexC.y;
-		fin >> ignore >> weights[0]     >> weights[1]     >> weights[2]     >> weights[3];
-		fin >> ignore >> boneIndices[0] >> boneIndices[1] >> boneIndices[2] >> boneIndices[3];
-
-		vertices[i].BoneWeights.x = weights[0];
-		vertices[i].BoneWeights.y = weights[1];
-		vertices[i].BoneWeights.z = weights[2];
-
-		vertices[i].BoneIndices[0] = (BYTE)boneIndices[0]; 
-		vertices[i].BoneIndices[1] = (BYTE)boneIndices[1]; 
-		vertices[i].BoneIndices[2] = (BYTE)boneIndices[2]; 
-		vertices[i].BoneIndices[3] = (BYTE)boneIndices[3]; 
+	    ReadSkinnedVertex(fin, vertices[i]);
     }
 }
 
-void M3DLoader::ReadTriangles(std::ifstream& fin, UINT numTriangles, std::vector<USHORT>& indices)
+void M3DLoader::ReadSkinnedVertex(TextScanner& fin, SkinnedVertex& vertex)
+{
+	int boneIndices[4];
+	float weights[4];
+    float blah;
+    fin.Skip() >> vertex.Pos.x        >> vertex.Pos.y          >> vertex.Pos.z;
+	fin.Skip() >> vertex.TangentU.x   >> vertex.TangentU.y     >> vertex.TangentU.z >> blah /*vertex.TangentU.w*/;
+    fin.Skip() >> vertex.Normal.x     >> vertex.Normal.y       >> vertex.Normal.z;
+    fin.Skip() >> vertex.TexC.x       >> vertex.TexC.y;
+	fin.Skip() >> weights[0]     >> weights[1]     >> weights[2]     >> weights[3];
+	fin.Skip() >> boneIndices[0] >> boneIndices[1] >> boneIndices[2] >> boneIndices[3];
+
+	vertex.BoneWeights.x = weights[0];
+	vertex.BoneWeights.y = weights[1];
+	vertex.BoneWeights.z = weights[2];
+
+	vertex.BoneIndices[0] = (BYTE)boneIndices[0]; 
+	vertex.BoneIndices[1] = (BYTE)boneIndices[1]; 
+	vertex.BoneIndices[2] = (BYTE)boneIndices[2]; 
+	vertex.BoneIndices[3] = (BYTE)boneIndices[3]; 
+}
+
+void M3DLoader::ReadTriangles(TextScanner& fin, UINT numTriangles, std::vector<UINT>& indices)
 {
-	std::string ignore;
     indices.resize(numTriangles*3);
 
-    fin >> ignore; // triangles header text
+    fin.Skip(); // triangles header text
     for(UINT i = 0; i < numTriangles; ++i)
     {
-        fin >> indices[i*3+0] >> indices[i*3+1] >> indices[i*3+2];
+        ReadTriangle(fin, &indices[i*3]);
     }
 }
+
+void M3DLoader::ReadTriangle(TextScanner& fin, UINT* indices)
+{
+    fin >> indices[0] >> indices[1] >> indices[2];
+}
  
-void M3DLoader::ReadBoneOffsets(std::ifstream& fin, UINT numBones, std::vector<XMFLOAT4X4>& boneOffsets)
+void M3DLoader::ReadBoneOffsets(TextScanner& fin, UINT numBones, std::vector<XMFLOAT4X4>& boneOffsets)
 {
-	std::string ignore;
     boneOffsets.resize(numBones);
 
-    fin >> ignore; // BoneOffsets header text
+    fin.Skip(); // BoneOffsets header text
     for(UINT i = 0; i < numBones; ++i)
     {
-        fin >> ignore >> 
+        fin.Skip() >> 
             boneOffsets[i](0,0) >> boneOffsets[i](0,1) >> boneOffsets[i](0,2) >> boneOffsets[i](0,3) >>
             boneOffsets[i](1,0) >> boneOffsets[i](1,1) >> boneOffsets[i](1,2) >> boneOffsets[i](1,3) >>
             boneOffsets[i](2,0) >> boneOffsets[i](2,1) >> boneOffsets[i](2,2) >> boneOffsets[i](2,3) >>
@@ -192,28 +745,26 @@ void M3DLoader::ReadBoneOffsets(std::ifstream& fin, UINT numBones, std::vector<X
     }
 }
 
-void M3DLoader::ReadBoneHierarchy(std::ifstream& fin, UINT numBones, std::vector<int>& boneIndexToParentIndex)
+void M3DLoader::ReadBoneHierarchy(TextScanner& fin, UINT numBones, std::vector<int>& boneIndexToParentIndex)
 {
-	std::string ignore;
     boneIndexToParentIndex.resize(numBones);
 
-    fin >> ignore; // BoneHierarchy header text
+    fin.Skip(); // BoneHierarchy header text
 	for(UINT i = 0; i < numBones; ++i)
 	{
-	    fin >> ignore >> boneIndexToParentIndex[i];
+	    fin.Skip() >> boneIndexToParentIndex[i];
 	}
 }
 
-void M3DLoader::ReadAnimationClips(std::ifstream& fin, UINT numBones, UINT numAnimationClips, 
+void M3DLoader::ReadAnimationClips(TextScanner& fin, UINT numBones, UINT numAnimationClips, 
 								   std::unordered_map<std::string, AnimationClip>& animations)
 {
-	std::string ignore;
-    fin >> ignore; // AnimationClips header text
+    fin.Skip(); // AnimationClips header text
     for(UINT clipIndex = 0; clipIndex < numAnimationClips; ++clipIndex)
     {
         std::string clipName;
-        fin >> ignore >> clipName;
-        fin >> ignore; // {
+        fin.Skip() >> clipName;
+        fin.Skip(); // {
 
 		AnimationClip clip;
 		clip.BoneAnimations.resize(numBones);
@@ -222,18 +773,17 @@ void M3DLoader::ReadAnimationClips(std::ifstream& fin, UINT numBones, UINT numAn
         {
             ReadBoneKeyframes(fin, numBones, clip.BoneAnimations[boneIndex]);
         }
-        fin >> ignore; // }
+        fin.Skip(); // }
 
         animations[clipName] = clip;
     }
 }
 
-void M3DLoader::ReadBoneKeyframes(std::ifstream& fin, UINT numBones, BoneAnimation& boneAnimation)
+void M3DLoader::ReadBoneKeyframes(TextScanner& fin, UINT numBones, BoneAnimation& boneAnimation)
 {
-	std::string ignore;
     UINT numKeyframes = 0;
-    fin >> ignore >> ignore >> numKeyframes;
-    fin >> ignore; // {
+    fin.Skip(2) >> numKeyframes;
+    fin.Skip(); // {
 
     boneAnimation.Keyframes.resize(numKeyframes);
     for(UINT i = 0; i < numKeyframes; ++i)
@@ -242,10 +792,10 @@ void M3DLoader::ReadBoneKeyframes(std::ifstream& fin, UINT numBones, BoneAnimati
         XMFLOAT3 p(0.0f, 0.0f, 0.0f);
         XMFLOAT3 s(1.0f, 1.0f, 1.0f);
         XMFLOAT4 q(0.0f, 0.0f, 0.0f, 1.0f);
-        fin >> ignore >> t;
-        fin >> ignore >> p.x >> p.y >> p.z;
-        fin >> ignore >> s.x >> s.y >> s.z;
-        fin >> ignore >> q.x >> q.y >> q.z >> q.w;
+        fin.Skip() >> t;
+        fin.Skip() >> p.x >> p.y >> p.z;
+        fin.Skip() >> s.x >> s.y >> s.z;
+        fin.Skip() >> q.x >> q.y >> q.z >> q.w;
 
 	    boneAnimation.Keyframes[i].TimePos      = t;
         boneAnimation.Keyframes[i].Translation  = p;
@@ -253,5 +803,5 @@ void M3DLoader::ReadBoneKeyframes(std::ifstream& fin, UINT numBones, BoneAnimati
 	    boneAnimation.Keyframes[i].RotationQuat = q;
     }
 
-    fin >> ignore; // }
+    fin.Skip(); // }
 }
\ No newline at end of file
@@ -3,7 +3,9 @@
 
 #include "SkinnedData.h"
 
-
+class M3dCache;
+class TextScanner;
+class ThreadPool;
 
 class M3DLoader
 {
@@ -49,28 +51,113 @@ public:
         std::string NormalMapName;
     };
 
+	///<summary>
+	/// Receives a skinned model from StreamM3d while it is being parsed.
+	/// Vertices and Indices are handed over in consecutive batches in file
+	/// order, always on the thread that called StreamM3d.  The batch pointers
+	/// are only valid during the call, so the data has to be copied to its
+	/// destination (a mapped buffer, a file, ...) right away.
+	///</summary>
+	class M3dSink
+	{
+	public:
+		virtual ~M3dSink() = default;
+
+		// Called once the header, materials and subset table are read.
+		// Returning false stops the load.
+		virtual bool Begin(UINT numVertices, UINT numTriangles,
+			const std::vector<Subset>& subsets,
+			const std::vector<M3dMaterial>& mats) = 0;
+
+		virtual void Vertices(UINT firstVertex, const SkinnedVertex* vertices, UINT count) = 0;
+		virtual void Indices(UINT firstIndex, const UINT* indices, UINT count) = 0;
+
+		virtual void Skeleton(const std::vector<int>& boneIndexToParentIndex,
+			const std::vector<DirectX::XMFLOAT4X4>& boneOffsets,
+			const std::unordered_map<std::string, AnimationClip>& animations) = 0;
+
+		// Called last, its result is what StreamM3d returns.
+		virtual bool End() = 0;
+	};
+
 	bool LoadM3d(const std::string& filename, 
 		std::vector<Vertex>& vertices,
-		std::vector<USHORT>& indices,
+		std::vector<UINT>& indices,
 		std::vector<Subset>& subsets,
 		std::vector<M3dMaterial>& mats);
 	bool LoadM3d(const std::string& filename, 
 		std::vector<SkinnedVertex>& vertices,
-		std::vector<USHORT>& indices,
+		std::vector<UINT>& indices,
 		std::vector<Subset>& subsets,
 		std::vector<M3dMaterial>& mats,
 		SkinnedData& skinInfo);
 
+	// Maps the binary cache next to filename, (re)building it from the text
+	// file first when it is missing or older than the text file.
+	bool LoadM3dCached(const std::string& filename, M3dCache& cache);
+
+	// Parses a skinned model into sink without building whole-model vertex
+	// and index arrays.  At most StreamBatchSize records are held per batch
+	// (per worker in parallel mode).
+	bool StreamM3d(const std::string& filename, M3dSink& sink);
+
+	static const UINT StreamBatchSize = 4096;
+
+	// With a pool set, the vertex, triangle and keyframe sections are split
+	// into chunks and parsed on the pool.  The result is the same as the
+	// serial reader, which is still used when no pool is set.
+	void SetThreadPool(ThreadPool* pool);
+
+private:
+	// Section name -> text range, filled by the parallel readers.
+	struct SectionTable;
+
+	bool ReadSkinnedM3d(const std::string& filename,
+		std::vector<SkinnedVertex>& vertices,
+		std::vector<UINT>& indices,
+		std::vector<Subset>& subsets,
+		std::vector<M3dMaterial>& mats,
+		std::vector<int>& boneIndexToParentIndex,
+		std::vector<DirectX::XMFLOAT4X4>& boneOffsets,
+		std::unordered_map<std::string, AnimationClip>& animations);
+
+	bool UseThreadPool()const;
+
+	// The parallel readers return false when the text can't be split into
+	// sections and records, and the caller then reads it serially.  Parse
+	// errors set fin's fail state instead, so the text isn't read twice.
+	bool ReadSectionsParallel(TextScanner& fin, UINT numVertices, UINT numTriangles,
+		std::vector<Vertex>& vertices,
+		std::vector<UINT>& indices);
+	bool ReadSkinnedSectionsParallel(TextScanner& fin, UINT numVertices, UINT numTriangles, UINT numBones, UINT numAnimationClips,
+		std::vector<SkinnedVertex>& vertices,
+		std::vector<UINT>& indices,
+		std::vector<int>& boneIndexToParentIndex,
+		std::vector<DirectX::XMFLOAT4X4>& boneOffsets,
+		std::unordered_map<std::string, AnimationClip>& animations);
+	bool StreamSkinnedSectionsParallel(TextScanner& fin, UINT numVertices, UINT numTriangles, UINT numBones, UINT numAnimationClips,
+		M3dSink& sink);
+	bool ReadSkeletonParallel(TextScanner& fin, const SectionTable& sections, UINT numBones, UINT numAnimationClips,
+		std::vector<int>& boneIndexToParentIndex,
+		std::vector<DirectX::XMFLOAT4X4>& boneOffsets,
+		std::unordered_map<std::string, AnimationClip>& animations);
+
+	// The serial readers leave errors in fin's fail state for the caller to check.
+	void ReadMaterials(TextScanner& fin, UINT numMaterials, std::vector<M3dMaterial>& mats);
+	void ReadSubsetTable(TextScanner& fin, UINT numSubsets, std::vector<Subset>& subsets);
+	void ReadVertices(TextScanner& fin, UINT numVertices, std::vector<Vertex>& vertices);
+	void ReadSkinnedVertices(TextScanner& fin, UINT numVertices, std::vector<SkinnedVertex>& vertices);
+	void ReadTriangles(TextScanner& fin, UINT numTriangles, std::vector<UINT>& indices);
+	void ReadVertex(TextScanner& fin, Vertex& vertex);
+	void ReadSkinnedVertex(TextScanner& fin, SkinnedVertex& vertex);
+	void ReadTriangle(TextScanner& fin, UINT* indices);
+	void ReadBoneOffsets(TextScanner& fin, UINT numBones, std::vector<DirectX::XMFLOAT4X4>& boneOffsets);
+	void ReadBoneHierarchy(TextScanner& fin, UINT numBones, std::vector<int>& boneIndexToParentIndex);
+	void ReadAnimationClips(TextScanner& fin, UINT numBones, UINT numAnimationClips, std::unordered_map<std::string, AnimationClip>& animations);
+	void ReadBoneKeyframes(TextScanner& fin, UINT numBones, BoneAnimation& boneAnimation);
+
 private:
-	void ReadMaterials(std::ifstream& fin, UINT numMaterials, std::vector<M3dMaterial>& mats);
-	void ReadSubsetTable(std::ifstream& fin, UINT numSubsets, std::vector<Subset>& subsets);
-	void ReadVertices(std::ifstream& fin, UINT numVertices, std::vector<Vertex>& vertices);
-	void ReadSkinnedVertices(std::ifstream& fin, UINT numVertices, std::vector<SkinnedVertex>& vertices);
-	void ReadTriangles(std::ifstream& fin, UINT numTriangles, std::vector<USHORT>& indices);
-	void ReadBoneOffsets(std::ifstream& fin, UINT numBones, std::vector<DirectX::XMFLOAT4X4>& boneOffsets);
-	void ReadBoneHierarchy(std::ifstream& fin, UINT numBones, std::vector<int>& boneIndexToParentIndex);
-	void ReadAnimationClips(std::ifstream& fin, UINT numBones, UINT numAnimationClips, std::unordered_map<std::string, AnimationClip>& animations);
-	void ReadBoneKeyframes(std::ifstream& fin, UINT numBones, BoneAnimation& boneAnimation);
+	ThreadPool* mThreadPool = nullptr;
 };
 
 
@@ -0,0 +1,524 @@
+#include "M3dCache.h"
+#include <cassert>
+#include <filesystem>
+
+using namespace DirectX;
+
+namespace
+{
+	const UINT64 SectionAlignment = 16;
+
+	UINT ExpectedElementSize(M3dCache::SectionType type)
+	{
+		switch(type)
+		{
+		case M3dCache::SectionType::Vertices:           return sizeof(M3DLoader::SkinnedVertex);
+		case M3dCache::SectionType::Indices:            return sizeof(UINT);
+		case M3dCache::SectionType::Subsets:            return sizeof(M3DLoader::Subset);
+		case M3dCache::SectionType::Materials:          return sizeof(M3dCache::MaterialRecord);
+		case M3dCache::SectionType::Strings:            return sizeof(char);
+		case M3dCache::SectionType::BoneHierarchy:      return sizeof(int);
+		case M3dCache::SectionType::BoneOffsets:        return sizeof(XMFLOAT4X4);
+		case M3dCache::SectionType::Clips:              return sizeof(M3dCache::ClipRecord);
+		case M3dCache::SectionType::BoneKeyframeRanges: return sizeof(M3dCache::KeyframeRange);
+		case M3dCache::SectionType::Keyframes:          return sizeof(M3dCache::KeyframeRecord);
+		default:                                        return 0;
+		}
+	}
+
+	UINT AddString(std::vector<char>& strings, const std::string& s)
+	{
+		UINT offset = (UINT)strings.size();
+		strings.insert(strings.end(), s.begin(), s.end());
+		strings.push_back('\0');
+		return offset;
+	}
+}
+
+std::string M3dCache::GetCachePath(const std::string& m3dFilename)
+{
+	return m3dFilename + "c";
+}
+
+bool M3dCache::GetSourceStamp(const std::string& sourceFilename, UINT64& size, UINT64& writeTime)
+{
+	std::error_code ec;
+	std::filesystem::path path(sourceFilename);
+
+	auto fileSize = std::filesystem::file_size(path, ec);
+	if(ec)
+		return false;
+
+	auto fileTime = std::filesystem::last_write_time(path, ec);
+	if(ec)
+		return false;
+
+	size = (UINT64)fileSize;
+	writeTime = (UINT64)fileTime.time_since_epoch().count();
+	return true;
+}
+
+bool M3dCache::Write(const std::string& cacheFilename,
+	const std::string& sourceFilename,
+	const std::vector<M3DLoader::SkinnedVertex>& vertices,
+	const std::vector<UINT>& indices,
+	const std::vector<M3DLoader::Subset>& subsets,
+	const std::vector<M3DLoader::M3dMaterial>& mats,
+	const std::vector<int>& boneHierarchy,
+	const std::vector<XMFLOAT4X4>& boneOffsets,
+	const std::unordered_map<std::string, AnimationClip>& animations)
+{
+	Writer writer(cacheFilename, sourceFilename);
+	if(!writer.Begin((UINT)vertices.size(), (UINT)indices.size() / 3, subsets, mats))
+		return false;
+
+	writer.Vertices(0, vertices.data(), (UINT)vertices.size());
+	writer.Indices(0, indices.data(), (UINT)indices.size());
+	writer.Skeleton(boneHierarchy, boneOffsets, animations);
+
+	return writer.End();
+}
+
+M3dCache::Writer::Writer(const std::string& cacheFilename, const std::string& sourceFilename)
+	: mCacheFilename(cacheFilename), mSourceFilename(sourceFilename)
+{
+}
+
+bool M3dCache::Writer::Begin(UINT numVertices, UINT numTriangles,
+	const std::vector<M3DLoader::Subset>& subsets,
+	const std::vector<M3DLoader::M3dMaterial>& mats)
+{
+	if(!GetSourceStamp(mSourceFilename, mHeader.SourceSize, mHeader.SourceWriteTime))
+		return false;
+
+	mFout.open(mCacheFilename, std::ios::binary | std::ios::trunc);
+	if(!mFout)
+		return false;
+
+	mExpectedVertices = numVertices;
+	mExpectedIndices = numTriangles * 3;
+	mSubsets = subsets;
+	mMats = mats;
+
+	// Header and section table are written twice: zeroed first so that a
+	// partially written file never passes validation, and for real in End().
+	mSections.assign((UINT)SectionType::Count, Section());
+	mHeader.Magic = 0;
+	mHeader.Version = Version;
+	mHeader.SectionCount = (UINT)SectionType::Count;
+	mFout.write(reinterpret_cast<const char*>(&mHeader), sizeof(Header));
+	mFout.write(reinterpret_cast<const char*>(mSections.data()), sizeof(Section) * mSections.size());
+
+	BeginSection(SectionType::Vertices);
+	return (bool)mFout;
+}
+
+void M3dCache::Writer::Vertices(UINT firstVertex, const M3DLoader::SkinnedVertex* vertices, UINT count)
+{
+	// Batches arrive in order, so firstVertex is always the current count.
+	assert(mCurrentSection == SectionType::Vertices);
+	assert(firstVertex == mSections[(UINT)SectionType::Vertices].Count);
+	Append(vertices, count);
+}
+
+void M3dCache::Writer::Indices(UINT firstIndex, const UINT* indices, UINT count)
+{
+	if(mCurrentSection != SectionType::Indices)
+		BeginSection(SectionType::Indices);
+
+	assert(firstIndex == mSections[(UINT)SectionType::Indices].Count);
+	Append(indices, count);
+}
+
+void M3dCache::Writer::Skeleton(const std::vector<int>& boneIndexToParentIndex,
+	const std::vector<XMFLOAT4X4>& boneOffsets,
+	const std::unordered_map<std::string, AnimationClip>& animations)
+{
+	if(mCurrentSection != SectionType::Indices)
+		BeginSection(SectionType::Indices);
+
+	std::vector<char> strings;
+
+	std::vector<MaterialRecord> matRecords(mMats.size());
+	for(size_t i = 0; i < mMats.size(); ++i)
+	{
+		matRecords[i].NameOffset             = AddString(strings, mMats[i].Name);
+		matRecords[i].MaterialTypeNameOffset = AddString(strings, mMats[i].MaterialTypeName);
+		matRecords[i].DiffuseMapNameOffset   = AddString(strings, mMats[i].DiffuseMapName);
+		matRecords[i].NormalMapNameOffset    = AddString(strings, mMats[i].NormalMapName);
+		matRecords[i].DiffuseAlbedo          = mMats[i].DiffuseAlbedo;
+		matRecords[i].FresnelR0              = mMats[i].FresnelR0;
+		matRecords[i].Roughness              = mMats[i].Roughness;
+		matRecords[i].AlphaClip              = mMats[i].AlphaClip ? 1 : 0;
+	}
+
+	std::vector<ClipRecord> clips;
+	std::vector<KeyframeRange> ranges;
+	std::vector<KeyframeRecord> keyframes;
+	for(const auto& e : animations)
+	{
+		ClipRecord clip;
+		clip.NameOffset = AddString(strings, e.first);
+		clip.FirstBoneRange = (UINT)ranges.size();
+		clips.push_back(clip);
+
+		for(const BoneAnimation& bone : e.second.BoneAnimations)
+		{
+			KeyframeRange range;
+			range.FirstKeyframe = (UINT)keyframes.size();
+			range.KeyframeCount = (UINT)bone.Keyframes.size();
+			ranges.push_back(range);
+
+			for(const Keyframe& key : bone.Keyframes)
+			{
+				KeyframeRecord record;
+				record.TimePos      = key.TimePos;
+				record.Translation  = key.Translation;
+				record.Scale        = key.Scale;
+				record.RotationQuat = key.RotationQuat;
+				keyframes.push_back(record);
+			}
+		}
+	}
+
+	mHeader.BoneCount = (UINT)boneIndexToParentIndex.size();
+
+	WriteSection(SectionType::Subsets, mSubsets.data(), mSubsets.size());
+	WriteSection(SectionType::Materials, matRecords.data(), matRecords.size());
+	WriteSection(SectionType::Strings, strings.data(), strings.size());
+	WriteSection(SectionType::BoneHierarchy, boneIndexToParentIndex.data(), boneIndexToParentIndex.size());
+	WriteSection(SectionType::BoneOffsets, boneOffsets.data(), boneOffsets.size());
+	WriteSection(SectionType::Clips, clips.data(), clips.size());
+	WriteSection(SectionType::BoneKeyframeRanges, ranges.data(), ranges.size());
+	WriteSection(SectionType::Keyframes, keyframes.data(), keyframes.size());
+
+	mSkeletonWritten = true;
+}
+
+bool M3dCache::Writer::End()
+{
+	if(!mFout || !mSkeletonWritten ||
+	   mSections[(UINT)SectionType::Vertices].Count != mExpectedVertices ||
+	   mSections[(UINT)SectionType::Indices].Count != mExpectedIndices)
+	{
+		return false;
+	}
+
+	mHeader.Magic = Magic;
+	mFout.seekp(0);
+	mFout.write(reinterpret_cast<const char*>(&mHeader), sizeof(Header));
+	mFout.write(reinterpret_cast<const char*>(mSections.data()), sizeof(Section) * mSections.size());
+	mFout.close();
+
+	return !mFout.fail();
+}
+
+void M3dCache::Writer::BeginSection(SectionType type)
+{
+	// Pad up to the section alignment so the mapped arrays can be read in place.
+	UINT64 offset = (UINT64)mFout.tellp();
+	UINT64 aligned = (offset + SectionAlignment - 1) & ~(SectionAlignment - 1);
+	static const char zeros[SectionAlignment] = {};
+	mFout.write(zeros, (std::streamsize)(aligned - offset));
+
+	Section& section = mSections[(UINT)type];
+	section.Type = (UINT)type;
+	section.ElementSize = ExpectedElementSize(type);
+	section.Offset = aligned;
+	section.Count = 0;
+
+	mCurrentSection = type;
+}
+
+void M3dCache::Writer::Append(const void* data, UINT64 count)
+{
+	Section& section = mSections[(UINT)mCurrentSection];
+	if(count > 0)
+		mFout.write(static_cast<const char*>(data), (std::streamsize)(count * section.ElementSize));
+	section.Count += count;
+}
+
+void M3dCache::Writer::WriteSection(SectionType type, const void* data, UINT64 count)
+{
+	BeginSection(type);
+	Append(data, count);
+}
+
+bool M3dCache::Open(const std::string& cacheFilename, const std::string& sourceFilename)
+{
+	Close();
+
+	UINT64 sourceSize = 0;
+	UINT64 sourceWriteTime = 0;
+	if(!GetSourceStamp(sourceFilename, sourceSize, sourceWriteTime))
+		return false;
+
+	if(!mFile.Open(cacheFilename))
+		return false;
+
+	if(!Attach(mFile.Data(), mFile.Size()) ||
+	   mHeader->SourceSize != sourceSize ||
+	   mHeader->SourceWriteTime != sourceWriteTime)
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+bool M3dCache::Open(const std::uint8_t* data, std::size_t size)
+{
+	Close();
+
+	if(reinterpret_cast<std::uintptr_t>(data) % SectionAlignment != 0 || !Attach(data, size))
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+bool M3dCache::Attach(const std::uint8_t* data, std::size_t size)
+{
+	const size_t tableEnd = sizeof(Header) + sizeof(Section) * (size_t)SectionType::Count;
+	if(size < tableEnd)
+		return false;
+
+	const Header* header = reinterpret_cast<const Header*>(data);
+	if(header->Magic != Magic ||
+	   header->Version != Version ||
+	   header->SectionCount != (UINT)SectionType::Count)
+	{
+		return false;
+	}
+
+	const Section* sections = reinterpret_cast<const Section*>(data + sizeof(Header));
+	for(UINT i = 0; i < (UINT)SectionType::Count; ++i)
+	{
+		const Section& s = sections[i];
+		if(s.Type != i ||
+		   s.ElementSize != ExpectedElementSize((SectionType)i) ||
+		   s.Offset % SectionAlignment != 0 ||
+		   s.Offset > size ||
+		   s.Count > (size - s.Offset) / s.ElementSize)
+		{
+			return false;
+		}
+	}
+
+	mData = data;
+	mHeader = header;
+	mSections = sections;
+
+	if(!ValidateReferences())
+	{
+		mData = nullptr;
+		mHeader = nullptr;
+		mSections = nullptr;
+		return false;
+	}
+
+	return true;
+}
+
+bool M3dCache::ValidateReferences()const
+{
+	UINT64 vertexCount = 0;
+	SectionData<M3DLoader::SkinnedVertex>(SectionType::Vertices, vertexCount);
+
+	UINT64 indexCount = 0;
+	const UINT* indices = SectionData<UINT>(SectionType::Indices, indexCount);
+	for(UINT64 i = 0; i < indexCount; ++i)
+	{
+		if(indices[i] >= vertexCount)
+			return false;
+	}
+
+	UINT64 subsetCount = 0;
+	const M3DLoader::Subset* subsets = SectionData<M3DLoader::Subset>(SectionType::Subsets, subsetCount);
+	for(UINT64 i = 0; i < subsetCount; ++i)
+	{
+		if((UINT64)subsets[i].VertexStart + subsets[i].VertexCount > vertexCount ||
+		   ((UINT64)subsets[i].FaceStart + subsets[i].FaceCount) * 3 > indexCount)
+		{
+			return false;
+		}
+	}
+
+	// Strings are read up to their terminator, so the section must end with one.
+	UINT64 stringSize = 0;
+	const char* strings = SectionData<char>(SectionType::Strings, stringSize);
+	if(stringSize > 0 && strings[stringSize - 1] != '\0')
+		return false;
+
+	UINT64 matCount = 0;
+	const MaterialRecord* mats = SectionData<MaterialRecord>(SectionType::Materials, matCount);
+	for(UINT64 i = 0; i < matCount; ++i)
+	{
+		if(mats[i].NameOffset >= stringSize ||
+		   mats[i].MaterialTypeNameOffset >= stringSize ||
+		   mats[i].DiffuseMapNameOffset >= stringSize ||
+		   mats[i].NormalMapNameOffset >= stringSize)
+		{
+			return false;
+		}
+	}
+
+	// One offset per bone, and parents come before their children.
+	UINT64 boneCount = 0;
+	const int* hierarchy = SectionData<int>(SectionType::BoneHierarchy, boneCount);
+
+	UINT64 offsetCount = 0;
+	SectionData<XMFLOAT4X4>(SectionType::BoneOffsets, offsetCount);
+	if(offsetCount != boneCount || mHeader->BoneCount != boneCount)
+		return false;
+
+	for(UINT64 b = 1; b < boneCount; ++b)
+	{
+		if(hierarchy[b] < 0 || (UINT64)hierarchy[b] >= b)
+			return false;
+	}
+
+	UINT64 keyCount = 0;
+	SectionData<KeyframeRecord>(SectionType::Keyframes, keyCount);
+
+	UINT64 rangeCount = 0;
+	const KeyframeRange* ranges = SectionData<KeyframeRange>(SectionType::BoneKeyframeRanges, rangeCount);
+	for(UINT64 r = 0; r < rangeCount; ++r)
+	{
+		if((UINT64)ranges[r].FirstKeyframe + ranges[r].KeyframeCount > keyCount)
+			return false;
+	}
+
+	UINT64 clipCount = 0;
+	const ClipRecord* clips = SectionData<ClipRecord>(SectionType::Clips, clipCount);
+	for(UINT64 c = 0; c < clipCount; ++c)
+	{
+		if(clips[c].NameOffset >= stringSize ||
+		   (UINT64)clips[c].FirstBoneRange + boneCount > rangeCount)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void M3dCache::Close()
+{
+	mFile.Close();
+	mData = nullptr;
+	mHeader = nullptr;
+	mSections = nullptr;
+}
+
+bool M3dCache::IsOpen()const
+{
+	return mHeader != nullptr;
+}
+
+const M3dCache::Section* M3dCache::FindSection(SectionType type)const
+{
+	return &mSections[(UINT)type];
+}
+
+const char* M3dCache::String(UINT offset)const
+{
+	return reinterpret_cast<const char*>(mData + FindSection(SectionType::Strings)->Offset) + offset;
+}
+
+const M3DLoader::SkinnedVertex* M3dCache::Vertices()const
+{
+	UINT64 count = 0;
+	return SectionData<M3DLoader::SkinnedVertex>(SectionType::Vertices, count);
+}
+
+UINT M3dCache::VertexCount()const
+{
+	return (UINT)FindSection(SectionType::Vertices)->Count;
+}
+
+const UINT* M3dCache::Indices()const
+{
+	UINT64 count = 0;
+	return SectionData<UINT>(SectionType::Indices, count);
+}
+
+UINT M3dCache::IndexCount()const
+{
+	return (UINT)FindSection(SectionType::Indices)->Count;
+}
+
+void M3dCache::GetSubsets(std::vector<M3DLoader::Subset>& subsets)const
+{
+	UINT64 count = 0;
+	const M3DLoader::Subset* data = SectionData<M3DLoader::Subset>(SectionType::Subsets, count);
+	subsets.assign(data, data + count);
+}
+
+void M3dCache::GetMaterials(std::vector<M3DLoader::M3dMaterial>& mats)const
+{
+	UINT64 count = 0;
+	const MaterialRecord* records = SectionData<MaterialRecord>(SectionType::Materials, count);
+
+	mats.resize((size_t)count);
+	for(UINT64 i = 0; i < count; ++i)
+	{
+		mats[i].Name             = String(records[i].NameOffset);
+		mats[i].MaterialTypeName = String(records[i].MaterialTypeNameOffset);
+		mats[i].DiffuseMapName   = String(records[i].DiffuseMapNameOffset);
+		mats[i].NormalMapName    = String(records[i].NormalMapNameOffset);
+		mats[i].DiffuseAlbedo    = records[i].DiffuseAlbedo;
+		mats[i].FresnelR0        = records[i].FresnelR0;
+		mats[i].Roughness        = records[i].Roughness;
+		mats[i].AlphaClip        = records[i].AlphaClip != 0;
+	}
+}
+
+void M3dCache::GetSkinnedData(SkinnedData& skinInfo)const
+{
+	UINT64 boneCount = 0;
+	const int* hierarchy = SectionData<int>(SectionType::BoneHierarchy, boneCount);
+
+	UINT64 offsetCount = 0;
+	const XMFLOAT4X4* offsets = SectionData<XMFLOAT4X4>(SectionType::BoneOffsets, offsetCount);
+
+	UINT64 clipCount = 0;
+	const ClipRecord* clips = SectionData<ClipRecord>(SectionType::Clips, clipCount);
+
+	UINT64 rangeCount = 0;
+	const KeyframeRange* ranges = SectionData<KeyframeRange>(SectionType::BoneKeyframeRanges, rangeCount);
+
+	UINT64 keyCount = 0;
+	const KeyframeRecord* keys = SectionData<KeyframeRecord>(SectionType::Keyframes, keyCount);
+
+	std::vector<int> boneHierarchy(hierarchy, hierarchy + boneCount);
+	std::vector<XMFLOAT4X4> boneOffsets(offsets, offsets + offsetCount);
+	std::unordered_map<std::string, AnimationClip> animations;
+
+	for(UINT64 c = 0; c < clipCount; ++c)
+	{
+		AnimationClip& clip = animations[String(clips[c].NameOffset)];
+		clip.BoneAnimations.resize((size_t)boneCount);
+
+		for(UINT64 b = 0; b < boneCount; ++b)
+		{
+			const KeyframeRange& range = ranges[clips[c].FirstBoneRange + b];
+			std::vector<Keyframe>& dst = clip.BoneAnimations[b].Keyframes;
+			dst.resize(range.KeyframeCount);
+
+			for(UINT k = 0; k < range.KeyframeCount; ++k)
+			{
+				const KeyframeRecord& src = keys[range.FirstKeyframe + k];
+				dst[k].TimePos      = src.TimePos;
+				dst[k].Translation  = src.Translation;
+				dst[k].Scale        = src.Scale;
+				dst[k].RotationQuat = src.RotationQuat;
+			}
+		}
+	}
+
+	skinInfo.Set(boneHierarchy, boneOffsets, animations);
+}
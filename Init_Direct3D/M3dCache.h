@@ -0,0 +1,199 @@
+#ifndef M3DCACHE_H
+#define M3DCACHE_H
+
+#include "LoadM3d.h"
+#include "MappedFile.h"
+#include <fstream>
+
+///<summary>
+/// Binary companion of a .m3d file.  The layout is a header, a section
+/// table and then one 16-byte aligned raw array per section, so once the
+/// file is mapped the vertex/index/bone/keyframe data can be used in place
+/// without any parsing.
+///
+/// The text .m3d stays the source of truth: the header records the size and
+/// write time of the source file and the cache is rejected (and rebuilt by
+/// M3DLoader::LoadM3dCached) as soon as either one changes.
+///</summary>
+class M3dCache
+{
+public:
+	static const UINT Magic = 0x4344334D; // 'M3DC'
+	static const UINT Version = 2;
+
+	enum class SectionType : UINT
+	{
+		Vertices = 0,
+		Indices,
+		Subsets,
+		Materials,
+		Strings,
+		BoneHierarchy,
+		BoneOffsets,
+		Clips,
+		BoneKeyframeRanges,
+		Keyframes,
+		Count
+	};
+
+	struct Header
+	{
+		UINT Magic;
+		UINT Version;
+		UINT64 SourceSize;
+		UINT64 SourceWriteTime;
+		UINT SectionCount;
+		UINT BoneCount;
+	};
+
+	struct Section
+	{
+		UINT Type;
+		UINT ElementSize;
+		UINT64 Offset;
+		UINT64 Count;
+	};
+
+	// Strings are stored as offsets into the Strings section (null terminated).
+	struct MaterialRecord
+	{
+		UINT NameOffset;
+		UINT MaterialTypeNameOffset;
+		UINT DiffuseMapNameOffset;
+		UINT NormalMapNameOffset;
+
+		DirectX::XMFLOAT4 DiffuseAlbedo;
+		DirectX::XMFLOAT3 FresnelR0;
+		float Roughness;
+		UINT AlphaClip;
+	};
+
+	// Each clip owns BoneCount consecutive entries of the BoneKeyframeRanges section.
+	struct ClipRecord
+	{
+		UINT NameOffset;
+		UINT FirstBoneRange;
+	};
+
+	struct KeyframeRange
+	{
+		UINT FirstKeyframe;
+		UINT KeyframeCount;
+	};
+
+	struct KeyframeRecord
+	{
+		float TimePos;
+		DirectX::XMFLOAT3 Translation;
+		DirectX::XMFLOAT3 Scale;
+		DirectX::XMFLOAT4 RotationQuat;
+	};
+
+	///<summary>
+	/// Writes a cache file while M3DLoader::StreamM3d parses the text.  The
+	/// vertex and index sections come first in the file, so their batches
+	/// are appended as they arrive; the rest is small and written at the end.
+	///</summary>
+	class Writer : public M3DLoader::M3dSink
+	{
+	public:
+		Writer(const std::string& cacheFilename, const std::string& sourceFilename);
+
+		virtual bool Begin(UINT numVertices, UINT numTriangles,
+			const std::vector<M3DLoader::Subset>& subsets,
+			const std::vector<M3DLoader::M3dMaterial>& mats)override;
+
+		virtual void Vertices(UINT firstVertex, const M3DLoader::SkinnedVertex* vertices, UINT count)override;
+		virtual void Indices(UINT firstIndex, const UINT* indices, UINT count)override;
+
+		virtual void Skeleton(const std::vector<int>& boneIndexToParentIndex,
+			const std::vector<DirectX::XMFLOAT4X4>& boneOffsets,
+			const std::unordered_map<std::string, AnimationClip>& animations)override;
+
+		virtual bool End()override;
+
+	private:
+		void BeginSection(SectionType type);
+		void Append(const void* data, UINT64 count);
+		void WriteSection(SectionType type, const void* data, UINT64 count);
+
+	private:
+		std::string mCacheFilename;
+		std::string mSourceFilename;
+		std::ofstream mFout;
+
+		Header mHeader = {};
+		std::vector<Section> mSections;
+		SectionType mCurrentSection = SectionType::Count;
+		bool mSkeletonWritten = false;
+
+		UINT mExpectedVertices = 0;
+		UINT mExpectedIndices = 0;
+
+		std::vector<M3DLoader::Subset> mSubsets;
+		std::vector<M3DLoader::M3dMaterial> mMats;
+	};
+
+public:
+	static std::string GetCachePath(const std::string& m3dFilename);
+
+	static bool Write(const std::string& cacheFilename,
+		const std::string& sourceFilename,
+		const std::vector<M3DLoader::SkinnedVertex>& vertices,
+		const std::vector<UINT>& indices,
+		const std::vector<M3DLoader::Subset>& subsets,
+		const std::vector<M3DLoader::M3dMaterial>& mats,
+		const std::vector<int>& boneHierarchy,
+		const std::vector<DirectX::XMFLOAT4X4>& boneOffsets,
+		const std::unordered_map<std::string, AnimationClip>& animations);
+
+	// Maps the cache and validates it against the current state of the source file.
+	bool Open(const std::string& cacheFilename, const std::string& sourceFilename);
+
+	// Uses a cache image that is already in memory (e.g. a blob of an
+	// AssetArchive).  There is no source file to check against; the memory
+	// must outlive the cache and start on a 16-byte boundary.
+	bool Open(const std::uint8_t* data, std::size_t size);
+	void Close();
+	bool IsOpen()const;
+
+	const M3DLoader::SkinnedVertex* Vertices()const;
+	UINT VertexCount()const;
+
+	const UINT* Indices()const;
+	UINT IndexCount()const;
+
+	void GetSubsets(std::vector<M3DLoader::Subset>& subsets)const;
+	void GetMaterials(std::vector<M3DLoader::M3dMaterial>& mats)const;
+	void GetSkinnedData(SkinnedData& skinInfo)const;
+
+private:
+	static bool GetSourceStamp(const std::string& sourceFilename, UINT64& size, UINT64& writeTime);
+
+	// Validates the header and section table of a cache image.
+	bool Attach(const std::uint8_t* data, std::size_t size);
+
+	// Checks every index and offset stored in the sections against the
+	// section it points into, so the accessors never read out of bounds.
+	bool ValidateReferences()const;
+
+	const Section* FindSection(SectionType type)const;
+
+	template<typename T>
+	const T* SectionData(SectionType type, UINT64& count)const
+	{
+		const Section* section = FindSection(type);
+		count = section->Count;
+		return reinterpret_cast<const T*>(mData + section->Offset);
+	}
+
+	const char* String(UINT offset)const;
+
+private:
+	MappedFile mFile;
+	const std::uint8_t* mData = nullptr;
+	const Header* mHeader = nullptr;
+	const Section* mSections = nullptr;
+};
+
+#endif // M3DCACHE_H
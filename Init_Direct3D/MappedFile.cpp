@@ -0,0 +1,118 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool MappedFile::Open(const std::string& filename)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if(file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if(!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if(mapping == nullptr)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if(view == nullptr)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	mFile = file;
+	mMapping = mapping;
+	mData = static_cast<const std::uint8_t*>(view);
+	mSize = (std::size_t)fileSize.QuadPart;
+#else
+	int fd = open(filename.c_str(), O_RDONLY);
+	if(fd < 0)
+		return false;
+
+	struct stat st;
+	if(fstat(fd, &st) != 0 || st.st_size == 0)
+	{
+		close(fd);
+		return false;
+	}
+
+	void* view = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if(view == MAP_FAILED)
+	{
+		close(fd);
+		return false;
+	}
+
+	mFd = fd;
+	mData = static_cast<const std::uint8_t*>(view);
+	mSize = (std::size_t)st.st_size;
+#endif
+
+	return true;
+}
+
+void MappedFile::Close()
+{
+#ifdef _WIN32
+	if(mData != nullptr)
+		UnmapViewOfFile(mData);
+	if(mMapping != nullptr)
+		CloseHandle((HANDLE)mMapping);
+	if(mFile != nullptr)
+		CloseHandle((HANDLE)mFile);
+
+	mFile = nullptr;
+	mMapping = nullptr;
+#else
+	if(mData != nullptr)
+		munmap((void*)mData, mSize);
+	if(mFd >= 0)
+		close(mFd);
+
+	mFd = -1;
+#endif
+
+	mData = nullptr;
+	mSize = 0;
+}
+
+bool MappedFile::IsOpen()const
+{
+	return mData != nullptr;
+}
+
+const std::uint8_t* MappedFile::Data()const
+{
+	return mData;
+}
+
+std::size_t MappedFile::Size()const
+{
+	return mSize;
+}
@@ -0,0 +1,40 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+///<summary>
+/// Read-only view of a whole file mapped into the address space.  The
+/// pages are only touched when the data is read, so opening a large file
+/// is cheap and the OS can share/evict the pages as it likes.
+///</summary>
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	MappedFile(const MappedFile& rhs) = delete;
+	MappedFile& operator=(const MappedFile& rhs) = delete;
+	~MappedFile();
+
+	bool Open(const std::string& filename);
+	void Close();
+
+	bool IsOpen()const;
+	const std::uint8_t* Data()const;
+	std::size_t Size()const;
+
+private:
+#ifdef _WIN32
+	void* mFile = nullptr;
+	void* mMapping = nullptr;
+#else
+	int mFd = -1;
+#endif
+
+	const std::uint8_t* mData = nullptr;
+	std::size_t mSize = 0;
+};
+
+#endif // MAPPEDFILE_H
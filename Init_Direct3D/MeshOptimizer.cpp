@@ -0,0 +1,168 @@
+#include "MeshOptimizer.h"
+#include <cstring>
+#include <vector>
+
+void MeshOptimizer::OptimizeVertexCache(std::uint32_t* indices, std::size_t indexCount, std::size_t vertexCount,
+	std::uint32_t cacheSize)
+{
+	const std::size_t triangleCount = indexCount / 3;
+	if(triangleCount == 0)
+		return;
+
+	// Vertex -> triangle adjacency (CSR layout).
+	std::vector<std::uint32_t> liveCount(vertexCount, 0);
+	for(std::size_t i = 0; i < triangleCount * 3; ++i)
+		++liveCount[indices[i]];
+
+	std::vector<std::uint32_t> adjacencyOffset(vertexCount + 1, 0);
+	for(std::size_t v = 0; v < vertexCount; ++v)
+		adjacencyOffset[v + 1] = adjacencyOffset[v] + liveCount[v];
+
+	std::vector<std::uint32_t> adjacency(triangleCount * 3);
+	{
+		std::vector<std::uint32_t> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+		for(std::size_t t = 0; t < triangleCount; ++t)
+		{
+			for(int k = 0; k < 3; ++k)
+				adjacency[fill[indices[t * 3 + k]]++] = (std::uint32_t)t;
+		}
+	}
+
+	// timeStamp[v] is the value of time when v last entered the FIFO, so v is
+	// still cached while time - timeStamp[v] <= cacheSize.
+	std::vector<std::uint32_t> timeStamp(vertexCount, 0);
+	std::uint32_t time = cacheSize + 1;
+
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<std::uint32_t> deadEnd;
+	deadEnd.reserve(triangleCount * 3);
+	std::vector<std::uint32_t> candidates;
+
+	std::vector<std::uint32_t> output;
+	output.reserve(triangleCount * 3);
+
+	std::size_t scanCursor = 0;
+	std::int64_t fan = 0;
+	while(fan >= 0)
+	{
+		// Emit every remaining triangle around the fanning vertex.
+		candidates.clear();
+		for(std::uint32_t a = adjacencyOffset[fan]; a < adjacencyOffset[fan + 1]; ++a)
+		{
+			std::uint32_t t = adjacency[a];
+			if(emitted[t])
+				continue;
+			emitted[t] = true;
+
+			for(int k = 0; k < 3; ++k)
+			{
+				std::uint32_t v = indices[t * 3 + k];
+				output.push_back(v);
+				deadEnd.push_back(v);
+				candidates.push_back(v);
+				--liveCount[v];
+
+				if(time - timeStamp[v] > cacheSize)
+					timeStamp[v] = time++;
+			}
+		}
+
+		// Next fan: the oldest candidate that will still be cached after its
+		// own triangles are emitted (each one can push at most two new vertices).
+		fan = -1;
+		std::int64_t bestPriority = -1;
+		for(std::uint32_t v : candidates)
+		{
+			if(liveCount[v] == 0)
+				continue;
+
+			std::int64_t priority = 0;
+			if(time - timeStamp[v] + 2 * liveCount[v] <= cacheSize)
+				priority = time - timeStamp[v];
+
+			if(priority > bestPriority)
+			{
+				bestPriority = priority;
+				fan = v;
+			}
+		}
+
+		if(fan >= 0)
+			continue;
+
+		// Dead end: go back to a recently used vertex, then to the next
+		// unfinished vertex in index order.  The cursor only moves forward.
+		while(!deadEnd.empty())
+		{
+			std::uint32_t v = deadEnd.back();
+			deadEnd.pop_back();
+			if(liveCount[v] > 0)
+			{
+				fan = v;
+				break;
+			}
+		}
+
+		if(fan < 0)
+		{
+			while(scanCursor < vertexCount && liveCount[scanCursor] == 0)
+				++scanCursor;
+			if(scanCursor < vertexCount)
+				fan = (std::int64_t)scanCursor;
+		}
+	}
+
+	memcpy(indices, output.data(), output.size() * sizeof(std::uint32_t));
+}
+
+void MeshOptimizer::OptimizeVertexFetch(void* vertices, std::size_t vertexCount, std::size_t vertexStride,
+	std::uint32_t* indices, std::size_t indexCount)
+{
+	const std::uint32_t Unused = 0xFFFFFFFF;
+
+	std::vector<std::uint32_t> remap(vertexCount, Unused);
+	std::uint32_t next = 0;
+
+	for(std::size_t i = 0; i < indexCount; ++i)
+	{
+		std::uint32_t& target = remap[indices[i]];
+		if(target == Unused)
+			target = next++;
+		indices[i] = target;
+	}
+
+	for(std::size_t v = 0; v < vertexCount; ++v)
+	{
+		if(remap[v] == Unused)
+			remap[v] = next++;
+	}
+
+	std::uint8_t* data = static_cast<std::uint8_t*>(vertices);
+	std::vector<std::uint8_t> copy(data, data + vertexCount * vertexStride);
+	for(std::size_t v = 0; v < vertexCount; ++v)
+		memcpy(data + remap[v] * vertexStride, &copy[v * vertexStride], vertexStride);
+}
+
+float MeshOptimizer::ComputeACMR(const std::uint32_t* indices, std::size_t indexCount, std::size_t vertexCount,
+	std::uint32_t cacheSize)
+{
+	const std::size_t triangleCount = indexCount / 3;
+	if(triangleCount == 0)
+		return 0.0f;
+
+	// A vertex is in the FIFO if it was inserted within the last cacheSize misses.
+	std::vector<std::size_t> insertedAt(vertexCount, 0);
+	std::size_t misses = 0;
+
+	for(std::size_t i = 0; i < triangleCount * 3; ++i)
+	{
+		std::uint32_t v = indices[i];
+		if(insertedAt[v] == 0 || misses + 1 - insertedAt[v] > cacheSize)
+		{
+			++misses;
+			insertedAt[v] = misses;
+		}
+	}
+
+	return (float)misses / triangleCount;
+}
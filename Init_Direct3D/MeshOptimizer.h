@@ -0,0 +1,38 @@
+#ifndef MESHOPTIMIZER_H
+#define MESHOPTIMIZER_H
+
+#include <cstddef>
+#include <cstdint>
+
+///<summary>
+/// Post-load index/vertex reordering for triangle lists.
+///
+/// OptimizeVertexCache reorders triangles so that vertices are reused while
+/// they are still in the post-transform cache (Tipsify, from Sander et al.
+/// "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw").  OptimizeVertexFetch then reorders the
+/// vertices in first-use order so the input assembler reads the vertex
+/// buffer mostly sequentially.  ComputeACMR measures the result with a FIFO
+/// cache simulation (average cache misses per triangle, 0.5 is the ideal
+/// for large regular meshes and 3.0 the worst case).
+///</summary>
+class MeshOptimizer
+{
+public:
+	static const std::uint32_t DefaultCacheSize = 16;
+
+	// Reorders the triangles of indices in place for a FIFO cache of cacheSize
+	// entries.  Only indices < vertexCount are valid.
+	static void OptimizeVertexCache(std::uint32_t* indices, std::size_t indexCount, std::size_t vertexCount,
+		std::uint32_t cacheSize = DefaultCacheSize);
+
+	// Reorders vertices (vertexStride bytes each) by first use in indices and
+	// remaps indices to match.  Unreferenced vertices are moved to the end.
+	static void OptimizeVertexFetch(void* vertices, std::size_t vertexCount, std::size_t vertexStride,
+		std::uint32_t* indices, std::size_t indexCount);
+
+	// Average cache misses per triangle for a FIFO cache of cacheSize entries.
+	static float ComputeACMR(const std::uint32_t* indices, std::size_t indexCount, std::size_t vertexCount,
+		std::uint32_t cacheSize = DefaultCacheSize);
+};
+
+#endif // MESHOPTIMIZER_H
@@ -0,0 +1,307 @@
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+	struct Float3
+	{
+		float X, Y, Z;
+	};
+
+	Float3 Sub(const Float3& a, const Float3& b) { return { a.X - b.X, a.Y - b.Y, a.Z - b.Z }; }
+	float Dot(const Float3& a, const Float3& b) { return a.X * b.X + a.Y * b.Y + a.Z * b.Z; }
+	Float3 Cross(const Float3& a, const Float3& b)
+	{
+		return { a.Y * b.Z - a.Z * b.Y, a.Z * b.X - a.X * b.Z, a.X * b.Y - a.Y * b.X };
+	}
+
+	// Symmetric 4x4 plane quadric, weighted by triangle area.
+	struct Quadric
+	{
+		double A00 = 0, A01 = 0, A02 = 0, A11 = 0, A12 = 0, A22 = 0;
+		double B0 = 0, B1 = 0, B2 = 0;
+		double C = 0;
+		double Weight = 0;
+
+		void AddPlane(const Float3& n, float d, double weight)
+		{
+			A00 += weight * n.X * n.X; A01 += weight * n.X * n.Y; A02 += weight * n.X * n.Z;
+			A11 += weight * n.Y * n.Y; A12 += weight * n.Y * n.Z; A22 += weight * n.Z * n.Z;
+			B0 += weight * n.X * d; B1 += weight * n.Y * d; B2 += weight * n.Z * d;
+			C += weight * d * d;
+			Weight += weight;
+		}
+
+		void Add(const Quadric& q)
+		{
+			A00 += q.A00; A01 += q.A01; A02 += q.A02; A11 += q.A11; A12 += q.A12; A22 += q.A22;
+			B0 += q.B0; B1 += q.B1; B2 += q.B2;
+			C += q.C;
+			Weight += q.Weight;
+		}
+
+		// Weighted sum of squared distances from p to the planes.
+		double Evaluate(const Float3& p) const
+		{
+			const double x = p.X, y = p.Y, z = p.Z;
+			const double r = A00 * x * x + A11 * y * y + A22 * z * z +
+				2.0 * (A01 * x * y + A02 * x * z + A12 * y * z) +
+				2.0 * (B0 * x + B1 * y + B2 * z) + C;
+			return r > 0.0 ? r : 0.0;
+		}
+	};
+
+	struct Collapse
+	{
+		double Cost;
+		std::uint32_t From;
+		std::uint32_t To;
+
+		bool operator<(const Collapse& rhs) const { return Cost < rhs.Cost; }
+	};
+
+	Float3 LoadPosition(const void* positions, std::size_t stride, std::uint32_t i)
+	{
+		Float3 p;
+		memcpy(&p, static_cast<const unsigned char*>(positions) + i * stride, sizeof(p));
+		return p;
+	}
+
+	std::uint64_t EdgeKey(std::uint32_t a, std::uint32_t b)
+	{
+		return a < b ? ((std::uint64_t)a << 32) | b : ((std::uint64_t)b << 32) | a;
+	}
+}
+
+std::size_t MeshSimplifier::Simplify(std::uint32_t* destination, const std::uint32_t* indices, std::size_t indexCount,
+	const void* positions, std::size_t positionStride, std::size_t vertexCount,
+	std::size_t targetIndexCount, float* resultError)
+{
+	indexCount -= indexCount % 3;
+	memcpy(destination, indices, indexCount * sizeof(std::uint32_t));
+	if(resultError != nullptr)
+		*resultError = 0.0f;
+
+	if(indexCount <= targetIndexCount || vertexCount == 0)
+		return indexCount;
+
+	// 1. Vertices that share a position; the first one stands for the group.
+	std::vector<std::uint32_t> positionId(vertexCount);
+	std::vector<std::uint32_t> groupSize(vertexCount, 0);
+	{
+		std::unordered_map<std::uint64_t, std::uint32_t> firstAt;
+		firstAt.reserve(vertexCount);
+		for(std::size_t v = 0; v < vertexCount; ++v)
+		{
+			positionId[v] = (std::uint32_t)v;
+
+			std::uint32_t bits[3];
+			memcpy(bits, static_cast<const unsigned char*>(positions) + v * positionStride, sizeof(bits));
+			const std::uint64_t key = ((std::uint64_t)bits[0] * 0x9E3779B97F4A7C15ull) ^
+				((std::uint64_t)bits[1] * 0xC2B2AE3D27D4EB4Full) ^ ((std::uint64_t)bits[2] * 0x165667B19E3779F9ull);
+
+			auto found = firstAt.emplace(key, (std::uint32_t)v);
+			if(!found.second && memcmp(static_cast<const unsigned char*>(positions) + found.first->second * positionStride,
+				bits, sizeof(bits)) == 0)
+				positionId[v] = found.first->second;
+		}
+
+		for(std::size_t v = 0; v < vertexCount; ++v)
+			++groupSize[positionId[v]];
+	}
+
+	// 2. Locked vertices: seams (shared position) and open borders (an edge
+	//    with one triangle).  Also the quadrics of the original surface.
+	std::vector<bool> locked(vertexCount, false);
+	std::vector<Quadric> quadrics(vertexCount);
+	{
+		std::unordered_map<std::uint64_t, std::uint32_t> edgeUse;
+		edgeUse.reserve(indexCount);
+
+		for(std::size_t i = 0; i < indexCount; i += 3)
+		{
+			const std::uint32_t p[3] = { positionId[indices[i]], positionId[indices[i + 1]], positionId[indices[i + 2]] };
+			for(int e = 0; e < 3; ++e)
+				++edgeUse[EdgeKey(p[e], p[(e + 1) % 3])];
+
+			const Float3 p0 = LoadPosition(positions, positionStride, p[0]);
+			const Float3 n = Cross(Sub(LoadPosition(positions, positionStride, p[1]), p0),
+				Sub(LoadPosition(positions, positionStride, p[2]), p0));
+			const float length = std::sqrt(Dot(n, n));
+			if(length <= 0.0f)
+				continue;
+
+			const Float3 unit = { n.X / length, n.Y / length, n.Z / length };
+			for(int c = 0; c < 3; ++c)
+				quadrics[p[c]].AddPlane(unit, -Dot(unit, p0), length * 0.5);
+		}
+
+		for(std::size_t i = 0; i < indexCount; i += 3)
+		{
+			const std::uint32_t p[3] = { positionId[indices[i]], positionId[indices[i + 1]], positionId[indices[i + 2]] };
+			for(int e = 0; e < 3; ++e)
+			{
+				if(edgeUse[EdgeKey(p[e], p[(e + 1) % 3])] == 1)
+				{
+					locked[p[e]] = true;
+					locked[p[(e + 1) % 3]] = true;
+				}
+			}
+		}
+
+		for(std::size_t v = 0; v < vertexCount; ++v)
+		{
+			if(groupSize[positionId[v]] > 1 || locked[positionId[v]])
+				locked[v] = true;
+		}
+	}
+
+	// 3. Passes: cost every edge, collapse the cheapest ones that don't touch
+	//    each other, then drop the triangles that became degenerate.
+	std::vector<std::uint32_t> triangleStart(vertexCount + 1);
+	std::vector<std::uint32_t> triangles;
+	std::vector<Collapse> collapses;
+	std::vector<bool> touched(vertexCount);
+	std::vector<std::uint32_t> remap(vertexCount);
+	double maxError = 0.0;
+
+	while(indexCount > targetIndexCount)
+	{
+		// Triangles around every vertex (CSR).
+		std::fill(triangleStart.begin(), triangleStart.end(), 0);
+		for(std::size_t i = 0; i < indexCount; ++i)
+			++triangleStart[destination[i] + 1];
+		for(std::size_t v = 0; v < vertexCount; ++v)
+			triangleStart[v + 1] += triangleStart[v];
+
+		triangles.resize(indexCount);
+		{
+			std::vector<std::uint32_t> fill(triangleStart.begin(), triangleStart.end() - 1);
+			for(std::size_t i = 0; i < indexCount; ++i)
+				triangles[fill[destination[i]]++] = (std::uint32_t)(i / 3);
+		}
+
+		collapses.clear();
+		for(std::size_t i = 0; i < indexCount; i += 3)
+		{
+			for(int e = 0; e < 3; ++e)
+			{
+				const std::uint32_t from = destination[i + e];
+				const std::uint32_t to = destination[i + (e + 1) % 3];
+				if(locked[from] || from == to)
+					continue;
+
+				Quadric q = quadrics[from];
+				q.Add(quadrics[positionId[to]]);
+				collapses.push_back({ q.Evaluate(LoadPosition(positions, positionStride, to)), from, to });
+			}
+		}
+
+		if(collapses.empty())
+			break;
+		std::sort(collapses.begin(), collapses.end());
+
+		for(std::size_t v = 0; v < vertexCount; ++v)
+		{
+			remap[v] = (std::uint32_t)v;
+			touched[v] = false;
+		}
+
+		// A collapse removes about two triangles; stop the pass a little
+		// short of the target so the last pass can still pick cheap edges.
+		const std::size_t trianglesToRemove = (indexCount - targetIndexCount) / 3;
+		std::size_t removed = 0;
+
+		for(const Collapse& collapse : collapses)
+		{
+			if(removed >= trianglesToRemove)
+				break;
+
+			const std::uint32_t from = collapse.From;
+			const std::uint32_t to = collapse.To;
+			if(touched[from] || touched[to])
+				continue;
+
+			// The triangles around from must keep their facing once from moves
+			// to to, and none of them may have been changed in this pass.
+			const Float3 target = LoadPosition(positions, positionStride, to);
+			bool valid = true;
+			std::size_t vanishing = 0;
+
+			for(std::uint32_t t = triangleStart[from]; t < triangleStart[from + 1] && valid; ++t)
+			{
+				const std::uint32_t* tri = destination + triangles[t] * 3;
+				if(touched[tri[0]] || touched[tri[1]] || touched[tri[2]])
+				{
+					valid = false;
+					break;
+				}
+
+				if(tri[0] == to || tri[1] == to || tri[2] == to)
+				{
+					++vanishing;
+					continue;
+				}
+
+				Float3 p[3];
+				Float3 moved[3];
+				for(int c = 0; c < 3; ++c)
+				{
+					p[c] = LoadPosition(positions, positionStride, tri[c]);
+					moved[c] = tri[c] == from ? target : p[c];
+				}
+
+				const Float3 before = Cross(Sub(p[1], p[0]), Sub(p[2], p[0]));
+				const Float3 after = Cross(Sub(moved[1], moved[0]), Sub(moved[2], moved[0]));
+				if(Dot(before, after) <= 0.0f)
+					valid = false;
+			}
+
+			if(!valid || vanishing == 0)
+				continue;
+
+			remap[from] = to;
+			quadrics[positionId[to]].Add(quadrics[from]);
+			removed += vanishing;
+
+			const double weight = quadrics[positionId[to]].Weight;
+			if(weight > 0.0)
+				maxError = std::max(maxError, collapse.Cost / weight);
+
+			for(std::uint32_t t = triangleStart[from]; t < triangleStart[from + 1]; ++t)
+			{
+				const std::uint32_t* tri = destination + triangles[t] * 3;
+				touched[tri[0]] = true;
+				touched[tri[1]] = true;
+				touched[tri[2]] = true;
+			}
+		}
+
+		if(removed == 0)
+			break;
+
+		std::size_t write = 0;
+		for(std::size_t i = 0; i < indexCount; i += 3)
+		{
+			const std::uint32_t a = remap[destination[i + 0]];
+			const std::uint32_t b = remap[destination[i + 1]];
+			const std::uint32_t c = remap[destination[i + 2]];
+			if(a == b || b == c || c == a)
+				continue;
+
+			destination[write++] = a;
+			destination[write++] = b;
+			destination[write++] = c;
+		}
+		indexCount = write;
+	}
+
+	if(resultError != nullptr)
+		*resultError = (float)std::sqrt(maxError);
+
+	return indexCount;
+}
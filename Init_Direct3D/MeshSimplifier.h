@@ -0,0 +1,28 @@
+#ifndef MESHSIMPLIFIER_H
+#define MESHSIMPLIFIER_H
+
+#include <cstddef>
+#include <cstdint>
+
+///<summary>
+/// Quadric error mesh simplification (Garland & Heckbert) for building LODs.
+///
+/// Edges are collapsed onto one of their existing vertices, so a LOD is only
+/// a new index list over the same vertex buffer.  Vertices on an open border
+/// or on an attribute seam (several vertices at one position) never move, so
+/// outlines and texture seams stay where they were.
+///</summary>
+class MeshSimplifier
+{
+public:
+	// Writes the simplified triangle list to destination (which needs room for
+	// indexCount indices) and returns its index count.  Stops at
+	// targetIndexCount or when no edge can be collapsed without flipping a
+	// triangle.  resultError receives the largest deviation from the original
+	// surface, in position units.
+	static std::size_t Simplify(std::uint32_t* destination, const std::uint32_t* indices, std::size_t indexCount,
+		const void* positions, std::size_t positionStride, std::size_t vertexCount,
+		std::size_t targetIndexCount, float* resultError = nullptr);
+};
+
+#endif // MESHSIMPLIFIER_H
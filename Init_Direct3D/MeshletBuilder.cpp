@@ -0,0 +1,341 @@
+#include "MeshletBuilder.h"
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace
+{
+	// How many live neighbours one unit of (1 - dot(axis, normal)) is worth
+	// when picking the next triangle.  Higher gives tighter normal cones,
+	// lower gives rounder meshlets.
+	const float ConeWeight = 16.0f;
+	struct Float3
+	{
+		float X, Y, Z;
+	};
+
+	Float3 Sub(const Float3& a, const Float3& b) { return { a.X - b.X, a.Y - b.Y, a.Z - b.Z }; }
+	float Dot(const Float3& a, const Float3& b) { return a.X * b.X + a.Y * b.Y + a.Z * b.Z; }
+	Float3 Cross(const Float3& a, const Float3& b)
+	{
+		return { a.Y * b.Z - a.Z * b.Y, a.Z * b.X - a.X * b.Z, a.X * b.Y - a.Y * b.X };
+	}
+
+	Float3 LoadPosition(const void* positions, std::size_t stride, std::uint32_t i)
+	{
+		Float3 p;
+		memcpy(&p, static_cast<const unsigned char*>(positions) + i * stride, sizeof(p));
+		return p;
+	}
+
+	// Sphere around the bounding box of the meshlet's vertices, then the
+	// cone of its triangle normals.
+	void ComputeBounds(Meshlet& meshlet, const std::uint32_t* indices,
+		const void* positions, std::size_t stride)
+	{
+		const std::uint32_t* tri = indices + meshlet.IndexOffset;
+		const std::size_t indexCount = meshlet.TriangleCount * 3;
+
+		Float3 vMin = LoadPosition(positions, stride, tri[0]);
+		Float3 vMax = vMin;
+		for(std::size_t i = 1; i < indexCount; ++i)
+		{
+			const Float3 p = LoadPosition(positions, stride, tri[i]);
+			vMin = { std::fmin(vMin.X, p.X), std::fmin(vMin.Y, p.Y), std::fmin(vMin.Z, p.Z) };
+			vMax = { std::fmax(vMax.X, p.X), std::fmax(vMax.Y, p.Y), std::fmax(vMax.Z, p.Z) };
+		}
+
+		const Float3 center = { (vMin.X + vMax.X) * 0.5f, (vMin.Y + vMax.Y) * 0.5f, (vMin.Z + vMax.Z) * 0.5f };
+		float radiusSq = 0.0f;
+		for(std::size_t i = 0; i < indexCount; ++i)
+		{
+			const Float3 d = Sub(LoadPosition(positions, stride, tri[i]), center);
+			radiusSq = std::fmax(radiusSq, Dot(d, d));
+		}
+
+		meshlet.Center[0] = center.X;
+		meshlet.Center[1] = center.Y;
+		meshlet.Center[2] = center.Z;
+		meshlet.Radius = std::sqrt(radiusSq);
+
+		// Normal cone: the axis is the average normal, the cutoff comes from
+		// the normal furthest from it.  The apex is moved back along the axis
+		// until every triangle plane is in front of it, so the test holds for
+		// any eye position, not only distant ones.
+		std::vector<Float3> normals;
+		normals.reserve(meshlet.TriangleCount);
+		Float3 axis = { 0.0f, 0.0f, 0.0f };
+		for(std::size_t i = 0; i < indexCount; i += 3)
+		{
+			const Float3 p0 = LoadPosition(positions, stride, tri[i + 0]);
+			const Float3 n = Cross(Sub(LoadPosition(positions, stride, tri[i + 1]), p0),
+				Sub(LoadPosition(positions, stride, tri[i + 2]), p0));
+
+			const float length = std::sqrt(Dot(n, n));
+			if(length <= 0.0f)
+			{
+				normals.push_back({ 0.0f, 0.0f, 0.0f });
+				continue;
+			}
+
+			normals.push_back({ n.X / length, n.Y / length, n.Z / length });
+			axis = { axis.X + normals.back().X, axis.Y + normals.back().Y, axis.Z + normals.back().Z };
+		}
+
+		const float axisLength = std::sqrt(Dot(axis, axis));
+		if(axisLength <= 0.0f)
+			return;
+		axis = { axis.X / axisLength, axis.Y / axisLength, axis.Z / axisLength };
+
+		float minDot = 1.0f;
+		for(const Float3& n : normals)
+		{
+			if(n.X != 0.0f || n.Y != 0.0f || n.Z != 0.0f)
+				minDot = std::fmin(minDot, Dot(axis, n));
+		}
+
+		// Normals spread over (almost) a half sphere, the cone would never cull.
+		if(minDot <= 0.1f)
+			return;
+
+		float maxT = 0.0f;
+		for(std::size_t t = 0; t < normals.size(); ++t)
+		{
+			const Float3& n = normals[t];
+			if(n.X == 0.0f && n.Y == 0.0f && n.Z == 0.0f)
+				continue;
+
+			const Float3 toCenter = Sub(center, LoadPosition(positions, stride, tri[t * 3]));
+			maxT = std::fmax(maxT, Dot(toCenter, n) / Dot(axis, n));
+		}
+
+		meshlet.ConeApex[0] = center.X - axis.X * maxT;
+		meshlet.ConeApex[1] = center.Y - axis.Y * maxT;
+		meshlet.ConeApex[2] = center.Z - axis.Z * maxT;
+		meshlet.ConeAxis[0] = axis.X;
+		meshlet.ConeAxis[1] = axis.Y;
+		meshlet.ConeAxis[2] = axis.Z;
+		meshlet.ConeCutoff = std::sqrt(1.0f - minDot * minDot);
+	}
+}
+
+std::vector<Meshlet> MeshletBuilder::Build(std::uint32_t* indices, std::size_t indexCount,
+	const void* positions, std::size_t positionStride, std::size_t vertexCount,
+	std::size_t maxVertices, std::size_t maxTriangles)
+{
+	std::vector<Meshlet> meshlets;
+	const std::size_t triangleCount = indexCount / 3;
+	if(triangleCount == 0 || maxVertices < 3 || maxTriangles < 1)
+		return meshlets;
+
+	// Vertices split at UV or normal seams share a position but not an
+	// index; growing over position ids lets a meshlet cross those seams.
+	std::vector<std::uint32_t> positionId(vertexCount);
+	{
+		std::unordered_map<std::uint64_t, std::uint32_t> firstAt;
+		firstAt.reserve(vertexCount);
+		for(std::size_t v = 0; v < vertexCount; ++v)
+		{
+			positionId[v] = (std::uint32_t)v;
+
+			std::uint32_t bits[3];
+			memcpy(bits, static_cast<const unsigned char*>(positions) + v * positionStride, sizeof(bits));
+			const std::uint64_t key = ((std::uint64_t)bits[0] * 0x9E3779B97F4A7C15ull) ^
+				((std::uint64_t)bits[1] * 0xC2B2AE3D27D4EB4Full) ^ ((std::uint64_t)bits[2] * 0x165667B19E3779F9ull);
+
+			auto found = firstAt.emplace(key, (std::uint32_t)v);
+			if(!found.second && memcmp(static_cast<const unsigned char*>(positions) + found.first->second * positionStride,
+				bits, sizeof(bits)) == 0)
+				positionId[v] = found.first->second;
+		}
+	}
+
+	// Triangles around every position (CSR).
+	std::vector<std::uint32_t> adjacencyStart(vertexCount + 1, 0);
+	for(std::size_t i = 0; i < triangleCount * 3; ++i)
+		++adjacencyStart[positionId[indices[i]] + 1];
+	for(std::size_t v = 0; v < vertexCount; ++v)
+		adjacencyStart[v + 1] += adjacencyStart[v];
+
+	std::vector<std::uint32_t> adjacency(triangleCount * 3);
+	std::vector<std::uint32_t> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+	for(std::size_t i = 0; i < triangleCount * 3; ++i)
+		adjacency[fill[positionId[indices[i]]]++] = (std::uint32_t)(i / 3);
+
+	std::vector<Float3> normals(triangleCount);
+	for(std::size_t t = 0; t < triangleCount; ++t)
+	{
+		const Float3 p0 = LoadPosition(positions, positionStride, indices[t * 3 + 0]);
+		const Float3 n = Cross(Sub(LoadPosition(positions, positionStride, indices[t * 3 + 1]), p0),
+			Sub(LoadPosition(positions, positionStride, indices[t * 3 + 2]), p0));
+		const float length = std::sqrt(Dot(n, n));
+		normals[t] = length > 0.0f ? Float3{ n.X / length, n.Y / length, n.Z / length } : Float3{ 0.0f, 0.0f, 0.0f };
+	}
+
+	// Triangles not yet placed around every position; they are kept at the
+	// front of the position's adjacency list.  Taking triangles with few live
+	// neighbours first keeps the unplaced part of the mesh in one piece
+	// instead of leaving small islands behind.
+	std::vector<std::uint32_t> live(vertexCount);
+	for(std::size_t v = 0; v < vertexCount; ++v)
+		live[v] = adjacencyStart[v + 1] - adjacencyStart[v];
+
+	// owner[v] == meshlets.size() when v is already in the open meshlet.
+	std::vector<std::size_t> owner(vertexCount, (std::size_t)-1);
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<std::uint32_t> meshletVertices;
+	std::vector<std::uint32_t> order;
+	order.reserve(triangleCount * 3);
+
+	auto countNewVertices = [&](std::size_t t)
+	{
+		const std::uint32_t* tri = indices + t * 3;
+		std::uint32_t count = 0;
+		for(int c = 0; c < 3; ++c)
+		{
+			if(owner[tri[c]] != meshlets.size() && (c < 1 || tri[c] != tri[0]) && (c < 2 || tri[c] != tri[1]))
+				++count;
+		}
+		return count;
+	};
+
+	Meshlet current;
+	Float3 axis = { 0.0f, 0.0f, 0.0f };
+	std::size_t seedCursor = 0;
+
+	for(std::size_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount)
+	{
+		// Grow the meshlet across its border: the triangle that adds the
+		// fewest vertices, then the one that faces closest to the meshlet's
+		// average normal (tight cones cull more).
+		std::size_t best = triangleCount;
+		std::uint32_t bestNew = 4;
+		std::uint32_t bestLive = ~0u;
+		float bestScore = 1e30f;
+
+		if(current.TriangleCount > 0 && current.TriangleCount < maxTriangles)
+		{
+			const float axisLength = std::sqrt(Dot(axis, axis));
+			const Float3 axisDirection = axisLength > 0.0f ?
+				Float3{ axis.X / axisLength, axis.Y / axisLength, axis.Z / axisLength } : Float3{ 0.0f, 0.0f, 0.0f };
+
+			for(std::uint32_t v : meshletVertices)
+			{
+				for(std::uint32_t a = adjacencyStart[positionId[v]]; a < adjacencyStart[positionId[v]] + live[positionId[v]]; ++a)
+				{
+					const std::uint32_t t = adjacency[a];
+					const std::uint32_t newVertices = countNewVertices(t);
+					if(current.VertexCount + newVertices > maxVertices)
+						continue;
+
+					const std::uint32_t* tri = indices + t * 3;
+					const std::uint32_t liveCount = live[positionId[tri[0]]] + live[positionId[tri[1]]] + live[positionId[tri[2]]];
+					const float d = Dot(axisDirection, normals[t]);
+					const float score = (float)liveCount + ConeWeight * (1.0f - d);
+					if(newVertices < bestNew || (newVertices == bestNew && score < bestScore))
+					{
+						best = t;
+						bestNew = newVertices;
+						bestScore = score;
+					}
+				}
+			}
+		}
+
+		// Full, or no neighbour fits: start a new meshlet next to the one
+		// just closed, at the triangle with the fewest live neighbours, or at
+		// the next triangle in index order when the closed one has no
+		// unplaced neighbours left.
+		if(best == triangleCount)
+		{
+			if(current.TriangleCount > 0)
+			{
+				ComputeBounds(current, order.data(), positions, positionStride);
+				meshlets.push_back(current);
+				current = Meshlet();
+				axis = { 0.0f, 0.0f, 0.0f };
+			}
+
+			for(std::uint32_t v : meshletVertices)
+			{
+				for(std::uint32_t a = adjacencyStart[positionId[v]]; a < adjacencyStart[positionId[v]] + live[positionId[v]]; ++a)
+				{
+					const std::uint32_t t = adjacency[a];
+					const std::uint32_t* tri = indices + t * 3;
+					const std::uint32_t liveCount = live[positionId[tri[0]]] + live[positionId[tri[1]]] + live[positionId[tri[2]]];
+					if(liveCount < bestLive)
+					{
+						best = t;
+						bestLive = liveCount;
+					}
+				}
+			}
+			meshletVertices.clear();
+
+			if(best == triangleCount)
+			{
+				while(emitted[seedCursor])
+					++seedCursor;
+				best = seedCursor;
+			}
+			current.IndexOffset = (std::uint32_t)order.size();
+		}
+
+		const std::uint32_t* tri = indices + best * 3;
+		current.VertexCount += countNewVertices(best);
+		for(int c = 0; c < 3; ++c)
+		{
+			if(owner[tri[c]] != meshlets.size())
+			{
+				owner[tri[c]] = meshlets.size();
+				meshletVertices.push_back(tri[c]);
+			}
+			order.push_back(tri[c]);
+
+			const std::uint32_t p = positionId[tri[c]];
+			std::uint32_t* list = adjacency.data() + adjacencyStart[p];
+			for(std::uint32_t a = 0; a < live[p]; ++a)
+			{
+				if(list[a] == best)
+				{
+					list[a] = list[--live[p]];
+					list[live[p]] = (std::uint32_t)best;
+					break;
+				}
+			}
+		}
+
+		axis = { axis.X + normals[best].X, axis.Y + normals[best].Y, axis.Z + normals[best].Z };
+		emitted[best] = true;
+		++current.TriangleCount;
+	}
+
+	ComputeBounds(current, order.data(), positions, positionStride);
+	meshlets.push_back(current);
+
+	memcpy(indices, order.data(), order.size() * sizeof(std::uint32_t));
+	return meshlets;
+}
+
+bool MeshletBuilder::IsBackfacing(const Meshlet& meshlet, const float eye[3])
+{
+	if(meshlet.ConeCutoff >= 1.0f)
+		return false;
+
+	const Float3 toApex = { meshlet.ConeApex[0] - eye[0], meshlet.ConeApex[1] - eye[1], meshlet.ConeApex[2] - eye[2] };
+	const Float3 axis = { meshlet.ConeAxis[0], meshlet.ConeAxis[1], meshlet.ConeAxis[2] };
+
+	// dot(normalize(toApex), axis) >= cutoff, without the square root.
+	const float d = Dot(toApex, axis);
+	return d > 0.0f && d * d >= meshlet.ConeCutoff * meshlet.ConeCutoff * Dot(toApex, toApex);
+}
+
+bool MeshletBuilder::IsBackfacingOrtho(const Meshlet& meshlet, const float viewDirection[3])
+{
+	if(meshlet.ConeCutoff >= 1.0f)
+		return false;
+
+	const Float3 direction = { viewDirection[0], viewDirection[1], viewDirection[2] };
+	const Float3 axis = { meshlet.ConeAxis[0], meshlet.ConeAxis[1], meshlet.ConeAxis[2] };
+	return Dot(direction, axis) >= meshlet.ConeCutoff * std::sqrt(Dot(direction, direction));
+}
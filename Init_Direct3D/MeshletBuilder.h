@@ -0,0 +1,56 @@
+#ifndef MESHLETBUILDER_H
+#define MESHLETBUILDER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+///<summary>
+/// A small cluster of consecutive triangles of an index range, with the
+/// bounds needed to cull it on the CPU.
+///
+/// The cluster can be skipped when its bounding sphere is outside the view,
+/// or when it faces away from the eye:
+///     dot(normalize(ConeApex - eye), ConeAxis) >= ConeCutoff
+/// For an orthographic view with direction d (eye towards scene) the test
+/// becomes dot(d, ConeAxis) >= ConeCutoff.  ConeCutoff is 1 when the
+/// triangle normals are spread too far for the cone to ever cull.
+///</summary>
+struct Meshlet
+{
+	std::uint32_t IndexOffset = 0;		// first index, relative to the start of the range
+	std::uint32_t TriangleCount = 0;
+	std::uint32_t VertexCount = 0;		// unique vertices referenced
+
+	float Center[3] = { 0.0f, 0.0f, 0.0f };
+	float Radius = 0.0f;
+
+	float ConeApex[3] = { 0.0f, 0.0f, 0.0f };
+	float ConeAxis[3] = { 0.0f, 0.0f, 1.0f };
+	float ConeCutoff = 1.0f;
+};
+
+///<summary>
+/// Splits an index range into meshlets.  A meshlet is grown from a seed
+/// triangle over its neighbours, preferring triangles that add no new
+/// vertices and that face the same way as the rest of the meshlet.  The
+/// triangles are then regrouped in place so that every meshlet is a
+/// contiguous index range; the triangles themselves are not changed.
+///</summary>
+class MeshletBuilder
+{
+public:
+	static const std::size_t DefaultMaxVertices = 64;
+	static const std::size_t DefaultMaxTriangles = 124;
+
+	// positions points at the float3 position of vertex 0, positionStride is the vertex size.
+	static std::vector<Meshlet> Build(std::uint32_t* indices, std::size_t indexCount,
+		const void* positions, std::size_t positionStride, std::size_t vertexCount,
+		std::size_t maxVertices = DefaultMaxVertices, std::size_t maxTriangles = DefaultMaxTriangles);
+
+	// Backface cone tests, see Meshlet.
+	static bool IsBackfacing(const Meshlet& meshlet, const float eye[3]);
+	static bool IsBackfacingOrtho(const Meshlet& meshlet, const float viewDirection[3]);
+};
+
+#endif // MESHLETBUILDER_H
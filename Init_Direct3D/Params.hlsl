@@ -26,6 +26,7 @@ cbuffer cbPerObject : register(b0)
 {
     float4x4 gWorld;
     float4x4 gTexTransform;
+    float4 gPosDequant;     //   ġ  (xyz ߽, w ũ)
 }
 
 cbuffer cbPerMaterial : register(b1)
@@ -88,6 +89,24 @@ float3 NormalSampleToWorld(float3 normalMapSample, float3 unitNormalW, float3 ta
     return bumpedNormalW; // 븻  
 }
 
+#ifdef PACKED
+//    (VertexPacking.cpp   )
+// snorm16 ġ -> ޽ ߽ / ũ ǵ
+float3 UnpackPosition(float3 packedPos)
+{
+    return packedPos * gPosDequant.w + gPosDequant.xyz;
+}
+
+// 8ü ڵ ->  
+float3 UnpackUnitVector(float2 e)
+{
+    float3 n = float3(e, 1.0f - abs(e.x) - abs(e.y));
+    float t = saturate(-n.z);
+    n.xy += n.xy >= 0.0f ? -t : t;
+    return normalize(n);
+}
+#endif // PACKED
+
 float CalcShadowFactor(float4 shadowPosH)
 {
     // ... .... .... ׸ڰ
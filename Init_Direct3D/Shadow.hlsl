@@ -13,13 +13,42 @@ struct VertexIn
     
 };
 
+#ifdef PACKED
+//   Է (BuildPackedInputLayout)
+struct PackedVertexIn
+{
+    float4 PosL : POSITION; // snorm16
+#ifdef SKINNED
+    float3 BoneWeights  : WEIGHTS;  // unorm8
+    uint4 BoneIndices   : BONEINDICES;
+#endif // SKINNED
+};
+
+VertexIn UnpackVertex(PackedVertexIn pin)
+{
+    VertexIn vin;
+    vin.PosL = UnpackPosition(pin.PosL.xyz);
+#ifdef SKINNED
+    vin.BoneWeights = pin.BoneWeights;
+    vin.BoneIndices = pin.BoneIndices;
+#endif // SKINNED
+    return vin;
+}
+#endif // PACKED
+
 struct VertexOut
 {
     float4 PosH : SV_POSITION; // 
 };
 
+#ifdef PACKED
+VertexOut VS(PackedVertexIn pin)
+{
+    VertexIn vin = UnpackVertex(pin);
+#else
 VertexOut VS(VertexIn vin)
 {
+#endif
     VertexOut vout = (VertexOut)0.0f;
     
 #ifdef SKINNED
@@ -9,14 +9,37 @@ struct VertexIn
     float2 Uv : TEXCOORD;
 };
 
+#ifdef PACKED
+//   Է (BuildPackedInputLayout)
+struct PackedVertexIn
+{
+    float4 PosL : POSITION; // snorm16
+    float2 Uv : TEXCOORD; // half
+};
+
+VertexIn UnpackVertex(PackedVertexIn pin)
+{
+    VertexIn vin;
+    vin.PosL = UnpackPosition(pin.PosL.xyz);
+    vin.Uv = pin.Uv;
+    return vin;
+}
+#endif // PACKED
+
 struct VertexOut
 {
     float4 PosH : SV_POSITION; // 
     float2 Uv : TEXCOORDx;
 };
 
+#ifdef PACKED
+VertexOut VS(PackedVertexIn pin)
+{
+    VertexIn vin = UnpackVertex(pin);
+#else
 VertexOut VS(VertexIn vin)
 {
+#endif
     VertexOut vout = (VertexOut) 0.0f;
     
     vout.PosH = float4(vin.PosL, 1.0f);
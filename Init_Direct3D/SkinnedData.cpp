@@ -1,4 +1,7 @@
 #include "SkinnedData.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
 
 using namespace DirectX;
 
@@ -29,53 +32,81 @@ float BoneAnimation::GetEndTime()const
 }
 
 void BoneAnimation::Interpolate(float t, XMFLOAT4X4& M)const
+{
+	UINT cursor = 0;
+	Interpolate(t, M, cursor);
+}
+
+void BoneAnimation::Interpolate(float t, XMFLOAT4X4& M, UINT& cursor)const
+{
+	Keyframe key;
+	Interpolate(t, key, cursor);
+
+	XMVECTOR S = XMLoadFloat3(&key.Scale);
+	XMVECTOR P = XMLoadFloat3(&key.Translation);
+	XMVECTOR Q = XMLoadFloat4(&key.RotationQuat);
+
+	XMVECTOR zero = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
+	XMStoreFloat4x4(&M, XMMatrixAffineTransformation(S, zero, Q, P));
+}
+
+void BoneAnimation::Interpolate(float t, Keyframe& key, UINT& cursor)const
 {
 	if( t <= Keyframes.front().TimePos )
 	{
-		XMVECTOR S = XMLoadFloat3(&Keyframes.front().Scale);
-		XMVECTOR P = XMLoadFloat3(&Keyframes.front().Translation);
-		XMVECTOR Q = XMLoadFloat4(&Keyframes.front().RotationQuat);
-
-		XMVECTOR zero = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
-		XMStoreFloat4x4(&M, XMMatrixAffineTransformation(S, zero, Q, P));
+		key = Keyframes.front();
+		cursor = 0;
 	}
 	else if( t >= Keyframes.back().TimePos )
 	{
-		XMVECTOR S = XMLoadFloat3(&Keyframes.back().Scale);
-		XMVECTOR P = XMLoadFloat3(&Keyframes.back().Translation);
-		XMVECTOR Q = XMLoadFloat4(&Keyframes.back().RotationQuat);
-
-		XMVECTOR zero = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
-		XMStoreFloat4x4(&M, XMMatrixAffineTransformation(S, zero, Q, P));
+		key = Keyframes.back();
 	}
 	else
 	{
-		for(UINT i = 0; i < Keyframes.size()-1; ++i)
-		{
-			if( t >= Keyframes[i].TimePos && t <= Keyframes[i+1].TimePos )
-			{
-				float lerpPercent = (t - Keyframes[i].TimePos) / (Keyframes[i+1].TimePos - Keyframes[i].TimePos);
+		UINT i = FindKeyframe(t, cursor);
 
-				XMVECTOR s0 = XMLoadFloat3(&Keyframes[i].Scale);
-				XMVECTOR s1 = XMLoadFloat3(&Keyframes[i+1].Scale);
+		float lerpPercent = (t - Keyframes[i].TimePos) / (Keyframes[i+1].TimePos - Keyframes[i].TimePos);
 
-				XMVECTOR p0 = XMLoadFloat3(&Keyframes[i].Translation);
-				XMVECTOR p1 = XMLoadFloat3(&Keyframes[i+1].Translation);
+		XMVECTOR s0 = XMLoadFloat3(&Keyframes[i].Scale);
+		XMVECTOR s1 = XMLoadFloat3(&Keyframes[i+1].Scale);
 
-				XMVECTOR q0 = XMLoadFloat4(&Keyframes[i].RotationQuat);
-				XMVECTOR q1 = XMLoadFloat4(&Keyframes[i+1].RotationQuat);
+		XMVECTOR p0 = XMLoadFloat3(&Keyframes[i].Translation);
+		XMVECTOR p1 = XMLoadFloat3(&Keyframes[i+1].Translation);
 
-				XMVECTOR S = XMVectorLerp(s0, s1, lerpPercent);
-				XMVECTOR P = XMVectorLerp(p0, p1, lerpPercent);
-				XMVECTOR Q = XMQuaternionSlerp(q0, q1, lerpPercent);
+		XMVECTOR q0 = XMLoadFloat4(&Keyframes[i].RotationQuat);
+		XMVECTOR q1 = XMLoadFloat4(&Keyframes[i+1].RotationQuat);
 
-				XMVECTOR zero = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
-				XMStoreFloat4x4(&M, XMMatrixAffineTransformation(S, zero, Q, P));
+		XMStoreFloat3(&key.Scale, XMVectorLerp(s0, s1, lerpPercent));
+		XMStoreFloat3(&key.Translation, XMVectorLerp(p0, p1, lerpPercent));
+		XMStoreFloat4(&key.RotationQuat, XMQuaternionSlerp(q0, q1, lerpPercent));
+	}
 
-				break;
-			}
+	key.TimePos = t;
+}
+
+UINT BoneAnimation::FindKeyframe(float t, UINT& cursor)const
+{
+	const UINT last = (UINT)Keyframes.size() - 1;
+
+	// Forward playback advances at most a few keys per frame, so walk
+	// ahead from the last segment for a bounded number of steps.
+	const UINT maxSteps = 4;
+	if( cursor < last && Keyframes[cursor].TimePos <= t )
+	{
+		for(UINT step = 0; step < maxSteps && cursor < last; ++step, ++cursor)
+		{
+			if( t < Keyframes[cursor+1].TimePos )
+				return cursor;
 		}
 	}
+
+	// Seek, loop or a large time step: binary search for the first key
+	// after t.  Since front < t < back it is in [1, last].
+	auto next = std::upper_bound(Keyframes.begin(), Keyframes.end(), t,
+		[](float time, const Keyframe& key) { return time < key.TimePos; });
+
+	cursor = (UINT)(next - Keyframes.begin()) - 1;
+	return cursor;
 }
 
 float AnimationClip::GetClipStartTime()const
@@ -110,16 +141,53 @@ void AnimationClip::Interpolate(float t, std::vector<XMFLOAT4X4>& boneTransforms
 	}
 }
 
+void AnimationClip::Interpolate(float t, std::vector<XMFLOAT4X4>& boneTransforms, std::vector<UINT>& keyCursors)const
+{
+	if(keyCursors.size() != BoneAnimations.size())
+		keyCursors.assign(BoneAnimations.size(), 0);
+
+	for(UINT i = 0; i < BoneAnimations.size(); ++i)
+	{
+		BoneAnimations[i].Interpolate(t, boneTransforms[i], keyCursors[i]);
+	}
+}
+
+SkinnedData::ClipHandle SkinnedData::FindClip(const std::string& clipName)const
+{
+	auto clip = mClipHandles.find(clipName);
+	return clip != mClipHandles.end() ? clip->second : InvalidClip;
+}
+
+float SkinnedData::GetClipStartTime(ClipHandle clip)const
+{
+	assert(clip < mClips.size());
+	return mClips[clip].StartTime;
+}
+
+float SkinnedData::GetClipEndTime(ClipHandle clip)const
+{
+	assert(clip < mClips.size());
+	return mClips[clip].EndTime;
+}
+
 float SkinnedData::GetClipStartTime(const std::string& clipName)const
 {
-	auto clip = mAnimations.find(clipName);
-	return clip->second.GetClipStartTime();
+	return GetClipStartTime(FindClip(clipName));
 }
 
 float SkinnedData::GetClipEndTime(const std::string& clipName)const
 {
-	auto clip = mAnimations.find(clipName);
-	return clip->second.GetClipEndTime();
+	return GetClipEndTime(FindClip(clipName));
+}
+
+std::vector<std::string> SkinnedData::GetClipNames()const
+{
+	std::vector<std::string> names;
+	names.reserve(mClips.size());
+	for(const Clip& clip : mClips)
+		names.push_back(clip.Name);
+
+	return names;
 }
 
 UINT SkinnedData::BoneCount()const
@@ -127,54 +195,358 @@ UINT SkinnedData::BoneCount()const
 	return mBoneHierarchy.size();
 }
 
+int SkinnedData::GetBoneParent(UINT bone)const
+{
+	return mBoneHierarchy[bone];
+}
+
+UINT SkinnedData::ClipCount()const
+{
+	return (UINT)mClips.size();
+}
+
 void SkinnedData::Set(std::vector<int>& boneHierarchy, 
 		              std::vector<XMFLOAT4X4>& boneOffsets,
 		              std::unordered_map<std::string, AnimationClip>& animations)
 {
 	mBoneHierarchy = boneHierarchy;
 	mBoneOffsets   = boneOffsets;
-	mAnimations    = animations;
+
+	mClips.clear();
+	mClipHandles.clear();
+	mClips.reserve(animations.size());
+	for(const auto& animation : animations)
+	{
+		mClipHandles[animation.first] = (ClipHandle)mClips.size();
+
+		mClips.emplace_back();
+		mClips.back().Name = animation.first;
+		mClips.back().Animation = animation.second;
+		PrepareClip(mClips.back());
+	}
+}
+
+void SkinnedData::PrepareClip(Clip& clip)
+{
+	if(mUseCompiledClips)
+		CompileClip(clip);
+	else
+		clip.Compiled.Clear();
+
+	clip.StartTime = clip.IsCompressed ? clip.Compressed.GetStartTime() : clip.Animation.GetClipStartTime();
+	clip.EndTime = clip.IsCompressed ? clip.Compressed.GetEndTime() : clip.Animation.GetClipEndTime();
+	clip.Baked.Clear();
+}
+
+void SkinnedData::CompileClip(Clip& clip)
+{
+	if(!clip.IsCompressed)
+	{
+		clip.Compiled.Compile(clip.Animation);
+		return;
+	}
+
+	// Only while compiling: the compressed clip stays the stored form.
+	AnimationClip decoded;
+	clip.Compressed.Decompress(decoded);
+	clip.Compiled.Compile(decoded);
+}
+
+void SkinnedData::InterpolateClip(const Clip& clip, float t, std::vector<XMFLOAT4X4>& toParentTransforms,
+	std::vector<UINT>& keyCursors)
+{
+	if(!clip.IsCompressed)
+	{
+		clip.Animation.Interpolate(t, toParentTransforms, keyCursors);
+		return;
+	}
+
+	const std::size_t numBones = clip.Compressed.BoneCount();
+	if(keyCursors.size() != numBones)
+		keyCursors.assign(numBones, 0);
+
+	for(std::size_t i = 0; i < numBones; ++i)
+		clip.Compressed.Interpolate(i, t, toParentTransforms[i], keyCursors[i]);
+}
+
+void SkinnedData::CompressClips(const ClipCompressor::Settings& settings,
+	std::unordered_map<std::string, ClipCompressor::Report>* reports)
+{
+	for(Clip& clip : mClips)
+	{
+		// A clip compressed before is compressed again from its decoded keys.
+		AnimationClip original;
+		if(clip.IsCompressed)
+			clip.Compressed.Decompress(original);
+		else
+			original = std::move(clip.Animation);
+
+		ClipCompressor::Report report;
+		ClipCompressor::Compress(original, settings, clip.Compressed, &report);
+
+		// Free the keyframes: the compressed clip is what is kept and sampled.
+		std::vector<BoneAnimation>().swap(clip.Animation.BoneAnimations);
+		clip.IsCompressed = true;
+		PrepareClip(clip);
+
+		if(reports == nullptr)
+			continue;
+
+		// Local errors add up along the hierarchy; measure where the bones
+		// actually end up.
+		const UINT numBones = mBoneHierarchy.size();
+		std::vector<XMFLOAT4X4> originalToRoot(numBones);
+		std::vector<XMFLOAT4X4> compressedToRoot(numBones);
+		std::vector<UINT> originalCursors;
+		std::vector<UINT> compressedCursors;
+
+		const float startTime = original.GetClipStartTime();
+		const float endTime = original.GetClipEndTime();
+		const UINT sampleCount = (UINT)((endTime - startTime) * 60.0f) + 1;
+		for(UINT sample = 0; sample <= sampleCount; ++sample)
+		{
+			const float t = startTime + (endTime - startTime) * sample / sampleCount;
+			original.Interpolate(t, originalToRoot, originalCursors);
+			InterpolateClip(clip, t, compressedToRoot, compressedCursors);
+
+			for(UINT i = 1; i < numBones; ++i)
+			{
+				const int parentIndex = mBoneHierarchy[i];
+				XMStoreFloat4x4(&originalToRoot[i], XMMatrixMultiply(
+					XMLoadFloat4x4(&originalToRoot[i]), XMLoadFloat4x4(&originalToRoot[parentIndex])));
+				XMStoreFloat4x4(&compressedToRoot[i], XMMatrixMultiply(
+					XMLoadFloat4x4(&compressedToRoot[i]), XMLoadFloat4x4(&compressedToRoot[parentIndex])));
+			}
+
+			for(UINT i = 0; i < numBones; ++i)
+			{
+				const XMFLOAT4X4& a = originalToRoot[i];
+				const XMFLOAT4X4& b = compressedToRoot[i];
+				XMVECTOR delta = XMVectorSet(a._41 - b._41, a._42 - b._42, a._43 - b._43, 0.0f);
+				report.MaxBonePositionError = MathHelper::Max(report.MaxBonePositionError, XMVectorGetX(XMVector3Length(delta)));
+			}
+		}
+
+		(*reports)[clip.Name] = report;
+	}
+}
+
+void SkinnedData::BakeClips(float sampleRate, std::unordered_map<std::string, BakedClip::Report>* reports)
+{
+	const UINT numBones = mBoneHierarchy.size();
+	std::vector<XMFLOAT4X4> toParentTransforms(numBones);
+	std::vector<XMFLOAT4X4> palette(numBones);
+	std::vector<XMFLOAT4X4> bakedPalette(numBones);
+	std::vector<UINT> keyCursors;
+	EvalScratch scratch;
+
+	// Bind space bone positions; the palette takes them to the posed bones.
+	std::vector<XMVECTOR> bindPositions(numBones);
+	for(UINT i = 0; i < numBones; ++i)
+	{
+		XMMATRIX offset = XMLoadFloat4x4(&mBoneOffsets[i]);
+		bindPositions[i] = XMMatrixInverse(nullptr, offset).r[3];
+	}
+
+	for(Clip& clip : mClips)
+	{
+		clip.Baked.Clear();
+
+		const float length = clip.EndTime - clip.StartTime;
+		if(sampleRate <= 0.0f || length <= 0.0f)
+			continue;
+
+		const std::size_t frameCount = (std::size_t)ceilf(length * sampleRate) + 1;
+		clip.Baked.Allocate(numBones, frameCount, clip.StartTime, clip.EndTime);
+
+		for(std::size_t frame = 0; frame < frameCount; ++frame)
+		{
+			InterpolateClip(clip, clip.Baked.GetFrameTime(frame), toParentTransforms, keyCursors);
+			GetFinalTransforms(toParentTransforms.data(), palette.data(), scratch);
+			clip.Baked.SetFrame(frame, palette.data());
+		}
+
+		if(reports == nullptr)
+			continue;
+
+		BakedClip::Report report;
+		report.SampleRate = (frameCount - 1) / length;
+		report.FrameCount = frameCount;
+		report.ByteSize = clip.Baked.GetByteSize();
+
+		// The lerp error peaks between frames; check four points in each.
+		const UINT subSamples = 4;
+		keyCursors.clear();
+		for(std::size_t frame = 0; frame + 1 < frameCount; ++frame)
+		{
+			const float t0 = clip.Baked.GetFrameTime(frame);
+			const float t1 = clip.Baked.GetFrameTime(frame + 1);
+			for(UINT sample = 1; sample <= subSamples; ++sample)
+			{
+				const float t = t0 + (t1 - t0) * sample / (subSamples + 1);
+				InterpolateClip(clip, t, toParentTransforms, keyCursors);
+				GetFinalTransforms(toParentTransforms.data(), palette.data(), scratch);
+				clip.Baked.Sample(t, bakedPalette.data());
+
+				// The palette is transposed: rows are the columns of the transform.
+				for(UINT i = 0; i < numBones; ++i)
+				{
+					XMMATRIX live = XMMatrixTranspose(XMLoadFloat4x4(&palette[i]));
+					XMMATRIX baked = XMMatrixTranspose(XMLoadFloat4x4(&bakedPalette[i]));
+					XMVECTOR delta = XMVectorSubtract(XMVector3Transform(bindPositions[i], live), XMVector3Transform(bindPositions[i], baked));
+					report.MaxBonePositionError = MathHelper::Max(report.MaxBonePositionError, XMVectorGetX(XMVector3Length(delta)));
+				}
+			}
+		}
+
+		(*reports)[clip.Name] = report;
+	}
+}
+
+const BakedClip* SkinnedData::FindBakedClip(ClipHandle clip)const
+{
+	return clip < mClips.size() && !mClips[clip].Baked.IsEmpty() ? &mClips[clip].Baked : nullptr;
+}
+
+void SkinnedData::UseCompiledClips(bool use)
+{
+	if(use == mUseCompiledClips)
+		return;
+
+	mUseCompiledClips = use;
+	for(Clip& clip : mClips)
+	{
+		if(use)
+			CompileClip(clip);
+		else
+			clip.Compiled.Clear();
+	}
+}
+
+bool SkinnedData::IsUsingCompiledClips()const
+{
+	return mUseCompiledClips;
+}
+
+const CompiledClip* SkinnedData::FindCompiledClip(ClipHandle clip)const
+{
+	return clip < mClips.size() && !mClips[clip].Compiled.IsEmpty() ? &mClips[clip].Compiled : nullptr;
+}
+
+const CompiledClip* SkinnedData::FindCompiledClip(const std::string& clipName)const
+{
+	return FindCompiledClip(FindClip(clipName));
 }
  
 void SkinnedData::GetFinalTransforms(const std::string& clipName, float timePos,  std::vector<XMFLOAT4X4>& finalTransforms)const
+{
+	std::vector<UINT> keyCursors;
+	GetFinalTransforms(clipName, timePos, finalTransforms, keyCursors);
+}
+
+void SkinnedData::GetFinalTransforms(const std::string& clipName, float timePos,
+	std::vector<XMFLOAT4X4>& finalTransforms, std::vector<UINT>& keyCursors)const
+{
+	EvalScratch scratch;
+	GetFinalTransforms(clipName, timePos, finalTransforms.data(), keyCursors, scratch);
+}
+
+void SkinnedData::GetFinalTransforms(const std::string& clipName, float timePos, XMFLOAT4X4* palette,
+	std::vector<UINT>& keyCursors, EvalScratch& scratch)const
+{
+	GetFinalTransforms(FindClip(clipName), timePos, palette, keyCursors, scratch);
+}
+
+void SkinnedData::GetFinalTransforms(ClipHandle clip, float timePos, XMFLOAT4X4* palette,
+	std::vector<UINT>& keyCursors, EvalScratch& scratch)const
 {
 	UINT numBones = mBoneOffsets.size();
 
-	std::vector<XMFLOAT4X4> toParentTransforms(numBones);
+	assert(clip < mClips.size());
+	const Clip& clipData = mClips[clip];
+	const std::vector<BoneAnimation>& boneAnimations = clipData.Animation.BoneAnimations;
+	const std::size_t clipBoneCount = clipData.IsCompressed ? clipData.Compressed.BoneCount() : boneAnimations.size();
 
-	// Interpolate all the bones of this clip at the given time instance.
-	auto clip = mAnimations.find(clipName);
-	clip->second.Interpolate(timePos, toParentTransforms);
+	// The compiled clip samples every bone up front, four at a time.
+	if(mUseCompiledClips)
+	{
+		if(keyCursors.size() != 1)
+			keyCursors.assign(1, 0);
 
-	//
-	// Traverse the hierarchy and transform all the bones to the root space.
-	//
+		if(scratch.ToParentTransforms.size() < numBones)
+			scratch.ToParentTransforms.resize(numBones);
 
-	std::vector<XMFLOAT4X4> toRootTransforms(numBones);
+		clipData.Compiled.Sample(timePos, scratch.ToParentTransforms.data(), keyCursors[0]);
+		GetFinalTransforms(scratch.ToParentTransforms.data(), palette, scratch);
+		return;
+	}
 
-	// The root bone has index 0.  The root bone has no parent, so its toRootTransform
-	// is just its local bone transform.
-	toRootTransforms[0] = toParentTransforms[0];
+	if(keyCursors.size() != clipBoneCount)
+		keyCursors.assign(clipBoneCount, 0);
 
-	// Now find the toRootTransform of the children.
-	for(UINT i = 1; i < numBones; ++i)
-	{
-		XMMATRIX toParent = XMLoadFloat4x4(&toParentTransforms[i]);
+	if(scratch.ToRootTransforms.size() < numBones)
+		scratch.ToRootTransforms.resize(numBones);
 
-		int parentIndex = mBoneHierarchy[i];
-		XMMATRIX parentToRoot = XMLoadFloat4x4(&toRootTransforms[parentIndex]);
+	std::vector<XMFLOAT4X4>& toRootTransforms = scratch.ToRootTransforms;
 
-		XMMATRIX toRoot = XMMatrixMultiply(toParent, parentToRoot);
+	// Parents always come before their children, so a single pass can
+	// interpolate each bone, move it to root space and emit its final
+	// transform.  Only the root space transforms are kept, for the children.
+	for(UINT i = 0; i < numBones; ++i)
+	{
+		// Interpolate this bone of the clip at the given time instance.
+		XMFLOAT4X4 toParentTransform;
+		if(clipData.IsCompressed)
+			clipData.Compressed.Interpolate(i, timePos, toParentTransform, keyCursors[i]);
+		else
+			boneAnimations[i].Interpolate(timePos, toParentTransform, keyCursors[i]);
+		XMMATRIX toParent = XMLoadFloat4x4(&toParentTransform);
+
+		// The root bone has index 0.  The root bone has no parent, so its
+		// toRootTransform is just its local bone transform.
+		XMMATRIX toRoot = toParent;
+		if(i > 0)
+		{
+			int parentIndex = mBoneHierarchy[i];
+			XMMATRIX parentToRoot = XMLoadFloat4x4(&toRootTransforms[parentIndex]);
 
+			toRoot = XMMatrixMultiply(toParent, parentToRoot);
+		}
 		XMStoreFloat4x4(&toRootTransforms[i], toRoot);
+
+		// Premultiply by the bone offset transform to get the final transform.
+		XMMATRIX offset = XMLoadFloat4x4(&mBoneOffsets[i]);
+		XMMATRIX finalTransform = XMMatrixMultiply(offset, toRoot);
+		XMStoreFloat4x4(&palette[i], XMMatrixTranspose(finalTransform));
 	}
+}
+
+void SkinnedData::GetFinalTransforms(const XMFLOAT4X4* toParentTransforms, XMFLOAT4X4* palette, EvalScratch& scratch)const
+{
+	UINT numBones = mBoneOffsets.size();
 
-	// Premultiply by the bone offset transform to get the final transform.
+	if(scratch.ToRootTransforms.size() < numBones)
+		scratch.ToRootTransforms.resize(numBones);
+
+	std::vector<XMFLOAT4X4>& toRootTransforms = scratch.ToRootTransforms;
+
+	// Same pass as above, with the local transforms already sampled.
 	for(UINT i = 0; i < numBones; ++i)
 	{
+		XMMATRIX toParent = XMLoadFloat4x4(&toParentTransforms[i]);
+
+		XMMATRIX toRoot = toParent;
+		if(i > 0)
+		{
+			int parentIndex = mBoneHierarchy[i];
+			XMMATRIX parentToRoot = XMLoadFloat4x4(&toRootTransforms[parentIndex]);
+
+			toRoot = XMMatrixMultiply(toParent, parentToRoot);
+		}
+		XMStoreFloat4x4(&toRootTransforms[i], toRoot);
+
 		XMMATRIX offset = XMLoadFloat4x4(&mBoneOffsets[i]);
-		XMMATRIX toRoot = XMLoadFloat4x4(&toRootTransforms[i]);
-        XMMATRIX finalTransform = XMMatrixMultiply(offset, toRoot);
-		XMStoreFloat4x4(&finalTransforms[i], XMMatrixTranspose(finalTransform));
+		XMMATRIX finalTransform = XMMatrixMultiply(offset, toRoot);
+		XMStoreFloat4x4(&palette[i], XMMatrixTranspose(finalTransform));
 	}
-}
\ No newline at end of file
+}
@@ -1,8 +1,13 @@
 #ifndef SKINNEDDATA_H
 #define SKINNEDDATA_H
 
-#include "../Common/d3dUtil.h"
 #include "../Common/MathHelper.h"
+#include "BakedClip.h"
+#include "ClipCompressor.h"
+#include "CompiledClip.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 ///<summary>
 /// A Keyframe defines the bone transformation at an instant in time.
@@ -32,6 +37,20 @@ struct BoneAnimation
 
     void Interpolate(float t, DirectX::XMFLOAT4X4& M)const;
 
+	// Same as above, but the keyframe search starts at cursor, the segment
+	// the previous call ended in.  Forward playback then only steps ahead a
+	// key or two; seeks and loops fall back to a binary search.  Keep one
+	// cursor per bone for every playing instance.
+	void Interpolate(float t, DirectX::XMFLOAT4X4& M, UINT& cursor)const;
+
+	// Interpolated translation / scale / rotation instead of the matrix.
+	// key.TimePos is set to t.
+	void Interpolate(float t, Keyframe& key, UINT& cursor)const;
+
+	// Index i with Keyframes[i].TimePos <= t < Keyframes[i+1].TimePos.
+	// t must lie strictly inside the animation.
+	UINT FindKeyframe(float t, UINT& cursor)const;
+
 	std::vector<Keyframe> Keyframes; 	
 };
 
@@ -47,36 +66,162 @@ struct AnimationClip
 
     void Interpolate(float t, std::vector<DirectX::XMFLOAT4X4>& boneTransforms)const;
 
+	// keyCursors holds one keyframe cursor per bone (resized if it does not match).
+	void Interpolate(float t, std::vector<DirectX::XMFLOAT4X4>& boneTransforms, std::vector<UINT>& keyCursors)const;
+
     std::vector<BoneAnimation> BoneAnimations; 	
 };
 
 class SkinnedData
 {
 public:
+	///<summary>
+	/// Caller-owned working memory for the allocation-free GetFinalTransforms.
+	/// It grows the first time it is used (or when the bone count grows) and
+	/// is reused afterwards.  Use one per thread that evaluates poses.
+	///</summary>
+	struct EvalScratch
+	{
+		std::vector<DirectX::XMFLOAT4X4> ToParentTransforms;
+		std::vector<DirectX::XMFLOAT4X4> ToRootTransforms;
+	};
+
+	///<summary>
+	/// Index of a clip.  Resolve the name once with FindClip and keep the
+	/// handle; the handle overloads below skip the string lookup, and the
+	/// clip's start and end times are computed when it is loaded.  Handles
+	/// stay valid until the next Set.
+	///</summary>
+	typedef UINT ClipHandle;
+	static const ClipHandle InvalidClip = 0xffffffff;
 
 	UINT BoneCount()const;
+	UINT ClipCount()const;
+
+	// Parents always have a smaller index than their children; the root's parent is -1.
+	int GetBoneParent(UINT bone)const;
+
+	// Clip handles run from 0 to ClipCount() - 1.
+	ClipHandle FindClip(const std::string& clipName)const;
 
+	float GetClipStartTime(ClipHandle clip)const;
+	float GetClipEndTime(ClipHandle clip)const;
 	float GetClipStartTime(const std::string& clipName)const;
 	float GetClipEndTime(const std::string& clipName)const;
 
+	// Indexed by ClipHandle.
+	std::vector<std::string> GetClipNames()const;
+
 	void Set(
 		std::vector<int>& boneHierarchy, 
 		std::vector<DirectX::XMFLOAT4X4>& boneOffsets,
 		std::unordered_map<std::string, AnimationClip>& animations);
 
+	// Sample poses from the CompiledClip of each clip instead of the
+	// per-bone keyframes.  Rotation uses nlerp between keys, so the pose
+	// differs slightly from the slerp path.  Off by default.  Turning it on
+	// compiles every clip (and Set / CompressClips then compile the new
+	// ones); turning it off frees them, so only one copy of the keys is
+	// kept unless compiled sampling is in use.
+	void UseCompiledClips(bool use);
+	bool IsUsingCompiledClips()const;
+
+	// nullptr unless compiled clips are in use.
+	const CompiledClip* FindCompiledClip(ClipHandle clip)const;
+	const CompiledClip* FindCompiledClip(const std::string& clipName)const;
+
+	// Runs every clip through ClipCompressor and keeps the CompressedClip
+	// in place of its keyframes, which are freed; the slerp path and
+	// BakeClips then decode the two keys around t from it.  A CompiledClip,
+	// when in use, is rebuilt from the decoded keys and is extra memory on
+	// top.  reports, if given, gets one entry per clip; CompressedBytes is
+	// what the clip keeps.
+	void CompressClips(const ClipCompressor::Settings& settings,
+		std::unordered_map<std::string, ClipCompressor::Report>* reports = nullptr);
+
+	// Samples the final palette of every clip at sampleRate frames per
+	// second (rounded up so frames land on both clip ends) into a
+	// BakedClip, from the keys with slerp.  Playback then costs one
+	// lerp of two frames per bone; see FindBakedClip.  A rate of 0 drops the
+	// bakes.  Set, CompressClips and a new bake discard the old ones.
+	// reports, if given, gets one entry per clip.
+	void BakeClips(float sampleRate, std::unordered_map<std::string, BakedClip::Report>* reports = nullptr);
+
+	// nullptr when the clip is not baked.
+	const BakedClip* FindBakedClip(ClipHandle clip)const;
+
 	 // In a real project, you'd want to cache the result if there was a chance
 	 // that you were calling this several times with the same clipName at 
-	 // the same timePos.
+	 // the same timePos.  BakeClips caches whole clips at a fixed rate.
     void GetFinalTransforms(const std::string& clipName, float timePos, 
 		 std::vector<DirectX::XMFLOAT4X4>& finalTransforms)const;
 
+	// Keyframe lookup resumes from keyCursors (see BoneAnimation::Interpolate;
+	// the compiled path keeps a single cursor for the whole pose).
+	// Pass the same vector every frame for the same playing instance.
+	void GetFinalTransforms(const std::string& clipName, float timePos,
+		 std::vector<DirectX::XMFLOAT4X4>& finalTransforms, std::vector<UINT>& keyCursors)const;
+
+	// Writes the transposed final transforms (BoneCount matrices, constant
+	// buffer layout) straight to palette, one store per bone, e.g. into a
+	// mapped upload buffer.  Does not allocate once keyCursors and scratch
+	// have been sized by a first call.
+	void GetFinalTransforms(ClipHandle clip, float timePos, DirectX::XMFLOAT4X4* palette,
+		 std::vector<UINT>& keyCursors, EvalScratch& scratch)const;
+	void GetFinalTransforms(const std::string& clipName, float timePos, DirectX::XMFLOAT4X4* palette,
+		 std::vector<UINT>& keyCursors, EvalScratch& scratch)const;
+
+	// Hierarchy pass only: the final transforms (same palette layout as
+	// above) of a pose given as BoneCount to-parent transforms, e.g. a
+	// blended pose.  toParentTransforms may be scratch.ToParentTransforms.
+	void GetFinalTransforms(const DirectX::XMFLOAT4X4* toParentTransforms, DirectX::XMFLOAT4X4* palette,
+		 EvalScratch& scratch)const;
+
+private:
+	struct Clip
+	{
+		std::string Name;
+
+		// The keys: the keyframes as loaded, or after CompressClips only
+		// the compressed form (Animation is then empty)
+		AnimationClip Animation;
+		CompressedClip Compressed;
+		bool IsCompressed = false;
+
+		// Same clip, resampled for SIMD pose sampling; empty unless
+		// UseCompiledClips is on
+		CompiledClip Compiled;
+
+		// Final palettes at a fixed rate, empty unless BakeClips ran
+		BakedClip Baked;
+
+		// Cached start / end time of the keys
+		float StartTime = 0.0f;
+		float EndTime = 0.0f;
+	};
+
+	// Caches the clip's start / end time after its keys changed and
+	// compiles it when compiled clips are in use.  Drops the bake, which
+	// no longer matches.
+	void PrepareClip(Clip& clip);
+	static void CompileClip(Clip& clip);
+
+	// To-parent transforms of every bone of the clip at t, with slerp,
+	// from whichever form the keys are kept in.
+	static void InterpolateClip(const Clip& clip, float t, std::vector<DirectX::XMFLOAT4X4>& toParentTransforms,
+		std::vector<UINT>& keyCursors);
+
 private:
     // Gives parentIndex of ith bone.
 	std::vector<int> mBoneHierarchy;
 
 	std::vector<DirectX::XMFLOAT4X4> mBoneOffsets;
    
-	std::unordered_map<std::string, AnimationClip> mAnimations;
+	// Indexed by ClipHandle
+	std::vector<Clip> mClips;
+	std::unordered_map<std::string, ClipHandle> mClipHandles;
+
+	bool mUseCompiledClips = false;
 };
  
 #endif // SKINNEDDATA_H
\ No newline at end of file
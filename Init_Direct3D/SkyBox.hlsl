@@ -10,14 +10,39 @@ struct VertexIn
     float3 Uv : TEXCOORD;
 };
 
+#ifdef PACKED
+//   Է (BuildPackedInputLayout)
+struct PackedVertexIn
+{
+    float4 PosL : POSITION; // snorm16
+    float2 NormalL : NORMAL; // 8ü ڵ
+    float2 Uv : TEXCOORD; // half
+};
+
+VertexIn UnpackVertex(PackedVertexIn pin)
+{
+    VertexIn vin;
+    vin.PosL = UnpackPosition(pin.PosL.xyz);
+    vin.NormalL = UnpackUnitVector(pin.NormalL);
+    vin.Uv = float3(pin.Uv, 0.0f);
+    return vin;
+}
+#endif // PACKED
+
 struct VertexOut
 {
     float4 PosH : SV_POSITION;
     float3 PosL : POSITION; 
 };
 
+#ifdef PACKED
+VertexOut VS(PackedVertexIn pin)
+{
+    VertexIn vin = UnpackVertex(pin);
+#else
 VertexOut VS(VertexIn vin)
 {
+#endif
     VertexOut vout;
     vout.PosL = vin.PosL;
     
@@ -0,0 +1,231 @@
+#include "TaskGraph.h"
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+
+TaskGraph::TaskId TaskGraph::Add(const std::string& name, std::function<void()> func, const std::vector<TaskId>& dependencies)
+{
+	Task task;
+	task.Name = name;
+	task.Func = std::move(func);
+	task.Dependencies = dependencies;
+
+	for(TaskId dependency : dependencies)
+	{
+		assert(dependency < mTasks.size());
+		(void)dependency;
+	}
+
+	mTasks.push_back(std::move(task));
+	return mTasks.size() - 1;
+}
+
+void TaskGraph::Run(ThreadPool& threadPool)
+{
+	typedef std::chrono::steady_clock Clock;
+
+	const std::size_t count = mTasks.size();
+	mTotalMs = 0.0;
+	if(count == 0)
+		return;
+
+	// Helpers that start after the graph is finished find no work and
+	// return right away, so the state has to outlive this call.
+	struct RunState
+	{
+		std::mutex Mutex;
+		std::condition_variable Changed;
+
+		std::vector<std::size_t> Waiting;			// unfinished dependencies per task
+		std::vector<std::vector<TaskId>> Dependents;
+		std::vector<bool> Skipped;
+		std::deque<TaskId> Ready;
+		std::size_t Finished = 0;
+		std::exception_ptr Error;
+
+		Clock::time_point Start;
+	};
+	auto state = std::make_shared<RunState>();
+	state->Waiting.resize(count);
+	state->Dependents.resize(count);
+	state->Skipped.resize(count, false);
+
+	for(TaskId id = 0; id < count; ++id)
+	{
+		state->Waiting[id] = mTasks[id].Dependencies.size();
+		for(TaskId dependency : mTasks[id].Dependencies)
+			state->Dependents[dependency].push_back(id);
+
+		if(state->Waiting[id] == 0)
+			state->Ready.push_back(id);
+	}
+
+	std::function<void()> helper;
+
+	auto runTask = [this, state, &threadPool, &helper](TaskId id)
+	{
+		Task& task = mTasks[id];
+
+		bool skipped = false;
+		{
+			std::lock_guard<std::mutex> lock(state->Mutex);
+			skipped = state->Skipped[id];
+		}
+
+		task.StartMs = std::chrono::duration<double, std::milli>(Clock::now() - state->Start).count();
+
+		bool failed = skipped;
+		if(!skipped)
+		{
+			try
+			{
+				task.Func();
+			}
+			catch(...)
+			{
+				failed = true;
+
+				std::lock_guard<std::mutex> lock(state->Mutex);
+				if(!state->Error)
+					state->Error = std::current_exception();
+			}
+		}
+
+		task.EndMs = std::chrono::duration<double, std::milli>(Clock::now() - state->Start).count();
+
+		std::size_t newlyReady = 0;
+		{
+			std::lock_guard<std::mutex> lock(state->Mutex);
+			for(TaskId dependent : state->Dependents[id])
+			{
+				if(failed)
+					state->Skipped[dependent] = true;
+
+				if(--state->Waiting[dependent] == 0)
+				{
+					state->Ready.push_back(dependent);
+					++newlyReady;
+				}
+			}
+		}
+		state->Changed.notify_all();
+
+		// The calling thread picks up one of them; the rest go to the pool.
+		// This task only counts as finished afterwards, so Run (and helper)
+		// is still alive here.
+		for(std::size_t i = 1; i < newlyReady; ++i)
+			threadPool.Enqueue(helper);
+
+		{
+			std::lock_guard<std::mutex> lock(state->Mutex);
+			++state->Finished;
+		}
+		state->Changed.notify_all();
+	};
+
+	// Runs at most one task; the calling thread may have taken it already.
+	helper = [state, runTask]()
+	{
+		TaskId id = 0;
+		{
+			std::lock_guard<std::mutex> lock(state->Mutex);
+			if(state->Ready.empty())
+				return;
+
+			id = state->Ready.front();
+			state->Ready.pop_front();
+		}
+		runTask(id);
+	};
+
+	state->Start = Clock::now();
+
+	std::size_t rootCount = state->Ready.size();
+	for(std::size_t i = 1; i < rootCount; ++i)
+		threadPool.Enqueue(helper);
+
+	for(;;)
+	{
+		TaskId id = 0;
+		{
+			std::unique_lock<std::mutex> lock(state->Mutex);
+			state->Changed.wait(lock, [&state, count] { return !state->Ready.empty() || state->Finished == count; });
+
+			if(state->Finished == count)
+				break;
+
+			id = state->Ready.front();
+			state->Ready.pop_front();
+		}
+		runTask(id);
+	}
+
+	mTotalMs = std::chrono::duration<double, std::milli>(Clock::now() - state->Start).count();
+
+	if(state->Error)
+		std::rethrow_exception(state->Error);
+}
+
+std::size_t TaskGraph::GetTaskCount()const
+{
+	return mTasks.size();
+}
+
+const TaskGraph::Task& TaskGraph::GetTask(TaskId id)const
+{
+	return mTasks[id];
+}
+
+double TaskGraph::GetTotalMs()const
+{
+	return mTotalMs;
+}
+
+double TaskGraph::GetSerialMs()const
+{
+	double sum = 0.0;
+	for(const Task& task : mTasks)
+		sum += task.EndMs - task.StartMs;
+
+	return sum;
+}
+
+std::vector<TaskGraph::TaskId> TaskGraph::GetCriticalPath()const
+{
+	std::vector<TaskId> path;
+	if(mTasks.empty())
+		return path;
+
+	// Dependencies always have smaller ids, so one pass in id order is a
+	// topological walk.
+	const std::size_t count = mTasks.size();
+	std::vector<double> pathMs(count, 0.0);
+	std::vector<std::size_t> previous(count, count);
+
+	TaskId last = 0;
+	for(TaskId id = 0; id < count; ++id)
+	{
+		double longest = 0.0;
+		for(TaskId dependency : mTasks[id].Dependencies)
+		{
+			if(pathMs[dependency] > longest || previous[id] == count)
+			{
+				longest = pathMs[dependency];
+				previous[id] = dependency;
+			}
+		}
+
+		pathMs[id] = longest + (mTasks[id].EndMs - mTasks[id].StartMs);
+		if(pathMs[id] > pathMs[last])
+			last = id;
+	}
+
+	for(std::size_t id = last; id != count; id = previous[id])
+		path.push_back(id);
+
+	return std::vector<TaskId>(path.rbegin(), path.rend());
+}
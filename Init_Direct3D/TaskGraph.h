@@ -0,0 +1,64 @@
+#ifndef TASKGRAPH_H
+#define TASKGRAPH_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+#include "ThreadPool.h"
+
+///<summary>
+/// One-shot dependency graph of named tasks.  Tasks are added with the
+/// tasks they have to wait for; Run executes every task once on the
+/// ThreadPool, starting each one as soon as its dependencies are done.
+///
+/// The calling thread also runs ready tasks while it waits, so the graph
+/// keeps moving even when the pool is busy with unrelated work (asset
+/// loads, ...).  Tasks may use ThreadPool::ParallelFor.
+///
+/// After Run every task has a start / end time relative to the start of
+/// Run, and GetCriticalPath returns the chain of dependencies with the
+/// largest summed duration: the chain that bounds the total time.
+///</summary>
+class TaskGraph
+{
+public:
+	typedef std::size_t TaskId;
+
+	struct Task
+	{
+		std::string Name;
+		std::function<void()> Func;
+		std::vector<TaskId> Dependencies;
+
+		// Milliseconds since the start of Run
+		double StartMs = 0.0;
+		double EndMs = 0.0;
+	};
+
+	// Dependencies must already be in the graph, so the graph can not have cycles.
+	TaskId Add(const std::string& name, std::function<void()> func, const std::vector<TaskId>& dependencies = {});
+
+	// Runs every task and returns once all of them are done.  If a task
+	// throws, tasks that depend on it are skipped and the first exception
+	// is rethrown here after the running tasks have finished.
+	void Run(ThreadPool& threadPool);
+
+	std::size_t GetTaskCount()const;
+	const Task& GetTask(TaskId id)const;
+
+	// Wall time of the last Run
+	double GetTotalMs()const;
+
+	// Sum of all task durations (what a serial run would have cost)
+	double GetSerialMs()const;
+
+	// Longest chain by summed duration, first task first.
+	std::vector<TaskId> GetCriticalPath()const;
+
+private:
+	std::vector<Task> mTasks;
+	double mTotalMs = 0.0;
+};
+
+#endif // TASKGRAPH_H
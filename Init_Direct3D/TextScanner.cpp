@@ -0,0 +1,185 @@
+#include "TextScanner.h"
+#include <charconv>
+
+namespace
+{
+	inline bool IsSpace(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+	}
+}
+
+TextScanner::TextScanner(const char* begin, const char* end)
+	: mCur(begin), mEnd(end)
+{
+}
+
+bool TextScanner::Open(const std::string& filename)
+{
+	if(!mFile.Open(filename))
+		return false;
+
+	mCur = reinterpret_cast<const char*>(mFile.Data());
+	mEnd = mCur + mFile.Size();
+	return true;
+}
+
+const char* TextScanner::Position()const
+{
+	return mCur;
+}
+
+const char* TextScanner::End()const
+{
+	return mEnd;
+}
+
+void TextScanner::Seek(const char* position)
+{
+	mCur = position;
+}
+
+bool TextScanner::Eof()
+{
+	SkipWhitespace();
+	return mCur >= mEnd;
+}
+
+void TextScanner::SkipWhitespace()
+{
+	while(mCur < mEnd && IsSpace(*mCur))
+		++mCur;
+}
+
+bool TextScanner::Fail()const
+{
+	return mFail;
+}
+
+void TextScanner::SetFail()
+{
+	mFail = true;
+}
+
+void TextScanner::SkipToken()
+{
+	while(mCur < mEnd && !IsSpace(*mCur))
+		++mCur;
+}
+
+TextScanner& TextScanner::Skip(int count)
+{
+	for(int i = 0; i < count; ++i)
+	{
+		SkipWhitespace();
+		if(mCur >= mEnd)
+		{
+			mFail = true;
+			break;
+		}
+		SkipToken();
+	}
+	return *this;
+}
+
+bool TextScanner::ReadToken(std::string& token)
+{
+	SkipWhitespace();
+
+	const char* begin = mCur;
+	SkipToken();
+
+	token.assign(begin, mCur);
+	if(mCur == begin)
+		mFail = true;
+	return mCur != begin;
+}
+
+bool TextScanner::EndNumber(const char* end)
+{
+	mCur = end;
+	if(mCur < mEnd && !IsSpace(*mCur))
+	{
+		// "1.5f", "3," ...: the number was only the front of the token.
+		mFail = true;
+		SkipToken();
+		return false;
+	}
+	return true;
+}
+
+template<typename T>
+T TextScanner::ReadNumber()
+{
+	SkipWhitespace();
+
+	// from_chars takes a leading '-' but not a '+'.
+	const char* begin = mCur;
+	if(begin < mEnd && *begin == '+' && begin + 1 < mEnd && *(begin + 1) != '-')
+		++begin;
+
+	T value = 0;
+	auto result = std::from_chars(begin, mEnd, value);
+	if(result.ec == std::errc())
+		return EndNumber(result.ptr) ? value : 0;
+
+	// Not a number (or the end of the text), or out of range: the whole
+	// token is consumed so the next read starts at the next token.
+	mFail = true;
+	SkipToken();
+	return 0;
+}
+
+float TextScanner::ReadFloat()
+{
+	return ReadNumber<float>();
+}
+
+int TextScanner::ReadInt()
+{
+	return ReadNumber<int>();
+}
+
+std::uint32_t TextScanner::ReadUInt()
+{
+	return ReadNumber<std::uint32_t>();
+}
+
+TextScanner& TextScanner::operator>>(float& value)
+{
+	value = ReadFloat();
+	return *this;
+}
+
+TextScanner& TextScanner::operator>>(int& value)
+{
+	value = ReadInt();
+	return *this;
+}
+
+TextScanner& TextScanner::operator>>(std::uint32_t& value)
+{
+	value = ReadUInt();
+	return *this;
+}
+
+TextScanner& TextScanner::operator>>(std::uint16_t& value)
+{
+	const std::uint32_t v = ReadUInt();
+	if(v > 0xffff)
+		mFail = true;
+	value = (std::uint16_t)v;
+	return *this;
+}
+
+TextScanner& TextScanner::operator>>(bool& value)
+{
+	value = ReadInt() != 0;
+	return *this;
+}
+
+TextScanner& TextScanner::operator>>(std::string& value)
+{
+	ReadToken(value);
+	return *this;
+}
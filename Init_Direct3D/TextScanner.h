@@ -0,0 +1,77 @@
+#ifndef TEXTSCANNER_H
+#define TEXTSCANNER_H
+
+#include <cstdint>
+#include <string>
+#include "MappedFile.h"
+
+///<summary>
+/// Whitespace separated token reader over an in-memory text buffer.  It is a
+/// replacement for std::ifstream >> in the model readers: the whole file is
+/// mapped once and numbers are parsed with std::from_chars, so there is no
+/// locale or stream state overhead per value.
+///
+/// Like operator>> on a stream, a numeric read expects the next token to be
+/// a number; labels such as "Pos:" or "{" are stepped over with Skip().
+/// When a read finds no token, a token that isn't entirely a number, or a
+/// value out of range, it returns 0, consumes the token and sets the fail
+/// state.  The state stays set, so callers check Fail() once after a
+/// record or a whole section instead of after every value.
+///</summary>
+class TextScanner
+{
+public:
+	TextScanner() = default;
+	TextScanner(const char* begin, const char* end);
+
+	TextScanner(const TextScanner& rhs) = delete;
+	TextScanner& operator=(const TextScanner& rhs) = delete;
+
+	bool Open(const std::string& filename);
+
+	// Current read position and end of the text, for splitting into sub-ranges.
+	const char* Position()const;
+	const char* End()const;
+	void Seek(const char* position);
+
+	bool Eof();
+
+	// True once a read or Skip() came up short (see above).
+	bool Fail()const;
+	// Sets the fail state, e.g. when a scanner over part of this text failed.
+	void SetFail();
+
+	// Skips count whitespace separated tokens.
+	TextScanner& Skip(int count = 1);
+
+	bool ReadToken(std::string& token);
+
+	float ReadFloat();
+	int ReadInt();
+	std::uint32_t ReadUInt();
+
+	TextScanner& operator>>(float& value);
+	TextScanner& operator>>(int& value);
+	TextScanner& operator>>(std::uint32_t& value);
+	TextScanner& operator>>(std::uint16_t& value);
+	TextScanner& operator>>(bool& value);
+	TextScanner& operator>>(std::string& value);
+
+private:
+	void SkipWhitespace();
+	void SkipToken();
+	// Moves past the number parsed up to end.  False (and fail) if the token goes on.
+	bool EndNumber(const char* end);
+
+	template<typename T>
+	T ReadNumber();
+
+private:
+	MappedFile mFile;
+
+	const char* mCur = nullptr;
+	const char* mEnd = nullptr;
+	bool mFail = false;
+};
+
+#endif // TEXTSCANNER_H
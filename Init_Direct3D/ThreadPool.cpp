@@ -0,0 +1,224 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(std::size_t threadCount)
+{
+	if(threadCount == 0)
+		threadCount = std::thread::hardware_concurrency();
+	if(threadCount == 0)
+		threadCount = 1;
+
+	// Every thread can own one loop while it helps with another (one level
+	// of nesting), so with this many records ParallelFor never allocates,
+	// however the helpers happen to be scheduled.
+	const std::size_t loopCount = 2 * (threadCount + 1);
+	mLoops.reserve(loopCount);
+	mFreeLoops.reserve(loopCount);
+	mOpenLoops.reserve(loopCount);
+	for(std::size_t i = 0; i < loopCount; ++i)
+	{
+		mLoops.push_back(std::make_unique<Loop>());
+		mFreeLoops.push_back(mLoops.back().get());
+	}
+
+	mThreads.reserve(threadCount);
+	for(std::size_t i = 0; i < threadCount; ++i)
+		mThreads.emplace_back(&ThreadPool::WorkerMain, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStop = true;
+	}
+	mTaskReady.notify_all();
+
+	for(auto& thread : mThreads)
+		thread.join();
+}
+
+std::size_t ThreadPool::GetThreadCount()const
+{
+	return mThreads.size();
+}
+
+void ThreadPool::Enqueue(std::function<void()> task)
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mTasks.push(std::move(task));
+	}
+	mTaskReady.notify_one();
+}
+
+void ThreadPool::Wait()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	mAllDone.wait(lock, [this] { return mTasks.empty() && mActiveTasks == 0; });
+}
+
+void ThreadPool::ParallelFor(std::size_t count, LoopBody body, const void* context)
+{
+	if(count == 0)
+		return;
+
+	if(count == 1 || mThreads.size() <= 1)
+	{
+		std::exception_ptr error;
+		for(std::size_t i = 0; i < count; ++i)
+		{
+			try
+			{
+				body(context, i);
+			}
+			catch(...)
+			{
+				if(!error)
+					error = std::current_exception();
+			}
+		}
+
+		if(error)
+			std::rethrow_exception(error);
+		return;
+	}
+
+	const std::size_t helperCount = count - 1 < mThreads.size() ? count - 1 : mThreads.size();
+
+	Loop* loop = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		if(mFreeLoops.empty())
+		{
+			mLoops.push_back(std::make_unique<Loop>());
+			mFreeLoops.push_back(mLoops.back().get());
+		}
+		loop = mFreeLoops.back();
+		mFreeLoops.pop_back();
+
+		loop->Body = body;
+		loop->Context = context;
+		loop->Count = count;
+		loop->Next = 0;
+		loop->Done = 0;
+		loop->HelpersWanted = helperCount;
+		loop->Users = 1;
+		mOpenLoops.push_back(loop);
+	}
+
+	if(helperCount > 1)
+		mTaskReady.notify_all();
+	else
+		mTaskReady.notify_one();
+
+	RunLoop(*loop);
+
+	// Helpers may still be inside Body; an iteration that throws counts as
+	// done, so this also waits for those before rethrowing.
+	std::exception_ptr error;
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mLoopDone.wait(lock, [loop] { return loop->Done == loop->Count; });
+
+		auto open = std::find(mOpenLoops.begin(), mOpenLoops.end(), loop);
+		if(open != mOpenLoops.end())
+			mOpenLoops.erase(open);
+
+		error = loop->Error;
+		loop->Error = nullptr;
+		ReleaseLoop(*loop);
+	}
+
+	if(error)
+		std::rethrow_exception(error);
+}
+
+void ThreadPool::RunLoop(Loop& loop)
+{
+	std::size_t done = 0;
+	for(std::size_t i = loop.Next++; i < loop.Count; i = loop.Next++)
+	{
+		try
+		{
+			loop.Body(loop.Context, i);
+		}
+		catch(...)
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			if(!loop.Error)
+				loop.Error = std::current_exception();
+		}
+		++done;
+	}
+
+	if(done > 0 && (loop.Done += done) == loop.Count)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mLoopDone.notify_all();
+	}
+}
+
+void ThreadPool::ReleaseLoop(Loop& loop)
+{
+	if(--loop.Users == 0)
+		mFreeLoops.push_back(&loop);
+}
+
+void ThreadPool::WorkerMain()
+{
+	for(;;)
+	{
+		std::function<void()> task;
+		Loop* loop = nullptr;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mTaskReady.wait(lock, [this] { return mStop || !mTasks.empty() || !mOpenLoops.empty(); });
+
+			// Loops first: their caller is already waiting on them.
+			if(!mOpenLoops.empty())
+			{
+				loop = mOpenLoops.back();
+				++loop->Users;
+				if(--loop->HelpersWanted == 0)
+					mOpenLoops.pop_back();
+			}
+			else
+			{
+				if(mStop && mTasks.empty())
+					return;
+
+				task = std::move(mTasks.front());
+				mTasks.pop();
+				++mActiveTasks;
+			}
+		}
+
+		if(loop != nullptr)
+		{
+			RunLoop(*loop);
+
+			std::lock_guard<std::mutex> lock(mMutex);
+			ReleaseLoop(*loop);
+			continue;
+		}
+
+		// Nothing can receive an exception from a queued task; dropping it
+		// keeps the worker (and the process) alive.  Tasks that need to
+		// report failure catch it themselves, as AssetManager does.
+		try
+		{
+			task();
+		}
+		catch(...)
+		{
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			--mActiveTasks;
+			if(mTasks.empty() && mActiveTasks == 0)
+				mAllDone.notify_all();
+		}
+	}
+}
@@ -0,0 +1,97 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+///<summary>
+/// Fixed set of worker threads that run queued tasks.  The pool is shared
+/// by everything that needs to fan work out (model parsing, animation
+/// evaluation, ...), so it only knows about plain std::function tasks.
+///
+/// ParallelFor is safe to call from inside a task: the calling thread also
+/// picks up iterations, so it never waits on helpers that have not started.
+/// Loops are not queued as tasks.  Idle workers join an open loop
+/// directly, and the loop records are made up front and recycled, so
+/// ParallelFor does not allocate unless loops nest more than one level
+/// deep (per frame work such as skinning relies on this).
+///</summary>
+class ThreadPool
+{
+public:
+	// threadCount == 0 uses one thread per hardware thread.
+	explicit ThreadPool(std::size_t threadCount = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool& rhs) = delete;
+	ThreadPool& operator=(const ThreadPool& rhs) = delete;
+
+	std::size_t GetThreadCount()const;
+
+	// An exception escaping task is dropped.
+	void Enqueue(std::function<void()> task);
+
+	// Blocks until every queued task has finished.
+	void Wait();
+
+	// Calls func(i) for every i in [0, count) and returns once all calls are done.
+	// If func throws, the other iterations still run and the first exception
+	// is rethrown here after the last call has returned.
+	// func is called concurrently and is not copied.
+	template<class Func>
+	void ParallelFor(std::size_t count, const Func& func)
+	{
+		ParallelFor(count, [](const void* context, std::size_t i) { (*static_cast<const Func*>(context))(i); }, &func);
+	}
+
+private:
+	typedef void (*LoopBody)(const void* context, std::size_t i);
+
+	struct Loop
+	{
+		LoopBody Body = nullptr;
+		const void* Context = nullptr;
+		std::size_t Count = 0;
+		std::atomic<std::size_t> Next{ 0 };
+		std::atomic<std::size_t> Done{ 0 };
+
+		// Guarded by mMutex
+		std::size_t HelpersWanted = 0;		// open (in mOpenLoops) while above 0
+		std::size_t Users = 0;				// threads holding the loop; recycled at 0
+		std::exception_ptr Error;			// first exception thrown by Body
+	};
+
+	void ParallelFor(std::size_t count, LoopBody body, const void* context);
+	void RunLoop(Loop& loop);
+	// Drops one user (mMutex held); the last one returns the loop to mFreeLoops.
+	void ReleaseLoop(Loop& loop);
+
+	void WorkerMain();
+
+private:
+	std::vector<std::thread> mThreads;
+	std::queue<std::function<void()>> mTasks;
+
+	std::mutex mMutex;
+	std::condition_variable mTaskReady;
+	std::condition_variable mAllDone;
+
+	std::size_t mActiveTasks = 0;
+	bool mStop = false;
+
+	// ParallelFor state, guarded by mMutex
+	std::vector<std::unique_ptr<Loop>> mLoops;	// every loop record ever made
+	std::vector<Loop*> mFreeLoops;
+	std::vector<Loop*> mOpenLoops;				// loops that still want helpers
+	std::condition_variable mLoopDone;
+};
+
+#endif // THREADPOOL_H
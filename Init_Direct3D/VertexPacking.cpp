@@ -0,0 +1,201 @@
+#include "VertexPacking.h"
+#include "../Common/MathHelper.h"
+#include <cmath>
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+namespace
+{
+	template<typename T>
+	const T& At(const void* base, std::size_t stride, std::size_t i)
+	{
+		return *reinterpret_cast<const T*>(static_cast<const unsigned char*>(base) + i * stride);
+	}
+
+	template<typename T>
+	T& At(void* base, std::size_t stride, std::size_t i)
+	{
+		return *reinterpret_cast<T*>(static_cast<unsigned char*>(base) + i * stride);
+	}
+
+	// Projects a unit vector onto the octahedron |x|+|y|+|z| = 1 and unfolds
+	// the lower half over the diagonals, giving a point in [-1,1]^2.
+	XMVECTOR XM_CALLCONV OctahedralEncode(FXMVECTOR n)
+	{
+		XMVECTOR p = XMVectorDivide(n, XMVector3Dot(XMVectorAbs(n), XMVectorSplatOne()));
+
+		if(XMVectorGetZ(p) < 0.0f)
+		{
+			XMVECTOR sign = XMVectorSelect(XMVectorReplicate(-1.0f), XMVectorSplatOne(),
+				XMVectorGreaterOrEqual(p, XMVectorZero()));
+			XMVECTOR folded = XMVectorSubtract(XMVectorSplatOne(), XMVectorAbs(XMVectorSwizzle<1, 0, 2, 3>(p)));
+			p = XMVectorMultiply(folded, sign);
+		}
+
+		return p;
+	}
+
+	XMVECTOR XM_CALLCONV OctahedralDecode(FXMVECTOR e)
+	{
+		const float x = XMVectorGetX(e);
+		const float y = XMVectorGetY(e);
+		const float z = 1.0f - fabsf(x) - fabsf(y);
+		const float t = z < 0.0f ? -z : 0.0f;
+
+		return XMVector3Normalize(XMVectorSet(x >= 0.0f ? x - t : x + t, y >= 0.0f ? y - t : y + t, z, 0.0f));
+	}
+}
+
+XMFLOAT4 VertexPacking::PackPositions(const void* src, std::size_t srcStride, std::size_t count,
+	void* dst, std::size_t dstStride)
+{
+	if(count == 0)
+		return XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+
+	XMVECTOR vMin = XMLoadFloat3(&At<XMFLOAT3>(src, srcStride, 0));
+	XMVECTOR vMax = vMin;
+	for(std::size_t i = 1; i < count; ++i)
+	{
+		XMVECTOR p = XMLoadFloat3(&At<XMFLOAT3>(src, srcStride, i));
+		vMin = XMVectorMin(vMin, p);
+		vMax = XMVectorMax(vMax, p);
+	}
+
+	// One scale for all axes, so normals transformed with the same world
+	// matrix keep their direction.
+	XMVECTOR center = XMVectorScale(XMVectorAdd(vMin, vMax), 0.5f);
+	XMFLOAT3 extents;
+	XMStoreFloat3(&extents, XMVectorScale(XMVectorSubtract(vMax, vMin), 0.5f));
+
+	float scale = extents.x;
+	if(extents.y > scale) scale = extents.y;
+	if(extents.z > scale) scale = extents.z;
+	if(scale <= 0.0f)
+		scale = 1.0f;
+
+	XMVECTOR invScale = XMVectorReplicate(1.0f / scale);
+	for(std::size_t i = 0; i < count; ++i)
+	{
+		XMVECTOR p = XMLoadFloat3(&At<XMFLOAT3>(src, srcStride, i));
+		p = XMVectorMultiply(XMVectorSubtract(p, center), invScale);
+		XMStoreShortN4(&At<XMSHORTN4>(dst, dstStride, i), XMVectorSetW(p, 0.0f));
+	}
+
+	XMFLOAT4 dequant;
+	XMStoreFloat4(&dequant, XMVectorSetW(center, scale));
+	return dequant;
+}
+
+void VertexPacking::PackUnitVectors(const void* src, std::size_t srcStride, std::size_t count,
+	void* dst, std::size_t dstStride)
+{
+	const float ShortMax = 32767.0f;
+
+	for(std::size_t i = 0; i < count; ++i)
+	{
+		XMVECTOR n = XMLoadFloat3(&At<XMFLOAT3>(src, srcStride, i));
+		XMSHORTN2& out = At<XMSHORTN2>(dst, dstStride, i);
+
+		if(XMVectorGetX(XMVector3LengthSq(n)) < 1e-12f)
+		{
+			out.x = 0;
+			out.y = 0;
+			continue;
+		}
+
+		n = XMVector3Normalize(n);
+		XMFLOAT2 e;
+		XMStoreFloat2(&e, OctahedralEncode(n));
+
+		// Rounding each axis on its own is not always the closest direction,
+		// so try the four surrounding grid points and keep the best one.
+		const float fx = floorf(e.x * ShortMax);
+		const float fy = floorf(e.y * ShortMax);
+
+		float bestDot = -2.0f;
+		for(int c = 0; c < 4; ++c)
+		{
+			XMSHORTN2 candidate;
+			candidate.x = (short)MathHelper::Clamp(fx + (c & 1), -ShortMax, ShortMax);
+			candidate.y = (short)MathHelper::Clamp(fy + (c >> 1), -ShortMax, ShortMax);
+
+			const float d = XMVectorGetX(XMVector3Dot(n, OctahedralDecode(XMLoadShortN2(&candidate))));
+			if(d > bestDot)
+			{
+				bestDot = d;
+				out = candidate;
+			}
+		}
+	}
+}
+
+void VertexPacking::PackTexCoords(const void* src, std::size_t srcStride, std::size_t count,
+	void* dst, std::size_t dstStride)
+{
+	for(std::size_t i = 0; i < count; ++i)
+		XMStoreHalf2(&At<XMHALF2>(dst, dstStride, i), XMLoadFloat2(&At<XMFLOAT2>(src, srcStride, i)));
+}
+
+void VertexPacking::PackBoneWeights(const void* src, std::size_t srcStride, std::size_t count,
+	void* dst, std::size_t dstStride)
+{
+	for(std::size_t i = 0; i < count; ++i)
+	{
+		const XMFLOAT3& w = At<XMFLOAT3>(src, srcStride, i);
+
+		int q[3] =
+		{
+			(int)(MathHelper::Clamp(w.x, 0.0f, 1.0f) * 255.0f + 0.5f),
+			(int)(MathHelper::Clamp(w.y, 0.0f, 1.0f) * 255.0f + 0.5f),
+			(int)(MathHelper::Clamp(w.z, 0.0f, 1.0f) * 255.0f + 0.5f)
+		};
+
+		// Rounding up can push the sum past 1, take the excess from the largest.
+		int excess = q[0] + q[1] + q[2] - 255;
+		if(excess > 0)
+		{
+			int largest = 0;
+			if(q[1] > q[largest]) largest = 1;
+			if(q[2] > q[largest]) largest = 2;
+			q[largest] -= excess;
+		}
+
+		XMUBYTEN4& out = At<XMUBYTEN4>(dst, dstStride, i);
+		out.x = (unsigned char)q[0];
+		out.y = (unsigned char)q[1];
+		out.z = (unsigned char)q[2];
+		out.w = (unsigned char)(255 - q[0] - q[1] - q[2]);
+	}
+}
+
+XMFLOAT3 VertexPacking::UnpackPosition(const XMSHORTN4& packed, const XMFLOAT4& dequant)
+{
+	XMVECTOR p = XMVectorMultiplyAdd(XMLoadShortN4(&packed), XMVectorReplicate(dequant.w),
+		XMVectorSet(dequant.x, dequant.y, dequant.z, 0.0f));
+
+	XMFLOAT3 result;
+	XMStoreFloat3(&result, p);
+	return result;
+}
+
+XMFLOAT3 VertexPacking::UnpackUnitVector(const XMSHORTN2& packed)
+{
+	XMFLOAT3 result;
+	XMStoreFloat3(&result, OctahedralDecode(XMLoadShortN2(&packed)));
+	return result;
+}
+
+XMFLOAT2 VertexPacking::UnpackTexCoord(const XMHALF2& packed)
+{
+	XMFLOAT2 result;
+	XMStoreFloat2(&result, XMLoadHalf2(&packed));
+	return result;
+}
+
+XMFLOAT3 VertexPacking::UnpackBoneWeights(const XMUBYTEN4& packed)
+{
+	XMFLOAT3 result;
+	XMStoreFloat3(&result, XMLoadUByteN4(&packed));
+	return result;
+}
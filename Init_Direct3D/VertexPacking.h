@@ -0,0 +1,46 @@
+#ifndef VERTEXPACKING_H
+#define VERTEXPACKING_H
+
+#include <cstddef>
+#include <DirectXMath.h>
+#include <DirectXPackedVector.h>
+
+///<summary>
+/// Conversion kernels for the compact vertex formats.
+///
+/// Every kernel reads count elements from src and writes them to dst, stepping
+/// srcStride / dstStride bytes per vertex.  Both pointers point at the
+/// attribute of the first vertex, so one call converts one attribute of a
+/// whole vertex array.  The conversions use the DirectXMath packed stores,
+/// which are SIMD on every platform DirectXMath supports.
+///
+/// The Unpack functions do the same math as the PACKED path in Params.hlsl.
+///</summary>
+class VertexPacking
+{
+public:
+	// float3 -> snorm16x4 relative to the bounds of all positions.  Returns the
+	// dequantization for the shader: position = packed.xyz * w + xyz.
+	static DirectX::XMFLOAT4 PackPositions(const void* src, std::size_t srcStride, std::size_t count,
+		void* dst, std::size_t dstStride);
+
+	// Unit float3 -> octahedral snorm16x2.  Zero vectors are stored as +Z.
+	static void PackUnitVectors(const void* src, std::size_t srcStride, std::size_t count,
+		void* dst, std::size_t dstStride);
+
+	// float2 -> half2.
+	static void PackTexCoords(const void* src, std::size_t srcStride, std::size_t count,
+		void* dst, std::size_t dstStride);
+
+	// float3 bone weights -> unorm8x4.  The three stored weights never add up
+	// to more than 1, w holds the remainder (the implicit fourth weight).
+	static void PackBoneWeights(const void* src, std::size_t srcStride, std::size_t count,
+		void* dst, std::size_t dstStride);
+
+	static DirectX::XMFLOAT3 UnpackPosition(const DirectX::PackedVector::XMSHORTN4& packed, const DirectX::XMFLOAT4& dequant);
+	static DirectX::XMFLOAT3 UnpackUnitVector(const DirectX::PackedVector::XMSHORTN2& packed);
+	static DirectX::XMFLOAT2 UnpackTexCoord(const DirectX::PackedVector::XMHALF2& packed);
+	static DirectX::XMFLOAT3 UnpackBoneWeights(const DirectX::PackedVector::XMUBYTEN4& packed);
+};
+
+#endif // VERTEXPACKING_H
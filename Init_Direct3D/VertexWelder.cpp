@@ -0,0 +1,226 @@
+#include "VertexWelder.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <unordered_map>
+
+namespace
+{
+	const std::size_t ChunkSize = 4096;
+
+	struct Cell
+	{
+		std::int64_t X, Y, Z;
+	};
+
+	// Cells are two epsilons wide, so a vertex within epsilon of p is either
+	// in p's cell or in the neighbour on the side of the half p is in.
+	struct CellSide
+	{
+		std::int8_t X, Y, Z;
+	};
+
+	// Runs func(first, last) over [0, count) in ChunkSize pieces, on the pool if there is one.
+	void ForEachChunk(ThreadPool* pool, std::size_t count, const std::function<void(std::size_t, std::size_t)>& func)
+	{
+		const std::size_t chunkCount = (count + ChunkSize - 1) / ChunkSize;
+		auto runChunk = [&](std::size_t chunk)
+		{
+			const std::size_t first = chunk * ChunkSize;
+			const std::size_t last = first + ChunkSize < count ? first + ChunkSize : count;
+			func(first, last);
+		};
+
+		if(pool != nullptr)
+			pool->ParallelFor(chunkCount, runChunk);
+		else
+		{
+			for(std::size_t chunk = 0; chunk < chunkCount; ++chunk)
+				runChunk(chunk);
+		}
+	}
+
+	std::int64_t CellCoord(float value, float epsilon, std::int8_t& side)
+	{
+		side = 0;
+		if(epsilon > 0.0f)
+		{
+			const double scaled = (double)value / (2.0 * epsilon);
+			const double cell = std::floor(scaled);
+			side = scaled - cell < 0.5 ? -1 : 1;
+			return (std::int64_t)cell;
+		}
+
+		// Exact mode: the cell is the bit pattern itself (with -0 == +0).
+		if(value == 0.0f)
+			value = 0.0f;
+		std::uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+
+	std::uint64_t HashCell(const Cell& cell)
+	{
+		std::uint64_t h = (std::uint64_t)cell.X * 0x9E3779B97F4A7C15ull;
+		h ^= (std::uint64_t)cell.Y * 0xC2B2AE3D27D4EB4Full + (h << 6) + (h >> 2);
+		h ^= (std::uint64_t)cell.Z * 0x165667B19E3779F9ull + (h << 6) + (h >> 2);
+		return h;
+	}
+
+	bool Matches(const std::uint8_t* a, const std::uint8_t* b, const std::vector<VertexWelder::Attribute>& attributes)
+	{
+		for(const auto& attribute : attributes)
+		{
+			if(attribute.Type == VertexWelder::AttributeType::Bytes)
+			{
+				if(memcmp(a + attribute.Offset, b + attribute.Offset, attribute.Count) != 0)
+					return false;
+				continue;
+			}
+
+			for(std::size_t c = 0; c < attribute.Count; ++c)
+			{
+				float fa, fb;
+				memcpy(&fa, a + attribute.Offset + c * sizeof(float), sizeof(float));
+				memcpy(&fb, b + attribute.Offset + c * sizeof(float), sizeof(float));
+				if(!(std::fabs(fa - fb) <= attribute.Epsilon))
+					return false;
+			}
+		}
+
+		return true;
+	}
+}
+
+std::size_t VertexWelder::Weld(void* vertices, std::size_t vertexCount, std::size_t vertexStride,
+	const std::vector<Attribute>& attributes,
+	std::uint32_t* indices, std::size_t indexCount,
+	ThreadPool* pool)
+{
+	if(vertexCount < 2 || attributes.empty())
+		return vertexCount;
+
+	std::uint8_t* data = static_cast<std::uint8_t*>(vertices);
+	const Attribute& position = attributes[0];
+	const bool exact = position.Epsilon <= 0.0f;
+
+	// 1. Spatial hash of the position, see CellSide.
+	std::vector<Cell> cells(vertexCount);
+	std::vector<CellSide> sides(vertexCount);
+	std::vector<std::pair<std::uint64_t, std::uint32_t>> sorted(vertexCount);
+
+	ForEachChunk(pool, vertexCount, [&](std::size_t first, std::size_t last)
+	{
+		for(std::size_t i = first; i < last; ++i)
+		{
+			float p[3];
+			memcpy(p, data + i * vertexStride + position.Offset, sizeof(p));
+
+			cells[i].X = CellCoord(p[0], position.Epsilon, sides[i].X);
+			cells[i].Y = CellCoord(p[1], position.Epsilon, sides[i].Y);
+			cells[i].Z = CellCoord(p[2], position.Epsilon, sides[i].Z);
+			sorted[i] = { HashCell(cells[i]), (std::uint32_t)i };
+		}
+	});
+
+	// Vertices of a cell are contiguous (and ascending) in sorted.
+	std::sort(sorted.begin(), sorted.end());
+
+	std::unordered_map<std::uint64_t, std::uint32_t> cellStart;
+	cellStart.reserve(vertexCount);
+	for(std::size_t i = 0; i < vertexCount; ++i)
+	{
+		if(i == 0 || sorted[i].first != sorted[i - 1].first)
+			cellStart[sorted[i].first] = (std::uint32_t)i;
+	}
+
+	// 2. For every vertex, the earlier vertices that match it (ascending).
+	//    Each chunk keeps its own lists so the chunks don't share anything.
+	const std::size_t chunkCount = (vertexCount + ChunkSize - 1) / ChunkSize;
+	std::vector<std::vector<std::uint32_t>> chunkCandidates(chunkCount);
+	std::vector<std::uint32_t> candidateCount(vertexCount, 0);
+
+	ForEachChunk(pool, vertexCount, [&](std::size_t first, std::size_t last)
+	{
+		std::vector<std::uint32_t>& candidates = chunkCandidates[first / ChunkSize];
+		const int neighbourCount = exact ? 1 : 8;
+
+		for(std::size_t i = first; i < last; ++i)
+		{
+			const std::size_t begin = candidates.size();
+			const std::uint8_t* vertex = data + i * vertexStride;
+
+			for(int n = 0; n < neighbourCount; ++n)
+			{
+				const Cell cell =
+				{
+					cells[i].X + ((n & 1) ? sides[i].X : 0),
+					cells[i].Y + ((n & 2) ? sides[i].Y : 0),
+					cells[i].Z + ((n & 4) ? sides[i].Z : 0)
+				};
+				const std::uint64_t key = HashCell(cell);
+
+				auto found = cellStart.find(key);
+				if(found == cellStart.end())
+					continue;
+
+				for(std::size_t s = found->second; s < vertexCount && sorted[s].first == key && sorted[s].second < i; ++s)
+				{
+					if(Matches(vertex, data + sorted[s].second * vertexStride, attributes))
+						candidates.push_back(sorted[s].second);
+				}
+			}
+
+			std::sort(candidates.begin() + begin, candidates.end());
+			candidateCount[i] = (std::uint32_t)(candidates.size() - begin);
+		}
+	});
+
+	// 3. In vertex order, weld into the first candidate that was kept.
+	//    Chaining is not allowed, so a welded vertex is always within
+	//    epsilon of the vertex it is replaced by.
+	std::vector<std::uint32_t> remap(vertexCount);
+	std::vector<bool> kept(vertexCount, false);
+	std::size_t next = 0;
+
+	for(std::size_t chunk = 0; chunk < chunkCount; ++chunk)
+	{
+		const std::vector<std::uint32_t>& candidates = chunkCandidates[chunk];
+		std::size_t cursor = 0;
+
+		const std::size_t first = chunk * ChunkSize;
+		const std::size_t last = first + ChunkSize < vertexCount ? first + ChunkSize : vertexCount;
+		for(std::size_t i = first; i < last; ++i)
+		{
+			const std::size_t count = candidateCount[i];
+
+			bool welded = false;
+			for(std::size_t c = cursor; c < cursor + count; ++c)
+			{
+				if(kept[candidates[c]])
+				{
+					remap[i] = remap[candidates[c]];
+					welded = true;
+					break;
+				}
+			}
+			cursor += count;
+
+			if(welded)
+				continue;
+
+			kept[i] = true;
+			remap[i] = (std::uint32_t)next;
+			if(next != i)
+				memcpy(data + next * vertexStride, data + i * vertexStride, vertexStride);
+			++next;
+		}
+	}
+
+	for(std::size_t i = 0; i < indexCount; ++i)
+		indices[i] = remap[indices[i]];
+
+	return next;
+}
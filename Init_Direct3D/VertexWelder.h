@@ -0,0 +1,47 @@
+#ifndef VERTEXWELDER_H
+#define VERTEXWELDER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+///<summary>
+/// Collapses exact and near-duplicate vertices of an indexed triangle list.
+///
+/// Two vertices are welded when every attribute matches within its own
+/// epsilon (per component, Float attributes) or exactly (Bytes attributes).
+/// Bytes of the vertex not covered by an attribute are ignored.  Candidates
+/// are found through a spatial hash of the first attribute, which must be the
+/// position.  Each vertex is welded into the earliest kept vertex that
+/// matches it, so the kept vertices stay in their original order and the
+/// result does not depend on the number of threads.
+///</summary>
+class VertexWelder
+{
+public:
+	enum class AttributeType
+	{
+		Float,	// Count floats, compared with Epsilon
+		Bytes	// Count bytes, compared exactly
+	};
+
+	struct Attribute
+	{
+		std::size_t Offset = 0;
+		std::size_t Count = 0;
+		AttributeType Type = AttributeType::Float;
+		float Epsilon = 0.0f;
+	};
+
+	// Welds vertices (vertexStride bytes each) in place and remaps indices.
+	// The kept vertices are moved to the front, the new vertex count is
+	// returned.  With a pool the search runs in parallel.
+	static std::size_t Weld(void* vertices, std::size_t vertexCount, std::size_t vertexStride,
+		const std::vector<Attribute>& attributes,
+		std::uint32_t* indices, std::size_t indexCount,
+		ThreadPool* pool = nullptr);
+};
+
+#endif // VERTEXWELDER_H
@@ -0,0 +1,141 @@
+#include "Test.h"
+#include "TestData.h"
+#include "../Init_Direct3D/ThreadPool.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Every allocation of the process goes through here; the tests compare the
+// count before and after the code under test.
+namespace
+{
+	std::atomic<std::size_t> gAllocations{ 0 };
+}
+
+void* operator new(std::size_t size)
+{
+	++gAllocations;
+	if(void* p = std::malloc(size != 0 ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* p)noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p)noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t)noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p, std::size_t)noexcept
+{
+	std::free(p);
+}
+
+using namespace DirectX;
+
+namespace
+{
+	// Allocations made by frames calls of frame(i) after one warm-up call.
+	template<class Frame>
+	std::size_t CountAllocations(int frames, Frame frame)
+	{
+		frame(0);
+
+		const std::size_t before = gAllocations;
+		for(int i = 1; i <= frames; ++i)
+			frame(i);
+		return gAllocations - before;
+	}
+}
+
+TEST(GetFinalTransformsDoesNotAllocate)
+{
+	SkinnedData skinnedData;
+	TestData::MakeSkinnedData(skinnedData, 58, 40, 1.25f);
+	const SkinnedData::ClipHandle clip = skinnedData.FindClip("Test");
+	REQUIRE(clip != SkinnedData::InvalidClip);
+
+	// Caller-owned buffers, as the app passes the mapped constant buffer.
+	std::vector<XMFLOAT4X4> palette(skinnedData.BoneCount());
+	std::vector<UINT> keyCursors;
+	SkinnedData::EvalScratch scratch;
+
+	for(bool compiled : { false, true })
+	{
+		skinnedData.UseCompiledClips(compiled);
+		keyCursors.clear();
+
+		// 600 frames at 60 Hz: several loops, so the cursors also wrap.
+		const float endTime = skinnedData.GetClipEndTime(clip);
+		const std::size_t allocations = CountAllocations(600, [&](int frame)
+		{
+			const float t = fmodf(frame / 60.0f, endTime);
+			skinnedData.GetFinalTransforms(clip, t, palette.data(), keyCursors, scratch);
+		});
+		CHECK(allocations == 0);
+
+		const std::size_t byNameAllocations = CountAllocations(600, [&](int frame)
+		{
+			const float t = fmodf(frame / 60.0f, endTime);
+			skinnedData.GetFinalTransforms("Test", t, palette.data(), keyCursors, scratch);
+		});
+		CHECK(byNameAllocations == 0);
+	}
+}
+
+TEST(ParallelForDoesNotAllocate)
+{
+	ThreadPool pool(4);
+
+	// The skinned pass shape: one call per frame over the instance list,
+	// writing through captured references.  Helpers that are still on
+	// their way out of the last frame's loop must not cost a new one.
+	std::vector<float> results(64);
+	const std::size_t allocations = CountAllocations(600, [&](int frame)
+	{
+		pool.ParallelFor(results.size(), [&](std::size_t i)
+		{
+			results[i] = (float)(frame + i);
+		});
+	});
+	CHECK(allocations == 0);
+	CHECK(results[63] == 600.0f + 63.0f);
+
+	// Loops started from inside another one, one level deep.
+	std::atomic<std::size_t> innerCalls{ 0 };
+	const std::size_t nestedAllocations = CountAllocations(200, [&](int)
+	{
+		pool.ParallelFor(4, [&](std::size_t)
+		{
+			pool.ParallelFor(8, [&](std::size_t) { ++innerCalls; });
+		});
+	});
+	CHECK(nestedAllocations == 0);
+	CHECK(innerCalls == 201 * 4 * 8);
+}
+
+TEST(AllocationCounterSeesAllocations)
+{
+	// Guards the tests above against a counter that never moves.
+	std::vector<int> values;
+	const std::size_t allocations = CountAllocations(10, [&](int frame)
+	{
+		values.assign(16 * (frame + 1), frame);
+	});
+	CHECK(allocations > 0);
+}
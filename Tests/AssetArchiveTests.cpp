@@ -0,0 +1,97 @@
+#include "Test.h"
+#include "../Init_Direct3D/AssetArchive.h"
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+	// A one-mesh archive in the temp directory, written by the baker's Writer.
+	struct MeshArchive
+	{
+		MeshArchive()
+		{
+			Path = (std::filesystem::temp_directory_path() / "AssetArchiveTests.pak").string();
+
+			AssetArchive::MeshVertex vertices[4] = {};
+			for(int v = 0; v < 4; ++v)
+				vertices[v].Position[0] = (float)v;
+			const std::uint32_t indices[6] = { 0, 1, 2, 2, 1, 3 };
+
+			AssetArchive::Writer writer;
+			writer.AddMesh("Models/quad.txt", vertices, 4, indices, 6);
+			Written = writer.Write(Path);
+		}
+
+		~MeshArchive()
+		{
+			std::error_code ec;
+			std::filesystem::remove(Path, ec);
+		}
+
+		// Overwrites the file at offset with value, as a corrupt or foreign file would have it.
+		void Patch(std::uint64_t offset, std::uint32_t value)
+		{
+			std::fstream file(Path, std::ios::binary | std::ios::in | std::ios::out);
+			file.seekp((std::streamoff)offset);
+			file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+		}
+
+		std::string Path;
+		bool Written = false;
+	};
+
+	const std::uint64_t EntryOffset = sizeof(AssetArchive::Header);
+}
+
+TEST(AssetArchiveOpensMesh)
+{
+	MeshArchive pak;
+	REQUIRE(pak.Written);
+
+	AssetArchive archive;
+	REQUIRE(archive.Open(pak.Path));
+
+	const AssetArchive::Entry* entry = archive.Find("..\\Models\\quad.txt", AssetArchive::AssetType::Mesh);
+	REQUIRE(entry != nullptr);
+	CHECK(entry->VertexCount == 4 && entry->IndexCount == 6);
+	CHECK(archive.MeshVertices(*entry)[3].Position[0] == 3.0f);
+	CHECK(archive.MeshIndices(*entry)[5] == 3);
+}
+
+TEST(AssetArchiveRejectsBadMesh)
+{
+	AssetArchive archive;
+
+	// An index past the last vertex.
+	{
+		MeshArchive pak;
+		REQUIRE(pak.Written);
+		REQUIRE(archive.Open(pak.Path));
+		const std::uint64_t lastIndex = archive.GetEntry(0).Offset + archive.GetEntry(0).IndexOffset + 5 * sizeof(std::uint32_t);
+		archive.Close();
+
+		pak.Patch(lastIndex, 4);
+		CHECK(!archive.Open(pak.Path));
+		archive.Close();
+	}
+
+	// A vertex count whose vertices would run into the indices.
+	{
+		MeshArchive pak;
+		REQUIRE(pak.Written);
+		pak.Patch(EntryOffset + offsetof(AssetArchive::Entry, VertexCount), 1000);
+		CHECK(!archive.Open(pak.Path));
+		archive.Close();
+	}
+
+	// Indices past the end of the blob.
+	{
+		MeshArchive pak;
+		REQUIRE(pak.Written);
+		pak.Patch(EntryOffset + offsetof(AssetArchive::Entry, IndexCount), 1000);
+		CHECK(!archive.Open(pak.Path));
+		archive.Close();
+	}
+}
@@ -0,0 +1,154 @@
+#include "Test.h"
+#include "TestData.h"
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	const UINT BoneCount = 13;
+
+	std::vector<XMFLOAT4X4> FinalTransforms(const SkinnedData& skinnedData, SkinnedData::ClipHandle clip, float t)
+	{
+		std::vector<XMFLOAT4X4> palette(skinnedData.BoneCount());
+		std::vector<UINT> cursors;
+		SkinnedData::EvalScratch scratch;
+		skinnedData.GetFinalTransforms(clip, t, palette.data(), cursors, scratch);
+		return palette;
+	}
+
+	std::vector<XMFLOAT4X4> BakedTransforms(const BakedClip& baked, float t)
+	{
+		std::vector<XMFLOAT4X4> palette(baked.BoneCount());
+		baked.Sample(t, palette.data());
+		return palette;
+	}
+
+	bool SameBytes(const std::vector<XMFLOAT4X4>& a, const std::vector<XMFLOAT4X4>& b)
+	{
+		return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(XMFLOAT4X4)) == 0;
+	}
+
+	// Largest distance between where the two palettes put a bone; the
+	// palette takes bone i's bind position (0, i, 0) to the posed bone.
+	float MaxBonePositionError(const std::vector<XMFLOAT4X4>& a, const std::vector<XMFLOAT4X4>& b)
+	{
+		float maxError = 0.0f;
+		for(UINT i = 0; i < a.size(); ++i)
+		{
+			const XMVECTOR bind = XMVectorSet(0.0f, (float)i, 0.0f, 1.0f);
+			const XMVECTOR pa = XMVector3Transform(bind, XMMatrixTranspose(XMLoadFloat4x4(&a[i])));
+			const XMVECTOR pb = XMVector3Transform(bind, XMMatrixTranspose(XMLoadFloat4x4(&b[i])));
+			maxError = fmaxf(maxError, XMVectorGetX(XMVector3Length(XMVectorSubtract(pa, pb))));
+		}
+		return maxError;
+	}
+}
+
+TEST(BakedClipMatchesFinalTransformsOnFrames)
+{
+	SkinnedData skinnedData;
+	TestData::MakeSkinnedData(skinnedData, BoneCount, 60, 2.0f);
+	const SkinnedData::ClipHandle clip = skinnedData.FindClip("Test");
+	REQUIRE(clip != SkinnedData::InvalidClip);
+	REQUIRE(skinnedData.GetClipStartTime(clip) == 0.0f && skinnedData.GetClipEndTime(clip) == 2.0f);
+
+	// 32 frames a second over 2 s: every frame time is exact in float, so
+	// sampling on a frame is the baked palette itself, bit for bit.
+	skinnedData.BakeClips(32.0f);
+	const BakedClip* baked = skinnedData.FindBakedClip(clip);
+	REQUIRE(baked != nullptr);
+	REQUIRE(baked->FrameCount() == 65);
+	REQUIRE(baked->BoneCount() == BoneCount);
+
+	std::size_t mismatches = 0;
+	for(std::size_t frame = 0; frame < baked->FrameCount(); ++frame)
+	{
+		const float t = baked->GetFrameTime(frame);
+		if(!SameBytes(BakedTransforms(*baked, t), FinalTransforms(skinnedData, clip, t)))
+			++mismatches;
+	}
+	CHECK(mismatches == 0);
+
+	// Outside the clip the ends hold.
+	CHECK(SameBytes(BakedTransforms(*baked, -1.0f), FinalTransforms(skinnedData, clip, 0.0f)));
+	CHECK(SameBytes(BakedTransforms(*baked, 3.0f), FinalTransforms(skinnedData, clip, 2.0f)));
+
+	// At a rate whose frame times round, a frame is off by a rounding step at most.
+	skinnedData.BakeClips(30.0f);
+	baked = skinnedData.FindBakedClip(clip);
+	REQUIRE(baked != nullptr);
+	float maxError = 0.0f;
+	for(std::size_t frame = 0; frame < baked->FrameCount(); ++frame)
+	{
+		const float t = baked->GetFrameTime(frame);
+		maxError = fmaxf(maxError, MaxBonePositionError(BakedTransforms(*baked, t), FinalTransforms(skinnedData, clip, t)));
+	}
+	CHECK_LE(maxError, 1e-5f);
+}
+
+TEST(BakedClipStaysWithinReportedError)
+{
+	SkinnedData skinnedData;
+	TestData::MakeSkinnedData(skinnedData, BoneCount, 60, 2.0f);
+	const SkinnedData::ClipHandle clip = skinnedData.FindClip("Test");
+	REQUIRE(clip != SkinnedData::InvalidClip);
+
+	float previousError = 0.0f;
+	for(float rate : { 60.0f, 15.0f })
+	{
+		std::unordered_map<std::string, BakedClip::Report> reports;
+		skinnedData.BakeClips(rate, &reports);
+		REQUIRE(reports.count("Test") == 1);
+		const BakedClip::Report& report = reports["Test"];
+		const BakedClip* baked = skinnedData.FindBakedClip(clip);
+		REQUIRE(baked != nullptr);
+		CHECK(report.SampleRate >= rate);
+		CHECK(report.FrameCount == baked->FrameCount());
+
+		// Seven points between each pair of frames, not the report's four.
+		float maxError = 0.0f;
+		for(std::size_t frame = 0; frame + 1 < baked->FrameCount(); ++frame)
+		{
+			const float t0 = baked->GetFrameTime(frame);
+			const float t1 = baked->GetFrameTime(frame + 1);
+			for(int sample = 1; sample <= 7; ++sample)
+			{
+				const float t = t0 + (t1 - t0) * sample / 8;
+				maxError = fmaxf(maxError, MaxBonePositionError(BakedTransforms(*baked, t), FinalTransforms(skinnedData, clip, t)));
+			}
+		}
+		CHECK(report.MaxBonePositionError > 0.0f);
+		CHECK_LE(maxError, report.MaxBonePositionError * 1.1f + 1e-5f);
+
+		// Fewer frames, more error.
+		CHECK(report.MaxBonePositionError > previousError);
+		previousError = report.MaxBonePositionError;
+	}
+}
+
+TEST(BakedClipReportsByteSize)
+{
+	SkinnedData skinnedData;
+	TestData::MakeSkinnedData(skinnedData, BoneCount, 60, 2.0f);
+	const SkinnedData::ClipHandle clip = skinnedData.FindClip("Test");
+	REQUIRE(clip != SkinnedData::InvalidClip);
+
+	std::unordered_map<std::string, BakedClip::Report> reports;
+	skinnedData.BakeClips(30.0f, &reports);
+	const BakedClip::Report& report = reports["Test"];
+	const BakedClip* baked = skinnedData.FindBakedClip(clip);
+	REQUIRE(baked != nullptr);
+
+	// Three rows of a float4 per bone per frame; the fourth row is implied.
+	CHECK(report.FrameCount == 61);
+	CHECK(report.ByteSize == report.FrameCount * BoneCount * 3 * sizeof(XMFLOAT4A));
+	CHECK(baked->GetByteSize() == report.ByteSize);
+
+	// A rate of 0 drops the baked clips.
+	skinnedData.BakeClips(0.0f);
+	CHECK(skinnedData.FindBakedClip(clip) == nullptr);
+}
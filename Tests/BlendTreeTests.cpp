@@ -0,0 +1,230 @@
+#include "Test.h"
+#include "TestData.h"
+#include "../Init_Direct3D/BlendTree.h"
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	const UINT BoneCount = 7;
+
+	// The clip alone at time, through SkinnedData's compiled path.
+	std::vector<XMFLOAT4X4> ClipPalette(const SkinnedData& skinnedData, SkinnedData::ClipHandle clip, float time)
+	{
+		std::vector<XMFLOAT4X4> palette(skinnedData.BoneCount());
+		std::vector<UINT> cursors;
+		SkinnedData::EvalScratch scratch;
+		skinnedData.GetFinalTransforms(clip, time, palette.data(), cursors, scratch);
+		return palette;
+	}
+
+	std::vector<XMFLOAT4X4> TreePalette(BlendTree& tree, const SkinnedData& skinnedData)
+	{
+		std::vector<XMFLOAT4X4> palette(skinnedData.BoneCount());
+		SkinnedData::EvalScratch scratch;
+		tree.Evaluate(skinnedData, palette.data(), scratch);
+		return palette;
+	}
+
+	float MaxDifference(const XMFLOAT4X4& a, const XMFLOAT4X4& b)
+	{
+		float maxDifference = 0.0f;
+		for(int r = 0; r < 4; ++r)
+		{
+			for(int c = 0; c < 4; ++c)
+				maxDifference = fmaxf(maxDifference, fabsf(a(r, c) - b(r, c)));
+		}
+		return maxDifference;
+	}
+
+	// The palette is transposed: the translation is the last column.
+	XMFLOAT3 Translation(const XMFLOAT4X4& m)
+	{
+		return XMFLOAT3(m(0, 3), m(1, 3), m(2, 3));
+	}
+}
+
+TEST(BlendTreeReversePlaybackStaysInClip)
+{
+	SkinnedData skinnedData;
+	TestData::MakeSkinnedData(skinnedData, 7, 10, 2.0f);
+
+	const SkinnedData::ClipHandle clip = skinnedData.FindClip("Test");
+	REQUIRE(clip != SkinnedData::InvalidClip);
+	const float startTime = skinnedData.GetClipStartTime(clip);
+	const float endTime = skinnedData.GetClipEndTime(clip);
+	const float length = endTime - startTime;
+	REQUIRE(length > 0.0f);
+
+	BlendTree tree;
+	const BlendTree::SourceId looping = tree.AddSource(clip, startTime + 0.25f * length, -1.0f, true);
+	const BlendTree::SourceId once = tree.AddSource(clip, startTime + 0.25f * length, -1.0f, false);
+	tree.AddClip(looping);
+
+	// Half the clip backwards from a quarter in wraps to three quarters in.
+	tree.Advance(skinnedData, 0.5f * length);
+	CHECK(fabsf(tree.GetSourceTime(looping) - (startTime + 0.75f * length)) < 1e-4f);
+	CHECK(tree.GetSourceTime(once) == startTime);
+
+	// Many frames backwards never leave the clip.
+	for(int frame = 0; frame < 1000; ++frame)
+	{
+		tree.Advance(skinnedData, 1.0f / 60.0f);
+		const float t = tree.GetSourceTime(looping);
+		CHECK(t >= startTime && t <= endTime);
+	}
+	CHECK(tree.GetSourceTime(once) == startTime);
+}
+
+TEST(BlendTreeFadeWeightOverTime)
+{
+	SkinnedData skinnedData;
+	TestData::MakeSkinnedData(skinnedData, BoneCount, 10, 2.0f);
+	skinnedData.UseCompiledClips(true);
+	const SkinnedData::ClipHandle clip = skinnedData.FindClip("Test");
+	REQUIRE(clip != SkinnedData::InvalidClip);
+
+	BlendTree tree;
+	const BlendTree::SourceId from = tree.AddSource(clip, 0.1f);
+	const BlendTree::SourceId to = tree.AddSource(clip, 1.3f);
+	const BlendTree::NodeId blend = tree.AddBlend(tree.AddClip(from), tree.AddClip(to));
+
+	// Weight 0 is the first input alone.
+	const std::vector<XMFLOAT4X4> start = TreePalette(tree, skinnedData);
+	CHECK(std::memcmp(start.data(), ClipPalette(skinnedData, clip, 0.1f).data(), start.size() * sizeof(XMFLOAT4X4)) == 0);
+
+	// A half second fade in steps of a tenth, the root bone's translation
+	// following the lerp of the two sources as both keep playing.
+	tree.FadeWeight(blend, 1.0f, 0.5f);
+	for(int step = 1; step <= 5; ++step)
+	{
+		tree.Advance(skinnedData, 0.1f);
+		const float weight = tree.GetWeight(blend);
+		CHECK(fabsf(weight - 0.2f * step) < 1e-5f);
+
+		const XMFLOAT3 a = Translation(ClipPalette(skinnedData, clip, tree.GetSourceTime(from))[0]);
+		const XMFLOAT3 b = Translation(ClipPalette(skinnedData, clip, tree.GetSourceTime(to))[0]);
+		const XMFLOAT3 blended = Translation(TreePalette(tree, skinnedData)[0]);
+		CHECK(fabsf(blended.x - (a.x + (b.x - a.x) * weight)) < 1e-4f);
+		CHECK(fabsf(blended.y - (a.y + (b.y - a.y) * weight)) < 1e-4f);
+		CHECK(fabsf(blended.z - (a.z + (b.z - a.z) * weight)) < 1e-4f);
+	}
+
+	// The fade ends exactly on its target and stays there, the second input alone.
+	CHECK(tree.GetWeight(blend) == 1.0f);
+	tree.Advance(skinnedData, 0.1f);
+	CHECK(tree.GetWeight(blend) == 1.0f);
+	const std::vector<XMFLOAT4X4> end = TreePalette(tree, skinnedData);
+	const std::vector<XMFLOAT4X4> expected = ClipPalette(skinnedData, clip, tree.GetSourceTime(to));
+	CHECK(std::memcmp(end.data(), expected.data(), end.size() * sizeof(XMFLOAT4X4)) == 0);
+
+	// Back down at the rate the distance and duration give: 0.75 in 0.3 s.
+	tree.FadeWeight(blend, 0.25f, 0.3f);
+	tree.Advance(skinnedData, 0.1f);
+	CHECK(fabsf(tree.GetWeight(blend) - 0.75f) < 1e-5f);
+	tree.Advance(skinnedData, 0.15f);
+	CHECK(fabsf(tree.GetWeight(blend) - 0.375f) < 1e-5f);
+	tree.Advance(skinnedData, 0.1f);
+	CHECK(tree.GetWeight(blend) == 0.25f);
+
+	// SetWeight cancels a running fade.
+	tree.FadeWeight(blend, 1.0f, 1.0f);
+	tree.SetWeight(blend, 0.5f);
+	tree.Advance(skinnedData, 0.1f);
+	CHECK(tree.GetWeight(blend) == 0.5f);
+}
+
+TEST(BlendTreeLayerMasksBones)
+{
+	SkinnedData skinnedData;
+	TestData::MakeSkinnedData(skinnedData, BoneCount, 10, 2.0f);
+	skinnedData.UseCompiledClips(true);
+	const SkinnedData::ClipHandle clip = skinnedData.FindClip("Test");
+	REQUIRE(clip != SkinnedData::InvalidClip);
+
+	// Bone 1 and its children 3 and 4.
+	const std::vector<float> mask = BlendTree::MakeSubtreeMask(skinnedData, 1);
+	const std::vector<float> expectedMask = { 0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f };
+	CHECK(mask == expectedMask);
+
+	const float baseTime = 0.3f;
+	const float layerTime = 1.1f;
+	BlendTree tree;
+	const BlendTree::NodeId base = tree.AddClip(tree.AddSource(clip, baseTime));
+	const BlendTree::NodeId layer = tree.AddClip(tree.AddSource(clip, layerTime));
+	tree.AddLayer(base, layer, mask);
+
+	// The expected pose takes the masked bones' to-parent transforms from
+	// the layer clip and the rest from the base, then runs the hierarchy.
+	std::vector<UINT> cursors;
+	SkinnedData::EvalScratch scratch;
+	std::vector<XMFLOAT4X4> palette(BoneCount);
+	skinnedData.GetFinalTransforms(clip, baseTime, palette.data(), cursors, scratch);
+	std::vector<XMFLOAT4X4> toParent = scratch.ToParentTransforms;
+	cursors.clear();
+	skinnedData.GetFinalTransforms(clip, layerTime, palette.data(), cursors, scratch);
+	for(UINT i = 0; i < BoneCount; ++i)
+	{
+		if(mask[i] > 0.0f)
+			toParent[i] = scratch.ToParentTransforms[i];
+	}
+
+	std::vector<XMFLOAT4X4> expected(BoneCount);
+	skinnedData.GetFinalTransforms(toParent.data(), expected.data(), scratch);
+
+	const std::vector<XMFLOAT4X4> actual = TreePalette(tree, skinnedData);
+	const std::vector<XMFLOAT4X4> basePalette = ClipPalette(skinnedData, clip, baseTime);
+	for(UINT i = 0; i < BoneCount; ++i)
+	{
+		CHECK_LE(MaxDifference(actual[i], expected[i]), 1e-4f);
+
+		// Bones outside the mask are where the base clip puts them.
+		if(mask[i] == 0.0f)
+			CHECK_LE(MaxDifference(actual[i], basePalette[i]), 1e-4f);
+	}
+	CHECK(MaxDifference(actual[1], basePalette[1]) > 1e-2f);
+}
+
+TEST(BlendTreeSamplesEachSourceOncePerFrame)
+{
+	SkinnedData skinnedData;
+	TestData::MakeSkinnedData(skinnedData, BoneCount, 10, 2.0f);
+	skinnedData.UseCompiledClips(true);
+	const SkinnedData::ClipHandle clip = skinnedData.FindClip("Test");
+	REQUIRE(clip != SkinnedData::InvalidClip);
+
+	// Source a feeds three clip nodes, b one.
+	BlendTree tree;
+	const BlendTree::SourceId a = tree.AddSource(clip, 0.2f);
+	const BlendTree::SourceId b = tree.AddSource(clip, 1.4f);
+	const BlendTree::NodeId same = tree.AddBlend(tree.AddClip(a), tree.AddClip(a), 0.5f);
+	const BlendTree::NodeId blend = tree.AddBlend(same, tree.AddClip(b), 0.5f);
+	const BlendTree::NodeId root = tree.AddLayer(blend, tree.AddClip(a), BlendTree::MakeSubtreeMask(skinnedData, 2));
+
+	SkinnedData::EvalScratch scratch;
+	std::vector<XMFLOAT4X4> palette(BoneCount);
+	for(int frame = 0; frame < 3; ++frame)
+	{
+		tree.Evaluate(skinnedData, palette.data(), scratch);
+		CHECK(tree.GetSampledSourceCount() == 2);
+		tree.Advance(skinnedData, 1.0f / 60.0f);
+	}
+
+	// A source blended with itself is that source.
+	tree.SetRoot(same);
+	const std::vector<XMFLOAT4X4> actual = TreePalette(tree, skinnedData);
+	CHECK(tree.GetSampledSourceCount() == 1);
+	const std::vector<XMFLOAT4X4> expected = ClipPalette(skinnedData, clip, tree.GetSourceTime(a));
+	for(UINT i = 0; i < BoneCount; ++i)
+		CHECK_LE(MaxDifference(actual[i], expected[i]), 1e-4f);
+
+	// A blend at weight 0 never reaches b.
+	tree.SetRoot(root);
+	tree.SetWeight(blend, 0.0f);
+	tree.Evaluate(skinnedData, palette.data(), scratch);
+	CHECK(tree.GetSampledSourceCount() == 1);
+}
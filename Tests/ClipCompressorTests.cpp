@@ -0,0 +1,248 @@
+#include "Test.h"
+#include "TestData.h"
+
+#include <cmath>
+#include <cstring>
+#include <random>
+
+using namespace DirectX;
+
+namespace
+{
+	// Angle of the rotation between two unit quaternions; atan2 in double
+	// keeps the precision acos loses near 1.
+	double RotationAngle(const XMFLOAT4& a, const XMFLOAT4& b)
+	{
+		const double dot = (double)a.x * b.x + (double)a.y * b.y + (double)a.z * b.z + (double)a.w * b.w;
+		const double cx = (double)a.w * b.x - (double)a.x * b.w - (double)a.y * b.z + (double)a.z * b.y;
+		const double cy = (double)a.w * b.y + (double)a.x * b.z - (double)a.y * b.w - (double)a.z * b.x;
+		const double cz = (double)a.w * b.z - (double)a.x * b.y + (double)a.y * b.x - (double)a.z * b.w;
+		return 2.0 * atan2(sqrt(cx * cx + cy * cy + cz * cz), fabs(dot));
+	}
+
+	float Distance(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		return XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&a), XMLoadFloat3(&b))));
+	}
+
+	// Times over the clip and a little past both ends (sampling clamps).
+	std::vector<float> SampleTimes(float start, float end, int count)
+	{
+		std::vector<float> times;
+		for(int i = 0; i <= count; ++i)
+			times.push_back(start - 0.05f + (end - start + 0.1f) * i / count);
+		return times;
+	}
+}
+
+TEST(ClipCompressorStaysWithinErrorLimits)
+{
+	const UINT boneCount = 58;
+	const AnimationClip clip = TestData::MakeClip(boneCount, 120, 4.0f);
+
+	ClipCompressor::Settings settings;
+	CompressedClip compressed;
+	ClipCompressor::Report report;
+	ClipCompressor::Compress(clip, settings, compressed, &report);
+
+	REQUIRE(compressed.BoneCount() == boneCount);
+	CHECK(report.CompressedKeys == compressed.KeyCount());
+	CHECK(report.CompressedKeys < report.OriginalKeys);
+	CHECK(report.CompressedBytes == compressed.SizeInBytes());
+	CHECK(report.CompressedBytes < report.OriginalBytes);
+
+	CHECK_LE(report.MaxTranslationError, settings.TranslationError);
+	CHECK_LE(report.MaxRotationError, settings.RotationError);
+	CHECK_LE(report.MaxScaleError, settings.ScaleError);
+
+	// Every original key, sampled from the compressed clip, is within what
+	// the report claims (up to float rounding).
+	float translationError = 0.0f;
+	double rotationError = 0.0;
+	float scaleError = 0.0f;
+	for(UINT b = 0; b < boneCount; ++b)
+	{
+		std::uint32_t cursor = 0;
+		for(const Keyframe& original : clip.BoneAnimations[b].Keyframes)
+		{
+			Keyframe key;
+			compressed.Interpolate(b, original.TimePos, key, cursor);
+			translationError = fmaxf(translationError, Distance(key.Translation, original.Translation));
+			rotationError = fmax(rotationError, RotationAngle(key.RotationQuat, original.RotationQuat));
+			scaleError = fmaxf(scaleError, Distance(key.Scale, original.Scale));
+		}
+	}
+	CHECK_LE(translationError, report.MaxTranslationError + 1e-6f);
+	CHECK_LE(rotationError, report.MaxRotationError + 1e-5);
+	CHECK_LE(scaleError, report.MaxScaleError + 1e-6f);
+}
+
+TEST(CompressedClipMatchesDecompressedClip)
+{
+	const UINT boneCount = 13;
+	const AnimationClip clip = TestData::MakeClip(boneCount, 90, 3.0f);
+
+	CompressedClip compressed;
+	ClipCompressor::Compress(clip, ClipCompressor::Settings(), compressed);
+
+	AnimationClip decompressed;
+	compressed.Decompress(decompressed);
+	REQUIRE(decompressed.BoneAnimations.size() == boneCount);
+
+	std::size_t keyCount = 0;
+	for(const BoneAnimation& bone : decompressed.BoneAnimations)
+		keyCount += bone.Keyframes.size();
+	CHECK(keyCount == compressed.KeyCount());
+	CHECK(compressed.GetStartTime() == decompressed.GetClipStartTime());
+	CHECK(compressed.GetEndTime() == decompressed.GetClipEndTime());
+
+	// Sampling the stored keys is the decompressed clip's slerp path exactly,
+	// through forward playback and random seeks alike.
+	std::vector<float> times = SampleTimes(compressed.GetStartTime(), compressed.GetEndTime(), 997);
+	std::mt19937 rng(19);
+	for(int i = 0; i < 500; ++i)
+		times.push_back(std::uniform_real_distribution<float>(-0.1f, 3.1f)(rng));
+
+	std::vector<std::uint32_t> cursors(boneCount, 0);
+	std::vector<UINT> keyCursors;
+	std::vector<XMFLOAT4X4> expected(boneCount);
+	std::size_t mismatches = 0;
+	for(float t : times)
+	{
+		decompressed.Interpolate(t, expected, keyCursors);
+		for(UINT b = 0; b < boneCount; ++b)
+		{
+			XMFLOAT4X4 actual;
+			compressed.Interpolate(b, t, actual, cursors[b]);
+			if(std::memcmp(&actual, &expected[b], sizeof(actual)) != 0)
+				++mismatches;
+		}
+	}
+	CHECK(mismatches == 0);
+}
+
+TEST(ClipCompressorStoresConstantTracksOnce)
+{
+	// One bone that never moves: one key, and the value comes back.
+	AnimationClip clip;
+	clip.BoneAnimations.resize(1);
+	const XMFLOAT4 rotation(0.0f, 0.38268343f, 0.0f, 0.92387953f);	// 45 degrees about y
+	for(int k = 0; k < 30; ++k)
+	{
+		Keyframe key;
+		key.TimePos = k / 30.0f;
+		key.Translation = XMFLOAT3(1.0f, 2.0f, 3.0f);
+		key.Scale = XMFLOAT3(2.0f, 2.0f, 2.0f);
+		key.RotationQuat = rotation;
+		clip.BoneAnimations[0].Keyframes.push_back(key);
+	}
+
+	CompressedClip compressed;
+	ClipCompressor::Report report;
+	ClipCompressor::Compress(clip, ClipCompressor::Settings(), compressed, &report);
+	CHECK(compressed.KeyCount() == 1);
+	CHECK(report.OriginalBytes == 30 * sizeof(Keyframe));
+
+	for(float t : { -1.0f, 0.0f, 0.5f, 2.0f })
+	{
+		Keyframe key;
+		std::uint32_t cursor = 0;
+		compressed.Interpolate(0, t, key, cursor);
+		CHECK(key.Translation.x == 1.0f && key.Translation.y == 2.0f && key.Translation.z == 3.0f);
+		CHECK(key.Scale.x == 2.0f && key.Scale.y == 2.0f && key.Scale.z == 2.0f);
+		CHECK_LE(RotationAngle(key.RotationQuat, rotation), 1e-4);
+	}
+}
+
+TEST(SmallestThreeRoundTrip)
+{
+	// Random rotations, plus each component being the largest with either sign.
+	std::vector<XMFLOAT4> rotations;
+	for(int largest = 0; largest < 4; ++largest)
+	{
+		for(float sign : { 1.0f, -1.0f })
+		{
+			float q[4] = { 0.1f, -0.2f, 0.3f, 0.1f };
+			q[largest] = 0.9f * sign;
+			XMFLOAT4 rotation;
+			XMStoreFloat4(&rotation, XMQuaternionNormalize(XMVectorSet(q[0], q[1], q[2], q[3])));
+			rotations.push_back(rotation);
+		}
+	}
+	rotations.push_back(XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f));
+	rotations.push_back(XMFLOAT4(0.5f, 0.5f, 0.5f, 0.5f));	// a tie for largest
+
+	std::mt19937 rng(3);
+	std::normal_distribution<float> normal;
+	for(int i = 0; i < 10000; ++i)
+	{
+		XMFLOAT4 rotation;
+		XMStoreFloat4(&rotation, XMQuaternionNormalize(XMVectorSet(normal(rng), normal(rng), normal(rng), normal(rng))));
+		rotations.push_back(rotation);
+	}
+
+	// 15 bits over [-1/sqrt2, 1/sqrt2]: each kept component is off by at
+	// most 2.2e-5 and the rebuilt one follows, about 1.2e-4 rad at worst.
+	double maxAngle = 0.0;
+	float maxLengthError = 0.0f;
+	for(const XMFLOAT4& rotation : rotations)
+	{
+		std::uint16_t encoded[3];
+		CompressedClip::EncodeRotation(rotation, encoded);
+		const XMFLOAT4 decoded = CompressedClip::DecodeRotation(encoded);
+
+		maxAngle = fmax(maxAngle, RotationAngle(decoded, rotation));
+		maxLengthError = fmaxf(maxLengthError, fabsf(XMVectorGetX(XMVector4Length(XMLoadFloat4(&decoded))) - 1.0f));
+	}
+	CHECK_LE(maxAngle, 1.5e-4);
+	CHECK_LE(maxLengthError, 1e-5f);
+}
+
+TEST(CompressClipsKeepsCompressedKeys)
+{
+	SkinnedData original;
+	TestData::MakeSkinnedData(original, 58, 120, 4.0f);
+	SkinnedData skinnedData;
+	TestData::MakeSkinnedData(skinnedData, 58, 120, 4.0f);
+
+	std::unordered_map<std::string, ClipCompressor::Report> reports;
+	skinnedData.CompressClips(ClipCompressor::Settings(), &reports);
+	REQUIRE(reports.count("Test") == 1);
+	const ClipCompressor::Report& report = reports["Test"];
+	CHECK(report.Ratio() > 1.0f);
+
+	const SkinnedData::ClipHandle clip = skinnedData.FindClip("Test");
+	REQUIRE(clip != SkinnedData::InvalidClip);
+	CHECK(skinnedData.FindCompiledClip(clip) == nullptr);
+	CHECK(fabsf(skinnedData.GetClipEndTime(clip) - original.GetClipEndTime(clip)) < 1e-3f);
+
+	// The slerp path samples the compressed keys: bones end up within the
+	// reported error of where the original clip puts them.  The palette
+	// takes bone i's bind position (0, i, 0) to the posed bone.
+	std::vector<XMFLOAT4X4> expected(skinnedData.BoneCount());
+	std::vector<XMFLOAT4X4> actual(skinnedData.BoneCount());
+	std::vector<UINT> expectedCursors;
+	std::vector<UINT> actualCursors;
+	SkinnedData::EvalScratch scratch;
+
+	float maxError = 0.0f;
+	for(float t : SampleTimes(0.0f, 4.0f, 240))
+	{
+		original.GetFinalTransforms(clip, t, expected.data(), expectedCursors, scratch);
+		skinnedData.GetFinalTransforms(clip, t, actual.data(), actualCursors, scratch);
+		for(UINT i = 0; i < skinnedData.BoneCount(); ++i)
+		{
+			const XMVECTOR bind = XMVectorSet(0.0f, (float)i, 0.0f, 1.0f);
+			const XMVECTOR a = XMVector3Transform(bind, XMMatrixTranspose(XMLoadFloat4x4(&expected[i])));
+			const XMVECTOR b = XMVector3Transform(bind, XMMatrixTranspose(XMLoadFloat4x4(&actual[i])));
+			maxError = fmaxf(maxError, XMVectorGetX(XMVector3Length(XMVectorSubtract(a, b))));
+		}
+	}
+	CHECK(report.MaxBonePositionError > 0.0f);
+	CHECK_LE(maxError, report.MaxBonePositionError * 1.1f + 1e-5f);
+
+	// Compiled sampling still works, rebuilt from the decoded keys.
+	skinnedData.UseCompiledClips(true);
+	REQUIRE(skinnedData.FindCompiledClip(clip) != nullptr);
+	CHECK(skinnedData.FindCompiledClip(clip)->BoneCount() == skinnedData.BoneCount());
+}
@@ -0,0 +1,170 @@
+#include "Test.h"
+#include "TestData.h"
+
+#include <chrono>
+
+using namespace DirectX;
+
+namespace
+{
+	float MaxDifference(const XMFLOAT4X4* a, const XMFLOAT4X4* b, std::size_t count)
+	{
+		float maxDiff = 0.0f;
+		for(std::size_t i = 0; i < count; ++i)
+		{
+			for(int r = 0; r < 4; ++r)
+			{
+				for(int c = 0; c < 4; ++c)
+					maxDiff = fmaxf(maxDiff, fabsf(a[i](r, c) - b[i](r, c)));
+			}
+		}
+		return maxDiff;
+	}
+
+	// Times over the clip and a little past both ends (sampling clamps).
+	std::vector<float> SampleTimes(float start, float end, int count)
+	{
+		std::vector<float> times;
+		for(int i = 0; i <= count; ++i)
+			times.push_back(start - 0.05f + (end - start + 0.1f) * i / count);
+		return times;
+	}
+}
+
+TEST(CompiledClipMatchesInterpolate)
+{
+	// 40 keys over 1.25 s: about 0.1 rad between neighbouring rotation keys.
+	const UINT boneCount = 58;
+	const AnimationClip clip = TestData::MakeClip(boneCount, 40, 1.25f);
+
+	CompiledClip compiled;
+	compiled.Compile(clip);
+	REQUIRE(compiled.BoneCount() == boneCount);
+	CHECK(compiled.GetStartTime() == clip.GetClipStartTime());
+	CHECK(compiled.GetEndTime() == clip.GetClipEndTime());
+
+	std::vector<XMFLOAT4X4> expected(boneCount);
+	std::vector<XMFLOAT4X4> actual(boneCount);
+	std::vector<UINT> keyCursors;
+	std::uint32_t cursor = 0;
+
+	// To-parent transforms are unit scale rotations plus small translations,
+	// so every element is within about 1.1.  nlerp vs slerp over 0.1 rad
+	// is off by about 3e-5; translation and scale are exact.
+	float maxDiff = 0.0f;
+	for(float t : SampleTimes(clip.GetClipStartTime(), clip.GetClipEndTime(), 997))
+	{
+		clip.Interpolate(t, expected, keyCursors);
+		compiled.Sample(t, actual.data(), cursor);
+		maxDiff = fmaxf(maxDiff, MaxDifference(expected.data(), actual.data(), boneCount));
+	}
+	CHECK_LE(maxDiff, 1e-4f);
+
+	// On a key of bone 0 no interpolation is left for that bone: same up to rounding.
+	float keyDiff = 0.0f;
+	for(const Keyframe& key : clip.BoneAnimations[0].Keyframes)
+	{
+		clip.Interpolate(key.TimePos, expected, keyCursors);
+		compiled.Sample(key.TimePos, actual.data(), cursor);
+		keyDiff = fmaxf(keyDiff, MaxDifference(expected.data(), actual.data(), 1));
+	}
+	CHECK_LE(keyDiff, 1e-5f);
+}
+
+TEST(CompiledFinalTransformsMatchSlerpPath)
+{
+	// The whole palette: errors add up along the hierarchy (depth 5 here)
+	// and are scaled by the bone offsets (up to 57 units), about 2e-3.
+	SkinnedData slerpData;
+	TestData::MakeSkinnedData(slerpData, 58, 40, 1.25f);
+	SkinnedData compiledData;
+	TestData::MakeSkinnedData(compiledData, 58, 40, 1.25f);
+	compiledData.UseCompiledClips(true);
+
+	const SkinnedData::ClipHandle clip = slerpData.FindClip("Test");
+	REQUIRE(clip != SkinnedData::InvalidClip && compiledData.FindClip("Test") == clip);
+
+	std::vector<XMFLOAT4X4> expected(slerpData.BoneCount());
+	std::vector<XMFLOAT4X4> actual(slerpData.BoneCount());
+	std::vector<UINT> slerpCursors;
+	std::vector<UINT> compiledCursors;
+	SkinnedData::EvalScratch scratch;
+
+	float maxDiff = 0.0f;
+	for(float t : SampleTimes(0.0f, slerpData.GetClipEndTime(clip), 499))
+	{
+		slerpData.GetFinalTransforms(clip, t, expected.data(), slerpCursors, scratch);
+		compiledData.GetFinalTransforms(clip, t, actual.data(), compiledCursors, scratch);
+		maxDiff = fmaxf(maxDiff, MaxDifference(expected.data(), actual.data(), expected.size()));
+	}
+	CHECK_LE(maxDiff, 5e-3f);
+}
+
+TEST(CompiledClipsOnlyWhileInUse)
+{
+	SkinnedData skinnedData;
+	TestData::MakeSkinnedData(skinnedData, 58, 40, 1.25f);
+	const SkinnedData::ClipHandle clip = skinnedData.FindClip("Test");
+	REQUIRE(clip != SkinnedData::InvalidClip);
+
+	// Off by default: only the keyframes are kept.
+	CHECK(!skinnedData.IsUsingCompiledClips());
+	CHECK(skinnedData.FindCompiledClip(clip) == nullptr);
+
+	skinnedData.UseCompiledClips(true);
+	const CompiledClip* compiled = skinnedData.FindCompiledClip(clip);
+	REQUIRE(compiled != nullptr);
+	CHECK(compiled->BoneCount() == skinnedData.BoneCount());
+	CHECK(compiled->GetByteSize() > 0);
+
+	skinnedData.UseCompiledClips(false);
+	CHECK(skinnedData.FindCompiledClip(clip) == nullptr);
+}
+
+BENCHMARK(CompiledClipThroughput)
+{
+	const UINT boneCount = 58;
+	const int frameCount = 5000;
+
+	std::printf("  %6s %6s %16s %16s %20s %20s\n", "bones", "keys",
+		"Interpolate us", "Sample us", "final (slerp) us", "final (compiled) us");
+	for(UINT keyCount : { 40u, 400u })
+	{
+		SkinnedData skinnedData;
+		TestData::MakeSkinnedData(skinnedData, boneCount, keyCount, keyCount / 30.0f);
+		const SkinnedData::ClipHandle clip = skinnedData.FindClip("Test");
+		skinnedData.UseCompiledClips(true);
+		const CompiledClip* compiled = skinnedData.FindCompiledClip(clip);
+		const AnimationClip animation = TestData::MakeClip(boneCount, keyCount, keyCount / 30.0f);
+		const float endTime = skinnedData.GetClipEndTime(clip);
+
+		std::vector<XMFLOAT4X4> transforms(boneCount);
+		std::vector<UINT> keyCursors;
+		std::uint32_t cursor = 0;
+		SkinnedData::EvalScratch scratch;
+
+		// us per pose, 60 Hz playback looping over the clip
+		auto poseUs = [&](auto&& sample)
+		{
+			sample(0.0f);
+			const auto start = std::chrono::steady_clock::now();
+			for(int frame = 0; frame < frameCount; ++frame)
+				sample(fmodf(frame / 60.0f, endTime));
+			return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / frameCount;
+		};
+
+		const double interpolateUs = poseUs([&](float t) { animation.Interpolate(t, transforms, keyCursors); });
+		const double sampleUs = poseUs([&](float t) { compiled->Sample(t, transforms.data(), cursor); });
+
+		skinnedData.UseCompiledClips(false);
+		keyCursors.clear();
+		const double slerpFinalUs = poseUs([&](float t) { skinnedData.GetFinalTransforms(clip, t, transforms.data(), keyCursors, scratch); });
+
+		skinnedData.UseCompiledClips(true);
+		keyCursors.clear();
+		const double compiledFinalUs = poseUs([&](float t) { skinnedData.GetFinalTransforms(clip, t, transforms.data(), keyCursors, scratch); });
+
+		std::printf("  %6u %6u %16.2f %16.2f %20.2f %20.2f\n", boneCount, keyCount,
+			interpolateUs, sampleUs, slerpFinalUs, compiledFinalUs);
+	}
+}
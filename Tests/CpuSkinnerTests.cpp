@@ -0,0 +1,229 @@
+#include "Test.h"
+#include "../Init_Direct3D/CpuSkinner.h"
+#include "../Init_Direct3D/ThreadPool.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	struct InVertex
+	{
+		XMFLOAT3 Pos;
+		XMFLOAT3 Normal;
+		XMFLOAT2 TexC;
+		XMFLOAT3 TangentU;
+		XMFLOAT3 BoneWeights;
+		std::uint8_t BoneIndices[4];
+	};
+
+	struct OutVertex
+	{
+		XMFLOAT3 Pos;
+		XMFLOAT3 Normal;
+		XMFLOAT2 TexC;
+		XMFLOAT3 TangentU;
+	};
+
+	CpuSkinner::InputLayout InLayout()
+	{
+		CpuSkinner::InputLayout in;
+		in.Stride = sizeof(InVertex);
+		in.Position = offsetof(InVertex, Pos);
+		in.Normal = offsetof(InVertex, Normal);
+		in.Tangent = offsetof(InVertex, TangentU);
+		in.BoneWeights = offsetof(InVertex, BoneWeights);
+		in.BoneIndices = offsetof(InVertex, BoneIndices);
+		return in;
+	}
+
+	CpuSkinner::OutputLayout OutLayout()
+	{
+		CpuSkinner::OutputLayout out;
+		out.Stride = sizeof(OutVertex);
+		out.Position = offsetof(OutVertex, Pos);
+		out.Normal = offsetof(OutVertex, Normal);
+		out.Tangent = offsetof(OutVertex, TangentU);
+		return out;
+	}
+
+	// Rotation, non-uniform scale and translation per bone, stored
+	// transposed like SkinnedData::GetFinalTransforms writes the palette.
+	std::vector<XMFLOAT4X4> MakePalette(std::size_t boneCount, std::mt19937& rng)
+	{
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		std::vector<XMFLOAT4X4> palette(boneCount);
+		for(XMFLOAT4X4& bone : palette)
+		{
+			const XMVECTOR axis = XMVector3Normalize(XMVectorSet(unit(rng), unit(rng), unit(rng) + 2.0f, 0.0f));
+			const XMVECTOR Q = XMQuaternionRotationAxis(axis, 3.0f * unit(rng));
+			const XMVECTOR S = XMVectorSet(1.0f + 0.5f * unit(rng), 1.0f + 0.5f * unit(rng), 1.0f + 0.5f * unit(rng), 0.0f);
+			const XMVECTOR T = XMVectorSet(10.0f * unit(rng), 10.0f * unit(rng), 10.0f * unit(rng), 0.0f);
+			XMStoreFloat4x4(&bone, XMMatrixTranspose(XMMatrixAffineTransformation(S, XMVectorZero(), Q, T)));
+		}
+		return palette;
+	}
+
+	// boneCount bones used, up to influences of them per vertex with random weights.
+	std::vector<InVertex> MakeVertices(std::size_t count, std::size_t boneCount, int influences, std::mt19937& rng)
+	{
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		std::uniform_int_distribution<int> bone(0, (int)boneCount - 1);
+		std::vector<InVertex> vertices(count);
+		for(std::size_t i = 0; i < count; ++i)
+		{
+			InVertex& v = vertices[i];
+			v.Pos = XMFLOAT3(5.0f * unit(rng), 5.0f * unit(rng), 5.0f * unit(rng));
+			XMStoreFloat3(&v.Normal, XMVector3Normalize(XMVectorSet(unit(rng), unit(rng), unit(rng) + 2.0f, 0.0f)));
+			XMStoreFloat3(&v.TangentU, XMVector3Normalize(XMVectorSet(unit(rng) + 2.0f, unit(rng), unit(rng), 0.0f)));
+			v.TexC = XMFLOAT2((float)i, -(float)i);
+
+			float w[4] = { 1.0f, 0.0f, 0.0f, 0.0f };
+			if(influences > 1)
+			{
+				float sum = 0.0f;
+				for(int j = 0; j < influences; ++j)
+					sum += w[j] = 0.1f + (unit(rng) + 1.0f);
+				for(int j = 0; j < influences; ++j)
+					w[j] /= sum;
+			}
+			v.BoneWeights = XMFLOAT3(w[0], w[1], w[2]);
+			for(int j = 0; j < 4; ++j)
+				v.BoneIndices[j] = (std::uint8_t)bone(rng);
+		}
+		return vertices;
+	}
+
+	// The shader's sum, one bone at a time in double: sum of w * (x * M)
+	// with M the untransposed bone matrix, w = 0 for normals / tangents.
+	void ReferenceSkin(const InVertex& v, const XMFLOAT4X4* palette, double* pos, double* normal, double* tangent)
+	{
+		const double w[4] = { v.BoneWeights.x, v.BoneWeights.y, v.BoneWeights.z,
+			1.0 - v.BoneWeights.x - v.BoneWeights.y - v.BoneWeights.z };
+		const float* in[3] = { &v.Pos.x, &v.Normal.x, &v.TangentU.x };
+		double* out[3] = { pos, normal, tangent };
+
+		for(int a = 0; a < 3; ++a)
+		{
+			const double x[4] = { in[a][0], in[a][1], in[a][2], a == 0 ? 1.0 : 0.0 };
+			for(int c = 0; c < 3; ++c)
+			{
+				out[a][c] = 0.0;
+				for(int j = 0; j < 4; ++j)
+				{
+					// palette holds the transpose: M(r, c) = palette(c, r).
+					const XMFLOAT4X4& P = palette[v.BoneIndices[j]];
+					double sum = 0.0;
+					for(int r = 0; r < 4; ++r)
+						sum += x[r] * P(c, r);
+					out[a][c] += w[j] * sum;
+				}
+			}
+		}
+	}
+
+	// Largest difference to the reference, relative to the coordinate size.
+	double MaxReferenceError(const std::vector<InVertex>& vertices, const std::vector<OutVertex>& posed, const XMFLOAT4X4* palette)
+	{
+		double maxError = 0.0;
+		for(std::size_t i = 0; i < vertices.size(); ++i)
+		{
+			double expected[3][3];
+			ReferenceSkin(vertices[i], palette, expected[0], expected[1], expected[2]);
+
+			const float* actual[3] = { &posed[i].Pos.x, &posed[i].Normal.x, &posed[i].TangentU.x };
+			for(int a = 0; a < 3; ++a)
+			{
+				for(int c = 0; c < 3; ++c)
+					maxError = fmax(maxError, fabs(actual[a][c] - expected[a][c]) / fmax(1.0, fabs(expected[a][c])));
+			}
+		}
+		return maxError;
+	}
+
+	std::vector<OutVertex> Skin(const std::vector<InVertex>& vertices, const std::vector<XMFLOAT4X4>& palette, ThreadPool* pool = nullptr)
+	{
+		// TexC is not in the output layout: it must keep this fill.
+		OutVertex fill;
+		std::memset(&fill, 0xcd, sizeof(fill));
+		std::vector<OutVertex> posed(vertices.size(), fill);
+
+		CpuSkinner::Skin(vertices.data(), vertices.size(), InLayout(), palette.data(), palette.size(),
+			posed.data(), OutLayout(), pool);
+		return posed;
+	}
+}
+
+TEST(CpuSkinnerIdentityPalette)
+{
+	std::mt19937 rng(25);
+	XMFLOAT4X4 identity;
+	XMStoreFloat4x4(&identity, XMMatrixIdentity());
+	const std::vector<XMFLOAT4X4> palette(8, identity);
+	const std::vector<InVertex> vertices = MakeVertices(300, palette.size(), 4, rng);
+
+	// Weights sum to 1 up to rounding, so the bind pose comes back.
+	const std::vector<OutVertex> posed = Skin(vertices, palette);
+	double maxError = 0.0;
+	for(std::size_t i = 0; i < vertices.size(); ++i)
+	{
+		const float* in[3] = { &vertices[i].Pos.x, &vertices[i].Normal.x, &vertices[i].TangentU.x };
+		const float* out[3] = { &posed[i].Pos.x, &posed[i].Normal.x, &posed[i].TangentU.x };
+		for(int a = 0; a < 3; ++a)
+		{
+			for(int c = 0; c < 3; ++c)
+				maxError = fmax(maxError, fabs(out[a][c] - in[a][c]));
+		}
+	}
+	CHECK_LE(maxError, 1e-5);
+	CHECK_LE(MaxReferenceError(vertices, posed, palette.data()), 1e-5);
+}
+
+TEST(CpuSkinnerMatchesScalarReference)
+{
+	std::mt19937 rng(7);
+	const std::vector<XMFLOAT4X4> palette = MakePalette(58, rng);
+
+	// One bone at full weight: just that bone's transform.
+	const std::vector<InVertex> single = MakeVertices(500, palette.size(), 1, rng);
+	const std::vector<OutVertex> singlePosed = Skin(single, palette);
+	CHECK_LE(MaxReferenceError(single, singlePosed, palette.data()), 1e-5);
+
+	// Four bones blended, the fourth weight implied.
+	const std::vector<InVertex> blended = MakeVertices(500, palette.size(), 4, rng);
+	const std::vector<OutVertex> blendedPosed = Skin(blended, palette);
+	CHECK_LE(MaxReferenceError(blended, blendedPosed, palette.data()), 1e-5);
+
+	// Bytes outside the output layout are left alone.
+	std::size_t touched = 0;
+	for(const OutVertex& v : blendedPosed)
+	{
+		std::uint8_t texC[sizeof(v.TexC)];
+		std::memcpy(texC, &v.TexC, sizeof(texC));
+		for(std::uint8_t b : texC)
+			touched += b != 0xcd;
+	}
+	CHECK(touched == 0);
+}
+
+TEST(CpuSkinnerPoolMatchesSerial)
+{
+	std::mt19937 rng(11);
+	const std::vector<XMFLOAT4X4> palette = MakePalette(58, rng);
+
+	// Several chunks, the last one partial.
+	const std::vector<InVertex> vertices = MakeVertices(10000, palette.size(), 4, rng);
+
+	ThreadPool pool(4);
+	const std::vector<OutVertex> serial = Skin(vertices, palette);
+	const std::vector<OutVertex> parallel = Skin(vertices, palette, &pool);
+
+	// Every vertex runs the same code whichever thread has it.
+	CHECK(std::memcmp(serial.data(), parallel.data(), serial.size() * sizeof(OutVertex)) == 0);
+	CHECK_LE(MaxReferenceError(vertices, parallel, palette.data()), 1e-5);
+}
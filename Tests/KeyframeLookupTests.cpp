@@ -0,0 +1,128 @@
+#include "Test.h"
+#include "TestData.h"
+
+#include <chrono>
+#include <cstring>
+#include <random>
+
+using namespace DirectX;
+
+namespace
+{
+	// The lookup BoneAnimation::Interpolate had before the cursor: a scan from key 0.
+	UINT LinearFindKeyframe(const BoneAnimation& bone, float t)
+	{
+		UINT i = 0;
+		while(bone.Keyframes[i + 1].TimePos <= t)
+			++i;
+		return i;
+	}
+
+	// A time strictly inside every bone's keys (FindKeyframe's precondition).
+	float Inside(const AnimationClip& clip, float t)
+	{
+		const float start = clip.GetClipStartTime();
+		const float end = clip.GetClipEndTime();
+		return MathHelper::Clamp(t, start + 1e-4f, end - 1e-4f);
+	}
+}
+
+TEST(KeyframeCursorMatchesLinearSearch)
+{
+	const AnimationClip clip = TestData::MakeClip(12, 3000, 50.0f);
+	const float endTime = clip.GetClipEndTime();
+
+	// Forward playback at 60 Hz over two loops, then random seeks, with one
+	// cursor per bone carried along as an instance does.
+	std::vector<float> times;
+	for(int frame = 0; frame < 6000; ++frame)
+		times.push_back(fmodf(frame / 60.0f, endTime));
+
+	std::mt19937 rng(16);
+	for(int i = 0; i < 2000; ++i)
+		times.push_back(std::uniform_real_distribution<float>(0.0f, endTime)(rng));
+
+	std::vector<UINT> cursors(clip.BoneAnimations.size(), 0);
+	std::size_t mismatches = 0;
+	for(float time : times)
+	{
+		const float t = Inside(clip, time);
+		for(std::size_t b = 0; b < clip.BoneAnimations.size(); ++b)
+		{
+			const BoneAnimation& bone = clip.BoneAnimations[b];
+			if(bone.FindKeyframe(t, cursors[b]) != LinearFindKeyframe(bone, t))
+				++mismatches;
+		}
+	}
+	CHECK(mismatches == 0);
+
+	// The cursor overloads give the same pose as the cursor-less ones.
+	std::vector<XMFLOAT4X4> withCursor(clip.BoneAnimations.size());
+	std::vector<XMFLOAT4X4> withoutCursor(clip.BoneAnimations.size());
+	std::vector<UINT> keyCursors;
+	std::size_t poseMismatches = 0;
+	for(std::size_t i = 0; i < times.size(); i += 7)
+	{
+		clip.Interpolate(times[i], withCursor, keyCursors);
+		clip.Interpolate(times[i], withoutCursor);
+		if(memcmp(withCursor.data(), withoutCursor.data(), withCursor.size() * sizeof(XMFLOAT4X4)) != 0)
+			++poseMismatches;
+	}
+	CHECK(poseMismatches == 0);
+}
+
+BENCHMARK(KeyframeLookupLongClips)
+{
+	// 58 bones (the soldier), keys at 30 Hz, sampled at 60 Hz for frameCount frames.
+	const UINT boneCount = 58;
+	const int frameCount = 2000;
+
+	std::printf("  %8s %14s %14s %14s %16s\n", "keys", "linear ns", "binary ns", "cursor ns", "Interpolate us");
+	for(UINT keyCount : { 30u, 300u, 3000u, 30000u })
+	{
+		const AnimationClip clip = TestData::MakeClip(boneCount, keyCount, keyCount / 30.0f);
+		const float endTime = clip.GetClipEndTime();
+
+		// Eight stretches of playback spread over the clip, like instances
+		// started at different times, so long clips are not only sampled
+		// near the start.  Each jump to the next stretch is a seek.
+		const int stretchFrames = frameCount / 8;
+		std::vector<float> times(frameCount);
+		for(int frame = 0; frame < frameCount; ++frame)
+		{
+			const float stretchStart = endTime * (frame / stretchFrames) / 8.0f;
+			times[frame] = Inside(clip, fmodf(stretchStart + (frame % stretchFrames) / 60.0f, endTime));
+		}
+
+		// ns per bone lookup
+		UINT checksum = 0;
+		auto lookupNs = [&](auto&& find)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			for(float t : times)
+			{
+				for(UINT b = 0; b < boneCount; ++b)
+					checksum += find(b, t);
+			}
+			return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+				((double)frameCount * boneCount);
+		};
+
+		std::vector<UINT> cursors(boneCount, 0);
+		const double linearNs = lookupNs([&](UINT b, float t) { return LinearFindKeyframe(clip.BoneAnimations[b], t); });
+		const double binaryNs = lookupNs([&](UINT b, float t) { UINT cursor = 0; return clip.BoneAnimations[b].FindKeyframe(t, cursor); });
+		const double cursorNs = lookupNs([&](UINT b, float t) { return clip.BoneAnimations[b].FindKeyframe(t, cursors[b]); });
+
+		// The whole per-frame sample (lookup + lerp / slerp + matrix) with cursors.
+		std::vector<XMFLOAT4X4> transforms(boneCount);
+		std::vector<UINT> keyCursors;
+		const auto start = std::chrono::steady_clock::now();
+		for(float t : times)
+			clip.Interpolate(t, transforms, keyCursors);
+		const double interpolateUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / frameCount;
+
+		// checksum keeps the lookups from being optimized away.
+		std::printf("  %8u %14.1f %14.1f %14.1f %16.2f%s\n", keyCount, linearNs, binaryNs, cursorNs, interpolateUs,
+			checksum == 0 ? " (no keys found)" : "");
+	}
+}
@@ -0,0 +1,185 @@
+#include "Test.h"
+#include "TestData.h"
+#include "../Init_Direct3D/M3dCache.h"
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+
+using namespace DirectX;
+
+namespace
+{
+	const UINT BoneCount = 7;
+
+	// A two-triangle skinned model with one clip, cached next to a dummy
+	// source file in the temp directory.
+	struct CacheFile
+	{
+		CacheFile()
+		{
+			const std::filesystem::path dir = std::filesystem::temp_directory_path();
+			Source = (dir / "M3dCacheTests.m3d").string();
+			Cache = M3dCache::GetCachePath(Source);
+			std::ofstream(Source) << "source";
+
+			std::vector<M3DLoader::SkinnedVertex> vertices(4);
+			for(UINT v = 0; v < 4; ++v)
+				vertices[v].Pos = XMFLOAT3((float)v, 0.0f, 0.0f);
+			const std::vector<UINT> indices = { 0, 1, 2, 2, 1, 3 };
+
+			std::vector<M3DLoader::Subset> subsets(1);
+			subsets[0].Id = 0;
+			subsets[0].VertexCount = 4;
+			subsets[0].FaceCount = 2;
+
+			std::vector<M3DLoader::M3dMaterial> mats(1);
+			mats[0].Name = "Quad";
+
+			std::vector<int> hierarchy(BoneCount);
+			for(UINT b = 0; b < BoneCount; ++b)
+				hierarchy[b] = b == 0 ? -1 : (int)(b - 1) / 2;
+			std::vector<XMFLOAT4X4> offsets(BoneCount, XMFLOAT4X4(
+				1.0f, 0.0f, 0.0f, 0.0f,
+				0.0f, 1.0f, 0.0f, 0.0f,
+				0.0f, 0.0f, 1.0f, 0.0f,
+				0.0f, 0.0f, 0.0f, 1.0f));
+
+			std::unordered_map<std::string, AnimationClip> animations;
+			animations["Take1"] = TestData::MakeClip(BoneCount, 5, 1.0f);
+
+			Written = M3dCache::Write(Cache, Source, vertices, indices, subsets, mats, hierarchy, offsets, animations);
+		}
+
+		~CacheFile()
+		{
+			std::error_code ec;
+			std::filesystem::remove(Cache, ec);
+			std::filesystem::remove(Source, ec);
+		}
+
+		// Overwrites a field of the file, as a corrupt cache would have it.
+		template<typename T>
+		void Patch(std::uint64_t offset, T value)
+		{
+			std::fstream file(Cache, std::ios::binary | std::ios::in | std::ios::out);
+			file.seekp((std::streamoff)offset);
+			file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+		}
+
+		std::uint64_t SectionOffset(M3dCache::SectionType type)
+		{
+			return sizeof(M3dCache::Header) + (std::uint64_t)type * sizeof(M3dCache::Section);
+		}
+
+		// Overwrites field (a byte offset) of element in the section.
+		template<typename T>
+		void PatchElement(M3dCache::SectionType type, std::uint64_t element, std::uint64_t field, T value)
+		{
+			M3dCache::Section section;
+			std::ifstream file(Cache, std::ios::binary);
+			file.seekg((std::streamoff)SectionOffset(type));
+			file.read(reinterpret_cast<char*>(&section), sizeof(section));
+			file.close();
+
+			Patch(section.Offset + element * section.ElementSize + field, value);
+		}
+
+		bool Open()
+		{
+			M3dCache cache;
+			return cache.Open(Cache, Source);
+		}
+
+		std::string Source;
+		std::string Cache;
+		bool Written = false;
+	};
+}
+
+TEST(M3dCacheOpensModel)
+{
+	CacheFile file;
+	REQUIRE(file.Written);
+
+	M3dCache cache;
+	REQUIRE(cache.Open(file.Cache, file.Source));
+	CHECK(cache.VertexCount() == 4 && cache.IndexCount() == 6);
+
+	std::vector<M3DLoader::M3dMaterial> mats;
+	cache.GetMaterials(mats);
+	CHECK(mats.size() == 1 && mats[0].Name == "Quad");
+
+	SkinnedData skinInfo;
+	cache.GetSkinnedData(skinInfo);
+	CHECK(skinInfo.BoneCount() == BoneCount);
+}
+
+TEST(M3dCacheRejectsBadReferences)
+{
+	using Section = M3dCache::SectionType;
+
+	// An index past the last vertex.
+	{
+		CacheFile file;
+		REQUIRE(file.Written);
+		file.PatchElement<UINT>(Section::Indices, 5, 0, 4);
+		CHECK(!file.Open());
+	}
+
+	// A subset with more faces than there are indices.
+	{
+		CacheFile file;
+		REQUIRE(file.Written);
+		file.PatchElement<UINT>(Section::Subsets, 0, offsetof(M3DLoader::Subset, FaceCount), 3);
+		CHECK(!file.Open());
+	}
+
+	// A material name past the end of the strings.
+	{
+		CacheFile file;
+		REQUIRE(file.Written);
+		file.PatchElement<UINT>(Section::Materials, 0, offsetof(M3dCache::MaterialRecord, NameOffset), 1000);
+		CHECK(!file.Open());
+	}
+
+	// A clip whose bone ranges run past the range section.
+	{
+		CacheFile file;
+		REQUIRE(file.Written);
+		file.PatchElement<UINT>(Section::Clips, 0, offsetof(M3dCache::ClipRecord, FirstBoneRange), 1);
+		CHECK(!file.Open());
+	}
+
+	// A bone range whose keyframes run past the keyframe section.
+	{
+		CacheFile file;
+		REQUIRE(file.Written);
+		file.PatchElement<UINT>(Section::BoneKeyframeRanges, BoneCount - 1, offsetof(M3dCache::KeyframeRange, KeyframeCount), 1000);
+		CHECK(!file.Open());
+	}
+
+	// A parent after its child.
+	{
+		CacheFile file;
+		REQUIRE(file.Written);
+		file.PatchElement<int>(Section::BoneHierarchy, 2, 0, 5);
+		CHECK(!file.Open());
+	}
+
+	// A count whose byte size wraps around 64 bits.
+	{
+		CacheFile file;
+		REQUIRE(file.Written);
+		file.Patch<UINT64>(file.SectionOffset(Section::Keyframes) + offsetof(M3dCache::Section, Count), 1ull << 62);
+		CHECK(!file.Open());
+	}
+
+	// Fewer bone offsets than bones.
+	{
+		CacheFile file;
+		REQUIRE(file.Written);
+		file.Patch<UINT64>(file.SectionOffset(Section::BoneOffsets) + offsetof(M3dCache::Section, Count), BoneCount - 1);
+		CHECK(!file.Open());
+	}
+}
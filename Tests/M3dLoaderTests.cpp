@@ -0,0 +1,248 @@
+#include "Test.h"
+#include "TestData.h"
+#include "../Init_Direct3D/LoadM3d.h"
+#include "../Init_Direct3D/M3dCache.h"
+#include "../Init_Direct3D/ThreadPool.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <random>
+
+using namespace DirectX;
+
+namespace
+{
+	const UINT BoneCount = 13;
+	const UINT VertexCount = 10000;
+	const UINT TriangleCount = 12000;
+
+	// A skinned .m3d text file in the temp directory, big enough that the
+	// parallel readers split the vertices and triangles into several chunks
+	// (and the streaming reader into several batches), with two clips over
+	// a multi-bone skeleton.
+	struct M3dFile
+	{
+		M3dFile()
+		{
+			Source = (std::filesystem::temp_directory_path() / "M3dLoaderTests.m3d").string();
+			Cache = M3dCache::GetCachePath(Source);
+			RemoveCache();
+
+			FILE* file = fopen(Source.c_str(), "w");
+			if(file == nullptr)
+				return;
+
+			std::mt19937 rng(3);
+			std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+			std::uniform_int_distribution<int> bone(0, BoneCount - 1);
+
+			fprintf(file, "***************m3d-File-Header***************\n");
+			fprintf(file, "#Materials 2\n#Vertices %u\n#Triangles %u\n#Bones %u\n#AnimationClips 2\n\n",
+				VertexCount, TriangleCount, BoneCount);
+
+			fprintf(file, "***************Materials*********************\n");
+			for(int m = 0; m < 2; ++m)
+			{
+				fprintf(file, "Name: part%d\nDiffuse: 1 1 1\nFresnel0: 0.05 0.05 0.05\nRoughness: 0.5\nAlphaClip: %d\n", m, m);
+				fprintf(file, "MaterialTypeName: Skinned\nDiffuseMap: part%d_diff.dds\nNormalMap: part%d_norm.dds\n\n", m, m);
+			}
+
+			const UINT firstVertices = VertexCount / 3;
+			const UINT firstFaces = TriangleCount / 3;
+			fprintf(file, "***************SubsetTable*******************\n");
+			fprintf(file, "SubsetID: 0 VertexStart: 0 VertexCount: %u FaceStart: 0 FaceCount: %u\n", firstVertices, firstFaces);
+			fprintf(file, "SubsetID: 1 VertexStart: %u VertexCount: %u FaceStart: %u FaceCount: %u\n\n",
+				firstVertices, VertexCount - firstVertices, firstFaces, TriangleCount - firstFaces);
+
+			fprintf(file, "***************Vertices**********************\n");
+			for(UINT v = 0; v < VertexCount; ++v)
+			{
+				const float w0 = 0.5f + 0.5f * unit(rng);
+				const float w1 = (1.0f - w0) * (0.5f + 0.5f * unit(rng));
+				fprintf(file, "Position: %.7g %.7g %.7g\n", 50.0f * unit(rng), 50.0f * unit(rng), 50.0f * unit(rng));
+				fprintf(file, "Tangent: %.7g %.7g %.7g 1\n", unit(rng), unit(rng), unit(rng));
+				fprintf(file, "Normal: %.7g %.7g %.7g\n", unit(rng), unit(rng), unit(rng));
+				fprintf(file, "Tex-Coords: %.7g %.7g\n", 0.5f + 0.5f * unit(rng), 0.5f + 0.5f * unit(rng));
+				fprintf(file, "BlendWeights: %.7g %.7g %.7g 0\n", w0, w1, 1.0f - w0 - w1);
+				fprintf(file, "BlendIndices: %d %d %d 0\n\n", bone(rng), bone(rng), bone(rng));
+			}
+
+			fprintf(file, "***************Triangles*********************\n");
+			for(UINT t = 0; t < TriangleCount; ++t)
+			{
+				const UINT first = t * 7 % (VertexCount - 2);
+				fprintf(file, "%u %u %u\n", first, first + 2, first + 1);
+			}
+			fprintf(file, "\n");
+
+			fprintf(file, "***************BoneOffsets*******************\n");
+			for(UINT b = 0; b < BoneCount; ++b)
+				fprintf(file, "BoneOffset%u 1 0 0 0 0 1 0 0 0 0 1 0 0 %d 0 1\n", b, -(int)b);
+			fprintf(file, "\n");
+
+			fprintf(file, "***************BoneHierarchy*****************\n");
+			for(UINT b = 0; b < BoneCount; ++b)
+				fprintf(file, "ParentIndexOfBone%u: %d\n", b, b == 0 ? -1 : (int)(b - 1) / 2);
+			fprintf(file, "\n");
+
+			fprintf(file, "***************AnimationClips****************\n");
+			const char* clipNames[2] = { "Walk", "Run" };
+			for(int c = 0; c < 2; ++c)
+			{
+				const AnimationClip clip = TestData::MakeClip(BoneCount, 40 + 25 * c, 1.5f + c);
+				fprintf(file, "AnimationClip %s\n{\n", clipNames[c]);
+				for(UINT b = 0; b < BoneCount; ++b)
+				{
+					const std::vector<Keyframe>& keys = clip.BoneAnimations[b].Keyframes;
+					fprintf(file, "\tBone%u #Keyframes: %u\n\t{\n", b, (UINT)keys.size());
+					for(const Keyframe& k : keys)
+					{
+						fprintf(file, "\t\tTime: %.7g Pos: %.7g %.7g %.7g Scale: %.7g %.7g %.7g Quat: %.7g %.7g %.7g %.7g\n",
+							k.TimePos, k.Translation.x, k.Translation.y, k.Translation.z,
+							k.Scale.x, k.Scale.y, k.Scale.z,
+							k.RotationQuat.x, k.RotationQuat.y, k.RotationQuat.z, k.RotationQuat.w);
+					}
+					fprintf(file, "\t}\n\n");
+				}
+				fprintf(file, "}\n\n");
+			}
+
+			Written = fclose(file) == 0;
+		}
+
+		~M3dFile()
+		{
+			RemoveCache();
+			std::error_code ec;
+			std::filesystem::remove(Source, ec);
+		}
+
+		void RemoveCache()
+		{
+			std::error_code ec;
+			std::filesystem::remove(Cache, ec);
+		}
+
+		std::string Source;
+		std::string Cache;
+		bool Written = false;
+	};
+
+	struct Model
+	{
+		std::vector<M3DLoader::SkinnedVertex> Vertices;
+		std::vector<UINT> Indices;
+		std::vector<M3DLoader::Subset> Subsets;
+		std::vector<M3DLoader::M3dMaterial> Mats;
+		SkinnedData SkinInfo;
+	};
+
+	template<typename T>
+	bool SameBytes(const std::vector<T>& a, const std::vector<T>& b)
+	{
+		return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0;
+	}
+
+	bool SameSubsets(const std::vector<M3DLoader::Subset>& a, const std::vector<M3DLoader::Subset>& b)
+	{
+		if(a.size() != b.size())
+			return false;
+		for(std::size_t i = 0; i < a.size(); ++i)
+		{
+			if(a[i].Id != b[i].Id || a[i].VertexStart != b[i].VertexStart || a[i].VertexCount != b[i].VertexCount ||
+				a[i].FaceStart != b[i].FaceStart || a[i].FaceCount != b[i].FaceCount)
+				return false;
+		}
+		return true;
+	}
+
+	// The final transforms of every clip over its whole length (and a little
+	// past both ends), bit for bit.
+	bool SamePoses(const SkinnedData& a, const SkinnedData& b)
+	{
+		if(a.BoneCount() != b.BoneCount() || a.ClipCount() != b.ClipCount())
+			return false;
+
+		for(const char* name : { "Walk", "Run" })
+		{
+			const SkinnedData::ClipHandle clipA = a.FindClip(name);
+			const SkinnedData::ClipHandle clipB = b.FindClip(name);
+			if(clipA == SkinnedData::InvalidClip || clipB == SkinnedData::InvalidClip)
+				return false;
+			if(a.GetClipStartTime(clipA) != b.GetClipStartTime(clipB) || a.GetClipEndTime(clipA) != b.GetClipEndTime(clipB))
+				return false;
+
+			std::vector<XMFLOAT4X4> poseA(a.BoneCount());
+			std::vector<XMFLOAT4X4> poseB(b.BoneCount());
+			std::vector<UINT> cursorsA;
+			std::vector<UINT> cursorsB;
+			SkinnedData::EvalScratch scratch;
+			const float end = a.GetClipEndTime(clipA);
+			for(int i = 0; i <= 200; ++i)
+			{
+				const float t = -0.1f + (end + 0.2f) * i / 200;
+				a.GetFinalTransforms(clipA, t, poseA.data(), cursorsA, scratch);
+				b.GetFinalTransforms(clipB, t, poseB.data(), cursorsB, scratch);
+				if(!SameBytes(poseA, poseB))
+					return false;
+			}
+		}
+		return true;
+	}
+}
+
+TEST(M3dParallelAndCachedLoadsMatchSerial)
+{
+	M3dFile file;
+	REQUIRE(file.Written);
+
+	// Serial reader.
+	Model serial;
+	{
+		M3DLoader loader;
+		REQUIRE(loader.LoadM3d(file.Source, serial.Vertices, serial.Indices, serial.Subsets, serial.Mats, serial.SkinInfo));
+	}
+	REQUIRE(serial.Vertices.size() == VertexCount);
+	REQUIRE(serial.Indices.size() == TriangleCount * 3);
+	REQUIRE(serial.SkinInfo.BoneCount() == BoneCount);
+	REQUIRE(serial.SkinInfo.ClipCount() == 2);
+
+	ThreadPool pool(4);
+
+	// ParseRecordsParallel, whole arrays.
+	Model parallel;
+	{
+		M3DLoader loader;
+		loader.SetThreadPool(&pool);
+		REQUIRE(loader.LoadM3d(file.Source, parallel.Vertices, parallel.Indices, parallel.Subsets, parallel.Mats, parallel.SkinInfo));
+	}
+	CHECK(SameBytes(parallel.Vertices, serial.Vertices));
+	CHECK(SameBytes(parallel.Indices, serial.Indices));
+	CHECK(SameSubsets(parallel.Subsets, serial.Subsets));
+	CHECK(parallel.Mats.size() == serial.Mats.size());
+	CHECK(SamePoses(parallel.SkinInfo, serial.SkinInfo));
+
+	// StreamRecordsParallel, batches written into a fresh cache.
+	M3dCache cache;
+	{
+		M3DLoader loader;
+		loader.SetThreadPool(&pool);
+		REQUIRE(loader.LoadM3dCached(file.Source, cache));
+	}
+	REQUIRE(cache.VertexCount() == VertexCount);
+	REQUIRE(cache.IndexCount() == TriangleCount * 3);
+
+	Model cached;
+	cached.Vertices.assign(cache.Vertices(), cache.Vertices() + cache.VertexCount());
+	cached.Indices.assign(cache.Indices(), cache.Indices() + cache.IndexCount());
+	cache.GetSubsets(cached.Subsets);
+	cache.GetMaterials(cached.Mats);
+	cache.GetSkinnedData(cached.SkinInfo);
+
+	CHECK(SameBytes(cached.Vertices, serial.Vertices));
+	CHECK(SameBytes(cached.Indices, serial.Indices));
+	CHECK(SameSubsets(cached.Subsets, serial.Subsets));
+	CHECK(cached.Mats.size() == serial.Mats.size());
+	CHECK(SamePoses(cached.SkinInfo, serial.SkinInfo));
+}
@@ -0,0 +1,66 @@
+#ifndef TEST_H
+#define TEST_H
+
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+///<summary>
+/// Minimal self-registering test runner for the portable code.
+///
+/// TEST(Name) { ... } defines a test, CHECK(condition) records a failure
+/// (with file and line) and lets the test go on, REQUIRE stops the test.
+/// BENCHMARK(Name) bodies only run with "Tests bench" and print their own
+/// numbers; they are not pass / fail.
+///</summary>
+namespace Test
+{
+	struct Case
+	{
+		const char* Name;
+		std::function<void()> Body;
+	};
+
+	std::vector<Case>& Tests();
+	std::vector<Case>& Benchmarks();
+
+	struct Registrar
+	{
+		Registrar(std::vector<Case>& list, const char* name, std::function<void()> body)
+		{
+			list.push_back({ name, std::move(body) });
+		}
+	};
+
+	// Thrown by REQUIRE to leave the current test.
+	struct Abort {};
+
+	void Fail(const char* file, int line, const std::string& message);
+}
+
+#define TEST_CONCAT_(a, b) a##b
+#define TEST_CONCAT(a, b) TEST_CONCAT_(a, b)
+
+#define TEST(name) \
+	static void TEST_CONCAT(Test_, name)(); \
+	static Test::Registrar TEST_CONCAT(TestRegistrar_, name)(Test::Tests(), #name, TEST_CONCAT(Test_, name)); \
+	static void TEST_CONCAT(Test_, name)()
+
+#define BENCHMARK(name) \
+	static void TEST_CONCAT(Benchmark_, name)(); \
+	static Test::Registrar TEST_CONCAT(BenchmarkRegistrar_, name)(Test::Benchmarks(), #name, TEST_CONCAT(Benchmark_, name)); \
+	static void TEST_CONCAT(Benchmark_, name)()
+
+#define CHECK(condition) \
+	do { if(!(condition)) Test::Fail(__FILE__, __LINE__, #condition); } while(false)
+
+#define REQUIRE(condition) \
+	do { if(!(condition)) { Test::Fail(__FILE__, __LINE__, #condition); throw Test::Abort(); } } while(false)
+
+// CHECK with the two values printed on failure.
+#define CHECK_LE(a, b) \
+	do { const double a_ = (a), b_ = (b); if(!(a_ <= b_)) \
+		Test::Fail(__FILE__, __LINE__, std::string(#a " <= " #b " (") + std::to_string(a_) + " > " + std::to_string(b_) + ")"); } while(false)
+
+#endif // TEST_H
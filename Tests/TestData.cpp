@@ -0,0 +1,52 @@
+#include "TestData.h"
+#include <cmath>
+
+using namespace DirectX;
+
+AnimationClip TestData::MakeClip(UINT boneCount, UINT keyCount, float duration)
+{
+	AnimationClip clip;
+	clip.BoneAnimations.resize(boneCount);
+
+	for(UINT bone = 0; bone < boneCount; ++bone)
+	{
+		// Up to a quarter fewer keys on some bones, so key times don't line up.
+		const UINT keys = keyCount > 4 ? keyCount - (bone % 4) * (keyCount / 16) : keyCount;
+		const float phase = 0.37f * bone;
+
+		std::vector<Keyframe>& keyframes = clip.BoneAnimations[bone].Keyframes;
+		keyframes.resize(keys);
+		for(UINT k = 0; k < keys; ++k)
+		{
+			const float t = duration * k / (keys - 1);
+			const float angle = 2.0f * XM_PI * t / duration + phase;
+
+			Keyframe& key = keyframes[k];
+			key.TimePos = t;
+			key.Translation = XMFLOAT3(0.1f * sinf(angle), 1.0f + 0.05f * cosf(angle), 0.02f * bone);
+			key.Scale = XMFLOAT3(1.0f, 1.0f + 0.05f * sinf(angle), 1.0f);
+
+			XMVECTOR axis = XMVector3Normalize(XMVectorSet(1.0f, 0.5f * sinf(phase), 0.3f, 0.0f));
+			XMStoreFloat4(&key.RotationQuat, XMQuaternionRotationAxis(axis, 0.6f * sinf(angle)));
+		}
+	}
+
+	return clip;
+}
+
+void TestData::MakeSkinnedData(SkinnedData& skinnedData, UINT boneCount, UINT keyCount, float duration,
+	const std::string& clipName)
+{
+	std::vector<int> hierarchy(boneCount);
+	std::vector<XMFLOAT4X4> offsets(boneCount);
+	for(UINT i = 0; i < boneCount; ++i)
+	{
+		hierarchy[i] = i == 0 ? -1 : (int)(i - 1) / 2;
+		XMStoreFloat4x4(&offsets[i], XMMatrixTranslation(0.0f, -1.0f * i, 0.0f));
+	}
+
+	std::unordered_map<std::string, AnimationClip> clips;
+	clips[clipName] = MakeClip(boneCount, keyCount, duration);
+
+	skinnedData.Set(hierarchy, offsets, clips);
+}
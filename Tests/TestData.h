@@ -0,0 +1,22 @@
+#ifndef TESTDATA_H
+#define TESTDATA_H
+
+#include "../Init_Direct3D/SkinnedData.h"
+
+///<summary>
+/// Synthetic skeletons for the animation tests, so they don't depend on a
+/// model file.  Bone i's parent is (i - 1) / 2 (a binary tree), and every
+/// bone gets its own smooth translation / rotation / scale curve with
+/// about keyCount keys over duration seconds.  Key times differ per bone
+/// so the clip has the uneven key layout real exports have.
+///</summary>
+namespace TestData
+{
+	void MakeSkinnedData(SkinnedData& skinnedData, UINT boneCount, UINT keyCount, float duration,
+		const std::string& clipName = "Test");
+
+	// The clip alone, for tests that work on an AnimationClip.
+	AnimationClip MakeClip(UINT boneCount, UINT keyCount, float duration);
+}
+
+#endif // TESTDATA_H
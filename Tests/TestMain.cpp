@@ -0,0 +1,80 @@
+//***************************************************************************************
+// Tests : unit tests and benchmarks for the portable parts of Init_Direct3D.
+//
+// usage: Tests          runs every test, exit code 1 if any failed
+//        Tests <name>   runs the tests whose name contains <name>
+//        Tests bench    runs the benchmarks instead
+//
+// Like AssetBaker it uses no Windows or D3D headers, so it also builds on
+// Linux, e.g. from this directory:
+//   g++ -std=c++17 -O2 -pthread -I<DirectXMath> *.cpp ../Common/MathHelper.cpp
+//       ../Init_Direct3D/{AssetArchive,BakedClip,BlendTree,ClipCompressor,CompiledClip,CpuSkinner,LoadM3d,
+//       M3dCache,MappedFile,SkinnedData,TextScanner,ThreadPool,VertexPacking}.cpp -o Tests
+// DirectXMath is header only; outside Windows it also needs the sal.h from DirectX-Headers.
+//***************************************************************************************
+
+#include "Test.h"
+
+#include <chrono>
+#include <cstring>
+
+namespace
+{
+	int gFailures = 0;
+}
+
+std::vector<Test::Case>& Test::Tests()
+{
+	static std::vector<Case> tests;
+	return tests;
+}
+
+std::vector<Test::Case>& Test::Benchmarks()
+{
+	static std::vector<Case> benchmarks;
+	return benchmarks;
+}
+
+void Test::Fail(const char* file, int line, const std::string& message)
+{
+	std::printf("  %s(%d): failed: %s\n", file, line, message.c_str());
+	++gFailures;
+}
+
+int main(int argc, char* argv[])
+{
+	const bool bench = argc > 1 && std::strcmp(argv[1], "bench") == 0;
+	const char* filter = argc > 1 && !bench ? argv[1] : nullptr;
+
+	int run = 0;
+	int failed = 0;
+	for(const Test::Case& test : bench ? Test::Benchmarks() : Test::Tests())
+	{
+		if(filter != nullptr && std::strstr(test.Name, filter) == nullptr)
+			continue;
+
+		std::printf("[%s]\n", test.Name);
+		const int failuresBefore = gFailures;
+		const auto start = std::chrono::steady_clock::now();
+		try
+		{
+			test.Body();
+		}
+		catch(const Test::Abort&)
+		{
+		}
+		catch(const std::exception& e)
+		{
+			Test::Fail(__FILE__, __LINE__, std::string("exception: ") + e.what());
+		}
+		const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		++run;
+		if(gFailures != failuresBefore)
+			++failed;
+		std::printf("  %s (%.1f ms)\n", gFailures != failuresBefore ? "FAILED" : "ok", ms);
+	}
+
+	std::printf("%d run, %d failed\n", run, failed);
+	return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,175 @@
+#include "Test.h"
+#include "../Init_Direct3D/TextScanner.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+
+namespace
+{
+	struct Text
+	{
+		explicit Text(const char* text) : Scan(text, text + std::strlen(text)) {}
+		TextScanner Scan;
+	};
+}
+
+TEST(TextScannerReadsValues)
+{
+	Text text("Pos: 1.5 -2 +3 1e3\nIds: 7 +8 -9\n{ name }");
+	TextScanner& scan = text.Scan;
+
+	float x = 0.0f, y = 0.0f, z = 0.0f, w = 0.0f;
+	scan.Skip() >> x >> y >> z >> w;
+	CHECK(x == 1.5f && y == -2.0f && z == 3.0f && w == 1000.0f);
+
+	std::uint32_t a = 0;
+	std::uint16_t b = 0;
+	int c = 0;
+	scan.Skip() >> a >> b >> c;
+	CHECK(a == 7 && b == 8 && c == -9);
+
+	std::string name;
+	scan.Skip() >> name;
+	CHECK(name == "name");
+	scan.Skip();
+
+	CHECK(!scan.Fail());
+	CHECK(scan.Eof());
+}
+
+TEST(TextScannerFailsOnGarbage)
+{
+	// A label where a number is expected: 0, and the label is consumed.
+	Text label("Pos: 4");
+	CHECK(label.Scan.ReadFloat() == 0.0f);
+	CHECK(label.Scan.Fail());
+
+	// The state stays set, but reading goes on at the next token.
+	CHECK(label.Scan.ReadFloat() == 4.0f);
+	CHECK(label.Scan.Fail());
+
+	// Only the front of the token is a number.
+	Text suffix("1.5f 2");
+	CHECK(suffix.Scan.ReadFloat() == 0.0f);
+	CHECK(suffix.Scan.Fail());
+	CHECK(suffix.Scan.ReadInt() == 2);
+
+	// A sign with nothing behind it.
+	Text sign("- +");
+	CHECK(sign.Scan.ReadInt() == 0);
+	CHECK(sign.Scan.Fail());
+}
+
+TEST(TextScannerFailsOutOfRange)
+{
+	Text bigFloat("1e99 3");
+	CHECK(bigFloat.Scan.ReadFloat() == 0.0f);
+	CHECK(bigFloat.Scan.Fail());
+	CHECK(bigFloat.Scan.ReadFloat() == 3.0f);
+
+	Text bigUInt("4294967296");
+	CHECK(bigUInt.Scan.ReadUInt() == 0);
+	CHECK(bigUInt.Scan.Fail());
+
+	Text negativeUInt("-1");
+	CHECK(negativeUInt.Scan.ReadUInt() == 0);
+	CHECK(negativeUInt.Scan.Fail());
+
+	Text bigUInt16("70000");
+	std::uint16_t value = 0;
+	bigUInt16.Scan >> value;
+	CHECK(bigUInt16.Scan.Fail());
+
+	Text bigInt("2147483648");
+	CHECK(bigInt.Scan.ReadInt() == 0);
+	CHECK(bigInt.Scan.Fail());
+}
+
+TEST(TextScannerFailsAtEnd)
+{
+	Text number("1 ");
+	CHECK(number.Scan.ReadInt() == 1);
+	CHECK(!number.Scan.Fail());
+	CHECK(number.Scan.ReadInt() == 0);
+	CHECK(number.Scan.Fail());
+
+	Text token("  ");
+	std::string value;
+	CHECK(!token.Scan.ReadToken(value));
+	CHECK(token.Scan.Fail());
+
+	Text skip("a");
+	skip.Scan.Skip(2);
+	CHECK(skip.Scan.Fail());
+}
+
+BENCHMARK(TextScannerThroughput)
+{
+	// Skinned vertex records as written in .m3d files.
+	std::string text;
+	const int vertexCount = 100000;
+	text.reserve(vertexCount * 260);
+	for(int i = 0; i < vertexCount; ++i)
+	{
+		const float f = i * 0.001f;
+		char record[320];
+		std::snprintf(record, sizeof(record),
+			"Position: %f %f %f\nTangent: %f %f %f 1\nNormal: %f %f %f\nTex-Coords: %f %f\n"
+			"BlendWeights: %f %f %f %f\nBlendIndices: %d %d %d %d\n\n",
+			f, -f, f * 2.0f, 0.5f, 0.25f, -0.75f, 0.0f, 1.0f, 0.0f, f, 1.0f - f,
+			0.5f, 0.25f, 0.25f, 0.0f, i % 58, (i + 1) % 58, (i + 2) % 58, 0);
+		text += record;
+	}
+	const double megabytes = text.size() / (1024.0 * 1024.0);
+
+	float values[19] = {};
+	int indices[4] = {};
+	float checksum = 0.0f;
+
+	auto timeMs = [](auto&& body)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		body();
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	};
+
+	const double scannerMs = timeMs([&]()
+	{
+		TextScanner scan(text.data(), text.data() + text.size());
+		for(int i = 0; i < vertexCount; ++i)
+		{
+			scan.Skip() >> values[0] >> values[1] >> values[2];
+			scan.Skip() >> values[3] >> values[4] >> values[5] >> values[6];
+			scan.Skip() >> values[7] >> values[8] >> values[9];
+			scan.Skip() >> values[10] >> values[11];
+			scan.Skip() >> values[12] >> values[13] >> values[14] >> values[15];
+			scan.Skip() >> indices[0] >> indices[1] >> indices[2] >> indices[3];
+			checksum += values[0];
+		}
+		CHECK(!scan.Fail());
+	});
+
+	// What the loader used before: operator>> on a stream, labels read into a string.
+	const double streamMs = timeMs([&]()
+	{
+		std::istringstream stream(text);
+		std::string label;
+		for(int i = 0; i < vertexCount; ++i)
+		{
+			stream >> label >> values[0] >> values[1] >> values[2];
+			stream >> label >> values[3] >> values[4] >> values[5] >> values[6];
+			stream >> label >> values[7] >> values[8] >> values[9];
+			stream >> label >> values[10] >> values[11];
+			stream >> label >> values[12] >> values[13] >> values[14] >> values[15];
+			stream >> label >> indices[0] >> indices[1] >> indices[2] >> indices[3];
+			checksum -= values[0];
+		}
+		CHECK(!stream.fail());
+	});
+
+	std::printf("  %d vertex records, %.1f MB (checksum %g)\n", vertexCount, megabytes, checksum);
+	std::printf("  TextScanner   : %7.1f ms, %6.1f MB/s\n", scannerMs, megabytes / (scannerMs / 1000.0));
+	std::printf("  istringstream : %7.1f ms, %6.1f MB/s\n", streamMs, megabytes / (streamMs / 1000.0));
+}
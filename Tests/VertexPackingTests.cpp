@@ -0,0 +1,190 @@
+#include "Test.h"
+#include "../Init_Direct3D/VertexPacking.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+// Pack* then Unpack* on random data, with the error each format allows.
+namespace
+{
+	const std::size_t VertexCount = 20000;
+
+	float Random(std::mt19937& rng, float lo, float hi)
+	{
+		return std::uniform_real_distribution<float>(lo, hi)(rng);
+	}
+
+	XMFLOAT3 RandomUnitVector(std::mt19937& rng)
+	{
+		for(;;)
+		{
+			XMFLOAT3 v(Random(rng, -1.0f, 1.0f), Random(rng, -1.0f, 1.0f), Random(rng, -1.0f, 1.0f));
+			const float lengthSq = v.x * v.x + v.y * v.y + v.z * v.z;
+			if(lengthSq > 1e-4f && lengthSq <= 1.0f)
+			{
+				const float s = 1.0f / sqrtf(lengthSq);
+				return XMFLOAT3(v.x * s, v.y * s, v.z * s);
+			}
+		}
+	}
+}
+
+TEST(PackPositionsRoundTrip)
+{
+	std::mt19937 rng(1);
+
+	// Off-center and uneven bounds: x is the longest axis and sets the scale.
+	std::vector<XMFLOAT3> positions(VertexCount);
+	for(XMFLOAT3& p : positions)
+		p = XMFLOAT3(Random(rng, 90.0f, 130.0f), Random(rng, -2.0f, 3.0f), Random(rng, -10.0f, 0.0f));
+
+	std::vector<XMSHORTN4> packed(VertexCount);
+	const XMFLOAT4 dequant = VertexPacking::PackPositions(positions.data(), sizeof(XMFLOAT3), VertexCount,
+		packed.data(), sizeof(XMSHORTN4));
+
+	// Half the largest extent, 20 here.
+	CHECK(fabsf(dequant.w - 20.0f) < 0.01f);
+
+	// One snorm16 step is scale / 32767; rounding is off by at most half of it.
+	const float tolerance = dequant.w / 32767.0f * 0.5f * 1.01f;
+	float maxError = 0.0f;
+	for(std::size_t i = 0; i < VertexCount; ++i)
+	{
+		const XMFLOAT3 p = VertexPacking::UnpackPosition(packed[i], dequant);
+		maxError = fmaxf(maxError, fabsf(p.x - positions[i].x));
+		maxError = fmaxf(maxError, fabsf(p.y - positions[i].y));
+		maxError = fmaxf(maxError, fabsf(p.z - positions[i].z));
+	}
+	CHECK_LE(maxError, tolerance);
+}
+
+TEST(PackUnitVectorsRoundTrip)
+{
+	std::mt19937 rng(2);
+
+	// Random directions plus the axes and the octahedron's folded edges.
+	std::vector<XMFLOAT3> normals;
+	for(int axis = 0; axis < 3; ++axis)
+	{
+		for(float s : { 1.0f, -1.0f })
+		{
+			XMFLOAT3 n(0.0f, 0.0f, 0.0f);
+			(&n.x)[axis] = s;
+			normals.push_back(n);
+		}
+	}
+	normals.push_back(XMFLOAT3(0.70710678f, 0.0f, -0.70710678f));
+	normals.push_back(XMFLOAT3(-0.57735027f, -0.57735027f, -0.57735027f));
+	while(normals.size() < VertexCount)
+		normals.push_back(RandomUnitVector(rng));
+
+	std::vector<XMSHORTN2> packed(normals.size());
+	VertexPacking::PackUnitVectors(normals.data(), sizeof(XMFLOAT3), normals.size(), packed.data(), sizeof(XMSHORTN2));
+
+	// The octahedral grid is 1 / 32767 apart.  The projection stretches it
+	// most near the folded edges, where the closest grid point is still
+	// within about 0.0075 degrees.
+	const float maxAngle = XMConvertToRadians(0.01f);
+	float worstAngle = 0.0f;
+	float worstLengthError = 0.0f;
+	for(std::size_t i = 0; i < normals.size(); ++i)
+	{
+		const XMFLOAT3 n = VertexPacking::UnpackUnitVector(packed[i]);
+		worstLengthError = fmaxf(worstLengthError, fabsf(n.x * n.x + n.y * n.y + n.z * n.z - 1.0f));
+
+		// atan2 of |cross| and dot: acos of a float dot near 1 can't resolve these angles.
+		const XMFLOAT3& m = normals[i];
+		const double cx = (double)n.y * m.z - (double)n.z * m.y;
+		const double cy = (double)n.z * m.x - (double)n.x * m.z;
+		const double cz = (double)n.x * m.y - (double)n.y * m.x;
+		const double d = (double)n.x * m.x + (double)n.y * m.y + (double)n.z * m.z;
+		worstAngle = fmaxf(worstAngle, (float)atan2(sqrt(cx * cx + cy * cy + cz * cz), d));
+	}
+	CHECK_LE(worstAngle, maxAngle);
+	CHECK_LE(worstLengthError, 1e-5f);
+
+	// Zero vectors are stored as +Z.
+	const XMFLOAT3 zero(0.0f, 0.0f, 0.0f);
+	XMSHORTN2 packedZero;
+	VertexPacking::PackUnitVectors(&zero, sizeof(XMFLOAT3), 1, &packedZero, sizeof(XMSHORTN2));
+	const XMFLOAT3 z = VertexPacking::UnpackUnitVector(packedZero);
+	CHECK(z.x == 0.0f && z.y == 0.0f && z.z == 1.0f);
+}
+
+TEST(PackTexCoordsRoundTrip)
+{
+	std::mt19937 rng(3);
+
+	// Tiled uvs go past [0, 1]; half keeps 11 significant bits at any size.
+	std::vector<XMFLOAT2> uvs(VertexCount);
+	for(XMFLOAT2& uv : uvs)
+		uv = XMFLOAT2(Random(rng, -4.0f, 4.0f), Random(rng, 0.0f, 1.0f));
+	uvs[0] = XMFLOAT2(0.0f, 1.0f);
+
+	std::vector<XMHALF2> packed(VertexCount);
+	VertexPacking::PackTexCoords(uvs.data(), sizeof(XMFLOAT2), VertexCount, packed.data(), sizeof(XMHALF2));
+
+	float worstRelative = 0.0f;
+	for(std::size_t i = 0; i < VertexCount; ++i)
+	{
+		const XMFLOAT2 uv = VertexPacking::UnpackTexCoord(packed[i]);
+
+		// Relative to the value, with a floor for values near 0 (half subnormals).
+		worstRelative = fmaxf(worstRelative, fabsf(uv.x - uvs[i].x) / fmaxf(fabsf(uvs[i].x), 1e-3f));
+		worstRelative = fmaxf(worstRelative, fabsf(uv.y - uvs[i].y) / fmaxf(fabsf(uvs[i].y), 1e-3f));
+	}
+	CHECK_LE(worstRelative, 1.0f / 2048.0f);
+
+	const XMFLOAT2 corner = VertexPacking::UnpackTexCoord(packed[0]);
+	CHECK(corner.x == 0.0f && corner.y == 1.0f);
+}
+
+TEST(PackBoneWeightsRoundTrip)
+{
+	std::mt19937 rng(4);
+
+	// Three stored weights of a four-bone vertex, summing to at most 1,
+	// plus the usual edge cases: a single bone, even splits, none.
+	std::vector<XMFLOAT3> weights;
+	weights.push_back(XMFLOAT3(1.0f, 0.0f, 0.0f));
+	weights.push_back(XMFLOAT3(1.0f / 3.0f, 1.0f / 3.0f, 1.0f / 3.0f));
+	weights.push_back(XMFLOAT3(0.25f, 0.25f, 0.25f));
+	weights.push_back(XMFLOAT3(0.0f, 0.0f, 0.0f));
+	while(weights.size() < VertexCount)
+	{
+		float w[4] = { Random(rng, 0.0f, 1.0f), Random(rng, 0.0f, 1.0f), Random(rng, 0.0f, 1.0f), Random(rng, 0.0f, 1.0f) };
+		const float sum = w[0] + w[1] + w[2] + w[3];
+		weights.push_back(XMFLOAT3(w[0] / sum, w[1] / sum, w[2] / sum));
+	}
+
+	std::vector<XMUBYTEN4> packed(weights.size());
+	VertexPacking::PackBoneWeights(weights.data(), sizeof(XMFLOAT3), weights.size(), packed.data(), sizeof(XMUBYTEN4));
+
+	// Each weight rounds to the nearest 1/255; when that overshoots 1, the
+	// excess (at most one step) comes off the largest weight.
+	float worstError = 0.0f;
+	float worstSum = 0.0f;
+	std::size_t badTotals = 0;
+	for(std::size_t i = 0; i < weights.size(); ++i)
+	{
+		const XMFLOAT3 w = VertexPacking::UnpackBoneWeights(packed[i]);
+		worstError = fmaxf(worstError, fabsf(w.x - weights[i].x));
+		worstError = fmaxf(worstError, fabsf(w.y - weights[i].y));
+		worstError = fmaxf(worstError, fabsf(w.z - weights[i].z));
+
+		// The implicit fourth weight is what the shader adds back.
+		worstSum = fmaxf(worstSum, w.x + w.y + w.z);
+		if(packed[i].x + packed[i].y + packed[i].z + packed[i].w != 255)
+			++badTotals;
+	}
+	CHECK_LE(worstError, 1.5f / 255.0f);
+	CHECK_LE(worstSum, 1.0f + 1e-6f);
+	CHECK(badTotals == 0);
+
+	const XMFLOAT3 single = VertexPacking::UnpackBoneWeights(packed[0]);
+	CHECK(single.x == 1.0f && single.y == 0.0f && single.z == 0.0f && packed[0].w == 0);
+}